@@ -0,0 +1,251 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "thrift/logging.h"
+#include "thrift/platform.h"
+
+#include "thrift/cache/t_cache.h"
+#include "thrift/generate/t_generator.h"
+
+static const char CACHE_MAGIC[] = "thrift-codegen-cache 1";
+
+// Each thread generates one program at a time
+static thread_local std::set<std::string> generated;
+
+/**
+ * 64-bit FNV-1a; the cache only has to notice edits, not resist attacks
+ */
+static uint64_t fnv1a(const std::string& data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (std::string::const_iterator it = data.begin(); it != data.end(); ++it) {
+    hash ^= static_cast<unsigned char>(*it);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+static std::string to_hex(uint64_t value) {
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(value));
+  return buf;
+}
+
+static bool file_hash(const std::string& path, std::string& hash) {
+  std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  hash = to_hex(fnv1a(contents.str()));
+  return true;
+}
+
+static bool file_exists(const std::string& path) {
+  return static_cast<bool>(std::ifstream(path.c_str()));
+}
+
+std::string codegen_cache_entry(const std::string& cache_dir, const std::vector<std::string>& key) {
+  std::string joined;
+  for (std::vector<std::string>::const_iterator it = key.begin(); it != key.end(); ++it) {
+    joined += *it + '\n';
+  }
+  return cache_dir + "/" + to_hex(fnv1a(joined)) + ".cache";
+}
+
+bool codegen_cache_lookup(const std::string& entry,
+                          const std::vector<std::string>& key,
+                          std::vector<std::string>& inputs,
+                          std::vector<std::string>& outputs) {
+  std::ifstream in(entry.c_str());
+  if (!in) {
+    return false;
+  }
+
+  std::string line;
+  if (!std::getline(in, line) || line != CACHE_MAGIC) {
+    return false;
+  }
+
+  // The file name is only a hash of the key, so compare the key itself
+  std::vector<std::string>::const_iterator key_iter = key.begin();
+  inputs.clear();
+  outputs.clear();
+  while (std::getline(in, line)) {
+    if (line.compare(0, 4, "key ") == 0) {
+      if (key_iter == key.end() || line.substr(4) != *key_iter++) {
+        return false;
+      }
+    } else if (line.compare(0, 3, "in ") == 0) {
+      std::string::size_type space = line.find(' ', 3);
+      if (space == std::string::npos) {
+        return false;
+      }
+      std::string path = line.substr(space + 1);
+      std::string hash;
+      if (!file_hash(path, hash) || hash != line.substr(3, space - 3)) {
+        pverbose("Cache entry %s is stale: %s changed\n", entry.c_str(), path.c_str());
+        return false;
+      }
+      inputs.push_back(path);
+    } else if (line.compare(0, 4, "out ") == 0) {
+      std::string path = line.substr(4);
+      if (!file_exists(path)) {
+        pverbose("Cache entry %s is stale: %s is missing\n", entry.c_str(), path.c_str());
+        return false;
+      }
+      outputs.push_back(path);
+    } else {
+      return false;
+    }
+  }
+
+  return key_iter == key.end() && !inputs.empty();
+}
+
+void codegen_cache_store(const std::string& entry,
+                         const std::vector<std::string>& key,
+                         const std::vector<std::string>& inputs,
+                         const std::vector<std::string>& outputs) {
+  std::string cache_dir = entry.substr(0, entry.rfind('/'));
+  try {
+    MKDIR(cache_dir.c_str());
+  } catch (const std::string& e) {
+    pwarning(0, "Cannot create cache directory %s\n", e.c_str());
+    return;
+  }
+
+  std::ostringstream contents;
+  contents << CACHE_MAGIC << '\n';
+  for (std::vector<std::string>::const_iterator it = key.begin(); it != key.end(); ++it) {
+    contents << "key " << *it << '\n';
+  }
+  for (std::vector<std::string>::const_iterator it = inputs.begin(); it != inputs.end(); ++it) {
+    std::string hash;
+    if (!file_hash(*it, hash)) {
+      return;
+    }
+    contents << "in " << hash << ' ' << *it << '\n';
+  }
+  for (std::vector<std::string>::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
+    contents << "out " << *it << '\n';
+  }
+
+  // Write a temporary file and rename it, so that a concurrent run never
+  // reads a partial entry
+  std::string temp = entry + ".tmp";
+  {
+    std::ofstream out(temp.c_str(), std::ios::out | std::ios::binary);
+    out << contents.str();
+    if (!out) {
+      pwarning(0, "Cannot write cache entry %s\n", temp.c_str());
+      return;
+    }
+  }
+#ifdef _WIN32
+  remove(entry.c_str());
+#endif
+  if (rename(temp.c_str(), entry.c_str()) != 0) {
+    pwarning(0, "Cannot write cache entry %s: %s\n", entry.c_str(), strerror(errno));
+    remove(temp.c_str());
+  }
+}
+
+/**
+ * Collapses the repeated separators that joining an output directory ending in
+ * '/' with a file name produces, so each file is named one way everywhere
+ */
+static std::string normalize_path(const std::string& path) {
+  std::string normalized;
+  for (std::string::const_iterator it = path.begin(); it != path.end(); ++it) {
+    if (*it == '/' && !normalized.empty() && normalized[normalized.size() - 1] == '/') {
+      continue;
+    }
+    normalized += *it;
+  }
+  return normalized;
+}
+
+/**
+ * Escapes a path for use in a Make rule
+ */
+static std::string depfile_escape(const std::string& path) {
+  std::string normalized = normalize_path(path);
+  std::string escaped;
+  for (std::string::const_iterator it = normalized.begin(); it != normalized.end(); ++it) {
+    if (*it == ' ' || *it == '#' || *it == '\\') {
+      escaped += '\\';
+    } else if (*it == '$') {
+      escaped += '$';
+    }
+    escaped += *it;
+  }
+  return escaped;
+}
+
+void write_depfile(const std::string& path, const std::vector<depfile_rule>& rules) {
+  std::ofstream out(path.c_str(), std::ios::out | std::ios::binary);
+  if (!out) {
+    failure("Cannot write dependency file %s", path.c_str());
+  }
+
+  std::set<std::string> all_inputs;
+  for (std::vector<depfile_rule>::const_iterator rule = rules.begin(); rule != rules.end(); ++rule) {
+    // Without any recorded output, the dependency file itself is the target
+    if (rule->outputs.empty()) {
+      out << depfile_escape(path);
+    }
+    std::vector<std::string>::const_iterator it;
+    for (it = rule->outputs.begin(); it != rule->outputs.end(); ++it) {
+      out << (it == rule->outputs.begin() ? "" : " \\\n ") << depfile_escape(*it);
+    }
+    out << ":";
+    for (it = rule->inputs.begin(); it != rule->inputs.end(); ++it) {
+      out << " \\\n  " << depfile_escape(*it);
+      all_inputs.insert(normalize_path(*it));
+    }
+    out << "\n";
+  }
+
+  // An empty rule per input keeps Make going when an IDL file is removed
+  for (std::set<std::string>::const_iterator it = all_inputs.begin(); it != all_inputs.end(); ++it) {
+    out << "\n" << depfile_escape(*it) << ":\n";
+  }
+}
+
+void record_generated_file(const std::string& path) {
+  generated.insert(normalize_path(path));
+}
+
+std::vector<std::string> generated_files() {
+  return std::vector<std::string>(generated.begin(), generated.end());
+}
+
+void clear_generated_files() {
+  generated.clear();
+}
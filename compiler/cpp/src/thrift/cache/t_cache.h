@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef T_CACHE_H
+#define T_CACHE_H
+
+#include <string>
+#include <vector>
+
+/**
+ * On-disk cache of code generation results (--cache).
+ *
+ * An entry is found by its key, which names everything besides the IDL
+ * files that affects the output: the compiler version, the input file, the
+ * generators and their options, and so on. It records a content hash of
+ * every IDL file that was parsed, which is the input file and everything it
+ * includes, and the list of generated files. As long as none of those IDL
+ * files changed and all generated files still exist, parsing and generation
+ * can be skipped.
+ */
+
+/**
+ * Path of the entry for key in cache_dir
+ */
+std::string codegen_cache_entry(const std::string& cache_dir, const std::vector<std::string>& key);
+
+/**
+ * Checks whether the entry is up to date, and if so returns the IDL files
+ * and generated files it recorded
+ */
+bool codegen_cache_lookup(const std::string& entry,
+                          const std::vector<std::string>& key,
+                          std::vector<std::string>& inputs,
+                          std::vector<std::string>& outputs);
+
+/**
+ * Records the IDL files and generated files of a successful run
+ */
+void codegen_cache_store(const std::string& entry,
+                         const std::vector<std::string>& key,
+                         const std::vector<std::string>& inputs,
+                         const std::vector<std::string>& outputs);
+
+/**
+ * A rule of a dependency file: generated files and the IDL files they were
+ * generated from
+ */
+struct depfile_rule {
+  std::vector<std::string> outputs;
+  std::vector<std::string> inputs;
+};
+
+/**
+ * Writes a Make-style dependency file
+ */
+void write_depfile(const std::string& path, const std::vector<depfile_rule>& rules);
+
+/**
+ * Files opened through ofstream_with_content_based_conditional_update by the
+ * calling thread since its last call to clear_generated_files, in sorted order
+ */
+std::vector<std::string> generated_files();
+
+void clear_generated_files();
+
+#endif
@@ -61,6 +61,7 @@ public:
     gen_pure_enums_ = false;
     use_include_prefix_ = false;
     gen_cob_style_ = false;
+    gen_coroutines_ = false;
     gen_no_client_completion_ = false;
     gen_no_default_operators_ = false;
     gen_templates_ = false;
@@ -68,6 +69,9 @@ public:
     gen_moveable_ = false;
     gen_no_ostream_operators_ = false;
     gen_no_skeleton_ = false;
+    gen_compact_layout_ = false;
+    gen_serialized_size_ = false;
+    gen_views_ = false;
     has_members_ = false;
 
     for( iter = parsed_options.begin(); iter != parsed_options.end(); ++iter) {
@@ -77,6 +81,8 @@ public:
         use_include_prefix_ = true;
       } else if( iter->first.compare("cob_style") == 0) {
         gen_cob_style_ = true;
+      } else if( iter->first.compare("coroutines") == 0) {
+        gen_coroutines_ = true;
       } else if( iter->first.compare("no_client_completion") == 0) {
         gen_no_client_completion_ = true;
       } else if( iter->first.compare("no_default_operators") == 0) {
@@ -90,6 +96,12 @@ public:
         gen_no_ostream_operators_ = true;
       } else if ( iter->first.compare("no_skeleton") == 0) {
         gen_no_skeleton_ = true;
+      } else if ( iter->first.compare("compact_layout") == 0) {
+        gen_compact_layout_ = true;
+      } else if ( iter->first.compare("serialized_size") == 0) {
+        gen_serialized_size_ = true;
+      } else if ( iter->first.compare("views") == 0) {
+        gen_views_ = true;
       } else {
         throw "unknown option cpp:" + iter->first;
       }
@@ -155,6 +167,14 @@ public:
   void generate_struct_reader(std::ostream& out, t_struct* tstruct, bool pointers = false);
   void generate_struct_writer(std::ostream& out, t_struct* tstruct, bool pointers = false);
   void generate_struct_result_writer(std::ostream& out, t_struct* tstruct, bool pointers = false);
+  void generate_struct_serialized_size(std::ostream& out, t_struct* tstruct);
+  void generate_serialized_size_value(std::ostream& out,
+                                      t_type* ttype,
+                                      std::string name,
+                                      bool pointer = false);
+  std::string serialized_size_call(t_type* ttype, std::string name);
+  void generate_struct_view(std::ostream& out, t_struct* tstruct);
+  std::string view_type_name(t_type* ttype);
   void generate_struct_swap(std::ostream& out, t_struct* tstruct);
   void generate_struct_print_method(std::ostream& out, t_struct* tstruct);
   void generate_exception_what_method(std::ostream& out, t_struct* tstruct);
@@ -177,6 +197,8 @@ public:
                                  bool specialized = false);
   void generate_function_helpers(t_service* tservice, t_function* tfunction);
   void generate_service_async_skeleton(t_service* tservice);
+  void generate_service_coro_client(t_service* tservice);
+  void generate_coro_process_function(t_service* tservice, t_function* tfunction);
 
   /**
    * Serialization constructs
@@ -266,6 +288,38 @@ public:
 
   bool is_reference(t_field* tfield) { return tfield->get_reference(); }
 
+  /**
+   * True if a struct field is kept encoded until first accessed (cpp.lazy).
+   */
+  bool is_lazy(t_field* tfield) const {
+    t_type* ttype = get_true_type(tfield->get_type());
+    return !tfield->get_reference() && (ttype->is_struct() || ttype->is_xception())
+           && tfield->annotations_.find("cpp.lazy") != tfield->annotations_.end();
+  }
+
+  /**
+   * True if any struct of the program has a cpp.lazy field.
+   */
+  bool has_lazy_fields() const {
+    vector<t_struct*> objects = program_->get_objects();
+    const vector<t_service*>& services = program_->get_services();
+    for (auto service : services) {
+      const vector<t_function*>& functions = service->get_functions();
+      for (auto function : functions) {
+        objects.push_back(function->get_arglist());
+      }
+    }
+    for (auto object : objects) {
+      const vector<t_field*>& members = object->get_members();
+      for (auto member : members) {
+        if (is_lazy(member)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
   bool is_complex_type(t_type* ttype) {
     ttype = get_true_type(ttype);
 
@@ -299,6 +353,19 @@ public:
    */
   bool is_struct_storage_not_throwing(t_struct* tstruct) const;
 
+  /**
+   * Returns the members of a struct in the order they are declared in the
+   * generated class: IDL order, or by decreasing alignment for compact_layout.
+   */
+  std::vector<t_field*> get_layout_members(t_struct* tstruct);
+
+  /**
+   * Returns the (approximate) alignment of a field's generated C++ type.
+   */
+  int get_field_alignment(t_field* tfield);
+
+  void generate_isset_declaration(std::ostream& out, t_struct* tstruct);
+
 private:
   /**
    * Returns the include prefix to use for a file generated by program, or the
@@ -350,6 +417,11 @@ private:
    */
   bool gen_cob_style_;
 
+  /**
+   * True if we should generate C++20 coroutine clients and processors as well.
+   */
+  bool gen_coroutines_;
+
   /**
    * True if we should omit calls to completion__() in CobClient class.
    */
@@ -365,6 +437,22 @@ private:
    */
   bool gen_no_skeleton_;
 
+  /**
+   * True if we should pack __isset flags into 64-bit words and order members
+   * by alignment.
+   */
+  bool gen_compact_layout_;
+
+  /**
+   * True if we should generate serializedSize<Protocol_>() for each struct
+   */
+  bool gen_serialized_size_;
+
+  /**
+   * True if we should generate read-only views of encoded structs
+   */
+  bool gen_views_;
+
   /**
    * True if thrift has member(s)
    */
@@ -386,6 +474,13 @@ private:
   ofstream_with_content_based_conditional_update f_types_impl_;
   ofstream_with_content_based_conditional_update f_types_tcc_;
   ofstream_with_content_based_conditional_update f_header_;
+
+  /**
+   * serializedSize() definitions, emitted at the end of the types header once
+   * every struct is complete.
+   */
+  std::ostringstream f_types_sizes_;
+  ofstream_with_content_based_conditional_update f_views_;
   ofstream_with_content_based_conditional_update f_service_;
   ofstream_with_content_based_conditional_update f_service_tcc_;
 
@@ -445,6 +540,13 @@ void t_cpp_generator::init_generator() {
   // Include C++xx compatibility header
   f_types_ << "#include <functional>" << endl;
   f_types_ << "#include <memory>" << endl;
+  if (gen_compact_layout_) {
+    // memcmp() of the packed __isset words
+    f_types_ << "#include <cstring>" << endl;
+  }
+  if (has_lazy_fields()) {
+    f_types_ << "#include <thrift/TLazyStruct.h>" << endl;
+  }
 
   // Include other Thrift includes
   const vector<t_program*>& includes = program_->get_includes();
@@ -491,12 +593,31 @@ void t_cpp_generator::init_generator() {
   f_types_impl_ << ns_open_ << endl << endl;
 
   f_types_tcc_ << ns_open_ << endl << endl;
+
+  if (gen_views_) {
+    string f_views_name = get_out_dir() + program_name_ + "_views.h";
+    f_views_.open(f_views_name.c_str());
+    f_views_ << autogen_comment();
+    f_views_ << "#ifndef " << program_name_ << "_VIEWS_H" << endl << "#define " << program_name_
+             << "_VIEWS_H" << endl << endl;
+    f_views_ << "#include <thrift/protocol/TView.h>" << endl << endl;
+    // XXX: included files are assumed to have been generated with views too
+    for (auto include : includes) {
+      f_views_ << "#include \"" << get_include_prefix(*include) << include->get_name()
+               << "_views.h\"" << endl;
+    }
+    f_views_ << "#include \"" << get_include_prefix(*get_program()) << program_name_
+             << "_types.h\"" << endl << endl;
+    f_views_ << ns_open_ << endl << endl;
+  }
 }
 
 /**
  * Closes the output files.
  */
 void t_cpp_generator::close_generator() {
+  f_types_ << f_types_sizes_.str();
+
   // Close namespace
   f_types_ << ns_close_ << endl << endl;
   f_types_impl_ << ns_close_ << endl;
@@ -519,6 +640,11 @@ void t_cpp_generator::close_generator() {
   f_types_impl_.close();
   f_types_tcc_.close();
 
+  if (gen_views_) {
+    f_views_ << ns_close_ << endl << endl << "#endif" << endl;
+    f_views_.close();
+  }
+
   string f_types_impl_name = get_out_dir() + program_name_ + "_types.cpp";
 
   if (!has_members_) {
@@ -892,6 +1018,10 @@ string t_cpp_generator::render_const_value(ostream& out,
 void t_cpp_generator::generate_forward_declaration(t_struct* tstruct) {
   // Forward declare struct def
   f_types_ << indent() << "class " << tstruct->get_name() << ";" << endl << endl;
+  if (gen_views_) {
+    f_views_ << indent() << "template <class Reader_>" << endl << indent() << "class "
+             << tstruct->get_name() << "View;" << endl << endl;
+  }
 }
 
 /**
@@ -908,6 +1038,12 @@ void t_cpp_generator::generate_cpp_struct(t_struct* tstruct, bool is_exception)
   std::ostream& out = (gen_templates_ ? f_types_tcc_ : f_types_impl_);
   generate_struct_reader(out, tstruct);
   generate_struct_writer(out, tstruct);
+  if (gen_serialized_size_) {
+    generate_struct_serialized_size(f_types_sizes_, tstruct);
+  }
+  if (gen_views_) {
+    generate_struct_view(f_views_, tstruct);
+  }
   generate_struct_swap(f_types_impl_, tstruct);
   generate_copy_constructor(f_types_impl_, tstruct, is_exception);
   if (gen_moveable_) {
@@ -1088,34 +1224,7 @@ void t_cpp_generator::generate_struct_declaration(ostream& out,
   }
 
   if (has_nonrequired_fields && (!pointers || read)) {
-
-    out << indent() << "typedef struct _" << tstruct->get_name() << "__isset {" << endl;
-    indent_up();
-
-    indent(out) << "_" << tstruct->get_name() << "__isset() ";
-    bool first = true;
-    for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
-      if ((*m_iter)->get_req() == t_field::T_REQUIRED) {
-        continue;
-      }
-      string isSet = ((*m_iter)->get_value() != nullptr) ? "true" : "false";
-      if (first) {
-        first = false;
-        out << ": " << (*m_iter)->get_name() << "(" << isSet << ")";
-      } else {
-        out << ", " << (*m_iter)->get_name() << "(" << isSet << ")";
-      }
-    }
-    out << " {}" << endl;
-
-    for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
-      if ((*m_iter)->get_req() != t_field::T_REQUIRED) {
-        indent(out) << "bool " << (*m_iter)->get_name() << " :1;" << endl;
-      }
-    }
-
-    indent_down();
-    indent(out) << "} _" << tstruct->get_name() << "__isset;" << endl;
+    generate_isset_declaration(out, tstruct);
   }
 
   out << endl;
@@ -1169,7 +1278,9 @@ void t_cpp_generator::generate_struct_declaration(ostream& out,
     std::string args_indent(
       indent().size() + clsname_ctor.size() + (has_default_value ? 3 : -1), ' ');
 
-    for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
+    // initializers must follow the declaration order
+    const vector<t_field*> layout = get_layout_members(tstruct);
+    for (m_iter = layout.begin(); m_iter != layout.end(); ++m_iter) {
       t_type* t = get_true_type((*m_iter)->get_type());
       if (t->is_base_type() || t->is_enum() || is_reference(*m_iter)) {
         string dval;
@@ -1217,7 +1328,8 @@ void t_cpp_generator::generate_struct_declaration(ostream& out,
   }
 
   // Declare all fields
-  for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
+  const vector<t_field*> layout = get_layout_members(tstruct);
+  for (m_iter = layout.begin(); m_iter != layout.end(); ++m_iter) {
 	generate_java_doc(out, *m_iter);
     indent(out) << declare_field(*m_iter,
                                  false,
@@ -1255,12 +1367,26 @@ void t_cpp_generator::generate_struct_declaration(ostream& out,
       out << indent() << "bool operator == (const " << tstruct->get_name() << " & "
           << (members.size() > 0 ? "rhs" : "/* rhs */") << ") const" << endl;
       scope_up(out);
+      bool has_optional_fields = false;
+      for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
+        if ((*m_iter)->get_req() == t_field::T_OPTIONAL)
+          has_optional_fields = true;
+      }
+      if (gen_compact_layout_ && has_optional_fields) {
+        // the presence of every optional field in one go
+        out << indent() << "if (!__isset.__equal_optional(rhs.__isset))" << endl << indent()
+            << "  return false;" << endl;
+      }
       for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
         // Most existing Thrift code does not use isset or optional/required,
         // so we treat "default" fields as required.
         if ((*m_iter)->get_req() != t_field::T_OPTIONAL) {
           out << indent() << "if (!(" << (*m_iter)->get_name() << " == rhs."
               << (*m_iter)->get_name() << "))" << endl << indent() << "  return false;" << endl;
+        } else if (gen_compact_layout_) {
+          out << indent() << "if (__isset." << (*m_iter)->get_name() << " && !("
+              << (*m_iter)->get_name() << " == rhs." << (*m_iter)->get_name() << "))" << endl
+              << indent() << "  return false;" << endl;
         } else {
           out << indent() << "if (__isset." << (*m_iter)->get_name() << " != rhs.__isset."
               << (*m_iter)->get_name() << ")" << endl << indent() << "  return false;" << endl
@@ -1306,6 +1432,10 @@ void t_cpp_generator::generate_struct_declaration(ostream& out,
         out << " override";
       out << ';' << endl;
     }
+    if (gen_serialized_size_ && is_user_struct) {
+      out << indent() << "template <class Protocol_>" << endl << indent()
+          << "uint32_t serializedSize() const;" << endl;
+    }
   }
   out << endl;
 
@@ -1646,6 +1776,297 @@ void t_cpp_generator::generate_struct_result_writer(ostream& out,
   indent(out) << "}" << endl << endl;
 }
 
+/**
+ * Generates serializedSize<Protocol_>(), which returns the number of bytes
+ * write() would produce with Protocol_ without writing anything.  Protocol_
+ * must provide the static size functions of TBinaryProtocolT and
+ * TCompactProtocolT.  The definition goes to the end of the types header so
+ * that structs reached through cpp.ref fields are complete.
+ *
+ * @param out Stream to write to
+ * @param tstruct The struct
+ */
+void t_cpp_generator::generate_struct_serialized_size(ostream& out, t_struct* tstruct) {
+  const vector<t_field*>& fields = tstruct->get_sorted_members();
+  vector<t_field*>::const_iterator f_iter;
+
+  out << indent() << "template <class Protocol_>" << endl << indent() << "uint32_t "
+      << tstruct->get_name() << "::serializedSize() const {" << endl;
+  indent_up();
+
+  out << indent() << "uint32_t xfer = 0;" << endl;
+  if (!fields.empty()) {
+    out << indent() << "int16_t lastFieldId = 0;" << endl;
+  }
+
+  for (f_iter = fields.begin(); f_iter != fields.end(); ++f_iter) {
+    bool check_if_set = (*f_iter)->get_req() == t_field::T_OPTIONAL
+                        || (*f_iter)->get_type()->is_xception();
+    if (check_if_set) {
+      out << endl << indent() << "if (this->__isset." << (*f_iter)->get_name() << ") {" << endl;
+      indent_up();
+    } else {
+      out << endl;
+    }
+
+    t_type* type = get_true_type((*f_iter)->get_type());
+    if (type->is_bool()) {
+      // Compact folds the value into the field header
+      out << indent() << "xfer += Protocol_::sizeBoolField(" << (*f_iter)->get_key()
+          << ", lastFieldId);" << endl;
+    } else {
+      out << indent() << "xfer += Protocol_::sizeFieldBegin(" << type_to_enum(type) << ", "
+          << (*f_iter)->get_key() << ", lastFieldId);" << endl;
+      generate_serialized_size_value(out,
+                                     type,
+                                     "this->" + (*f_iter)->get_name(),
+                                     is_reference(*f_iter));
+    }
+
+    if (check_if_set) {
+      indent_down();
+      indent(out) << '}' << endl;
+    }
+  }
+
+  out << endl << indent() << "xfer += Protocol_::sizeFieldStop();" << endl << indent()
+      << "return xfer;" << endl;
+
+  indent_down();
+  indent(out) << "}" << endl << endl;
+}
+
+/**
+ * Adds the encoded size of one value to xfer.  Lists, sets and maps of
+ * fixed-width values are sized with a multiply when Protocol_ encodes them
+ * at a fixed width.
+ */
+void t_cpp_generator::generate_serialized_size_value(ostream& out,
+                                                     t_type* ttype,
+                                                     string name,
+                                                     bool pointer) {
+  t_type* type = get_true_type(ttype);
+
+  if (type->is_struct() || type->is_xception()) {
+    if (pointer) {
+      // write() emits an empty struct for a null reference
+      indent(out) << "xfer += " << name << " ? " << name
+                  << "->serializedSize<Protocol_>() : Protocol_::sizeFieldStop();" << endl;
+    } else {
+      indent(out) << "xfer += " << name << ".serializedSize<Protocol_>();" << endl;
+    }
+  } else if (type->is_map()) {
+    t_type* ktype = get_true_type(((t_map*)type)->get_key_type());
+    t_type* vtype = get_true_type(((t_map*)type)->get_val_type());
+    string size = "static_cast<uint32_t>(" + name + ".size())";
+    string iter = tmp("_iter");
+    scope_up(out);
+    indent(out) << "xfer += Protocol_::sizeMapBegin(" << size << ");" << endl;
+    bool fixed = !serialized_size_call(ktype, "").empty() && !serialized_size_call(vtype, "").empty();
+    if (fixed) {
+      string kwidth = tmp("_kwidth");
+      string vwidth = tmp("_vwidth");
+      indent(out) << "const uint32_t " << kwidth << " = Protocol_::fixedSize(" << type_to_enum(ktype)
+                  << ");" << endl;
+      indent(out) << "const uint32_t " << vwidth << " = Protocol_::fixedSize(" << type_to_enum(vtype)
+                  << ");" << endl;
+      indent(out) << "if (" << kwidth << " != 0 && " << vwidth << " != 0) {" << endl;
+      indent_up();
+      indent(out) << "xfer += (" << kwidth << " + " << vwidth << ") * " << size << ";" << endl;
+      indent_down();
+      indent(out) << "} else {" << endl;
+      indent_up();
+    }
+    indent(out) << "for (const auto& " << iter << " : " << name << ") {" << endl;
+    indent_up();
+    generate_serialized_size_value(out, ktype, iter + ".first");
+    generate_serialized_size_value(out, vtype, iter + ".second");
+    indent_down();
+    indent(out) << "}" << endl;
+    if (fixed) {
+      indent_down();
+      indent(out) << "}" << endl;
+    }
+    scope_down(out);
+  } else if (type->is_list() || type->is_set()) {
+    t_type* etype = get_true_type(type->is_list() ? ((t_list*)type)->get_elem_type()
+                                                  : ((t_set*)type)->get_elem_type());
+    string size = "static_cast<uint32_t>(" + name + ".size())";
+    string iter = tmp("_iter");
+    scope_up(out);
+    indent(out) << "xfer += Protocol_::" << (type->is_list() ? "sizeListBegin(" : "sizeSetBegin(")
+                << size << ");" << endl;
+    bool fixed = !serialized_size_call(etype, "").empty();
+    if (fixed) {
+      string width = tmp("_width");
+      indent(out) << "const uint32_t " << width << " = Protocol_::fixedSize(" << type_to_enum(etype)
+                  << ");" << endl;
+      indent(out) << "if (" << width << " != 0) {" << endl;
+      indent_up();
+      indent(out) << "xfer += " << width << " * " << size << ";" << endl;
+      indent_down();
+      indent(out) << "} else {" << endl;
+      indent_up();
+    }
+    indent(out) << "for (const auto& " << iter << " : " << name << ") {" << endl;
+    indent_up();
+    generate_serialized_size_value(out, etype, iter);
+    indent_down();
+    indent(out) << "}" << endl;
+    if (fixed) {
+      indent_down();
+      indent(out) << "}" << endl;
+    }
+    scope_down(out);
+  } else if (type->is_string()) {
+    indent(out) << "xfer += Protocol_::" << (type->is_binary() ? "sizeBinary(" : "sizeString(")
+                << name << ");" << endl;
+  } else if (type->is_base_type() || type->is_enum()) {
+    indent(out) << "xfer += " << serialized_size_call(type, name) << ";" << endl;
+  } else {
+    throw "compiler error: no C++ size for type " + type_name(type) + " of " + name;
+  }
+}
+
+/**
+ * Returns the Protocol_ size call for a value whose width depends only on
+ * its type under some protocols, or "" for strings, structs and containers.
+ */
+string t_cpp_generator::serialized_size_call(t_type* ttype, string name) {
+  t_type* type = get_true_type(ttype);
+  if (type->is_enum()) {
+    return "Protocol_::sizeI32(static_cast<int32_t>(" + name + "))";
+  }
+  if (!type->is_base_type()) {
+    return "";
+  }
+  switch (((t_base_type*)type)->get_base()) {
+  case t_base_type::TYPE_BOOL:
+    return "Protocol_::sizeBool(" + name + ")";
+  case t_base_type::TYPE_I8:
+    return "Protocol_::sizeByte(" + name + ")";
+  case t_base_type::TYPE_I16:
+    return "Protocol_::sizeI16(" + name + ")";
+  case t_base_type::TYPE_I32:
+    return "Protocol_::sizeI32(" + name + ")";
+  case t_base_type::TYPE_I64:
+    return "Protocol_::sizeI64(" + name + ")";
+  case t_base_type::TYPE_DOUBLE:
+    return "Protocol_::sizeDouble(" + name + ")";
+  default:
+    return "";
+  }
+}
+
+/**
+ * Generates FooView<Reader_>, a read-only view of an encoded Foo with one
+ * accessor per field, and has_<field>() for its presence. An unset field
+ * reads as its default value; strings come back as TStringView, structs as
+ * their views and containers as TListView, TSetView and TMapView.
+ *
+ * @param out Stream to write to
+ * @param tstruct The struct
+ */
+void t_cpp_generator::generate_struct_view(ostream& out, t_struct* tstruct) {
+  const vector<t_field*>& fields = tstruct->get_members();
+  vector<t_field*>::const_iterator f_iter;
+  string view_name = tstruct->get_name() + "View";
+  std::ostringstream base;
+  base << "::apache::thrift::protocol::TStructView<" << view_name << "<Reader_>, Reader_, "
+       << fields.size() << ">";
+
+  indent(out) << "template <class Reader_>" << endl;
+  indent(out) << "class " << view_name << endl;
+  indent(out) << "  : public " << base.str() << " {" << endl;
+  indent(out) << " public:" << endl;
+  indent_up();
+  indent(out) << view_name << "() {}" << endl;
+  indent(out) << view_name << "(const uint8_t* data, uint32_t size)" << endl;
+  indent(out) << "  : " << base.str() << "(data, size) {}" << endl;
+
+  size_t slot = 0;
+  for (f_iter = fields.begin(); f_iter != fields.end(); ++f_iter, ++slot) {
+    t_type* type = get_true_type((*f_iter)->get_type());
+    string value_type = view_type_name(type);
+    string default_value;
+    if ((*f_iter)->get_value() != nullptr && (type->is_base_type() || type->is_enum())) {
+      default_value = render_const_value(out, (*f_iter)->get_name(), type, (*f_iter)->get_value());
+    } else if (type->is_enum()) {
+      default_value = "static_cast<" + value_type + ">(0)";
+    } else if (type->is_base_type() && !type->is_string()) {
+      default_value = type->is_bool() ? "false" : "0";
+    } else {
+      default_value = value_type + "()";
+    }
+
+    out << endl;
+    indent(out) << "bool has_" << (*f_iter)->get_name() << "() const {" << endl;
+    indent(out) << "  return this->__field(" << slot << ") != nullptr;" << endl;
+    indent(out) << "}" << endl;
+    indent(out) << value_type << " " << (*f_iter)->get_name() << "() const {" << endl;
+    indent(out) << "  return this->template __get<" << value_type << ">(" << slot << ", "
+                << default_value << ");" << endl;
+    indent(out) << "}" << endl;
+  }
+
+  // Maps the id and wire type of each field to its slot in the index
+  out << endl;
+  indent(out) << "static int __slot(int16_t fid, ::apache::thrift::protocol::TType ftype) {" << endl;
+  indent_up();
+  if (fields.empty()) {
+    indent(out) << "(void)fid;" << endl;
+    indent(out) << "(void)ftype;" << endl;
+    indent(out) << "return -1;" << endl;
+  } else {
+    indent(out) << "switch (fid) {" << endl;
+    slot = 0;
+    for (f_iter = fields.begin(); f_iter != fields.end(); ++f_iter, ++slot) {
+      indent(out) << "case " << (*f_iter)->get_key() << ":" << endl;
+      indent(out) << "  return ftype == " << type_to_enum((*f_iter)->get_type()) << " ? " << slot
+                  << " : -1;" << endl;
+    }
+    indent(out) << "default:" << endl;
+    indent(out) << "  return -1;" << endl;
+    indent(out) << "}" << endl;
+  }
+  indent_down();
+  indent(out) << "}" << endl;
+
+  indent_down();
+  indent(out) << "};" << endl << endl;
+}
+
+/**
+ * Returns the type a view returns for a value of ttype
+ */
+string t_cpp_generator::view_type_name(t_type* ttype) {
+  t_type* type = get_true_type(ttype);
+  if (type->is_string()) {
+    return "::apache::thrift::protocol::TStringView";
+  } else if (type->is_base_type()) {
+    return base_type_name(((t_base_type*)type)->get_base());
+  } else if (type->is_enum()) {
+    return type_name(type);
+  } else if (type->is_map()) {
+    return "::apache::thrift::protocol::TMapView<Reader_, "
+           + view_type_name(((t_map*)type)->get_key_type()) + ", "
+           + view_type_name(((t_map*)type)->get_val_type()) + " >";
+  } else if (type->is_set()) {
+    return "::apache::thrift::protocol::TSetView<Reader_, "
+           + view_type_name(((t_set*)type)->get_elem_type()) + " >";
+  } else if (type->is_list()) {
+    return "::apache::thrift::protocol::TListView<Reader_, "
+           + view_type_name(((t_list*)type)->get_elem_type()) + " >";
+  }
+
+  t_program* program = type->get_program();
+  string pname = type->get_name() + "View<Reader_>";
+  if (program != nullptr && program != program_) {
+    pname = namespace_prefix(program->get_namespace("cpp")) + pname;
+  }
+  return pname;
+}
+
 /**
  * Generates the swap function.
  *
@@ -1873,6 +2294,12 @@ void t_cpp_generator::generate_service(t_service* tservice) {
   if (gen_cob_style_) {
     f_header_ << "#include <thrift/async/TAsyncDispatchProcessor.h>" << endl;
   }
+  if (gen_coroutines_) {
+    if (!gen_cob_style_) {
+      f_header_ << "#include <thrift/async/TAsyncDispatchProcessor.h>" << endl;
+    }
+    f_header_ << "#include <thrift/async/TCoroChannel.h>" << endl;
+  }
   f_header_ << "#include <thrift/async/TConcurrentClientSyncInfo.h>" << endl;
   f_header_ << "#include <memory>" << endl;
   f_header_ << "#include \"" << get_include_prefix(*get_program()) << program_name_ << "_types.h\""
@@ -1950,6 +2377,14 @@ void t_cpp_generator::generate_service(t_service* tservice) {
 
   }
 
+  // Generate the coroutine components
+  if (gen_coroutines_) {
+    generate_service_interface(tservice, "Coro");
+    generate_service_interface_factory(tservice, "Coro");
+    generate_service_coro_client(tservice);
+    generate_service_processor(tservice, "Coro");
+  }
+
   f_header_ << "#ifdef _MSC_VER\n"
                "  #pragma warning( pop )\n"
                "#endif\n\n";
@@ -1996,6 +2431,9 @@ void t_cpp_generator::generate_service_helpers(t_service* tservice) {
     generate_struct_definition(out, f_service_, ts, false);
     generate_struct_reader(out, ts);
     generate_struct_writer(out, ts);
+    if (gen_views_) {
+      generate_struct_view(f_views_, ts);
+    }
     ts->set_name(tservice->get_name() + "_" + (*f_iter)->get_name() + "_pargs");
     generate_struct_declaration(f_header_, ts, false, true, false, true);
     generate_struct_definition(out, f_service_, ts, false);
@@ -3010,6 +3448,196 @@ void t_cpp_generator::generate_service_client(t_service* tservice, string style)
   }
 }
 
+/**
+ * Generates the coroutine client for a service.  Every call serializes its
+ * arguments before returning the task, into buffers owned by that call, so
+ * any number of calls may be outstanding on one client.
+ *
+ * @param tservice The service to generate a client for
+ */
+void t_cpp_generator::generate_service_coro_client(t_service* tservice) {
+  string client_name = service_name_ + "CoroClient";
+  string channel_type = "::std::shared_ptr< ::apache::thrift::async::TCoroChannel>";
+  string factory_type = "::std::shared_ptr< ::apache::thrift::protocol::TProtocolFactory>";
+  string request_type = "std::unique_ptr< ::apache::thrift::async::TCoroRequest>";
+
+  string extends = "";
+  string extends_client = "";
+  if (tservice->get_extends() != nullptr) {
+    extends = type_name(tservice->get_extends()) + "CoroClient";
+    extends_client = ", public " + extends;
+  }
+
+  // Generate the header portion
+  f_header_ << "class " << client_name << " : virtual public " << service_name_ << "CoroIf"
+            << extends_client << " {" << endl << " public:" << endl;
+  indent_up();
+  f_header_ << indent() << client_name << "(" << channel_type << " channel, " << factory_type
+            << " protocolFactory) :" << endl;
+  if (extends.empty()) {
+    f_header_ << indent() << "  channel_(channel)," << endl << indent()
+              << "  protocolFactory_(protocolFactory)," << endl << indent() << "  seqid_(0) {}"
+              << endl;
+  } else {
+    f_header_ << indent() << "  " << extends << "(channel, protocolFactory) {}" << endl;
+  }
+  f_header_ << indent() << channel_type << " getChannel() {" << endl << indent()
+            << "  return channel_;" << endl << indent() << "}" << endl;
+
+  vector<t_function*> functions = tservice->get_functions();
+  vector<t_function*>::const_iterator f_iter;
+  for (f_iter = functions.begin(); f_iter != functions.end(); ++f_iter) {
+    generate_java_doc(f_header_, *f_iter);
+    indent(f_header_) << function_signature(*f_iter, "Coro") << " override;" << endl;
+    indent(f_header_) << "void send_" << (*f_iter)->get_name()
+                      << "(::apache::thrift::protocol::TProtocol* oprot, int32_t cseqid"
+                      << argument_list((*f_iter)->get_arglist(), true, true) << ");" << endl;
+    if (!(*f_iter)->is_oneway()) {
+      indent(f_header_) << "::apache::thrift::async::TTask<"
+                        << type_name((*f_iter)->get_returntype()) << "> recv_"
+                        << (*f_iter)->get_name() << "(" << request_type
+                        << " request, int32_t cseqid);" << endl;
+    }
+  }
+  indent_down();
+
+  if (extends.empty()) {
+    f_header_ << " protected:" << endl;
+    indent_up();
+    f_header_ << indent() << channel_type << " channel_;" << endl << indent() << factory_type
+              << " protocolFactory_;" << endl << indent() << "int32_t seqid_;" << endl;
+    indent_down();
+  }
+  f_header_ << "};" << endl << endl;
+
+  string scope = client_name + "::";
+
+  // Generate client method implementations
+  for (f_iter = functions.begin(); f_iter != functions.end(); ++f_iter) {
+    string funname = (*f_iter)->get_name();
+    const vector<t_field*>& fields = (*f_iter)->get_arglist()->get_members();
+    vector<t_field*>::const_iterator fld_iter;
+
+    f_service_ << function_signature(*f_iter, "Coro", scope) << endl;
+    scope_up(f_service_);
+    f_service_ << indent() << request_type << " request(new ::apache::thrift::async::TCoroRequest("
+               << "protocolFactory_.get()));" << endl;
+    if ((*f_iter)->is_oneway()) {
+      f_service_ << indent() << "send_" << funname << "(request->getOutputProtocol(), 0";
+    } else {
+      f_service_ << indent() << "int32_t cseqid = ++seqid_;" << endl << indent() << "send_"
+                 << funname << "(request->getOutputProtocol(), cseqid";
+    }
+    for (fld_iter = fields.begin(); fld_iter != fields.end(); ++fld_iter) {
+      f_service_ << ", " << (*fld_iter)->get_name();
+    }
+    f_service_ << ");" << endl;
+    if ((*f_iter)->is_oneway()) {
+      f_service_ << indent() << "return channel_->sendRequest(std::move(request));" << endl;
+    } else {
+      f_service_ << indent() << "return recv_" << funname << "(std::move(request), cseqid);"
+                 << endl;
+    }
+    scope_down(f_service_);
+    f_service_ << endl;
+
+    // Function for sending
+    string argsname = tservice->get_name() + "_" + funname + "_pargs";
+    f_service_ << "void " << scope << "send_" << funname
+               << "(::apache::thrift::protocol::TProtocol* oprot, int32_t cseqid"
+               << argument_list((*f_iter)->get_arglist(), true, true) << ")" << endl;
+    scope_up(f_service_);
+    f_service_ << indent() << "oprot->writeMessageBegin(\"" << funname
+               << "\", ::apache::thrift::protocol::"
+               << ((*f_iter)->is_oneway() ? "T_ONEWAY" : "T_CALL") << ", cseqid);" << endl
+               << endl << indent() << argsname << " args;" << endl;
+    for (fld_iter = fields.begin(); fld_iter != fields.end(); ++fld_iter) {
+      f_service_ << indent() << "args." << (*fld_iter)->get_name() << " = &"
+                 << (*fld_iter)->get_name() << ";" << endl;
+    }
+    f_service_ << indent() << "args.write(oprot);" << endl << endl << indent()
+               << "oprot->writeMessageEnd();" << endl << indent()
+               << "oprot->getTransport()->writeEnd();" << endl << indent()
+               << "oprot->getTransport()->flush();" << endl;
+    scope_down(f_service_);
+    f_service_ << endl;
+
+    if ((*f_iter)->is_oneway()) {
+      continue;
+    }
+
+    // Function for waiting for and reading the reply
+    t_type* rtype = (*f_iter)->get_returntype();
+    string resultname = tservice->get_name() + "_" + funname + "_presult";
+    f_service_ << "::apache::thrift::async::TTask<" << type_name(rtype) << "> " << scope
+               << "recv_" << funname << "(" << request_type << " request, int32_t cseqid)"
+               << endl;
+    scope_up(f_service_);
+    f_service_ << indent() << "co_await channel_->sendAndRecvMessage(request->getSendBuffer(), "
+               << "request->getRecvBuffer());" << endl << indent()
+               << "::apache::thrift::protocol::TProtocol* iprot = request->getInputProtocol();"
+               << endl << endl << indent() << "int32_t rseqid = 0;" << endl << indent()
+               << "std::string fname;" << endl << indent()
+               << "::apache::thrift::protocol::TMessageType mtype;" << endl << endl << indent()
+               << "iprot->readMessageBegin(fname, mtype, rseqid);" << endl << indent()
+               << "if (mtype == ::apache::thrift::protocol::T_EXCEPTION) {" << endl << indent()
+               << "  ::apache::thrift::TApplicationException x;" << endl << indent()
+               << "  x.read(iprot);" << endl << indent() << "  iprot->readMessageEnd();" << endl
+               << indent() << "  iprot->getTransport()->readEnd();" << endl << indent()
+               << "  throw x;" << endl << indent() << "}" << endl;
+
+    // Anything but the reply to this call is a protocol violation
+    string checks[][3] = {
+        {"mtype != ::apache::thrift::protocol::T_REPLY", "INVALID_MESSAGE_TYPE", "invalid message type"},
+        {"fname.compare(\"" + funname + "\") != 0", "WRONG_METHOD_NAME", "wrong method name"},
+        {"rseqid != cseqid", "BAD_SEQUENCE_ID", "out of sequence response"}};
+    for (auto& check : checks) {
+      f_service_ << indent() << "if (" << check[0] << ") {" << endl << indent()
+                 << "  iprot->skip(::apache::thrift::protocol::T_STRUCT);" << endl << indent()
+                 << "  iprot->readMessageEnd();" << endl << indent()
+                 << "  iprot->getTransport()->readEnd();" << endl << indent()
+                 << "  throw ::apache::thrift::TApplicationException("
+                 << "::apache::thrift::TApplicationException::" << check[1] << ", \"" << funname
+                 << " failed: " << check[2] << "\");" << endl << indent() << "}" << endl;
+    }
+
+    if (!rtype->is_void()) {
+      t_field returnfield(rtype, "_return");
+      f_service_ << indent() << declare_field(&returnfield) << endl;
+    }
+    f_service_ << indent() << resultname << " result;" << endl;
+    if (!rtype->is_void()) {
+      f_service_ << indent() << "result.success = &_return;" << endl;
+    }
+    f_service_ << indent() << "result.read(iprot);" << endl << indent()
+               << "iprot->readMessageEnd();" << endl << indent()
+               << "iprot->getTransport()->readEnd();" << endl << endl;
+
+    if (!rtype->is_void()) {
+      f_service_ << indent() << "if (result.__isset.success) {" << endl << indent()
+                 << "  co_return _return;" << endl << indent() << "}" << endl;
+    }
+
+    const std::vector<t_field*>& xceptions = (*f_iter)->get_xceptions()->get_members();
+    vector<t_field*>::const_iterator x_iter;
+    for (x_iter = xceptions.begin(); x_iter != xceptions.end(); ++x_iter) {
+      f_service_ << indent() << "if (result.__isset." << (*x_iter)->get_name() << ") {" << endl
+                 << indent() << "  throw result." << (*x_iter)->get_name() << ";" << endl
+                 << indent() << "}" << endl;
+    }
+
+    if (rtype->is_void()) {
+      f_service_ << indent() << "co_return;" << endl;
+    } else {
+      f_service_ << indent() << "throw ::apache::thrift::TApplicationException("
+                 << "::apache::thrift::TApplicationException::MISSING_RESULT, \"" << funname
+                 << " failed: unknown result\");" << endl;
+    }
+    scope_down(f_service_);
+    f_service_ << endl;
+  }
+}
+
 class ProcessorGenerator {
 public:
   ProcessorGenerator(t_cpp_generator* generator, t_service* service, const string& style);
@@ -3019,7 +3647,7 @@ public:
 
     // Generate the dispatchCall() function
     generate_dispatch_call(false);
-    if (generator_->gen_templates_) {
+    if (templates_) {
       generate_dispatch_call(true);
     }
 
@@ -3067,6 +3695,8 @@ protected:
   string typename_str_;
   string class_suffix_;
   string extends_;
+  bool async_;
+  bool templates_;
 };
 
 ProcessorGenerator::ProcessorGenerator(t_cpp_generator* generator,
@@ -3075,13 +3705,17 @@ ProcessorGenerator::ProcessorGenerator(t_cpp_generator* generator,
   : generator_(generator),
     service_(service),
     f_header_(generator->f_header_),
-    f_out_(generator->gen_templates_ ? generator->f_service_tcc_ : generator->f_service_),
+    f_out_(generator->gen_templates_ && style != "Coro" ? generator->f_service_tcc_
+                                                        : generator->f_service_),
     service_name_(generator->service_name_),
-    style_(style) {
-  if (style_ == "Cob") {
-    pstyle_ = "Async";
+    style_(style),
+    async_(style == "Cob" || style == "Coro"),
+    // Coroutine processors only come in the generic TProtocol flavour
+    templates_(generator->gen_templates_ && style != "Coro") {
+  if (async_) {
+    pstyle_ = (style_ == "Cob" ? "Async" : "Coro");
     class_name_ = service_name_ + pstyle_ + "Processor";
-    if_name_ = service_name_ + "CobSvIf";
+    if_name_ = service_name_ + (style_ == "Cob" ? "CobSvIf" : "CoroIf");
 
     finish_cob_ = "::std::function<void(bool ok)> cob, ";
     finish_cob_decl_ = "::std::function<void(bool ok)>, ";
@@ -3100,7 +3734,7 @@ ProcessorGenerator::ProcessorGenerator(t_cpp_generator* generator,
 
   factory_class_name_ = class_name_ + "Factory";
 
-  if (generator->gen_templates_) {
+  if (templates_) {
     template_header_ = "template <class Protocol_>\n";
     template_suffix_ = "<Protocol_>";
     typename_str_ = "typename ";
@@ -3110,7 +3744,7 @@ ProcessorGenerator::ProcessorGenerator(t_cpp_generator* generator,
 
   if (service_->get_extends() != nullptr) {
     extends_ = type_name(service_->get_extends()) + pstyle_ + "Processor";
-    if (generator_->gen_templates_) {
+    if (templates_) {
       // TODO(simpkins): If gen_templates_ is enabled, we currently assume all
       // parent services were also generated with templates enabled.
       extends_ += "T<Protocol_>";
@@ -3127,13 +3761,13 @@ void ProcessorGenerator::generate_class_definition() {
   if (service_->get_extends() != nullptr) {
     parent_class = extends_;
   } else {
-    if (style_ == "Cob") {
+    if (async_) {
       parent_class = "::apache::thrift::async::TAsyncDispatchProcessor";
     } else {
       parent_class = "::apache::thrift::TDispatchProcessor";
     }
 
-    if (generator_->gen_templates_) {
+    if (templates_) {
       parent_class += "T<Protocol_>";
     }
   }
@@ -3151,7 +3785,7 @@ void ProcessorGenerator::generate_class_definition() {
             << "::apache::thrift::protocol::TProtocol* oprot, "
             << "const std::string& fname, int32_t seqid" << call_context_ 
             << ") override;" << endl;
-  if (generator_->gen_templates_) {
+  if (templates_) {
     f_header_ << indent() << "virtual " << ret_type_ << "dispatchCallTemplated(" << finish_cob_
               << "Protocol_* iprot, Protocol_* oprot, "
               << "const std::string& fname, int32_t seqid" << call_context_ << ");" << endl;
@@ -3167,7 +3801,7 @@ void ProcessorGenerator::generate_class_definition() {
             << "ProcessFunction)(" << finish_cob_decl_ << "int32_t, "
             << "::apache::thrift::protocol::TProtocol*, "
             << "::apache::thrift::protocol::TProtocol*" << call_context_decl_ << ");" << endl;
-  if (generator_->gen_templates_) {
+  if (templates_) {
     f_header_ << indent() << "typedef void (" << class_name_ << "::*"
               << "SpecializedProcessFunction)(" << finish_cob_decl_ << "int32_t, "
               << "Protocol_*, Protocol_*" << call_context_decl_ << ");" << endl << indent()
@@ -3191,11 +3825,17 @@ void ProcessorGenerator::generate_class_definition() {
                       << "int32_t seqid, ::apache::thrift::protocol::TProtocol* iprot, "
                          "::apache::thrift::protocol::TProtocol* oprot" << call_context_ << ");"
                       << endl;
-    if (generator_->gen_templates_) {
+    if (templates_) {
       indent(f_header_) << "void process_" << (*f_iter)->get_name() << "(" << finish_cob_
                         << "int32_t seqid, Protocol_* iprot, Protocol_* oprot" << call_context_
                         << ");" << endl;
     }
+    if (style_ == "Coro") {
+      f_header_ << indent() << "::apache::thrift::async::TTask<void> run_" << (*f_iter)->get_name()
+                << "(::std::function<void(bool ok)> cob, int32_t seqid, "
+                << "::apache::thrift::protocol::TProtocol* iprot, "
+                << "::apache::thrift::protocol::TProtocol* oprot);" << endl;
+    }
     if (style_ == "Cob") {
       // XXX Factor this out, even if it is a pain.
       string ret_arg = ((*f_iter)->get_returntype()->is_void()
@@ -3205,7 +3845,7 @@ void ProcessorGenerator::generate_class_definition() {
                 << "(::std::function<void(bool ok)> cob, int32_t seqid, "
                 << "::apache::thrift::protocol::TProtocol* oprot, "
                 << "void* ctx" << ret_arg << ");" << endl;
-      if (generator_->gen_templates_) {
+      if (templates_) {
         f_header_ << indent() << "void return_" << (*f_iter)->get_name()
                   << "(::std::function<void(bool ok)> cob, int32_t seqid, "
                   << "Protocol_* oprot, void* ctx" << ret_arg << ");" << endl;
@@ -3215,7 +3855,7 @@ void ProcessorGenerator::generate_class_definition() {
                 << "(::std::function<void(bool ok)> cob, int32_t seqid, "
                 << "::apache::thrift::protocol::TProtocol* oprot, void* ctx, "
                 << "::apache::thrift::TDelayedException* _throw);" << endl;
-      if (generator_->gen_templates_) {
+      if (templates_) {
         f_header_ << indent() << "void throw_" << (*f_iter)->get_name()
                   << "(::std::function<void(bool ok)> cob, int32_t seqid, "
                   << "Protocol_* oprot, void* ctx, "
@@ -3234,7 +3874,7 @@ void ProcessorGenerator::generate_class_definition() {
 
   for (f_iter = functions.begin(); f_iter != functions.end(); ++f_iter) {
     f_header_ << indent() << "processMap_[\"" << (*f_iter)->get_name() << "\"] = ";
-    if (generator_->gen_templates_) {
+    if (templates_) {
       f_header_ << "ProcessFunctions(" << endl;
       if (generator_->gen_templates_only_) {
         indent(f_header_) << "  nullptr," << endl;
@@ -3255,7 +3895,7 @@ void ProcessorGenerator::generate_class_definition() {
   indent_down();
   f_header_ << "};" << endl << endl;
 
-  if (generator_->gen_templates_) {
+  if (templates_) {
     // Generate a backwards compatible typedef, for callers who don't know
     // about the new template-style code.
     //
@@ -3307,21 +3947,21 @@ void ProcessorGenerator::generate_dispatch_call(bool template_protocol) {
            << "  oprot->writeMessageEnd();" << endl << indent()
            << "  oprot->getTransport()->writeEnd();" << endl << indent()
            << "  oprot->getTransport()->flush();" << endl << indent()
-           << (style_ == "Cob" ? "  return cob(true);" : "  return true;") << endl;
+           << (async_ ? "  return cob(true);" : "  return true;") << endl;
   } else {
     f_out_ << indent() << "  return " << extends_ << "::dispatchCall("
-           << (style_ == "Cob" ? "cob, " : "") << "iprot, oprot, fname, seqid" << call_context_arg_
+           << (async_ ? "cob, " : "") << "iprot, oprot, fname, seqid" << call_context_arg_
            << ");" << endl;
   }
   f_out_ << indent() << "}" << endl;
   if (template_protocol) {
     f_out_ << indent() << "(this->*(pfn->second.specialized))";
   } else {
-    if (generator_->gen_templates_only_) {
+    if (templates_ && generator_->gen_templates_only_) {
       // TODO: This is a null pointer, so nothing good will come from calling
       // it.  Throw an exception instead.
       f_out_ << indent() << "(this->*(pfn->second.generic))";
-    } else if (generator_->gen_templates_) {
+    } else if (templates_) {
       f_out_ << indent() << "(this->*(pfn->second.generic))";
     } else {
       f_out_ << indent() << "(this->*(pfn->second))";
@@ -3330,7 +3970,7 @@ void ProcessorGenerator::generate_dispatch_call(bool template_protocol) {
   f_out_ << "(" << cob_arg_ << "seqid, iprot, oprot" << call_context_arg_ << ");" << endl;
 
   // TODO(dreiss): return pfn ret?
-  if (style_ == "Cob") {
+  if (async_) {
     f_out_ << indent() << "return;" << endl;
   } else {
     f_out_ << indent() << "return true;" << endl;
@@ -3344,7 +3984,9 @@ void ProcessorGenerator::generate_process_functions() {
   vector<t_function*> functions = service_->get_functions();
   vector<t_function*>::iterator f_iter;
   for (f_iter = functions.begin(); f_iter != functions.end(); ++f_iter) {
-    if (generator_->gen_templates_) {
+    if (style_ == "Coro") {
+      generator_->generate_coro_process_function(service_, *f_iter);
+    } else if (templates_) {
       generator_->generate_process_function(service_, *f_iter, style_, false);
       generator_->generate_process_function(service_, *f_iter, style_, true);
     } else {
@@ -3358,7 +4000,7 @@ void ProcessorGenerator::generate_factory() {
 
   // Generate the factory class definition
   f_header_ << template_header_ << "class " << factory_class_name_ << " : public ::apache::thrift::"
-            << (style_ == "Cob" ? "async::TAsyncProcessorFactory" : "TProcessorFactory") << " {"
+            << (async_ ? "async::TAsyncProcessorFactory" : "TProcessorFactory") << " {"
             << endl << " public:" << endl;
   indent_up();
 
@@ -3366,7 +4008,7 @@ void ProcessorGenerator::generate_factory() {
             << " >& handlerFactory) noexcept :" << endl << indent()
             << "    handlerFactory_(handlerFactory) {}" << endl << endl << indent()
             << "::std::shared_ptr< ::apache::thrift::"
-            << (style_ == "Cob" ? "async::TAsyncProcessor" : "TProcessor") << " > "
+            << (async_ ? "async::TAsyncProcessor" : "TProcessor") << " > "
             << "getProcessor(const ::apache::thrift::TConnectionInfo& connInfo) override;"
             << endl;
 
@@ -3378,7 +4020,7 @@ void ProcessorGenerator::generate_factory() {
 
   // If we are generating templates, output a typedef for the plain
   // factory name.
-  if (generator_->gen_templates_) {
+  if (templates_) {
     f_header_ << "typedef " << factory_class_name_
               << "< ::apache::thrift::protocol::TDummyProtocol > " << service_name_ << pstyle_
               << "ProcessorFactory;" << endl << endl;
@@ -3386,7 +4028,7 @@ void ProcessorGenerator::generate_factory() {
 
   // Generate the getProcessor() method
   f_out_ << template_header_ << indent() << "::std::shared_ptr< ::apache::thrift::"
-         << (style_ == "Cob" ? "async::TAsyncProcessor" : "TProcessor") << " > "
+         << (async_ ? "async::TAsyncProcessor" : "TProcessor") << " > "
          << factory_class_name_ << template_suffix_ << "::getProcessor("
          << "const ::apache::thrift::TConnectionInfo& connInfo) {" << endl;
   indent_up();
@@ -3396,7 +4038,7 @@ void ProcessorGenerator::generate_factory() {
          << if_name_ << " > handler("
          << "handlerFactory_->getHandler(connInfo), cleanup);" << endl << indent()
          << "::std::shared_ptr< ::apache::thrift::"
-         << (style_ == "Cob" ? "async::TAsyncProcessor" : "TProcessor") << " > "
+         << (async_ ? "async::TAsyncProcessor" : "TProcessor") << " > "
          << "processor(new " << class_name_ << template_suffix_ << "(handler));" << endl << indent()
          << "return processor;" << endl;
 
@@ -3870,6 +4512,147 @@ void t_cpp_generator::generate_process_function(t_service* tservice,
   }   // cob style
 }
 
+/**
+ * Generates the process function of a coroutine processor.  The arguments
+ * are read before run_ first suspends, while iprot is still valid; the reply
+ * is written once the handler's task completes.
+ *
+ * @param tfunction The function to write a dispatcher for
+ */
+void t_cpp_generator::generate_coro_process_function(t_service* tservice, t_function* tfunction) {
+  const std::vector<t_field*>& fields = tfunction->get_arglist()->get_members();
+  vector<t_field*>::const_iterator f_iter;
+  const std::vector<t_field*>& xceptions = tfunction->get_xceptions()->get_members();
+  vector<t_field*>::const_iterator x_iter;
+  string service_func_name = "\"" + tservice->get_name() + "." + tfunction->get_name() + "\"";
+  string class_name = tservice->get_name() + "CoroProcessor";
+  string prot_type = "::apache::thrift::protocol::TProtocol";
+  std::ostream& out = f_service_;
+
+  // Processor entry point
+  out << "void " << class_name << "::process_" << tfunction->get_name()
+      << "(::std::function<void(bool ok)> cob, int32_t seqid, " << prot_type << "* iprot, "
+      << prot_type << "* oprot)" << endl;
+  scope_up(out);
+  out << indent() << "run_" << tfunction->get_name()
+      << "(std::move(cob), seqid, iprot, oprot).detach();" << endl;
+  scope_down(out);
+  out << endl;
+
+  out << "::apache::thrift::async::TTask<void> " << class_name << "::run_" << tfunction->get_name()
+      << "(::std::function<void(bool ok)> cob, int32_t seqid, " << prot_type << "* iprot, "
+      << prot_type << "* oprot)" << endl;
+  scope_up(out);
+  if (tfunction->is_oneway()) {
+    out << indent() << "(void) seqid;" << endl << indent() << "(void) oprot;" << endl;
+  }
+  out << indent() << tservice->get_name() + "_" + tfunction->get_name() << "_args args;" << endl
+      << indent() << "void* ctx = nullptr;" << endl << indent()
+      << "if (this->eventHandler_.get() != nullptr) {" << endl << indent()
+      << "  ctx = this->eventHandler_->getContext(" << service_func_name << ", nullptr);" << endl
+      << indent() << "}" << endl << indent() << "::apache::thrift::TProcessorContextFreer freer("
+      << "this->eventHandler_.get(), ctx, " << service_func_name << ");" << endl << endl
+      << indent() << "try {" << endl;
+  indent_up();
+  out << indent() << "if (this->eventHandler_.get() != nullptr) {" << endl << indent()
+      << "  this->eventHandler_->preRead(ctx, " << service_func_name << ");" << endl << indent()
+      << "}" << endl << indent() << "args.read(iprot);" << endl << indent()
+      << "iprot->readMessageEnd();" << endl << indent()
+      << "uint32_t bytes = iprot->getTransport()->readEnd();" << endl << indent()
+      << "if (this->eventHandler_.get() != nullptr) {" << endl << indent()
+      << "  this->eventHandler_->postRead(ctx, " << service_func_name << ", bytes);" << endl
+      << indent() << "}" << endl;
+  indent_down();
+  out << indent() << "} catch (const std::exception&) {" << endl << indent()
+      << "  if (this->eventHandler_.get() != nullptr) {" << endl << indent()
+      << "    this->eventHandler_->handlerError(ctx, " << service_func_name << ");" << endl
+      << indent() << "  }" << endl << indent() << "  co_return cob(false);" << endl << indent()
+      << "}" << endl << endl;
+
+  if (!tfunction->is_oneway()) {
+    out << indent() << tservice->get_name() << "_" << tfunction->get_name() << "_result result;"
+        << endl;
+  }
+
+  // Await the handler
+  out << indent() << "try {" << endl;
+  indent_up();
+  out << indent();
+  if (!tfunction->is_oneway() && !tfunction->get_returntype()->is_void()) {
+    out << "result.success = ";
+  }
+  out << "co_await iface_->" << tfunction->get_name() << "(";
+  bool first = true;
+  for (f_iter = fields.begin(); f_iter != fields.end(); ++f_iter) {
+    if (first) {
+      first = false;
+    } else {
+      out << ", ";
+    }
+    out << "args." << (*f_iter)->get_name();
+  }
+  out << ");" << endl;
+  if (!tfunction->is_oneway() && !tfunction->get_returntype()->is_void()) {
+    out << indent() << "result.__isset.success = true;" << endl;
+  }
+  indent_down();
+  out << indent() << "}";
+
+  if (!tfunction->is_oneway()) {
+    for (x_iter = xceptions.begin(); x_iter != xceptions.end(); ++x_iter) {
+      out << " catch (" << type_name((*x_iter)->get_type()) << " &" << (*x_iter)->get_name()
+          << ") {" << endl;
+      indent_up();
+      out << indent() << "result." << (*x_iter)->get_name() << " = std::move("
+          << (*x_iter)->get_name() << ");" << endl << indent() << "result.__isset."
+          << (*x_iter)->get_name() << " = true;" << endl;
+      indent_down();
+      out << indent() << "}";
+    }
+    out << " catch (const std::exception& e) {" << endl;
+  } else {
+    out << " catch (const std::exception&) {" << endl;
+  }
+  indent_up();
+  out << indent() << "if (this->eventHandler_.get() != nullptr) {" << endl << indent()
+      << "  this->eventHandler_->handlerError(ctx, " << service_func_name << ");" << endl
+      << indent() << "}" << endl;
+  if (!tfunction->is_oneway()) {
+    out << endl << indent() << "::apache::thrift::TApplicationException x(e.what());" << endl
+        << indent() << "oprot->writeMessageBegin(\"" << tfunction->get_name()
+        << "\", ::apache::thrift::protocol::T_EXCEPTION, seqid);" << endl << indent()
+        << "x.write(oprot);" << endl << indent() << "oprot->writeMessageEnd();" << endl
+        << indent() << "oprot->getTransport()->writeEnd();" << endl << indent()
+        << "oprot->getTransport()->flush();" << endl;
+  }
+  out << indent() << "co_return cob(true);" << endl;
+  indent_down();
+  out << indent() << "}" << endl << endl;
+
+  if (tfunction->is_oneway()) {
+    out << indent() << "if (this->eventHandler_.get() != nullptr) {" << endl << indent()
+        << "  this->eventHandler_->asyncComplete(ctx, " << service_func_name << ");" << endl
+        << indent() << "}" << endl << indent() << "co_return cob(true);" << endl;
+    scope_down(out);
+    out << endl;
+    return;
+  }
+
+  // Serialize the result
+  out << indent() << "if (this->eventHandler_.get() != nullptr) {" << endl << indent()
+      << "  this->eventHandler_->preWrite(ctx, " << service_func_name << ");" << endl << indent()
+      << "}" << endl << endl << indent() << "oprot->writeMessageBegin(\"" << tfunction->get_name()
+      << "\", ::apache::thrift::protocol::T_REPLY, seqid);" << endl << indent()
+      << "result.write(oprot);" << endl << indent() << "oprot->writeMessageEnd();" << endl
+      << indent() << "uint32_t bytes = oprot->getTransport()->writeEnd();" << endl << indent()
+      << "oprot->getTransport()->flush();" << endl << endl << indent()
+      << "if (this->eventHandler_.get() != nullptr) {" << endl << indent()
+      << "  this->eventHandler_->postWrite(ctx, " << service_func_name << ", bytes);" << endl
+      << indent() << "}" << endl << indent() << "co_return cob(true);" << endl;
+  scope_down(out);
+  out << endl;
+}
+
 /**
  * Generates a skeleton file of a server
  *
@@ -4514,6 +5297,8 @@ string t_cpp_generator::declare_field(t_field* tfield,
   result += type_name(tfield->get_type());
   if (is_reference(tfield)) {
     result = "::std::shared_ptr<" + result + ">";
+  } else if (is_lazy(tfield) && !pointer) {
+    result = "::apache::thrift::TLazyStruct<" + result + ">";
   }
   if (pointer) {
     result += "*";
@@ -4600,6 +5385,9 @@ string t_cpp_generator::function_signature(t_function* tfunction,
 
     return "void " + prefix + tfunction->get_name() + "(::std::function<void" + cob_type + "> cob"
            + exn_cob + argument_list(arglist, name_params, true) + ")";
+  } else if (style == "Coro") {
+    return "::apache::thrift::async::TTask<" + type_name(ttype) + "> " + prefix
+           + tfunction->get_name() + "(" + argument_list(arglist, name_params) + ")";
   } else {
     throw "UNKNOWN STYLE";
   }
@@ -4684,6 +5472,8 @@ bool t_cpp_generator::is_struct_storage_not_throwing(t_struct* tstruct) const {
 
     if(type->is_enum())
       continue;
+    if(is_lazy(members[i]))
+      return false; // holds the encoded bytes
     if(type->is_xception())
       return false;
     if(type->is_base_type()) switch(((t_base_type*)type)->get_base()) {
@@ -4712,6 +5502,124 @@ bool t_cpp_generator::is_struct_storage_not_throwing(t_struct* tstruct) const {
   return true;
 }
 
+vector<t_field*> t_cpp_generator::get_layout_members(t_struct* tstruct) {
+  vector<t_field*> members = tstruct->get_members();
+  if (gen_compact_layout_) {
+    // widest first, so that the narrow fields share what would be padding;
+    // fields of the same alignment keep their IDL order
+    std::stable_sort(members.begin(), members.end(), [this](t_field* a, t_field* b) {
+      return get_field_alignment(a) > get_field_alignment(b);
+    });
+  }
+  return members;
+}
+
+int t_cpp_generator::get_field_alignment(t_field* tfield) {
+  t_type* type = get_true_type(tfield->get_type());
+  if (is_reference(tfield)) {
+    return 8;
+  }
+  if (type->is_enum()) {
+    return 4;
+  }
+  if (type->is_base_type()) {
+    switch (((t_base_type*)type)->get_base()) {
+    case t_base_type::TYPE_BOOL:
+    case t_base_type::TYPE_I8:
+      return 1;
+    case t_base_type::TYPE_I16:
+      return 2;
+    case t_base_type::TYPE_I32:
+      return 4;
+    default:
+      break;
+    }
+  }
+  // 64-bit values, strings, containers and structs
+  return 8;
+}
+
+/**
+ * Writes the declaration of a struct's __isset flags. By default each flag is
+ * a one bit bool. With compact_layout the flags are 64-bit bitfields: the
+ * optional fields come first and are padded out to a whole number of words,
+ * so that their presence can be compared with memcmp(), followed by the
+ * fields of default requiredness.
+ */
+void t_cpp_generator::generate_isset_declaration(ostream& out, t_struct* tstruct) {
+  const vector<t_field*>& members = tstruct->get_members();
+  vector<t_field*> flags;
+  vector<t_field*>::const_iterator m_iter;
+  size_t optional_count = 0;
+  for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
+    if (gen_compact_layout_ && (*m_iter)->get_req() == t_field::T_OPTIONAL) {
+      flags.insert(flags.begin() + optional_count++, *m_iter);
+    } else if ((*m_iter)->get_req() != t_field::T_REQUIRED) {
+      flags.push_back(*m_iter);
+    }
+  }
+  size_t optional_pad = optional_count % 64 == 0 ? 0 : 64 - optional_count % 64;
+  size_t default_count = flags.size() - optional_count;
+  size_t default_pad = default_count % 64 == 0 ? 0 : 64 - default_count % 64;
+
+  out << indent() << "typedef struct _" << tstruct->get_name() << "__isset {" << endl;
+  indent_up();
+
+  indent(out) << "_" << tstruct->get_name() << "__isset() ";
+  bool first = true;
+  for (m_iter = flags.begin(); m_iter != flags.end(); ++m_iter) {
+    string isSet = ((*m_iter)->get_value() != nullptr) ? "true" : "false";
+    out << (first ? ": " : ", ") << (*m_iter)->get_name() << "(" << isSet << ")";
+    first = false;
+    if (gen_compact_layout_ && optional_pad > 0
+        && m_iter - flags.begin() + 1 == static_cast<ptrdiff_t>(optional_count)) {
+      out << ", __optional_unused(0)";
+    }
+  }
+  if (gen_compact_layout_ && default_pad > 0) {
+    out << ", __default_unused(0)";
+  }
+  out << " {}" << endl;
+
+  if (!gen_compact_layout_) {
+    for (m_iter = flags.begin(); m_iter != flags.end(); ++m_iter) {
+      indent(out) << "bool " << (*m_iter)->get_name() << " :1;" << endl;
+    }
+  } else {
+    for (m_iter = flags.begin(); m_iter != flags.end(); ++m_iter) {
+      indent(out) << "uint64_t " << (*m_iter)->get_name() << " :1;" << endl;
+      if (optional_pad > 0
+          && m_iter - flags.begin() + 1 == static_cast<ptrdiff_t>(optional_count)) {
+        indent(out) << "uint64_t __optional_unused :" << optional_pad << ";" << endl;
+      }
+    }
+    if (default_pad > 0) {
+      indent(out) << "uint64_t __default_unused :" << default_pad << ";" << endl;
+    }
+
+    // every bit is named and initialized, so the words can be compared directly
+    out << endl;
+    indent(out) << "bool operator==(const _" << tstruct->get_name() << "__isset& rhs) const {"
+                << endl;
+    indent(out) << "  return ::memcmp(this, &rhs, sizeof(*this)) == 0;" << endl;
+    indent(out) << "}" << endl;
+    indent(out) << "bool operator!=(const _" << tstruct->get_name() << "__isset& rhs) const {"
+                << endl;
+    indent(out) << "  return !(*this == rhs);" << endl;
+    indent(out) << "}" << endl;
+    if (optional_count > 0) {
+      indent(out) << "bool __equal_optional(const _" << tstruct->get_name()
+                  << "__isset& rhs) const {" << endl;
+      indent(out) << "  return ::memcmp(this, &rhs, " << (optional_count + 63) / 64
+                  << " * sizeof(uint64_t)) == 0;" << endl;
+      indent(out) << "}" << endl;
+    }
+  }
+
+  indent_down();
+  indent(out) << "} _" << tstruct->get_name() << "__isset;" << endl;
+}
+
 
 string t_cpp_generator::get_include_prefix(const t_program& program) const {
   string include_prefix = program.get_include_prefix();
@@ -4750,6 +5658,7 @@ THRIFT_REGISTER_GENERATOR(
     cpp,
     "C++",
     "    cob_style:       Generate \"Continuation OBject\"-style classes.\n"
+    "    coroutines:      Generate C++20 coroutine clients, handler interfaces and processors.\n"
     "    no_client_completion:\n"
     "                     Omit calls to completion__() in CobClient class.\n"
     "    no_default_operators:\n"
@@ -4760,4 +5669,10 @@ THRIFT_REGISTER_GENERATOR(
     "    moveable_types:  Generate move constructors and assignment operators.\n"
     "    no_ostream_operators:\n"
     "                     Omit generation of ostream definitions.\n"
-    "    no_skeleton:     Omits generation of skeleton.\n")
+    "    no_skeleton:     Omits generation of skeleton.\n"
+    "    compact_layout:  Pack __isset flags into 64-bit words, order members by\n"
+    "                     alignment and compare presence with word compares.\n"
+    "    serialized_size: Generate serializedSize<Protocol_>() for the binary and compact\n"
+    "                     protocols, to reserve write buffers up front.\n"
+    "    views:           Generate read-only views of binary or compact encoded structs and\n"
+    "                     call arguments in <program>_views.h.\n")
@@ -385,13 +385,21 @@ private:
   int tmp_;
 };
 
+/**
+ * Notes a file written by a generator, so that it can be listed in the
+ * dependency file and the code generation cache
+ */
+void record_generated_file(const std::string& path);
+
 template<typename _CharT, typename _Traits = std::char_traits<_CharT> >
 class template_ofstream_with_content_based_conditional_update : public std::ostringstream {
 public:
   template_ofstream_with_content_based_conditional_update(): contents_written(false) {}
 
   template_ofstream_with_content_based_conditional_update(std::string const& output_file_path_)
-  : output_file_path(output_file_path_), contents_written(false) {}
+  : output_file_path(output_file_path_), contents_written(false) {
+    record_generated_file(output_file_path);
+  }
 
   ~template_ofstream_with_content_based_conditional_update() {
     if (!contents_written) {
@@ -403,6 +411,7 @@ public:
     output_file_path = output_file_path_;
     clear_buf();
     contents_written = false;
+    record_generated_file(output_file_path);
   }
 
   void close() {
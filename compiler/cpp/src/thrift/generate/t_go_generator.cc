@@ -63,7 +63,6 @@ static const string endl = "\n"; // avoid ostream << std::endl flushes
 bool format_go_output(const string& file_path);
 
 const string DEFAULT_THRIFT_IMPORT = "github.com/apache/thrift/lib/go/thrift";
-static std::string package_flag;
 
 /**
  * Go code generator.
@@ -80,20 +79,26 @@ public:
 
     gen_thrift_import_ = DEFAULT_THRIFT_IMPORT;
     gen_package_prefix_ = "";
-    package_flag = "";
+    package_flag_ = "";
     read_write_private_ = false;
     ignore_initialisms_ = false;
+    fast_paths_ = false;
+    pool_ = false;
     for( iter = parsed_options.begin(); iter != parsed_options.end(); ++iter) {
       if( iter->first.compare("package_prefix") == 0) {
         gen_package_prefix_ = (iter->second);
       } else if( iter->first.compare("thrift_import") == 0) {
         gen_thrift_import_ = (iter->second);
       } else if( iter->first.compare("package") == 0) {
-        package_flag = (iter->second);
+        package_flag_ = (iter->second);
       } else if( iter->first.compare("read_write_private") == 0) {
         read_write_private_ = true;
       } else if( iter->first.compare("ignore_initialisms") == 0) {
         ignore_initialisms_ =  true;
+      } else if( iter->first.compare("fast_paths") == 0) {
+        fast_paths_ = true;
+      } else if( iter->first.compare("pool") == 0) {
+        pool_ = true;
       } else {
         throw "unknown option go:" + iter->first;
       }
@@ -153,6 +158,8 @@ public:
                                  bool is_result = false,
                                  bool uses_countsetfields = false);
   void generate_go_struct_equals(std::ostream& out, t_struct* tstruct, const string& tstruct_name);
+  void generate_go_struct_reset(std::ostream& out, t_struct* tstruct, const string& tstruct_name);
+  void generate_go_struct_pool(std::ostream& out, const string& tstruct_name);
   void generate_go_function_helpers(t_function* tfunction);
   void get_publicized_name_and_def_value(t_field* tfield,
                                          string* OUT_pub_name,
@@ -279,10 +286,10 @@ public:
   std::string type_to_go_key_type(t_type* ttype);
   std::string type_to_spec_args(t_type* ttype);
 
-  static std::string get_real_go_module(const t_program* program) {
+  std::string get_real_go_module(const t_program* program) const {
 
-    if (!package_flag.empty()) {
-      return package_flag;
+    if (!package_flag_.empty()) {
+      return package_flag_;
     }
     std::string real_module = program->get_namespace("go");
     if (!real_module.empty()) {
@@ -295,8 +302,11 @@ public:
 private:
   std::string gen_package_prefix_;
   std::string gen_thrift_import_;
+  std::string package_flag_;
   bool read_write_private_;
   bool ignore_initialisms_;
+  bool fast_paths_;
+  bool pool_;
 
   /**
    * File streams
@@ -316,6 +326,10 @@ private:
   std::string write_method_name_;
   std::string equals_method_name_;
 
+  // The concrete protocol ("Binary" or "Compact") whose fast path is being
+  // generated, empty while generating for thrift.TProtocol
+  std::string fast_protocol_;
+
   std::set<std::string> commonInitialisms;
 
   std::string camelcase(const std::string& value) const;
@@ -327,6 +341,10 @@ private:
   static std::string variable_name_to_go_name(const std::string& value);
   static bool is_pointer_field(t_field* tfield, bool in_container = false);
   static bool omit_initialization(t_field* tfield);
+  std::string protocol_type() const;
+  std::string struct_read_method_name(t_struct* tstruct) const;
+  std::string struct_write_method_name(t_struct* tstruct) const;
+  void generate_fast_path_dispatch(std::ostream& out, const string& method, const string& prot);
 };
 
 // returns true if field initialization can be omitted since it has corresponding go type zero value
@@ -434,6 +452,30 @@ bool t_go_generator::is_pointer_field(t_field* tfield, bool in_container_value)
   throw "INVALID TYPE IN type_to_go_type: " + type->get_name();
 }
 
+// Type of the iprot and oprot parameters of the methods being generated
+std::string t_go_generator::protocol_type() const {
+  if (fast_protocol_.empty()) {
+    return "thrift.TProtocol";
+  }
+  return "*thrift.T" + fast_protocol_ + "Protocol";
+}
+
+// Structs of this program have fast paths of their own, structs of included
+// programs are read through their Read method, which dispatches again
+std::string t_go_generator::struct_read_method_name(t_struct* tstruct) const {
+  if (fast_protocol_.empty() || tstruct->get_program() != program_) {
+    return read_method_name_;
+  }
+  return "fastRead" + fast_protocol_;
+}
+
+std::string t_go_generator::struct_write_method_name(t_struct* tstruct) const {
+  if (fast_protocol_.empty() || tstruct->get_program() != program_) {
+    return write_method_name_;
+  }
+  return "fastWrite" + fast_protocol_;
+}
+
 std::string t_go_generator::camelcase(const std::string& value) const {
   std::string value2(value);
   std::setlocale(LC_ALL, "C"); // set locale to classic
@@ -928,6 +970,10 @@ string t_go_generator::go_imports_begin(bool consts) {
     system_packages.push_back("errors");
   }
   system_packages.push_back("fmt");
+  // Structs and exceptions get a pool each
+  if (!consts && pool_ && !get_program()->get_objects().empty()) {
+    system_packages.push_back("sync");
+  }
   system_packages.push_back("time");
   system_packages.push_back(gen_thrift_import_);
   return "import(\n" + render_system_packages(system_packages);
@@ -1490,9 +1536,22 @@ void t_go_generator::generate_go_struct_definition(ostream& out,
   generate_isset_helpers(out, tstruct, tstruct_name, is_result);
   generate_go_struct_reader(out, tstruct, tstruct_name, is_result);
   generate_go_struct_writer(out, tstruct, tstruct_name, is_result, num_setable > 0);
+  if (fast_paths_) {
+    const char* fast_protocols[] = {"Binary", "Compact"};
+    for (const char* fast_protocol : fast_protocols) {
+      fast_protocol_ = fast_protocol;
+      generate_go_struct_reader(out, tstruct, tstruct_name, is_result);
+      generate_go_struct_writer(out, tstruct, tstruct_name, is_result, num_setable > 0);
+    }
+    fast_protocol_.clear();
+  }
   if (!is_result && !is_args) {
     generate_go_struct_equals(out, tstruct, tstruct_name);
   }
+  if (pool_ && !is_result && !is_args) {
+    generate_go_struct_reset(out, tstruct, tstruct_name);
+    generate_go_struct_pool(out, tstruct_name);
+  }
 
   out << indent() << "func (p *" << tstruct_name << ") String() string {" << endl;
   out << indent() << "  if p == nil {" << endl;
@@ -1609,9 +1668,14 @@ void t_go_generator::generate_go_struct_reader(ostream& out,
   const vector<t_field*>& fields = tstruct->get_members();
   vector<t_field*>::const_iterator f_iter;
   string escaped_tstruct_name(escape_string(tstruct->get_name()));
-  out << indent() << "func (p *" << tstruct_name << ") " << read_method_name_ << "(ctx context.Context, iprot thrift.TProtocol) error {"
+  string read_method_name(fast_protocol_.empty() ? read_method_name_ : "fastRead" + fast_protocol_);
+  string field_method_base(fast_protocol_.empty() ? "ReadField" : "fastRead" + fast_protocol_ + "Field");
+  out << indent() << "func (p *" << tstruct_name << ") " << read_method_name << "(ctx context.Context, iprot " << protocol_type() << ") error {"
       << endl;
   indent_up();
+  if (fast_paths_ && fast_protocol_.empty()) {
+    generate_fast_path_dispatch(out, "fastRead", "iprot");
+  }
   out << indent() << "if _, err := iprot.ReadStructBegin(ctx); err != nil {" << endl;
   out << indent() << "  return thrift.PrependError(fmt.Sprintf(\"%T read error: \", p), err)"
       << endl;
@@ -1653,7 +1717,7 @@ void t_go_generator::generate_go_struct_reader(ostream& out,
     field_id = (*f_iter)->get_key();
 
     // if negative id, ensure we generate a valid method name
-    string field_method_prefix("ReadField");
+    string field_method_prefix(field_method_base);
     int32_t field_method_suffix = field_id;
 
     if (field_method_suffix < 0) {
@@ -1737,7 +1801,7 @@ void t_go_generator::generate_go_struct_reader(ostream& out,
   for (f_iter = fields.begin(); f_iter != fields.end(); ++f_iter) {
     string field_type_name(publicize((*f_iter)->get_type()->get_name()));
     string field_name(publicize((*f_iter)->get_name()));
-    string field_method_prefix("ReadField");
+    string field_method_prefix(field_method_base);
     int32_t field_id = (*f_iter)->get_key();
     int32_t field_method_suffix = field_id;
 
@@ -1747,7 +1811,7 @@ void t_go_generator::generate_go_struct_reader(ostream& out,
     }
 
     out << indent() << "func (p *" << tstruct_name << ")  " << field_method_prefix << field_method_suffix
-        << "(ctx context.Context, iprot thrift.TProtocol) error {" << endl;
+        << "(ctx context.Context, iprot " << protocol_type() << ") error {" << endl;
     indent_up();
     generate_deserialize_field(out, *f_iter, false, "p.");
     indent_down();
@@ -1765,8 +1829,13 @@ void t_go_generator::generate_go_struct_writer(ostream& out,
   string name(tstruct->get_name());
   const vector<t_field*>& fields = tstruct->get_sorted_members();
   vector<t_field*>::const_iterator f_iter;
-  indent(out) << "func (p *" << tstruct_name << ") " << write_method_name_ << "(ctx context.Context, oprot thrift.TProtocol) error {" << endl;
+  string write_method_name(fast_protocol_.empty() ? write_method_name_ : "fastWrite" + fast_protocol_);
+  string field_method_base(fast_protocol_.empty() ? "writeField" : "fastWrite" + fast_protocol_ + "Field");
+  indent(out) << "func (p *" << tstruct_name << ") " << write_method_name << "(ctx context.Context, oprot " << protocol_type() << ") error {" << endl;
   indent_up();
+  if (fast_paths_ && fast_protocol_.empty()) {
+    generate_fast_path_dispatch(out, "fastWrite", "oprot");
+  }
   if (tstruct->is_union() && uses_countsetfields) {
     std::string tstruct_name(publicize(tstruct->get_name()));
     out << indent() << "if c := p.CountSetFields" << tstruct_name << "(); c != 1 {" << endl
@@ -1788,7 +1857,7 @@ void t_go_generator::generate_go_struct_writer(ostream& out,
   indent_up();
 
   for (f_iter = fields.begin(); f_iter != fields.end(); ++f_iter) {
-    string field_method_prefix("writeField");
+    string field_method_prefix(field_method_base);
     field_name = (*f_iter)->get_name();
     escape_field_name = escape_string(field_name);
     field_id = (*f_iter)->get_key();
@@ -1816,7 +1885,7 @@ void t_go_generator::generate_go_struct_writer(ostream& out,
   out << indent() << "}" << endl << endl;
 
   for (f_iter = fields.begin(); f_iter != fields.end(); ++f_iter) {
-    string field_method_prefix("writeField");
+    string field_method_prefix(field_method_base);
     field_id = (*f_iter)->get_key();
     field_name = (*f_iter)->get_name();
     escape_field_name = escape_string(field_name);
@@ -1830,7 +1899,7 @@ void t_go_generator::generate_go_struct_writer(ostream& out,
     }
 
     out << indent() << "func (p *" << tstruct_name << ") " << field_method_prefix << field_method_suffix
-        << "(ctx context.Context, oprot thrift.TProtocol) (err error) {" << endl;
+        << "(ctx context.Context, oprot " << protocol_type() << ") (err error) {" << endl;
     indent_up();
 
     if (field_required == t_field::T_OPTIONAL) {
@@ -1917,6 +1986,96 @@ void t_go_generator::generate_go_struct_equals(ostream& out,
   out << indent() << "}" << endl << endl;
 }
 
+/**
+ * Generates a switch that hands a concrete TBinaryProtocol or
+ * TCompactProtocol to the fast path of the method
+ */
+void t_go_generator::generate_fast_path_dispatch(ostream& out,
+                                                 const string& method,
+                                                 const string& prot) {
+  out << indent() << "switch fast := " << prot << ".(type) {" << endl;
+  out << indent() << "case *thrift.TBinaryProtocol:" << endl;
+  out << indent() << "  return p." << method << "Binary(ctx, fast)" << endl;
+  out << indent() << "case *thrift.TCompactProtocol:" << endl;
+  out << indent() << "  return p." << method << "Compact(ctx, fast)" << endl;
+  out << indent() << "}" << endl;
+}
+
+/**
+ * Generates the Reset method of a struct. Lists, sets and maps that are
+ * neither optional nor have a default value keep their storage, which the
+ * next Read reuses.
+ */
+void t_go_generator::generate_go_struct_reset(ostream& out,
+                                              t_struct* tstruct,
+                                              const string& tstruct_name) {
+  const vector<t_field*>& fields = tstruct->get_members();
+  vector<std::pair<string, string> > kept;
+
+  out << indent() << "// Reset restores the defaults of New" << tstruct_name
+      << ", keeping the storage of" << endl;
+  out << indent() << "// required and default lists, sets and maps for the next Read" << endl;
+  out << indent() << "func (p *" << tstruct_name << ") Reset() {" << endl;
+  indent_up();
+  for (auto field : fields) {
+    t_type* ttype = field->get_type()->get_true_type();
+    if (!ttype->is_container() || is_pointer_field(field)
+        || field->get_req() == t_field::T_OPTIONAL || field->get_value() != nullptr) {
+      continue;
+    }
+    string field_name = "p." + publicize(field->get_name());
+    if (ttype->is_map()) {
+      // NaN keys cannot be deleted
+      t_type* key_type = ((t_map*)ttype)->get_key_type()->get_true_type();
+      if (key_type->is_base_type()
+          && ((t_base_type*)key_type)->get_base() == t_base_type::TYPE_DOUBLE) {
+        continue;
+      }
+      string keep = tmp("keep");
+      out << indent() << keep << " := " << field_name << endl;
+      out << indent() << "for k := range " << keep << " {" << endl;
+      out << indent() << "  delete(" << keep << ", k)" << endl;
+      out << indent() << "}" << endl;
+      kept.push_back(std::make_pair(field_name, keep));
+    } else {
+      string keep = tmp("keep");
+      out << indent() << keep << " := " << field_name << "[:0]" << endl;
+      kept.push_back(std::make_pair(field_name, keep));
+    }
+  }
+  out << indent() << "*p = ";
+  generate_go_struct_initializer(out, tstruct);
+  for (auto& keep : kept) {
+    out << indent() << keep.first << " = " << keep.second << endl;
+  }
+  indent_down();
+  out << indent() << "}" << endl << endl;
+}
+
+/**
+ * Generates a sync.Pool of a struct and the functions to take structs from it
+ * and return them
+ */
+void t_go_generator::generate_go_struct_pool(ostream& out, const string& tstruct_name) {
+  string pool_name = "pool" + tstruct_name;
+  out << indent() << "var " << pool_name << " = sync.Pool{" << endl;
+  out << indent() << "  New: func() interface{} { return New" << tstruct_name << "() }," << endl;
+  out << indent() << "}" << endl << endl;
+
+  out << indent() << "// Acquire" << tstruct_name << " takes a " << tstruct_name
+      << " from a pool, in the state of New" << tstruct_name << " or Reset" << endl;
+  out << indent() << "func Acquire" << tstruct_name << "() *" << tstruct_name << " {" << endl;
+  out << indent() << "  return " << pool_name << ".Get().(*" << tstruct_name << ")" << endl;
+  out << indent() << "}" << endl << endl;
+
+  out << indent() << "// Release" << tstruct_name << " resets p and returns it to the pool." << endl;
+  out << indent() << "// Neither p nor anything read into it may be used afterwards" << endl;
+  out << indent() << "func Release" << tstruct_name << "(p *" << tstruct_name << ") {" << endl;
+  out << indent() << "  p.Reset()" << endl;
+  out << indent() << "  " << pool_name << ".Put(p)" << endl;
+  out << indent() << "}" << endl << endl;
+}
+
 /**
  * Generates a thrift service.
  *
@@ -3182,7 +3341,7 @@ void t_go_generator::generate_deserialize_struct(ostream& out,
 
   out << indent() << prefix << eq << (pointer_field ? "&" : "");
   generate_go_struct_initializer(out, tstruct);
-  out << indent() << "if err := " << prefix << "." << read_method_name_ <<  "(ctx, iprot); err != nil {" << endl;
+  out << indent() << "if err := " << prefix << "." << struct_read_method_name(tstruct) <<  "(ctx, iprot); err != nil {" << endl;
   out << indent() << "  return thrift.PrependError(fmt.Sprintf(\"%T error reading struct: \", "
       << prefix << "), err)" << endl;
   out << indent() << "}" << endl;
@@ -3204,27 +3363,51 @@ void t_go_generator::generate_deserialize_container(ostream& out,
     eq = " := ";
   }
 
+  // Reuse the empty storage that Reset left in the field
+  bool reuse = pool_ && !declare && !pointer_field;
+
   // Declare variables, read header
   if (ttype->is_map()) {
     out << indent() << "_, _, size, err := iprot.ReadMapBegin(ctx)" << endl;
     out << indent() << "if err != nil {" << endl;
     out << indent() << "  return thrift.PrependError(\"error reading map begin: \", err)" << endl;
     out << indent() << "}" << endl;
-    out << indent() << "tMap := make(" << type_to_go_type(orig_type) << ", size)" << endl;
+    if (reuse) {
+      out << indent() << "tMap := " << prefix << endl;
+      out << indent() << "if len(tMap) != 0 || tMap == nil {" << endl;
+      out << indent() << "  tMap = make(" << type_to_go_type(orig_type) << ", size)" << endl;
+      out << indent() << "}" << endl;
+    } else {
+      out << indent() << "tMap := make(" << type_to_go_type(orig_type) << ", size)" << endl;
+    }
     out << indent() << prefix << eq << " " << (pointer_field ? "&" : "") << "tMap" << endl;
   } else if (ttype->is_set()) {
     out << indent() << "_, size, err := iprot.ReadSetBegin(ctx)" << endl;
     out << indent() << "if err != nil {" << endl;
     out << indent() << "  return thrift.PrependError(\"error reading set begin: \", err)" << endl;
     out << indent() << "}" << endl;
-    out << indent() << "tSet := make(" << type_to_go_type(orig_type) << ", 0, size)" << endl;
+    if (reuse) {
+      out << indent() << "tSet := " << prefix << endl;
+      out << indent() << "if len(tSet) != 0 || cap(tSet) < size || tSet == nil {" << endl;
+      out << indent() << "  tSet = make(" << type_to_go_type(orig_type) << ", 0, size)" << endl;
+      out << indent() << "}" << endl;
+    } else {
+      out << indent() << "tSet := make(" << type_to_go_type(orig_type) << ", 0, size)" << endl;
+    }
     out << indent() << prefix << eq << " " << (pointer_field ? "&" : "") << "tSet" << endl;
   } else if (ttype->is_list()) {
     out << indent() << "_, size, err := iprot.ReadListBegin(ctx)" << endl;
     out << indent() << "if err != nil {" << endl;
     out << indent() << "  return thrift.PrependError(\"error reading list begin: \", err)" << endl;
     out << indent() << "}" << endl;
-    out << indent() << "tSlice := make(" << type_to_go_type(orig_type) << ", 0, size)" << endl;
+    if (reuse) {
+      out << indent() << "tSlice := " << prefix << endl;
+      out << indent() << "if len(tSlice) != 0 || cap(tSlice) < size || tSlice == nil {" << endl;
+      out << indent() << "  tSlice = make(" << type_to_go_type(orig_type) << ", 0, size)" << endl;
+      out << indent() << "}" << endl;
+    } else {
+      out << indent() << "tSlice := make(" << type_to_go_type(orig_type) << ", 0, size)" << endl;
+    }
     out << indent() << prefix << eq << " " << (pointer_field ? "&" : "") << "tSlice" << endl;
   } else {
     throw "INVALID TYPE IN generate_deserialize_container '" + ttype->get_name() + "' for prefix '"
@@ -3408,8 +3591,7 @@ void t_go_generator::generate_serialize_field(ostream& out,
  * @param prefix  String prefix to attach to all fields
  */
 void t_go_generator::generate_serialize_struct(ostream& out, t_struct* tstruct, string prefix) {
-  (void)tstruct;
-  out << indent() << "if err := " << prefix << "." << write_method_name_ << "(ctx, oprot); err != nil {" << endl;
+  out << indent() << "if err := " << prefix << "." << struct_write_method_name(tstruct) << "(ctx, oprot); err != nil {" << endl;
   out << indent() << "  return thrift.PrependError(fmt.Sprintf(\"%T error writing struct: \", "
       << prefix << "), err)" << endl;
   out << indent() << "}" << endl;
@@ -4096,4 +4278,7 @@ THRIFT_REGISTER_GENERATOR(go, "Go",
                           "    ignore_initialisms\n"
                           "                     Disable automatic spelling correction of initialisms (e.g. \"URL\")\n" \
                           "    read_write_private\n"
-                          "                     Make read/write methods private, default is public Read/Write\n")
+                          "                     Make read/write methods private, default is public Read/Write\n" \
+                          "    fast_paths       Generate Read/Write variants that call TBinaryProtocol and\n" \
+                          "                     TCompactProtocol directly instead of through thrift.TProtocol\n" \
+                          "    pool             Generate Reset() methods and sync.Pool backed Acquire/Release helpers\n")
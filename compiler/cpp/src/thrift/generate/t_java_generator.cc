@@ -73,6 +73,8 @@ public:
     suppress_generated_annotations_ = false;
     rethrow_unhandled_exceptions_ = false;
     unsafe_binaries_ = false;
+    primitive_lists_ = false;
+    clear_and_reuse_ = false;
     for( iter = parsed_options.begin(); iter != parsed_options.end(); ++iter) {
       if( iter->first.compare("beans") == 0) {
         bean_style_ = true;
@@ -106,6 +108,10 @@ public:
         }
       } else if( iter->first.compare("unsafe_binaries") == 0) {
         unsafe_binaries_ = true;
+      } else if( iter->first.compare("primitive_lists") == 0) {
+        primitive_lists_ = true;
+      } else if( iter->first.compare("clear_and_reuse") == 0) {
+        clear_and_reuse_ = true;
       } else {
         throw "unknown option java:" + iter->first;
       }
@@ -115,6 +121,10 @@ public:
       android_legacy_ = true;
     }
 
+    if (clear_and_reuse_) {
+      reuse_objects_ = true;
+    }
+
     out_dir_base_ = (bean_style_ ? "gen-javabean" : "gen-java");
   }
 
@@ -321,6 +331,7 @@ public:
                         bool force_namespace = false);
   std::string base_type_name(t_base_type* tbase, bool in_container = false);
   std::string declare_field(t_field* tfield, bool init = false, bool comment = false);
+  std::string primitive_list_stem(t_type* ttype);
   std::string function_signature(t_function* tfunction, std::string prefix = "");
   std::string function_signature_async(t_function* tfunction,
                                        bool use_base_method = false,
@@ -415,6 +426,8 @@ private:
   bool suppress_generated_annotations_;
   bool rethrow_unhandled_exceptions_;
   bool unsafe_binaries_;
+  bool primitive_lists_;
+  bool clear_and_reuse_;
 
 };
 
@@ -3818,7 +3831,12 @@ void t_java_generator::generate_deserialize_struct(ostream& out,
     indent_up();
   }
   indent(out) << prefix << " = new " << type_name(tstruct) << "();" << endl;
-  if (reuse_objects_) {
+  if (clear_and_reuse_) {
+    indent_down();
+    indent(out) << "} else {" << endl;
+    indent(out) << "  " << prefix << ".clear();" << endl;
+    indent(out) << "}" << endl;
+  } else if (reuse_objects_) {
     indent_down();
     indent(out) << "}" << endl;
   }
@@ -3899,7 +3917,12 @@ void t_java_generator::generate_deserialize_container(ostream& out,
         << ");" << endl;
   }
 
-  if (reuse_objects_) {
+  if (clear_and_reuse_) {
+    indent_down();
+    indent(out) << "} else {" << endl;
+    indent(out) << "  " << prefix << ".clear();" << endl;
+    indent(out) << "}" << endl;
+  } else if (reuse_objects_) {
     indent_down();
     indent(out) << "}" << endl;
   }
@@ -4173,13 +4196,23 @@ void t_java_generator::generate_serialize_container(ostream& out,
   } else if (ttype->is_set()) {
     indent(out) << "for (" << type_name(((t_set*)ttype)->get_elem_type()) << " " << iter << " : "
                 << prefix << ")";
+  } else if (ttype->is_list() && !primitive_list_stem(ttype).empty()) {
+    // index the list rather than iterate it, so that the elements are not boxed
+    string i = tmp("_i");
+    indent(out) << "for (int " << i << " = 0; " << i << " < " << prefix << ".size(); ++" << i
+                << ")" << endl;
+    scope_up(out);
+    indent(out) << type_name(((t_list*)ttype)->get_elem_type()) << " " << iter << " = " << prefix
+                << ".get" << primitive_list_stem(ttype) << "(" << i << ");" << endl;
   } else if (ttype->is_list()) {
     indent(out) << "for (" << type_name(((t_list*)ttype)->get_elem_type()) << " " << iter << " : "
                 << prefix << ")";
   }
 
-  out << endl;
-  scope_up(out);
+  if (!ttype->is_list() || primitive_list_stem(ttype).empty()) {
+    out << endl;
+    scope_up(out);
+  }
   if (ttype->is_map()) {
     generate_serialize_map_element(out, (t_map*)ttype, iter, prefix, has_metadata);
   } else if (ttype->is_set()) {
@@ -4288,6 +4321,9 @@ string t_java_generator::type_name(t_type* ttype,
     return prefix + (skip_generic ? "" : "<" + type_name(tset->get_elem_type(), true) + ">");
   } else if (ttype->is_list()) {
     t_list* tlist = (t_list*)ttype;
+    if (!primitive_list_stem(tlist).empty()) {
+      return "org.apache.thrift.collections." + primitive_list_stem(tlist) + "List";
+    }
     if (in_init) {
       prefix = "java.util.ArrayList";
     } else {
@@ -4343,6 +4379,34 @@ string t_java_generator::base_type_name(t_base_type* type, bool in_container) {
   }
 }
 
+/**
+ * Returns the stem of the org.apache.thrift.collections class that holds a list
+ * without boxing its elements, i.e. "Int" for IntList, or "" if the type is not
+ * such a list. Byte and boolean lists are left alone, their boxes are cached.
+ */
+string t_java_generator::primitive_list_stem(t_type* ttype) {
+  ttype = get_true_type(ttype);
+  if (!primitive_lists_ || !ttype->is_list()) {
+    return "";
+  }
+  t_type* elem_type = get_true_type(((t_list*)ttype)->get_elem_type());
+  if (!elem_type->is_base_type()) {
+    return "";
+  }
+  switch (((t_base_type*)elem_type)->get_base()) {
+  case t_base_type::TYPE_I16:
+    return "Short";
+  case t_base_type::TYPE_I32:
+    return "Int";
+  case t_base_type::TYPE_I64:
+    return "Long";
+  case t_base_type::TYPE_DOUBLE:
+    return "Double";
+  default:
+    return "";
+  }
+}
+
 /**
  * Declares a field, which may include initialization as necessary.
  *
@@ -5420,13 +5484,14 @@ void t_java_generator::generate_java_scheme_lookup(ostream& out) {
 
 void t_java_generator::generate_javax_generated_annotation(ostream& out) {
   time_t seconds = time(nullptr);
-  struct tm* now = localtime(&seconds);
+  struct tm now;
+  THRIFT_LOCALTIME(&seconds, &now);
   indent(out) << "@javax.annotation.Generated(value = \"" << autogen_summary() << "\"";
   if (undated_generated_annotations_) {
     out << ")" << endl;
   } else {
-    indent(out) << ", date = \"" << (now->tm_year + 1900) << "-" << setfill('0') << setw(2)
-                << (now->tm_mon + 1) << "-" << setfill('0') << setw(2) << now->tm_mday
+    indent(out) << ", date = \"" << (now.tm_year + 1900) << "-" << setfill('0') << setw(2)
+                << (now.tm_mon + 1) << "-" << setfill('0') << setw(2) << now.tm_mday
                 << "\")" << endl;
   }
 }
@@ -5455,4 +5520,9 @@ THRIFT_REGISTER_GENERATOR(
     "    generated_annotations=[undated|suppress]:\n"
     "                     undated: suppress the date at @Generated annotations\n"
     "                     suppress: suppress @Generated annotations entirely\n"
-    "    unsafe_binaries: Do not copy ByteBuffers in constructors, getters, and setters.\n")
+    "    unsafe_binaries: Do not copy ByteBuffers in constructors, getters, and setters.\n"
+    "    primitive_lists: Use IntList etc. from org.apache.thrift.collections for lists of "
+    "i16/i32/i64/double,\n"
+    "                     which do not box their elements.\n"
+    "    clear_and_reuse: Like reuse-objects, but clear existing containers and structs before "
+    "reading into them.\n")
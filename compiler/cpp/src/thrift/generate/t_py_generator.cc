@@ -60,6 +60,7 @@ public:
     gen_utf8strings_ = true;
     gen_dynbase_ = false;
     gen_slots_ = false;
+    gen_fast_structs_ = false;
     gen_tornado_ = false;
     gen_zope_interface_ = false;
     gen_twisted_ = false;
@@ -83,6 +84,9 @@ public:
         gen_utf8strings_ = false;
       } else if( iter->first.compare("slots") == 0) {
         gen_slots_ = true;
+      } else if( iter->first.compare("fast_structs") == 0) {
+        gen_fast_structs_ = true;
+        gen_slots_ = true;
       } else if( iter->first.compare("package_prefix") == 0) {
         package_prefix_ = iter->second;
       } else if( iter->first.compare("dynamic") == 0) {
@@ -311,6 +315,12 @@ private:
 
   bool gen_slots_;
 
+  /**
+   * True if the accelerated protocols may create instances without calling
+   * __init__, filling in their slots directly.
+   */
+  bool gen_fast_structs_;
+
   std::string copy_options_;
 
   /**
@@ -378,6 +388,7 @@ void t_py_generator::init_generator() {
     MKDIR(package_dir_.c_str());
     std::ofstream init_py((package_dir_ + "/__init__.py").c_str(), std::ios_base::app);
     init_py.close();
+    record_generated_file(package_dir_ + "/__init__.py");
     if (module.empty()) {
       break;
     }
@@ -813,6 +824,10 @@ void t_py_generator::generate_py_struct_definition(ostream& out,
     indent(out) << ")" << endl << endl;
   }
 
+  if (gen_fast_structs_) {
+    indent(out) << "thrift_fast_struct = True" << endl;
+  }
+
   // TODO(dreiss): Look into generating an empty tuple instead of None
   // for structures with no members.
   // TODO(dreiss): Test encoding of structs where some inner structs
@@ -2792,6 +2807,8 @@ THRIFT_REGISTER_GENERATOR(
     "    no_utf8strings:  Do not Encode/decode strings using utf8 in the generated code. Basically no effect for Python 3.\n"
     "    coding=CODING:   Add file encoding declare in generated file.\n"
     "    slots:           Generate code using slots for instance members.\n"
+    "    fast_structs:    Like slots, but the accelerated protocols build structs without calling "
+    "__init__.\n"
     "    dynamic:         Generate dynamic code, less code generated but slower.\n"
     "    dynbase=CLS      Derive generated classes from class CLS instead of TBase.\n"
     "    dynfrozen=CLS    Derive generated immutable classes from class CLS instead of TFrozenBase.\n"
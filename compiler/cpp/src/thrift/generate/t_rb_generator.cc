@@ -57,7 +57,14 @@ public:
   explicit t_rb_ofstream(const char* filename,
                          ios_base::openmode mode = ios_base::out,
                          int indent = 0)
-    : std::ofstream(filename, mode), indent_(indent) {}
+    : std::ofstream(filename, mode), indent_(indent) {
+    record_generated_file(filename);
+  }
+
+  void open(const char* filename, ios_base::openmode mode = ios_base::out) {
+    std::ofstream::open(filename, mode);
+    record_generated_file(filename);
+  }
 
   t_rb_ofstream& indent() {
     for (int i = 0; i < indent_; ++i) {
@@ -64,9 +64,24 @@ class t_rs_generator : public t_generator {
 public:
   t_rs_generator(
     t_program* program,
-    const std::map<std::string, std::string>&,
+    const std::map<std::string, std::string>& parsed_options,
     const std::string&
   ) : t_generator(program) {
+    gen_hash_collections_ = false;
+    gen_borrowed_ = false;
+    render_borrowed_ = false;
+
+    std::map<std::string, std::string>::const_iterator iter;
+    for (iter = parsed_options.begin(); iter != parsed_options.end(); ++iter) {
+      if (iter->first.compare("hash_collections") == 0) {
+        gen_hash_collections_ = true;
+      } else if (iter->first.compare("borrowed") == 0) {
+        gen_borrowed_ = true;
+      } else {
+        throw "unknown option rs:" + iter->first;
+      }
+    }
+
     gen_dir_ = get_out_dir();
   }
 
@@ -102,6 +117,16 @@ private:
   // File to which generated code is written.
   ofstream_with_content_based_conditional_update f_gen_;
 
+  // Represent maps and sets as `HashMap` and `HashSet` instead of `BTreeMap` and `BTreeSet`.
+  bool gen_hash_collections_;
+
+  // Also generate a `FooRef<'a>` for every struct, union and exception that contains strings or
+  // binaries. It is read from an in-memory buffer, and its strings and binaries borrow from it.
+  bool gen_borrowed_;
+
+  // `true` while the borrowed version of a type is rendered.
+  bool render_borrowed_;
+
   // Write the common compiler attributes and module includes to the top of the auto-generated file.
   void render_attributes_and_includes();
 
@@ -149,6 +174,14 @@ private:
     t_const_value* tvalue
   );
 
+  // Write the borrowed `FooRef<'a>` version of a thrift struct, union or exception: its definition
+  // and its `read_from_in_protocol`. Borrowed types cannot be written.
+  void render_borrowed_struct(t_struct* tstruct);
+
+  // Write the first line of a `read_from_in_protocol` function that returns `type_name`. Borrowed types
+  // read from any protocol that can lend out parts of its buffer.
+  void render_sync_read_signature(const string& visibility, const string& type_name);
+
   // Write the rust representation of a thrift struct to the generated file. Set `struct_type` to `T_ARGS`
   // if rendering the struct used to pack arguments for a service call. When `struct_type` is `T_ARGS` the
   // struct and its members have module visibility, and all fields are required. When `struct_type` is
@@ -411,6 +444,22 @@ private:
   // Return a string representing the rust type given a `t_type`.
   string to_rust_type(t_type* ttype);
 
+  // Return the rust type used for thrift maps or sets, depending on the `hash_collections` option.
+  string rust_map_type();
+  string rust_set_type();
+
+  // Return the derive attribute for the rust representation of a struct or union. Hash maps and sets
+  // implement neither `Hash` nor `Ord`, so types that contain them derive fewer traits.
+  string rust_derives(t_struct* tstruct);
+
+  // Return `true` if `ttype` is or contains a map or set, through typedefs, lists and struct fields.
+  bool contains_map_or_set(t_type* ttype);
+  bool contains_map_or_set(t_type* ttype, set<t_type*>& visited);
+
+  // Return `true` if `ttype` is or contains a string or binary, and has a borrowed version.
+  bool needs_lifetime(t_type* ttype);
+  bool needs_lifetime(t_type* ttype, set<t_type*>& visited);
+
   // Return a string representing the `const` rust type given a `t_type`
   string to_rust_const_type(t_type* ttype);
 
@@ -457,6 +506,9 @@ private:
   // a reserved word.
   string rust_struct_name(t_struct* tstruct);
 
+  // Returns the name of the borrowed version of a Rust struct type, without its lifetime parameter.
+  string rust_borrowed_struct_name(t_struct* tstruct);
+
   // Returns the snake-cased name for a Rust field or local variable. Handles the case where
   // `tfield->get_name()` is a reserved word.
   string rust_field_name(t_field* tstruct);
@@ -561,7 +613,11 @@ void t_rs_generator::render_attributes_and_includes() {
 
   // add standard includes
   f_gen_ << "use std::cell::RefCell;" << endl;
-  f_gen_ << "use std::collections::{BTreeMap, BTreeSet};" << endl;
+  if (gen_hash_collections_) {
+    f_gen_ << "use std::collections::{BTreeMap, BTreeSet, HashMap, HashSet};" << endl;
+  } else {
+    f_gen_ << "use std::collections::{BTreeMap, BTreeSet};" << endl;
+  }
   f_gen_ << "use std::convert::{From, TryFrom};" << endl;
   f_gen_ << "use std::default::Default;" << endl;
   f_gen_ << "use std::error::Error;" << endl;
@@ -572,6 +628,9 @@ void t_rs_generator::render_attributes_and_includes() {
   f_gen_ << "use thrift::OrderedFloat;" << endl;
   f_gen_ << "use thrift::{ApplicationError, ApplicationErrorKind, ProtocolError, ProtocolErrorKind, TThriftClient};" << endl;
   f_gen_ << "use thrift::protocol::{TFieldIdentifier, TListIdentifier, TMapIdentifier, TMessageIdentifier, TMessageType, TInputProtocol, TOutputProtocol, TSetIdentifier, TStructIdentifier, TType};" << endl;
+  if (gen_borrowed_) {
+    f_gen_ << "use thrift::protocol::TBorrowedInputProtocol;" << endl;
+  }
   f_gen_ << "use thrift::protocol::field_id;" << endl;
   f_gen_ << "use thrift::protocol::verify_expected_message_type;" << endl;
   f_gen_ << "use thrift::protocol::verify_expected_sequence_number;" << endl;
@@ -793,7 +852,11 @@ void t_rs_generator::render_const_list(t_type* ttype, t_const_value* tvalue) {
 
 void t_rs_generator::render_const_set(t_type* ttype, t_const_value* tvalue) {
   t_type* elem_type = ((t_set*)ttype)->get_elem_type();
-  f_gen_ << indent() << "let mut s: BTreeSet<" << to_rust_type(elem_type) << "> = BTreeSet::new();" << endl;
+  f_gen_
+    << indent()
+    << "let mut s: " << rust_set_type() << "<" << to_rust_type(elem_type) << "> = "
+    << rust_set_type() << "::new();"
+    << endl;
   const vector<t_const_value*>& elems = tvalue->get_list();
   vector<t_const_value*>::const_iterator elem_iter;
   for(elem_iter = elems.begin(); elem_iter != elems.end(); ++elem_iter) {
@@ -808,9 +871,9 @@ void t_rs_generator::render_const_map(t_type* ttype, t_const_value* tvalue) {
   t_type* val_type = ((t_map*)ttype)->get_val_type();
   f_gen_
     << indent()
-    << "let mut m: BTreeMap<"
+    << "let mut m: " << rust_map_type() << "<"
     << to_rust_type(key_type) << ", " << to_rust_type(val_type)
-    << "> = BTreeMap::new();"
+    << "> = " << rust_map_type() << "::new();"
     << endl;
   const map<t_const_value*, t_const_value*, t_const_value::value_compare>& elems = tvalue->get_map();
   map<t_const_value*, t_const_value*, t_const_value::value_compare>::const_iterator elem_iter;
@@ -1030,6 +1093,9 @@ void t_rs_generator::render_enum_conversion(t_enum* tenum, const string& enum_na
 
 void t_rs_generator::generate_xception(t_struct* txception) {
   render_struct(rust_struct_name(txception), txception, t_rs_generator::T_EXCEPTION);
+  if (gen_borrowed_ && needs_lifetime(txception)) {
+    render_borrowed_struct(txception);
+  }
 }
 
 void t_rs_generator::generate_struct(t_struct* tstruct) {
@@ -1040,6 +1106,34 @@ void t_rs_generator::generate_struct(t_struct* tstruct) {
   } else {
     throw "cannot generate struct for exception";
   }
+  if (gen_borrowed_ && needs_lifetime(tstruct)) {
+    render_borrowed_struct(tstruct);
+  }
+}
+
+void t_rs_generator::render_borrowed_struct(t_struct* tstruct) {
+  string struct_name(rust_borrowed_struct_name(tstruct));
+  render_borrowed_ = true;
+
+  render_type_comment(struct_name);
+  if (tstruct->is_union()) {
+    render_union_definition(struct_name, tstruct);
+  } else {
+    render_struct_definition(struct_name, tstruct, t_rs_generator::T_REGULAR);
+  }
+
+  f_gen_ << "impl<'a> " << struct_name << "<'a> {" << endl;
+  indent_up();
+  if (tstruct->is_union()) {
+    render_union_sync_read(struct_name, tstruct);
+  } else {
+    render_struct_sync_read(struct_name, tstruct, t_rs_generator::T_REGULAR);
+  }
+  indent_down();
+  f_gen_ << "}" << endl;
+  f_gen_ << endl;
+
+  render_borrowed_ = false;
 }
 
 void t_rs_generator::render_struct(
@@ -1064,8 +1158,11 @@ void t_rs_generator::render_struct_definition(
   t_rs_generator::e_struct_type struct_type
 ) {
   render_rustdoc((t_doc*) tstruct);
-  f_gen_ << "#[derive(Clone, Debug, Eq, Hash, Ord, PartialEq, PartialOrd)]" << endl;
-  f_gen_ << visibility_qualifier(struct_type) << "struct " << struct_name << " {" << endl;
+  f_gen_ << rust_derives(tstruct) << endl;
+  f_gen_
+    << visibility_qualifier(struct_type)
+    << "struct " << struct_name << (render_borrowed_ ? "<'a>" : "") << " {"
+    << endl;
 
   // render the members
   vector<t_field*> members = tstruct->get_sorted_members();
@@ -1407,8 +1504,8 @@ void t_rs_generator::render_union_definition(const string& union_name, t_struct*
     throw "cannot generate rust enum with 0 members"; // may be valid thrift, but it's invalid rust
   }
 
-  f_gen_ << "#[derive(Clone, Debug, Eq, Hash, Ord, PartialEq, PartialOrd)]" << endl;
-  f_gen_ << "pub enum " << union_name << " {" << endl;
+  f_gen_ << rust_derives(tstruct) << endl;
+  f_gen_ << "pub enum " << union_name << (render_borrowed_ ? "<'a>" : "") << " {" << endl;
   indent_up();
 
   vector<t_field*>::const_iterator member_iter;
@@ -1721,12 +1818,7 @@ void t_rs_generator::render_struct_sync_read(
     const string &struct_name,
     t_struct *tstruct, t_rs_generator::e_struct_type struct_type
 ) {
-  f_gen_
-    << indent()
-    << visibility_qualifier(struct_type)
-    << "fn read_from_in_protocol(i_prot: &mut dyn TInputProtocol) -> thrift::Result<" << struct_name << "> {"
-    << endl;
-
+  render_sync_read_signature(visibility_qualifier(struct_type), struct_name);
   indent_up();
 
   f_gen_ << indent() << "i_prot.read_struct_begin()?;" << endl;
@@ -1843,11 +1935,25 @@ void t_rs_generator::render_struct_sync_read(
   f_gen_ << indent() << "}" << endl;
 }
 
+void t_rs_generator::render_sync_read_signature(const string& visibility, const string& type_name) {
+  if (render_borrowed_) {
+    f_gen_
+      << indent()
+      << visibility
+      << "fn read_from_in_protocol<P: TBorrowedInputProtocol<'a>>(i_prot: &mut P) -> thrift::Result<"
+      << type_name << "<'a>> {"
+      << endl;
+  } else {
+    f_gen_
+      << indent()
+      << visibility
+      << "fn read_from_in_protocol(i_prot: &mut dyn TInputProtocol) -> thrift::Result<" << type_name << "> {"
+      << endl;
+  }
+}
+
 void t_rs_generator::render_union_sync_read(const string &union_name, t_struct *tstruct) {
-  f_gen_
-    << indent()
-    << "pub fn read_from_in_protocol(i_prot: &mut dyn TInputProtocol) -> thrift::Result<" << union_name << "> {"
-    << endl;
+  render_sync_read_signature("pub ", union_name);
   indent_up();
 
   // create temporary variables to hold the
@@ -1948,9 +2054,17 @@ void t_rs_generator::render_type_sync_read(const string &type_var, t_type *ttype
       throw "cannot read field of type TYPE_VOID from input protocol";
     case t_base_type::TYPE_STRING:
       if (tbase_type->is_binary()) {
-        f_gen_ << indent() << "let " << type_var << " = i_prot.read_bytes()?;" << endl;
+        f_gen_
+          << indent()
+          << "let " << type_var << " = i_prot."
+          << (render_borrowed_ ? "read_borrowed_bytes" : "read_bytes") << "()?;"
+          << endl;
       } else {
-        f_gen_ << indent() << "let " << type_var << " = i_prot.read_string()?;" << endl;
+        f_gen_
+          << indent()
+          << "let " << type_var << " = i_prot."
+          << (render_borrowed_ ? "read_borrowed_string" : "read_string") << "()?;"
+          << endl;
       }
       return;
     case t_base_type::TYPE_BOOL:
@@ -1985,7 +2099,11 @@ void t_rs_generator::render_type_sync_read(const string &type_var, t_type *ttype
     render_type_sync_read(type_var, ttypedef->get_type(), ttypedef->is_forward_typedef());
     return;
   } else if (ttype->is_enum() || ttype->is_struct() || ttype->is_xception()) {
-    string read_call(to_rust_type(ttype) + "::read_from_in_protocol(i_prot)?");
+    string read_type(to_rust_type(ttype));
+    if (render_borrowed_ && needs_lifetime(ttype)) {
+      read_type = rust_namespace(ttype) + rust_borrowed_struct_name((t_struct*)ttype);
+    }
+    string read_call(read_type + "::read_from_in_protocol(i_prot)?");
     read_call = is_boxed ? "Box::new(" + read_call + ")" : read_call;
     f_gen_
       << indent()
@@ -2011,6 +2129,41 @@ void t_rs_generator::render_list_sync_read(t_list *tlist, const string &list_var
   t_type* elem_type = tlist->get_elem_type();
 
   f_gen_ << indent() << "let list_ident = i_prot.read_list_begin()?;" << endl;
+
+  // lists of numbers are read with a single call, which the protocol may decode in bulk
+  t_type* true_elem_type = get_true_type(elem_type);
+  if (true_elem_type->is_base_type()) {
+    string bulk_read;
+    switch (((t_base_type*)true_elem_type)->get_base()) {
+    case t_base_type::TYPE_I8:
+      bulk_read = "read_i8_list";
+      break;
+    case t_base_type::TYPE_I16:
+      bulk_read = "read_i16_list";
+      break;
+    case t_base_type::TYPE_I32:
+      bulk_read = "read_i32_list";
+      break;
+    case t_base_type::TYPE_I64:
+      bulk_read = "read_i64_list";
+      break;
+    case t_base_type::TYPE_DOUBLE:
+      bulk_read = "read_double_list";
+      break;
+    default:
+      break;
+    }
+    if (!bulk_read.empty()) {
+      f_gen_
+        << indent()
+        << "let " << list_var << ": " << to_rust_type((t_type*) tlist)
+        << " = i_prot." << bulk_read << "(list_ident.size)?;"
+        << endl;
+      f_gen_ << indent() << "i_prot.read_list_end()?;" << endl;
+      return;
+    }
+  }
+
   f_gen_
     << indent()
     << "let mut " << list_var << ": " << to_rust_type((t_type*) tlist)
@@ -2038,7 +2191,7 @@ void t_rs_generator::render_set_sync_read(t_set *tset, const string &set_var) {
   f_gen_
     << indent()
     << "let mut " << set_var << ": " << to_rust_type((t_type*) tset)
-    << " = BTreeSet::new();"
+    << (gen_hash_collections_ ? " = HashSet::with_capacity(set_ident.size as usize);" : " = BTreeSet::new();")
     << endl;
   f_gen_ << indent() << "for _ in 0..set_ident.size {" << endl;
 
@@ -2063,7 +2216,7 @@ void t_rs_generator::render_map_sync_read(t_map *tmap, const string &map_var) {
   f_gen_
     << indent()
     << "let mut " << map_var << ": " << to_rust_type((t_type*) tmap)
-    << " = BTreeMap::new();"
+    << (gen_hash_collections_ ? " = HashMap::with_capacity(map_ident.size as usize);" : " = BTreeMap::new();")
     << endl;
   f_gen_ << indent() << "for _ in 0..map_ident.size {" << endl;
 
@@ -3054,9 +3207,9 @@ string t_rs_generator::to_rust_type(t_type* ttype) {
       return "()";
     case t_base_type::TYPE_STRING:
       if (tbase_type->is_binary()) {
-        return "Vec<u8>";
+        return render_borrowed_ ? "&'a [u8]" : "Vec<u8>";
       } else {
-        return "String";
+        return render_borrowed_ ? "&'a str" : "String";
       }
     case t_base_type::TYPE_BOOL:
       return "bool";
@@ -3074,18 +3227,33 @@ string t_rs_generator::to_rust_type(t_type* ttype) {
   } else if (ttype->is_typedef()) {
     t_typedef* ttypedef = (t_typedef*)ttype;
     string rust_type = rust_namespace(ttype) + ttypedef->get_symbolic();
+    // the typedef names the owned type, so a borrowed type uses what it points to
+    if (render_borrowed_ && needs_lifetime(ttypedef->get_type())) {
+      rust_type = to_rust_type(ttypedef->get_type());
+    }
     rust_type =  ttypedef->is_forward_typedef() ? "Box<" + rust_type + ">" : rust_type;
     return rust_type;
   } else if (ttype->is_enum()) {
     return rust_namespace(ttype) + rust_camel_case(ttype->get_name());
   } else if (ttype->is_struct() || ttype->is_xception()) {
+    if (render_borrowed_ && needs_lifetime(ttype)) {
+      return rust_namespace(ttype) + rust_borrowed_struct_name((t_struct*)ttype) + "<'a>";
+    }
     return rust_namespace(ttype) + rust_camel_case(ttype->get_name());
   } else if (ttype->is_map()) {
     t_map* tmap = (t_map*)ttype;
-    return "BTreeMap<" + to_rust_type(tmap->get_key_type()) + ", " + to_rust_type(tmap->get_val_type()) + ">";
+    if (gen_hash_collections_ && contains_map_or_set(tmap->get_key_type())) {
+      throw "rs:hash_collections cannot use " + tmap->get_key_type()->get_name()
+          + " as a map key, because it contains a map or set";
+    }
+    return rust_map_type() + "<" + to_rust_type(tmap->get_key_type()) + ", " + to_rust_type(tmap->get_val_type()) + ">";
   } else if (ttype->is_set()) {
     t_set* tset = (t_set*)ttype;
-    return "BTreeSet<" + to_rust_type(tset->get_elem_type()) + ">";
+    if (gen_hash_collections_ && contains_map_or_set(tset->get_elem_type())) {
+      throw "rs:hash_collections cannot use " + tset->get_elem_type()->get_name()
+          + " as a set element, because it contains a map or set";
+    }
+    return rust_set_type() + "<" + to_rust_type(tset->get_elem_type()) + ">";
   } else if (ttype->is_list()) {
     t_list* tlist = (t_list*)ttype;
     return "Vec<" + to_rust_type(tlist->get_elem_type()) + ">";
@@ -3094,6 +3262,79 @@ string t_rs_generator::to_rust_type(t_type* ttype) {
   throw "cannot find rust type for " + ttype->get_name();
 }
 
+string t_rs_generator::rust_map_type() {
+  return gen_hash_collections_ ? "HashMap" : "BTreeMap";
+}
+
+string t_rs_generator::rust_set_type() {
+  return gen_hash_collections_ ? "HashSet" : "BTreeSet";
+}
+
+string t_rs_generator::rust_derives(t_struct* tstruct) {
+  if (gen_hash_collections_ && contains_map_or_set(tstruct)) {
+    return "#[derive(Clone, Debug, Eq, PartialEq)]";
+  }
+  return "#[derive(Clone, Debug, Eq, Hash, Ord, PartialEq, PartialOrd)]";
+}
+
+bool t_rs_generator::contains_map_or_set(t_type* ttype) {
+  set<t_type*> visited;
+  return contains_map_or_set(ttype, visited);
+}
+
+bool t_rs_generator::contains_map_or_set(t_type* ttype, set<t_type*>& visited) {
+  ttype = get_true_type(ttype);
+  if (ttype->is_map() || ttype->is_set()) {
+    return true;
+  } else if (ttype->is_list()) {
+    return contains_map_or_set(((t_list*)ttype)->get_elem_type(), visited);
+  } else if (ttype->is_struct() || ttype->is_xception()) {
+    // a recursive struct is only as bad as its other members
+    if (!visited.insert(ttype).second) {
+      return false;
+    }
+    const vector<t_field*>& members = ((t_struct*)ttype)->get_members();
+    vector<t_field*>::const_iterator members_iter;
+    for (members_iter = members.begin(); members_iter != members.end(); ++members_iter) {
+      if (contains_map_or_set((*members_iter)->get_type(), visited)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool t_rs_generator::needs_lifetime(t_type* ttype) {
+  set<t_type*> visited;
+  return needs_lifetime(ttype, visited);
+}
+
+bool t_rs_generator::needs_lifetime(t_type* ttype, set<t_type*>& visited) {
+  ttype = get_true_type(ttype);
+  if (ttype->is_base_type()) {
+    return ((t_base_type*)ttype)->get_base() == t_base_type::TYPE_STRING;
+  } else if (ttype->is_list()) {
+    return needs_lifetime(((t_list*)ttype)->get_elem_type(), visited);
+  } else if (ttype->is_set()) {
+    return needs_lifetime(((t_set*)ttype)->get_elem_type(), visited);
+  } else if (ttype->is_map()) {
+    return needs_lifetime(((t_map*)ttype)->get_key_type(), visited)
+        || needs_lifetime(((t_map*)ttype)->get_val_type(), visited);
+  } else if (ttype->is_struct() || ttype->is_xception()) {
+    if (!visited.insert(ttype).second) {
+      return false;
+    }
+    const vector<t_field*>& members = ((t_struct*)ttype)->get_members();
+    vector<t_field*>::const_iterator members_iter;
+    for (members_iter = members.begin(); members_iter != members.end(); ++members_iter) {
+      if (needs_lifetime((*members_iter)->get_type(), visited)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 string t_rs_generator::to_rust_const_type(t_type* ttype) {
   if (ttype->is_base_type()) {
     t_base_type* tbase_type = ((t_base_type*)ttype);
@@ -3154,7 +3395,9 @@ string t_rs_generator::opt_in_req_out_value(t_type* ttype) {
     case t_base_type::TYPE_VOID:
       throw "cannot generate OPT_IN_REQ_OUT value for void";
     case t_base_type::TYPE_STRING:
-      if (tbase_type->is_binary()) {
+      if (render_borrowed_) {
+        return tbase_type->is_binary() ? "Some(&[])" : "Some(\"\")";
+      } else if (tbase_type->is_binary()) {
         return "Some(Vec::new())";
       } else {
         return "Some(\"\".to_owned())";
@@ -3175,9 +3418,9 @@ string t_rs_generator::opt_in_req_out_value(t_type* ttype) {
   } else if (ttype->is_list()) {
     return "Some(Vec::new())";
   } else if (ttype->is_set()) {
-    return "Some(BTreeSet::new())";
+    return "Some(" + rust_set_type() + "::new())";
   } else if (ttype->is_map()) {
-    return "Some(BTreeMap::new())";
+    return "Some(" + rust_map_type() + "::new())";
   }
 
   throw "cannot generate opt-in-req-out value for type " + ttype->get_name();
@@ -3265,6 +3508,10 @@ string t_rs_generator::rust_struct_name(t_struct* tstruct) {
   return rust_safe_name(base_struct_name);
 }
 
+string t_rs_generator::rust_borrowed_struct_name(t_struct* tstruct) {
+  return rust_struct_name(tstruct) + "Ref";
+}
+
 string t_rs_generator::rust_field_name(t_field* tfield) {
   string base_field_name(rust_snake_case(tfield->get_name()));
   return rust_safe_name(base_field_name);
@@ -3404,4 +3651,6 @@ void t_rs_generator::string_replace(string& target, const string& search_string,
 THRIFT_REGISTER_GENERATOR(
   rs,
   "Rust",
-  "\n") // no Rust-generator-specific options
+  "    hash_collections: Use HashMap and HashSet for maps and sets instead of BTreeMap and BTreeSet.\n"
+  "    borrowed:         Also generate FooRef<'a> types that read strings and binaries from an\n"
+  "                      in-memory buffer without copying them.\n")
@@ -0,0 +1,584 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sstream>
+#include "thrift/platform.h"
+#include "thrift/generate/t_generator.h"
+
+using std::map;
+using std::ostringstream;
+using std::set;
+using std::string;
+using std::vector;
+
+static const string endl = "\n"; // avoid ostream << std::endl flushes
+
+/**
+ * Range of encoded sizes of a value. The largest encoding is unbounded
+ * when a string, binary, container or recursive struct can occur.
+ */
+struct size_range {
+  size_range(uint64_t lo = 0, uint64_t hi = 0) : min(lo), max(hi), bounded(true) {}
+
+  size_range& operator+=(const size_range& rhs) {
+    min += rhs.min;
+    max += rhs.max;
+    bounded = bounded && rhs.bounded;
+    return *this;
+  }
+
+  uint64_t min;
+  uint64_t max;
+  bool bounded;
+};
+
+/**
+ * Size, alignment and padding of a generated C++ class
+ */
+struct cpp_layout {
+  cpp_layout() : size(0), align(1), padding(0) {}
+
+  uint64_t size;
+  uint64_t align;
+  uint64_t padding;
+};
+
+/**
+ * Size and layout report generator. Writes a text report per program with,
+ * for every struct, union and exception:
+ * - the smallest and largest encoding under the binary and compact protocols
+ * - the field ids that are too far from the previous one for the one byte
+ *   field headers of the compact protocol
+ * - sizeof and padding of the class the C++ generator emits for it, with and
+ *   without its compact_layout option
+ * - how deeply structs are nested within it
+ *
+ * Sizes of strings, containers and structs assume LP64 and libstdc++.
+ */
+class t_sizeinfo_generator : public t_generator {
+public:
+  t_sizeinfo_generator(t_program* program,
+                       const std::map<std::string, std::string>& parsed_options,
+                       const std::string& option_string)
+    : t_generator(program) {
+    (void)option_string;
+    std::map<std::string, std::string>::const_iterator iter;
+
+    nesting_limit_ = 4;
+    for( iter = parsed_options.begin(); iter != parsed_options.end(); ++iter) {
+      if( iter->first.compare("nesting") == 0) {
+        nesting_limit_ = atoi(iter->second.c_str());
+        if (nesting_limit_ <= 0) {
+          throw "invalid value for sizeinfo:nesting: " + iter->second;
+        }
+      } else {
+        throw "unknown option sizeinfo:" + iter->first;
+      }
+    }
+
+    out_dir_base_ = "gen-sizeinfo";
+  }
+
+  /**
+   * Init and end of generator
+   */
+  void init_generator() override;
+  void close_generator() override;
+
+  /**
+   * Program-level generation functions
+   */
+  void generate_typedef(t_typedef* ttypedef) override { (void)ttypedef; }
+  void generate_enum(t_enum* tenum) override { (void)tenum; }
+  void generate_struct(t_struct* tstruct) override;
+  void generate_xception(t_struct* txception) override;
+  void generate_service(t_service* tservice) override { (void)tservice; }
+
+private:
+  enum protocol { BINARY, COMPACT };
+
+  /**
+   * Encoded sizes
+   */
+  size_range struct_size(t_struct* tstruct, protocol proto);
+  size_range value_size(t_type* ttype, protocol proto, bool is_field);
+  uint64_t compact_field_header_size(int32_t key, int32_t previous_key);
+  string describe(const size_range& range, const vector<string>& unbounded);
+
+  /**
+   * C++ layout
+   */
+  cpp_layout class_layout(t_struct* tstruct, bool reorder, bool compact_isset);
+  void member_layout(t_field* tfield, bool compact_layout, uint64_t& size, uint64_t& align);
+  static int member_alignment(t_field* tfield);
+  static bool is_lazy(t_field* tfield);
+
+  /**
+   * Nesting
+   */
+  int nesting_depth(t_type* ttype, vector<string>& chain, bool& recursive);
+
+  void generate_struct_report(t_struct* tstruct, bool is_exception);
+
+  ofstream_with_content_based_conditional_update f_out_;
+  vector<string> hot_spots_;
+  set<t_struct*> visiting_;
+  int nesting_limit_;
+};
+
+static uint64_t varint_size(uint64_t value) {
+  uint64_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+static uint64_t round_up(uint64_t value, uint64_t align) {
+  return (value + align - 1) / align * align;
+}
+
+void t_sizeinfo_generator::init_generator() {
+  MKDIR(get_out_dir().c_str());
+  string fname = get_out_dir() + program_->get_name() + ".txt";
+  f_out_.open(fname.c_str());
+  f_out_ << "Size and layout report for " << program_->get_path() << endl
+         << endl
+         << "Encoded sizes are in bytes. The minimum counts the required fields and the" << endl
+         << "fields of default requiredness, with empty strings and containers. The" << endl
+         << "maximum adds the optional fields and is unbounded when a string, binary," << endl
+         << "container or recursive struct can occur. C++ sizes assume LP64 and" << endl
+         << "libstdc++." << endl;
+}
+
+void t_sizeinfo_generator::close_generator() {
+  f_out_ << endl << "Hot spots" << endl;
+  if (hot_spots_.empty()) {
+    f_out_ << "  none" << endl;
+  }
+  for (vector<string>::const_iterator it = hot_spots_.begin(); it != hot_spots_.end(); ++it) {
+    f_out_ << "  " << *it << endl;
+  }
+  f_out_.close();
+}
+
+void t_sizeinfo_generator::generate_struct(t_struct* tstruct) {
+  generate_struct_report(tstruct, false);
+}
+
+void t_sizeinfo_generator::generate_xception(t_struct* txception) {
+  generate_struct_report(txception, true);
+}
+
+void t_sizeinfo_generator::generate_struct_report(t_struct* tstruct, bool is_exception) {
+  string name = tstruct->get_name();
+  // in the order they are written
+  const vector<t_field*>& members = tstruct->get_sorted_members();
+  vector<t_field*>::const_iterator m_iter;
+
+  f_out_ << endl
+         << (is_exception ? "exception " : (tstruct->is_union() ? "union " : "struct ")) << name
+         << endl;
+
+  // Encoded sizes, naming the fields that leave the maximum unbounded
+  vector<string> unbounded;
+  for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
+    visiting_.insert(tstruct);
+    bool bounded = value_size((*m_iter)->get_type(), BINARY, true).bounded;
+    visiting_.clear();
+    if (!bounded) {
+      unbounded.push_back((*m_iter)->get_name());
+    }
+  }
+  f_out_ << "  binary:         " << describe(struct_size(tstruct, BINARY), unbounded) << endl;
+  f_out_ << "  compact:        " << describe(struct_size(tstruct, COMPACT), unbounded) << endl;
+
+  // Ids that take a long compact field header when all fields are present
+  int32_t previous_key = 0;
+  for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
+    int32_t key = (*m_iter)->get_key();
+    int32_t previous = tstruct->is_union() ? 0 : previous_key;
+    uint64_t header = compact_field_header_size(key, previous);
+    if (header > 1) {
+      ostringstream gap;
+      gap << "field " << key << " (" << (*m_iter)->get_name() << ") ";
+      if (key <= previous) {
+        gap << "has a non-positive id";
+      } else {
+        gap << "is " << (key - previous) << " ids after "
+            << (previous == 0 ? string("the start") : "field " + std::to_string(previous));
+      }
+      gap << ", its compact header takes " << header << " bytes instead of 1";
+      f_out_ << "  compact gap:    " << gap.str() << endl;
+      hot_spots_.push_back(name + ": " + gap.str());
+    }
+    previous_key = key;
+  }
+
+  // C++ layout as emitted by the cpp generator, and with cpp:compact_layout
+  cpp_layout layout = class_layout(tstruct, false, false);
+  cpp_layout compact = class_layout(tstruct, true, true);
+  cpp_layout reordered = class_layout(tstruct, true, false);
+  f_out_ << "  C++ layout:     sizeof " << layout.size << ", padding " << layout.padding << endl;
+  f_out_ << "  compact_layout: sizeof " << compact.size << ", padding " << compact.padding << endl;
+  if (reordered.size < layout.size) {
+    ostringstream saving;
+    saving << "declaring the fields widest first would save " << (layout.size - reordered.size)
+           << " of " << layout.size << " bytes in C++";
+    f_out_ << "  reordering:     " << saving.str() << endl;
+    hot_spots_.push_back(name + ": " + saving.str());
+  }
+
+  // Nesting
+  vector<string> chain;
+  bool recursive = false;
+  int depth = nesting_depth(tstruct, chain, recursive);
+  visiting_.clear();
+  string path;
+  for (vector<string>::const_iterator it = chain.begin(); it != chain.end(); ++it) {
+    path += (it == chain.begin() ? "" : " -> ") + *it;
+  }
+  f_out_ << "  nesting depth:  " << depth << (recursive ? ", recursive" : "") << " (" << path << ")"
+         << endl;
+  if (depth > nesting_limit_) {
+    ostringstream deep;
+    deep << "nested " << depth << " structs deep (" << path << ")";
+    hot_spots_.push_back(name + ": " + deep.str());
+  }
+  if (recursive) {
+    hot_spots_.push_back(name + ": nests recursive structs, its encoded size is unbounded");
+  }
+}
+
+string t_sizeinfo_generator::describe(const size_range& range, const vector<string>& unbounded) {
+  ostringstream out;
+  out << "min " << range.min << ", max ";
+  if (range.bounded) {
+    out << range.max;
+  } else {
+    out << "unbounded (";
+    for (vector<string>::const_iterator it = unbounded.begin(); it != unbounded.end(); ++it) {
+      out << (it == unbounded.begin() ? "" : ", ") << *it;
+    }
+    out << ")";
+  }
+  return out.str();
+}
+
+/**
+ * The compact protocol writes the difference to the previous field id into
+ * the type byte when it is 1 to 15, and the zigzag varint id otherwise
+ */
+uint64_t t_sizeinfo_generator::compact_field_header_size(int32_t key, int32_t previous_key) {
+  int32_t delta = key - previous_key;
+  if (delta > 0 && delta <= 15) {
+    return 1;
+  }
+  int16_t id = static_cast<int16_t>(key);
+  uint32_t zigzag = (static_cast<uint32_t>(id) << 1) ^ static_cast<uint32_t>(id >> 15);
+  return 1 + varint_size(zigzag & 0xffff);
+}
+
+size_range t_sizeinfo_generator::struct_size(t_struct* tstruct, protocol proto) {
+  uint64_t header = 3;
+  const vector<t_field*>& members = tstruct->get_sorted_members();
+  vector<t_field*>::const_iterator m_iter;
+
+  // The stop field
+  size_range size(1, 1);
+  if (visiting_.count(tstruct)) {
+    size.bounded = false;
+    return size;
+  }
+  visiting_.insert(tstruct);
+
+  if (tstruct->is_union()) {
+    // Exactly one field is set
+    size_range smallest(UINT64_MAX, 0);
+    for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
+      size_range field = value_size((*m_iter)->get_type(), proto, true);
+      uint64_t field_header = proto == BINARY ? header
+                                              : compact_field_header_size((*m_iter)->get_key(), 0);
+      smallest.min = std::min(smallest.min, field_header + field.min);
+      smallest.max = std::max(smallest.max, field_header + field.max);
+      smallest.bounded = smallest.bounded && field.bounded;
+    }
+    if (!members.empty()) {
+      size += smallest;
+    }
+  } else {
+    // Always written fields set the delta of the smallest encoding, and the
+    // largest header follows the last of them when optional fields are unset
+    int32_t previous_written = 0;
+    for (m_iter = members.begin(); m_iter != members.end(); ++m_iter) {
+      bool optional = (*m_iter)->get_req() == t_field::T_OPTIONAL;
+      int32_t key = (*m_iter)->get_key();
+      size_range field = value_size((*m_iter)->get_type(), proto, true);
+      if (proto == COMPACT) {
+        header = compact_field_header_size(key, previous_written);
+      }
+      field += size_range(header, header);
+      if (optional) {
+        field.min = 0;
+      } else {
+        previous_written = key;
+      }
+      size += field;
+    }
+  }
+
+  visiting_.erase(tstruct);
+  return size;
+}
+
+size_range t_sizeinfo_generator::value_size(t_type* ttype, protocol proto, bool is_field) {
+  ttype = get_true_type(ttype);
+  bool binary = proto == BINARY;
+
+  if (ttype->is_base_type()) {
+    switch (((t_base_type*)ttype)->get_base()) {
+    case t_base_type::TYPE_BOOL:
+      // compact puts the value of a bool field into its header
+      return (!binary && is_field) ? size_range(0, 0) : size_range(1, 1);
+    case t_base_type::TYPE_I8:
+      return size_range(1, 1);
+    case t_base_type::TYPE_I16:
+      return binary ? size_range(2, 2) : size_range(1, 3);
+    case t_base_type::TYPE_I32:
+      return binary ? size_range(4, 4) : size_range(1, 5);
+    case t_base_type::TYPE_I64:
+      return binary ? size_range(8, 8) : size_range(1, 10);
+    case t_base_type::TYPE_DOUBLE:
+      return size_range(8, 8);
+    case t_base_type::TYPE_STRING: {
+      size_range size = binary ? size_range(4, 4) : size_range(1, 5);
+      size.bounded = false;
+      return size;
+    }
+    default:
+      break;
+    }
+    return size_range();
+  } else if (ttype->is_enum()) {
+    return binary ? size_range(4, 4) : size_range(1, 5);
+  } else if (ttype->is_struct() || ttype->is_xception()) {
+    return struct_size((t_struct*)ttype, proto);
+  }
+
+  // Containers: element type and size header, empty at the least
+  size_range size;
+  if (ttype->is_map()) {
+    size = binary ? size_range(6, 6) : size_range(1, 6);
+  } else {
+    size = binary ? size_range(5, 5) : size_range(1, 6);
+  }
+  size.bounded = false;
+  return size;
+}
+
+/**
+ * Mirrors t_cpp_generator::get_field_alignment(), which orders the members
+ * with compact_layout
+ */
+int t_sizeinfo_generator::member_alignment(t_field* tfield) {
+  t_type* type = get_true_type(tfield->get_type());
+  if (tfield->get_reference()) {
+    return 8;
+  }
+  if (type->is_enum()) {
+    return 4;
+  }
+  if (type->is_base_type()) {
+    switch (((t_base_type*)type)->get_base()) {
+    case t_base_type::TYPE_BOOL:
+    case t_base_type::TYPE_I8:
+      return 1;
+    case t_base_type::TYPE_I16:
+      return 2;
+    case t_base_type::TYPE_I32:
+      return 4;
+    default:
+      break;
+    }
+  }
+  return 8;
+}
+
+bool t_sizeinfo_generator::is_lazy(t_field* tfield) {
+  t_type* ttype = get_true_type(tfield->get_type());
+  return !tfield->get_reference() && (ttype->is_struct() || ttype->is_xception())
+         && tfield->annotations_.find("cpp.lazy") != tfield->annotations_.end();
+}
+
+void t_sizeinfo_generator::member_layout(t_field* tfield,
+                                         bool compact_layout,
+                                         uint64_t& size,
+                                         uint64_t& align) {
+  t_type* ttype = get_true_type(tfield->get_type());
+  align = member_alignment(tfield);
+  if (tfield->get_reference()) {
+    // std::shared_ptr
+    size = 16;
+  } else if (ttype->is_base_type()) {
+    size = ((t_base_type*)ttype)->is_string() ? 32 : align;
+  } else if (ttype->is_enum()) {
+    size = 4;
+  } else if (ttype->is_list()) {
+    // std::vector<bool> keeps a bit iterator to the end
+    t_type* elem = get_true_type(((t_list*)ttype)->get_elem_type());
+    size = elem->is_bool() ? 40 : 24;
+  } else if (ttype->is_set() || ttype->is_map()) {
+    size = 48;
+  } else if (visiting_.count((t_struct*)ttype)) {
+    // only valid C++ through a reference, which is handled above
+    size = 8;
+  } else {
+    size = class_layout((t_struct*)ttype, compact_layout, compact_layout).size;
+    if (is_lazy(tfield)) {
+      // TLazyStruct: the value, the encoded bytes and a flag
+      size = round_up(size + 32 + 1, 8);
+    }
+  }
+}
+
+/**
+ * The cpp generator derives structs from TBase, a virtual base with nothing
+ * but a vtable pointer that shares the one of the class, and exceptions from
+ * TException. The members are followed by the __isset flags, one bit each
+ * for the fields that are not required, which compact_layout packs into 64
+ * bit words. Exceptions end with a string holding the what() message.
+ */
+cpp_layout t_sizeinfo_generator::class_layout(t_struct* tstruct, bool reorder, bool compact_isset) {
+  vector<t_field*> members = tstruct->get_members();
+  if (reorder) {
+    std::stable_sort(members.begin(), members.end(), [](t_field* a, t_field* b) {
+      return member_alignment(a) > member_alignment(b);
+    });
+  }
+
+  cpp_layout layout;
+  layout.align = 8;
+  // vtable pointer, or std::exception and the message of TException
+  uint64_t offset = tstruct->is_xception() ? 40 : 8;
+
+  visiting_.insert(tstruct);
+  size_t optional_flags = 0;
+  size_t default_flags = 0;
+  for (vector<t_field*>::const_iterator m_iter = members.begin(); m_iter != members.end();
+       ++m_iter) {
+    uint64_t size, align;
+    member_layout(*m_iter, compact_isset, size, align);
+    uint64_t aligned = round_up(offset, align);
+    layout.padding += aligned - offset;
+    offset = aligned + size;
+    if ((*m_iter)->get_req() == t_field::T_OPTIONAL) {
+      ++optional_flags;
+    } else if ((*m_iter)->get_req() != t_field::T_REQUIRED) {
+      ++default_flags;
+    }
+  }
+  visiting_.erase(tstruct);
+
+  if (optional_flags + default_flags > 0) {
+    if (compact_isset) {
+      uint64_t aligned = round_up(offset, 8);
+      layout.padding += aligned - offset;
+      offset = aligned + 8 * ((optional_flags + 63) / 64 + (default_flags + 63) / 64);
+    } else {
+      offset += (optional_flags + default_flags + 7) / 8;
+    }
+  }
+
+  if (tstruct->is_xception()) {
+    uint64_t aligned = round_up(offset, 8);
+    layout.padding += aligned - offset;
+    offset = aligned + 32;
+  }
+
+  layout.size = round_up(offset, layout.align);
+  layout.padding += layout.size - offset;
+  return layout;
+}
+
+/**
+ * Number of struct levels below and including ttype along its deepest path,
+ * which is returned in chain as "Struct.field" steps
+ */
+int t_sizeinfo_generator::nesting_depth(t_type* ttype, vector<string>& chain, bool& recursive) {
+  ttype = get_true_type(ttype);
+  chain.clear();
+  if (ttype->is_list()) {
+    return nesting_depth(((t_list*)ttype)->get_elem_type(), chain, recursive);
+  } else if (ttype->is_set()) {
+    return nesting_depth(((t_set*)ttype)->get_elem_type(), chain, recursive);
+  } else if (ttype->is_map()) {
+    vector<string> key_chain;
+    int key_depth = nesting_depth(((t_map*)ttype)->get_key_type(), key_chain, recursive);
+    int val_depth = nesting_depth(((t_map*)ttype)->get_val_type(), chain, recursive);
+    if (key_depth > val_depth) {
+      chain.swap(key_chain);
+      return key_depth;
+    }
+    return val_depth;
+  } else if (!ttype->is_struct() && !ttype->is_xception()) {
+    return 0;
+  }
+
+  t_struct* tstruct = (t_struct*)ttype;
+  if (visiting_.count(tstruct)) {
+    recursive = true;
+    return 0;
+  }
+  visiting_.insert(tstruct);
+
+  int deepest = 0;
+  string step = tstruct->get_name();
+  const vector<t_field*>& members = tstruct->get_members();
+  for (vector<t_field*>::const_iterator m_iter = members.begin(); m_iter != members.end();
+       ++m_iter) {
+    vector<string> field_chain;
+    int depth = nesting_depth((*m_iter)->get_type(), field_chain, recursive);
+    if (depth > deepest) {
+      deepest = depth;
+      step = tstruct->get_name() + "." + (*m_iter)->get_name();
+      chain.swap(field_chain);
+    }
+  }
+
+  visiting_.erase(tstruct);
+  chain.insert(chain.begin(), step);
+  return deepest + 1;
+}
+
+THRIFT_REGISTER_GENERATOR(
+    sizeinfo,
+    "Size and layout report",
+    "    nesting=N:       Report structs nested deeper than N levels as hot spots (default: 4).\n")
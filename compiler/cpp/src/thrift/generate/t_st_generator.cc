@@ -273,11 +273,11 @@ void t_st_generator::st_class_method(std::ostream& out, string cls, string name,
 void t_st_generator::st_method(std::ostream& out, string cls, string name, string category) {
   char timestr[50];
   time_t rawtime;
-  struct tm* tinfo;
+  struct tm tinfo;
 
   time(&rawtime);
-  tinfo = localtime(&rawtime);
-  strftime(timestr, 50, "%m/%d/%Y %H:%M", tinfo);
+  THRIFT_LOCALTIME(&rawtime, &tinfo);
+  strftime(timestr, 50, "%m/%d/%Y %H:%M", &tinfo);
 
   out << "!" << prefix(cls) << " methodsFor: '" + category + "' stamp: 'thrift " << timestr
       << "'!\n" << name << endl;
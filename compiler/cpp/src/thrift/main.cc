@@ -34,6 +34,14 @@
 #include <time.h>
 #include <string>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
@@ -53,6 +61,7 @@
 #include "thrift/parse/t_scope.h"
 #include "thrift/generate/t_generator.h"
 #include "thrift/audit/t_audit.h"
+#include "thrift/cache/t_cache.h"
 
 #include "thrift/version.h"
 
@@ -160,6 +169,85 @@ bool g_return_failure = false;
 bool g_audit_fatal = true;
 bool g_generator_failure = false;
 
+/**
+ * Print parse and generation timings
+ */
+bool g_stats = false;
+
+/**
+ * Number of programs to generate concurrently
+ */
+int g_jobs = 1;
+
+/**
+ * Guards state shared by concurrently running generators
+ */
+mutex g_generate_mutex;
+
+/**
+ * Set on the threads of a parallel generate(), where failure() must not exit
+ * while other threads are still writing their output
+ */
+thread_local bool g_generate_worker = false;
+
+/**
+ * Failure messages of the parallel generate() threads, and the number of
+ * them that are done with the current include level. Guarded by
+ * g_generate_mutex.
+ */
+vector<string> g_generate_failures;
+size_t g_generate_stopped = 0;
+condition_variable g_generate_stopped_cond;
+
+/**
+ * Directory of the code generation cache, if enabled
+ */
+string g_cache_dir;
+
+/**
+ * Dependency file to write, if any, and its rules
+ */
+string g_depfile;
+vector<depfile_rule> g_depfile_rules;
+
+/**
+ * Files written and time spent by the generators of each program
+ */
+map<t_program*, vector<string> > g_program_outputs;
+map<t_program*, double> g_program_generate_ms;
+
+/**
+ * Programs created for include directives, keyed by canonical path and the
+ * include prefix, so that a file included from many places is parsed once
+ */
+map<pair<string, string>, t_program*> g_program_cache;
+
+/**
+ * Programs that have been parsed, and the paths currently being parsed
+ */
+set<t_program*> g_parsed_programs;
+set<string> g_parsing_paths;
+
+/**
+ * Timings collected for --stats
+ */
+struct parse_stats {
+  string path;
+  double include_ms;
+  double program_ms;
+  size_t includes;
+  size_t reused;
+};
+vector<parse_stats> g_parse_stats;
+double g_generate_ms = 0;
+
+/**
+ * Milliseconds elapsed since start
+ */
+double elapsed_ms(chrono::steady_clock::time_point start) {
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
 /**
  * Win32 doesn't have realpath, so use fallback implementation in that case,
  * otherwise this just calls through to realpath
@@ -286,6 +374,21 @@ void pwarning(int level, const char* fmt, ...) {
   printf("\n");
 }
 
+/**
+ * Formats a failure message the way failure() prints it
+ */
+static string format_failure(const char* fmt, va_list args) {
+  va_list copy;
+  va_copy(copy, args);
+  int size = vsnprintf(nullptr, 0, fmt, copy);
+  va_end(copy);
+  vector<char> message(size > 0 ? size + 1 : 1);
+  vsnprintf(message.data(), message.size(), fmt, args);
+  char prefix[32];
+  snprintf(prefix, sizeof(prefix), ":%d] ", yylineno);
+  return "[FAILURE:" + g_curpath + prefix + message.data();
+}
+
 /**
  * Prints a failure message and exits
  *
@@ -293,6 +396,23 @@ void pwarning(int level, const char* fmt, ...) {
  */
 void failure(const char* fmt, ...) {
   va_list args;
+  if (g_generate_worker) {
+    // Leave the message for generate() to print once the other threads are
+    // done. This thread never returns to its caller, and is not unwound
+    // either, since failure() may be called from a destructor.
+    va_start(args, fmt);
+    string message = format_failure(fmt, args);
+    va_end(args);
+    {
+      lock_guard<mutex> lock(g_generate_mutex);
+      g_generate_failures.push_back(message);
+      ++g_generate_stopped;
+      g_generate_stopped_cond.notify_all();
+    }
+    for (;;) {
+      this_thread::sleep_for(chrono::hours(1));
+    }
+  }
   fprintf(stderr, "[FAILURE:%s:%d] ", g_curpath.c_str(), yylineno);
   va_start(args, fmt);
   vfprintf(stderr, fmt, args);
@@ -377,6 +497,37 @@ string include_file(string filename) {
   return std::string();
 }
 
+/**
+ * Finds or creates the program for a file with the given include prefix
+ */
+t_program* cached_program(string path, string include_prefix) {
+  pair<string, string> key(path, include_prefix);
+  map<pair<string, string>, t_program*>::iterator it = g_program_cache.find(key);
+  if (it != g_program_cache.end()) {
+    return it->second;
+  }
+
+  t_program* program = new t_program(path);
+  program->set_include_prefix(include_prefix);
+  g_program_cache[key] = program;
+  return program;
+}
+
+/**
+ * Finds or creates the program for an include file
+ */
+t_program* include_program(string path, string include_site) {
+  // include prefix for this program is the site at which it was included
+  // (minus the filename)
+  string include_prefix;
+  string::size_type last_slash = string::npos;
+  if ((last_slash = include_site.rfind("/")) != string::npos) {
+    include_prefix = include_site.substr(0, last_slash);
+  }
+
+  return cached_program(path, include_prefix);
+}
+
 /**
  * Clears any previously stored doctext string.
  * Also prints a warning if we are discarding information.
@@ -685,12 +836,22 @@ void help() {
   fprintf(stderr, "  -strict     Strict compiler warnings on\n");
   fprintf(stderr, "  -v[erbose]  Verbose mode\n");
   fprintf(stderr, "  -r[ecurse]  Also generate included files\n");
+  fprintf(stderr, "  -j N        Generate up to N included files at once (with -r)\n");
   fprintf(stderr, "  -debug      Parse debug trace to stdout\n");
+  fprintf(stderr, "  --stats     Print parse and generation timings to stderr\n");
   fprintf(stderr,
           "  --allow-neg-keys  Allow negative field keys (Used to "
           "preserve protocol\n");
   fprintf(stderr, "                compatibility with older .thrift files)\n");
   fprintf(stderr, "  --allow-64bit-consts  Do not print warnings about using 64-bit constants\n");
+  fprintf(stderr, "  --batch file  Generate code for each Thrift file listed in file, one\n");
+  fprintf(stderr, "                per line, instead of a single file. Files included by\n");
+  fprintf(stderr, "                several of them are parsed and generated once.\n");
+  fprintf(stderr, "  --cache dir  Skip parsing and generation when neither the input file,\n");
+  fprintf(stderr, "                the files it includes nor the options changed since a\n");
+  fprintf(stderr, "                previous run with the same cache directory\n");
+  fprintf(stderr, "  --depfile file  Write a Make-style dependency file listing the\n");
+  fprintf(stderr, "                generated files and the Thrift files they depend on\n");
   fprintf(stderr, "  --gen STR   Generate code with a dynamically-registered generator.\n");
   fprintf(stderr, "                STR has the form language[:key1=val1[,key2[,key3=val3]]].\n");
   fprintf(stderr, "                Keys and values are options passed to the generator.\n");
@@ -902,6 +1063,35 @@ bool skip_utf8_bom(FILE* f) {
   return false;
 }
 
+/**
+ * Adds the definitions of an already parsed program to the scope of a program
+ * that includes it, as parsing it with that parent would have done
+ */
+void import_program_scope(t_program* parent_program, t_program* program) {
+  t_scope* scope = parent_program->scope();
+  string prefix = program->get_name() + ".";
+
+  for (auto tdef : program->get_typedefs()) {
+    scope->add_type(prefix + tdef->get_name(), tdef);
+  }
+  for (auto tenum : program->get_enums()) {
+    scope->add_type(prefix + tenum->get_name(), tenum);
+    for (auto value : tenum->get_constants()) {
+      string const_name = tenum->get_name() + "." + value->get_name();
+      scope->add_constant(prefix + const_name, program->scope()->get_constant(const_name));
+    }
+  }
+  for (auto tstruct : program->get_objects()) {
+    scope->add_type(prefix + tstruct->get_name(), tstruct);
+  }
+  for (auto tservice : program->get_services()) {
+    scope->add_service(prefix + tservice->get_name(), tservice);
+  }
+  for (auto tconst : program->get_consts()) {
+    scope->add_constant(prefix + tconst->get_name(), tconst);
+  }
+}
+
 /**
  * Parses a program
  */
@@ -909,6 +1099,16 @@ void parse(t_program* program, t_program* parent_program) {
   // Get scope file path
   string path = program->get_path();
 
+  if (g_parsing_paths.count(path)) {
+    failure("Circular include of \"%s\"", path.c_str());
+  }
+  g_parsing_paths.insert(path);
+
+  parse_stats stats;
+  stats.path = path;
+  stats.reused = 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
   // Set current dir global, which is used in the include_file function
   g_curdir = directory_name(path);
   g_curpath = path;
@@ -922,7 +1122,8 @@ void parse(t_program* program, t_program* parent_program) {
   if (skip_utf8_bom(yyin))
     pverbose("Skipped UTF-8 BOM at %s\n", path.c_str());
 
-  // Create new scope and scan for includes
+  // Create new scope and scan for includes. The scanner stops at the first
+  // definition, since includes may only appear in the header.
   pverbose("Scanning %s for includes\n", path.c_str());
   g_parse_mode = INCLUDES;
   g_program = program;
@@ -936,18 +1137,33 @@ void parse(t_program* program, t_program* parent_program) {
     failure(x.c_str());
   }
   fclose(yyin);
+  stats.include_ms = elapsed_ms(start);
 
-  // Recursively parse all the include programs
+  // Recursively parse all the include programs. A program already parsed
+  // through another include site only needs its definitions added to this
+  // program's scope.
   vector<t_program*>& includes = program->get_includes();
   vector<t_program*>::iterator iter;
   for (iter = includes.begin(); iter != includes.end(); ++iter) {
-    parse(*iter, program);
+    if (g_parsed_programs.count(*iter)) {
+      pverbose("Reusing %s\n", (*iter)->get_path().c_str());
+      try {
+        import_program_scope(program, *iter);
+      } catch (string &x) {
+        failure(x.c_str());
+      }
+      ++stats.reused;
+    } else {
+      parse(*iter, program);
+    }
   }
+  stats.includes = includes.size();
 
   // reset program doctext status before parsing a new file
   reset_program_doctext_info();
 
   // Parse the program file
+  start = chrono::steady_clock::now();
   g_parse_mode = PROGRAM;
   g_program = program;
   g_scope = program->scope();
@@ -974,12 +1190,57 @@ void parse(t_program* program, t_program* parent_program) {
     failure(x.c_str());
   }
   fclose(yyin);
+  stats.program_ms = elapsed_ms(start);
+
+  g_parsing_paths.erase(path);
+  g_parsed_programs.insert(program);
+  if (g_stats) {
+    g_parse_stats.push_back(stats);
+  }
+}
+
+/**
+ * Prints the timings collected for --stats
+ */
+void print_stats(double total_ms) {
+  double parse_ms = 0;
+  size_t includes = 0, reused = 0;
+  fprintf(stderr, "%10s %10s  %s\n", "scan ms", "parse ms", "file");
+  for (auto& stats : g_parse_stats) {
+    fprintf(stderr, "%10.2f %10.2f  %s (%lu includes, %lu reused)\n",
+            stats.include_ms,
+            stats.program_ms,
+            stats.path.c_str(),
+            (unsigned long)stats.includes,
+            (unsigned long)stats.reused);
+    parse_ms += stats.include_ms + stats.program_ms;
+    includes += stats.includes;
+    reused += stats.reused;
+  }
+  fprintf(stderr,
+          "%lu files parsed, %lu of %lu includes reused\n",
+          (unsigned long)g_parse_stats.size(),
+          (unsigned long)reused,
+          (unsigned long)includes);
+  fprintf(stderr,
+          "parse %.2f ms, generate %.2f ms, total %.2f ms\n",
+          parse_ms,
+          g_generate_ms,
+          total_ms);
 }
 
 /**
- * Generate code
+ * Collects a program and, when generating recursively, the programs it
+ * includes, each after the programs it includes
  */
-void generate(t_program* program, const vector<string>& generator_strings) {
+void collect_programs(t_program* program, vector<t_program*>& programs) {
+  // Included programs are shared between include sites, so only generate
+  // each of them once
+  static set<t_program*> collected;
+  if (!collected.insert(program).second) {
+    return;
+  }
+
   // Oooohh, recursive code generation, hot!!
   if (gen_recurse) {
     program->set_recursive(true);
@@ -988,10 +1249,20 @@ void generate(t_program* program, const vector<string>& generator_strings) {
       // Propagate output path from parent to child programs
       include->set_out_path(program->get_out_path(), program->is_out_path_absolute());
 
-      generate(include, generator_strings);
+      collect_programs(include, programs);
     }
   }
 
+  programs.push_back(program);
+}
+
+/**
+ * Generate code for a single program
+ */
+void generate_program(t_program* program, const vector<string>& generator_strings) {
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  clear_generated_files();
+
   // Generate code!
   try {
     pverbose("Program: %s\n", program->get_path().c_str());
@@ -1006,6 +1277,7 @@ void generate(t_program* program, const vector<string>& generator_strings) {
 
       if (generator == nullptr) {
         pwarning(1, "Unable to get a generator for \"%s\".\n", iter->c_str());
+        lock_guard<mutex> lock(g_generate_mutex);
         g_generator_failure = true;
       } else if (generator) {
         generator->validate_input();
@@ -1021,6 +1293,326 @@ void generate(t_program* program, const vector<string>& generator_strings) {
   } catch (const std::invalid_argument& invalid_argument_exception) {
     failure("Error: %s\n", invalid_argument_exception.what());
   }
+
+  lock_guard<mutex> lock(g_generate_mutex);
+  g_program_outputs[program] = generated_files();
+  g_program_generate_ms[program] = elapsed_ms(start);
+}
+
+/**
+ * Depth of a program in the include graph: 0 if it includes nothing, else
+ * one more than the deepest program it includes
+ */
+size_t include_level(t_program* program, map<t_program*, size_t>& levels) {
+  map<t_program*, size_t>::const_iterator it = levels.find(program);
+  if (it != levels.end()) {
+    return it->second;
+  }
+  size_t level = 0;
+  for (auto include : program->get_includes()) {
+    level = (std::max)(level, include_level(include, levels) + 1);
+  }
+  levels[program] = level;
+  return level;
+}
+
+/**
+ * Generate code for a list of programs
+ */
+void generate(const vector<t_program*>& programs, const vector<string>& generator_strings) {
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  size_t jobs = (std::min)(static_cast<size_t>(g_jobs), programs.size());
+  if (jobs <= 1) {
+    for (auto p : programs) {
+      generate_program(p, generator_strings);
+    }
+  } else {
+    // Generators update the parse tree of the program they generate (the go
+    // generator makes union fields optional, for example), and the
+    // generators of a program read the trees of the programs it includes.
+    // So programs are generated one include level at a time: those of a
+    // level include none of each other and can be generated concurrently,
+    // once every program they include is done. The generators of a single
+    // program still run in order on one thread.
+    map<t_program*, size_t> levels;
+    vector<vector<t_program*> > by_level;
+    for (auto p : programs) {
+      size_t level = include_level(p, levels);
+      if (level >= by_level.size()) {
+        by_level.resize(level + 1);
+      }
+      by_level[level].push_back(p);
+    }
+
+    //
+    // A thread that fails stops in failure(); the others finish the program
+    // they are generating and start no other, then the failures are printed
+    // and the compiler exits.
+    for (const auto& level : by_level) {
+      atomic<size_t> next(0);
+      vector<thread> workers;
+      size_t count = (std::min)(jobs, level.size());
+      g_generate_stopped = 0;
+      for (size_t j = 0; j < count; ++j) {
+        workers.emplace_back([&]() {
+          g_generate_worker = true;
+          size_t index;
+          while ((index = next++) < level.size()) {
+            {
+              lock_guard<mutex> lock(g_generate_mutex);
+              if (!g_generate_failures.empty()) {
+                break;
+              }
+            }
+            generate_program(level[index], generator_strings);
+          }
+          lock_guard<mutex> lock(g_generate_mutex);
+          ++g_generate_stopped;
+          g_generate_stopped_cond.notify_all();
+        });
+      }
+
+      vector<string> failures;
+      {
+        unique_lock<mutex> lock(g_generate_mutex);
+        g_generate_stopped_cond.wait(lock, [&]() { return g_generate_stopped == count; });
+        failures = g_generate_failures;
+      }
+      if (!failures.empty()) {
+        for (const auto& message : failures) {
+          fprintf(stderr, "%s", message.c_str());
+          printf("\n");
+        }
+        // the threads that failed cannot be joined
+        for (auto& worker : workers) {
+          worker.detach();
+        }
+        exit(1);
+      }
+      for (auto& worker : workers) {
+        worker.join();
+      }
+    }
+  }
+
+  g_generate_ms += elapsed_ms(start);
+}
+
+/**
+ * Collects the paths of a program and all programs it includes
+ */
+void collect_idl_files(const t_program* program, set<string>& paths) {
+  if (!paths.insert(program->get_path()).second) {
+    return;
+  }
+  for (auto include : program->get_includes()) {
+    collect_idl_files(include, paths);
+  }
+}
+
+/**
+ * An input file given on the command line or in a batch file
+ */
+struct compile_job {
+  string input_filename;
+  string input_file;
+  t_program* program;
+  vector<t_program*> programs;
+  vector<string> cache_key;
+  string cache_entry;
+  bool up_to_date;
+  double parse_ms;
+};
+
+/**
+ * Resolves the input file of a job, and checks whether the code generation
+ * cache shows that its output is already up to date
+ */
+void prepare_job(compile_job& job,
+                 const vector<string>& generator_strings,
+                 const string& out_path,
+                 bool out_path_is_absolute) {
+  // Real-pathify it
+  char rp[THRIFT_PATH_MAX];
+  // cppcheck-suppress uninitvar
+  if (saferealpath(job.input_filename.c_str(), rp) == nullptr) {
+    failure("Could not open input file with realpath: %s", job.input_filename.c_str());
+  }
+  job.input_file = rp;
+  job.program = nullptr;
+  job.up_to_date = false;
+  job.parse_ms = 0;
+
+  // Compute the cpp include prefix.
+  // infer this from the filename passed in
+  string include_prefix;
+
+  string::size_type last_slash = string::npos;
+  if ((last_slash = job.input_filename.rfind("/")) != string::npos) {
+    include_prefix = job.input_filename.substr(0, last_slash);
+  }
+
+  // Everything besides the IDL files that affects the generated code
+  if (!g_cache_dir.empty()) {
+    char cwd[THRIFT_PATH_MAX];
+    job.cache_key.push_back(string("version ") + THRIFT_VERSION);
+    job.cache_key.push_back(string("cwd ") + (saferealpath(".", cwd) ? cwd : "."));
+    job.cache_key.push_back("input " + job.input_file);
+    job.cache_key.push_back("include_prefix " + include_prefix);
+    job.cache_key.push_back("out " + out_path + (out_path_is_absolute ? " absolute" : ""));
+    job.cache_key.push_back(string("recurse ") + (gen_recurse ? "1" : "0"));
+    for (const auto& generator_string : generator_strings) {
+      job.cache_key.push_back("gen " + generator_string);
+    }
+    for (const auto& dir : g_incl_searchpath) {
+      job.cache_key.push_back("I " + dir);
+    }
+    job.cache_key.push_back("flags " + to_string(g_strict) + " " + to_string(g_allow_neg_field_keys)
+                            + " " + to_string(g_allow_64bit_consts));
+
+    job.cache_entry = codegen_cache_entry(g_cache_dir, job.cache_key);
+    depfile_rule rule;
+    if (codegen_cache_lookup(job.cache_entry, job.cache_key, rule.inputs, rule.outputs)) {
+      pverbose("%s is up to date\n", job.input_file.c_str());
+      g_depfile_rules.push_back(rule);
+      job.up_to_date = true;
+      return;
+    }
+  }
+
+  // Input files are shared with the programs included by earlier files of a
+  // batch, so a file may already have been parsed
+  job.program = cached_program(job.input_file, include_prefix);
+  if (out_path.size()) {
+    job.program->set_out_path(out_path, out_path_is_absolute);
+  }
+}
+
+/**
+ * Records the dependencies and cache entry of a job once it is generated
+ */
+void finish_job(compile_job& job) {
+  if (g_depfile.empty() && (job.cache_entry.empty() || g_generator_failure)) {
+    return;
+  }
+
+  set<string> idl_files;
+  collect_idl_files(job.program, idl_files);
+
+  // Programs shared with earlier files of a batch are generated, and so
+  // listed, only once
+  depfile_rule rule;
+  rule.inputs.assign(idl_files.begin(), idl_files.end());
+  for (auto program : job.programs) {
+    const vector<string>& outputs = g_program_outputs[program];
+    rule.outputs.insert(rule.outputs.end(), outputs.begin(), outputs.end());
+  }
+  sort(rule.outputs.begin(), rule.outputs.end());
+  g_depfile_rules.push_back(rule);
+
+  // An entry without outputs could never notice them being deleted
+  if (!job.cache_entry.empty() && !g_generator_failure && !rule.outputs.empty()) {
+    codegen_cache_store(job.cache_entry, job.cache_key, rule.inputs, rule.outputs);
+  }
+}
+
+/**
+ * Parses input files and generates code for them, skipping files that the
+ * code generation cache shows to be up to date. Files included by several
+ * inputs are parsed and generated once.
+ */
+void compile(vector<compile_job>& jobs,
+             const vector<string>& generator_strings,
+             const string& out_path,
+             bool out_path_is_absolute) {
+  vector<t_program*> programs;
+  for (auto& job : jobs) {
+    prepare_job(job, generator_strings, out_path, out_path_is_absolute);
+    if (job.up_to_date) {
+      continue;
+    }
+
+    // Parse it!
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (!g_parsed_programs.count(job.program)) {
+      parse(job.program, nullptr);
+    }
+    job.parse_ms = elapsed_ms(start);
+
+    collect_programs(job.program, job.programs);
+    programs.insert(programs.end(), job.programs.begin(), job.programs.end());
+  }
+
+  // The current path is not really relevant when we are doing generation.
+  // Reset the variable to make warning messages clearer.
+  g_curpath = "generation";
+  // Reset yylineno for the heck of it.  Use 1 instead of 0 because
+  // That is what shows up during argument parsing.
+  yylineno = 1;
+
+  // Generate it!
+  generate(programs, generator_strings);
+
+  for (auto& job : jobs) {
+    if (!job.up_to_date) {
+      finish_job(job);
+    }
+  }
+}
+
+/**
+ * Reads the input files of a batch, one per line. Empty lines and lines
+ * starting with # are skipped.
+ */
+vector<compile_job> read_batch_file(const string& path) {
+  ifstream in(path.c_str());
+  if (!in) {
+    failure("Could not open batch file: %s", path.c_str());
+  }
+
+  vector<compile_job> jobs;
+  string line;
+  while (getline(in, line)) {
+    string::size_type begin = line.find_first_not_of(" \t\r");
+    if (begin == string::npos || line[begin] == '#') {
+      continue;
+    }
+    string::size_type end = line.find_last_not_of(" \t\r");
+    compile_job job;
+    job.input_filename = line.substr(begin, end - begin + 1);
+    jobs.push_back(job);
+  }
+  return jobs;
+}
+
+/**
+ * Prints how long a batch took and, with --stats, how long each file took
+ */
+void print_batch_stats(const vector<compile_job>& jobs, double total_ms) {
+  size_t up_to_date = 0;
+  for (const auto& job : jobs) {
+    double generate_ms = 0;
+    for (auto program : job.programs) {
+      generate_ms += g_program_generate_ms[program];
+    }
+    if (job.up_to_date) {
+      ++up_to_date;
+    }
+    if (!g_stats) {
+      continue;
+    }
+    fprintf(stderr,
+            "%10.2f ms  %s%s\n",
+            job.parse_ms + generate_ms,
+            job.input_filename.c_str(),
+            job.up_to_date ? " (up to date)" : "");
+  }
+  fprintf(stderr,
+          "%lu files, %lu up to date, in %.2f ms\n",
+          (unsigned long)jobs.size(),
+          (unsigned long)up_to_date,
+          total_ms);
 }
 
 void audit(t_program* new_program,
@@ -1058,6 +1650,8 @@ int main(int argc, char** argv) {
   std::string out_path;
   bool out_path_is_absolute = false;
 
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
   // Setup time string
   time_t now = time(nullptr);
   g_time_str = ctime(&now);
@@ -1069,6 +1663,7 @@ int main(int argc, char** argv) {
   }
 
   vector<string> generator_strings;
+  string batch_file;
   string old_thrift_include_path;
   string new_thrift_include_path;
   string old_input_file;
@@ -1076,8 +1671,17 @@ int main(int argc, char** argv) {
   // Set the current path to a dummy value to make warning messages clearer.
   g_curpath = "arguments";
 
+  // The last argument is the input file, unless the input files are listed
+  // in a batch file
+  int last_option = argc - 1;
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-batch") == 0 || strcmp(argv[i], "--batch") == 0) {
+      last_option = argc;
+    }
+  }
+
   // Hacky parameter handling... I didn't feel like using a library sorry!
-  for (i = 1; i < argc - 1; i++) {
+  for (i = 1; i < last_option; i++) {
     char* arg;
 
     arg = strtok(argv[i], " ");
@@ -1094,6 +1698,36 @@ int main(int argc, char** argv) {
         exit(0);
       } else if (strcmp(arg, "-debug") == 0) {
         g_debug = 1;
+      } else if (strcmp(arg, "-stats") == 0) {
+        g_stats = true;
+      } else if (strcmp(arg, "-batch") == 0) {
+        arg = argv[++i];
+        if (arg == nullptr) {
+          fprintf(stderr, "Missing batch file name\n");
+          usage();
+        }
+        batch_file = arg;
+      } else if (strcmp(arg, "-cache") == 0) {
+        arg = argv[++i];
+        if (arg == nullptr) {
+          fprintf(stderr, "Missing cache directory\n");
+          usage();
+        }
+        g_cache_dir = arg;
+      } else if (strcmp(arg, "-depfile") == 0) {
+        arg = argv[++i];
+        if (arg == nullptr) {
+          fprintf(stderr, "Missing dependency file name\n");
+          usage();
+        }
+        g_depfile = arg;
+      } else if (strcmp(arg, "-j") == 0) {
+        arg = argv[++i];
+        if (arg == nullptr || atoi(arg) < 1) {
+          fprintf(stderr, "-j: missing or invalid number of jobs\n");
+          usage();
+        }
+        g_jobs = atoi(arg);
       } else if (strcmp(arg, "-nowarn") == 0) {
         g_warn = 0;
       } else if (strcmp(arg, "-strict") == 0) {
@@ -1228,49 +1862,31 @@ int main(int argc, char** argv) {
       usage();
     }
 
-    // Real-pathify it
-    char rp[THRIFT_PATH_MAX];
-    if (argv[i] == nullptr) {
-      fprintf(stderr, "Missing file name\n");
-      usage();
-    }
-    // cppcheck-suppress uninitvar
-    if (saferealpath(argv[i], rp) == nullptr) {
-      failure("Could not open input file with realpath: %s", argv[i]);
-    }
-    string input_file(rp);
-
-    // Instance of the global parse tree
-    t_program* program = new t_program(input_file);
-    if (out_path.size()) {
-      program->set_out_path(out_path, out_path_is_absolute);
+    vector<compile_job> jobs;
+    if (!batch_file.empty()) {
+      jobs = read_batch_file(batch_file);
+    } else {
+      if (argv[i] == nullptr) {
+        fprintf(stderr, "Missing file name\n");
+        usage();
+      }
+      jobs.resize(1);
+      jobs[0].input_filename = argv[i];
     }
 
-    // Compute the cpp include prefix.
-    // infer this from the filename passed in
-    string input_filename = argv[i];
-    string include_prefix;
+    compile(jobs, generator_strings, out_path, out_path_is_absolute);
 
-    string::size_type last_slash = string::npos;
-    if ((last_slash = input_filename.rfind("/")) != string::npos) {
-      include_prefix = input_filename.substr(0, last_slash);
+    if (!batch_file.empty()) {
+      print_batch_stats(jobs, elapsed_ms(start));
     }
 
-    program->set_include_prefix(include_prefix);
-
-    // Parse it!
-    parse(program, nullptr);
-
-    // The current path is not really relevant when we are doing generation.
-    // Reset the variable to make warning messages clearer.
-    g_curpath = "generation";
-    // Reset yylineno for the heck of it.  Use 1 instead of 0 because
-    // That is what shows up during argument parsing.
-    yylineno = 1;
+    if (!g_depfile.empty()) {
+      write_depfile(g_depfile, g_depfile_rules);
+    }
+  }
 
-    // Generate it!
-    generate(program, generator_strings);
-    delete program;
+  if (g_stats) {
+    print_stats(elapsed_ms(start));
   }
 
   // Clean up. Who am I kidding... this program probably orphans heap memory
@@ -28,6 +28,8 @@
 #include "thrift/parse/t_const.h"
 #include "thrift/parse/t_field.h"
 
+class t_program;
+
 /**
  * Defined in the flex library
  */
@@ -76,6 +78,11 @@ std::string directory_name(std::string filename);
  */
 std::string include_file(std::string filename);
 
+/**
+ * Get the program for an include file, shared by all sites that include it
+ */
+t_program* include_program(std::string path, std::string include_site);
+
 /**
  * Clears any previously stored doctext string.
  */
@@ -46,7 +46,10 @@ public:
 
   void add_type(std::string name, t_type* type) { types_[name] = type; }
 
-  t_type* get_type(std::string name) { return types_[name]; }
+  t_type* get_type(std::string name) {
+    const auto it = types_.find(name);
+    return types_.end() != it ? it->second : nullptr;
+  }
 
   const t_type* get_type(std::string name) const {
     const auto it = types_.find(name);
@@ -59,7 +62,10 @@ public:
 
   void add_service(std::string name, t_service* service) { services_[name] = service; }
 
-  t_service* get_service(std::string name) { return services_[name]; }
+  t_service* get_service(std::string name) {
+    const auto it = services_.find(name);
+    return services_.end() != it ? it->second : nullptr;
+  }
 
   const t_service* get_service(std::string name) const { 
     const auto it = services_.find(name);
@@ -78,7 +84,10 @@ public:
     }
   }
 
-  t_const* get_constant(std::string name) { return constants_[name]; }
+  t_const* get_constant(std::string name) {
+    const auto it = constants_.find(name);
+    return constants_.end() != it ? it->second : nullptr;
+  }
 
   const t_const* get_constant(std::string name) const { 
     const auto it = constants_.find(name);
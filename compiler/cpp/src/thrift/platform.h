@@ -43,6 +43,13 @@
 #define MKDIR(x) { int r = mkdir(x, S_IRWXU | S_IRWXG | S_IRWXO); if (r == -1 && errno != EEXIST) { throw (std::string(x) + ": ") + strerror(errno); } }
 #endif
 
+// thread safe localtime(), as generators may run concurrently
+#ifdef _WIN32
+#define THRIFT_LOCALTIME(t, tm) localtime_s(tm, t)
+#else
+#define THRIFT_LOCALTIME(t, tm) localtime_r(t, tm)
+#endif
+
 #ifdef PATH_MAX
 #define THRIFT_PATH_MAX PATH_MAX
 #else
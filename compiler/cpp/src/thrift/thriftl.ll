@@ -86,6 +86,17 @@ void unexpected_token(char* text) {
   exit(1);
 }
 
+/**
+ * Includes may only appear in the header, so the include pass ends the input
+ * at the first definition instead of scanning the rest of the file.
+ */
+#define DEFINITION_TOKEN(tok)         \
+  if (g_parse_mode == INCLUDES) {     \
+    yy_flush_buffer(YY_CURRENT_BUFFER); \
+    return 0;                         \
+  }                                   \
+  return tok
+
 %}
 
 /**
@@ -239,21 +250,21 @@ literal_begin (['\"])
 }
 "senum" {
   pwarning(0, "\"senum\" is deprecated and will be removed in a future compiler version.  This type should be replaced with \"string\".\n");
-  return tok_senum;
+  DEFINITION_TOKEN(tok_senum);
 }
 "map"                { return tok_map;                  }
 "list"               { return tok_list;                 }
 "set"                { return tok_set;                  }
 "oneway"             { return tok_oneway;               }
-"typedef"            { return tok_typedef;              }
-"struct"             { return tok_struct;               }
-"union"              { return tok_union;                }
-"exception"          { return tok_xception;             }
+"typedef"            { DEFINITION_TOKEN(tok_typedef);   }
+"struct"             { DEFINITION_TOKEN(tok_struct);    }
+"union"              { DEFINITION_TOKEN(tok_union);     }
+"exception"          { DEFINITION_TOKEN(tok_xception);  }
 "extends"            { return tok_extends;              }
 "throws"             { return tok_throws;               }
-"service"            { return tok_service;              }
-"enum"               { return tok_enum;                 }
-"const"              { return tok_const;                }
+"service"            { DEFINITION_TOKEN(tok_service);   }
+"enum"               { DEFINITION_TOKEN(tok_enum);      }
+"const"              { DEFINITION_TOKEN(tok_const);     }
 "required"           { return tok_required;             }
 "optional"           { return tok_optional;             }
 "async" {
@@ -330,7 +330,7 @@ Include:
       if (g_parse_mode == INCLUDES) {
         std::string path = include_file(std::string($2));
         if (!path.empty()) {
-          g_program->add_include(path, std::string($2));
+          g_program->add_include(include_program(path, std::string($2)));
         }
       }
     }
@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements. See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership. The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+from __future__ import print_function
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+
+class TestBatch(unittest.TestCase):
+    """
+    Generates code for several input files with --batch, and compares the
+    result to generating each of them with a separate invocation.
+    """
+
+    CURRENT_DIR_PATH = os.path.dirname(os.path.realpath(__file__))
+    THRIFT_EXECUTABLE_PATH = None
+    GENERATORS = ["-gen", "cpp", "-gen", "py"]
+
+    SHARED = """
+namespace * shared
+
+struct Shared {
+  1: i32 id
+  2: string name
+}
+"""
+
+    USER = """
+include "Shared.thrift"
+
+namespace * {name}
+
+struct {name} {{
+  1: Shared.Shared shared
+}}
+
+service {name}Service {{
+  Shared.Shared get(1: {name} request)
+}}
+"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp(dir=TestBatch.CURRENT_DIR_PATH)
+        self.write("Shared.thrift", TestBatch.SHARED)
+        self.inputs = []
+        for name in ["Alpha", "Beta", "Gamma"]:
+            self.inputs.append(self.write(name + ".thrift", TestBatch.USER.format(name=name)))
+
+        self.batch_file_path = self.write("inputs.txt", "\n".join([
+            "# Thrift files of the test",
+            "",
+            self.inputs[0],
+            "   ",
+            "  # Beta is indented, and followed by blanks",
+            "\t" + self.inputs[1] + "  ",
+            self.inputs[2] + "\r",
+            ""]))
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir, ignore_errors=True)
+
+    def write(self, name, contents):
+        path = os.path.join(self.temp_dir, name)
+        written_file = open(path, "w")
+        written_file.write(contents)
+        written_file.close()
+        return path
+
+    def read(self, path):
+        read_file = open(path, "rb")
+        contents = read_file.read()
+        read_file.close()
+        return contents
+
+    def read_tree(self, root):
+        files = {}
+        for dir_path, _, file_names in os.walk(root):
+            for file_name in file_names:
+                path = os.path.join(dir_path, file_name)
+                files[os.path.relpath(path, root)] = self.read(path)
+        return files
+
+    def run_thrift(self, arguments):
+        command = [TestBatch.THRIFT_EXECUTABLE_PATH, "-r"] + TestBatch.GENERATORS + arguments
+        process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        stdout, stderr = process.communicate()
+        self.assertEqual(process.returncode, 0, stderr.decode("utf-8", "replace"))
+
+    def run_batch(self, out_name):
+        out_dir_path = os.path.join(self.temp_dir, out_name)
+        if not os.path.isdir(out_dir_path):
+            os.mkdir(out_dir_path)
+        self.run_thrift(["-o", out_dir_path, "--cache", self.cache_dir_path(), "--depfile", self.depfile_path(),
+                         "--batch", self.batch_file_path])
+        return out_dir_path
+
+    def cache_dir_path(self):
+        return os.path.join(self.temp_dir, "cache")
+
+    def depfile_path(self):
+        return os.path.join(self.temp_dir, "batch.d")
+
+    def depfile_rules(self):
+        """
+        Returns the targets and prerequisites of the rules of the depfile,
+        leaving out the empty rules it adds for each input
+        """
+        contents = self.read(self.depfile_path()).decode("utf-8").replace(" \\\n", " ")
+        rules = []
+        for line in contents.split("\n"):
+            if not line:
+                continue
+            targets, prerequisites = line.split(":", 1)
+            if prerequisites.split():
+                rules.append((targets.split(), prerequisites.split()))
+        return rules
+
+    def test_batch_output_matches_separate_invocations(self):
+        separate_path = os.path.join(self.temp_dir, "separate")
+        os.mkdir(separate_path)
+        for input_path in self.inputs:
+            self.run_thrift(["-o", separate_path, input_path])
+
+        batch = self.read_tree(self.run_batch("batch"))
+        separate = self.read_tree(separate_path)
+        self.assertIn(os.path.join("gen-cpp", "Shared_types.h"), batch)
+        self.assertIn(os.path.join("gen-py", "Gamma", "ttypes.py"), batch)
+        self.assertEqual(sorted(batch.keys()), sorted(separate.keys()))
+        for name in separate:
+            self.assertEqual(batch[name], separate[name], name)
+
+    def test_batch_depfile_and_cache_have_an_entry_per_input(self):
+        out_dir_path = self.run_batch("batch")
+
+        rules = self.depfile_rules()
+        self.assertEqual(len(rules), len(self.inputs))
+        shared_path = os.path.join(self.temp_dir, "Shared.thrift")
+        for (targets, prerequisites), input_path in zip(rules, self.inputs):
+            self.assertEqual(sorted(prerequisites), sorted([input_path, shared_path]))
+            self.assertTrue(targets)
+
+        # Shared is generated once, with the first input that includes it, so
+        # only that rule lists its files. Together the rules list every
+        # generated file.
+        shared_types_path = os.path.join(out_dir_path, "gen-cpp", "Shared_types.h")
+        self.assertEqual([shared_types_path in rule[0] for rule in rules], [True, False, False])
+        targets = set(target for rule in rules for target in rule[0])
+        generated = set(os.path.join(out_dir_path, name) for name in self.read_tree(out_dir_path))
+        self.assertEqual(targets, generated)
+
+        entries = sorted(os.listdir(self.cache_dir_path()))
+        self.assertEqual(len(entries), len(self.inputs))
+        keys = set()
+        for entry in entries:
+            self.assertTrue(entry.endswith(".cache"), entry)
+            for line in self.read(os.path.join(self.cache_dir_path(), entry)).decode("utf-8").split("\n"):
+                if line.startswith("key input "):
+                    keys.add(line[len("key input "):])
+        self.assertEqual(keys, set(self.inputs))
+
+        # A second run finds every input in the cache and writes the same
+        # dependencies
+        depfile_contents = self.read(self.depfile_path())
+        self.run_batch("batch")
+        self.assertEqual(self.read(self.depfile_path()), depfile_contents)
+        self.assertEqual(sorted(os.listdir(self.cache_dir_path())), entries)
+
+
+def suite():
+    suite = unittest.TestSuite()
+    loader = unittest.TestLoader()
+    suite.addTest(loader.loadTestsFromTestCase(TestBatch))
+    return suite
+
+
+if __name__ == "__main__":
+    # The path of Thrift compiler is passed as an argument to the test script.
+    # Remove it to not confuse the unit testing framework
+    TestBatch.THRIFT_EXECUTABLE_PATH = sys.argv[-1]
+    del sys.argv[-1]
+    unittest.main(defaultTest="suite", testRunner=unittest.TextTestRunner(verbosity=2))
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements. See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership. The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+from __future__ import print_function
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+
+class TestParallelGeneration(unittest.TestCase):
+    """
+    Generates a diamond of includes, Top on Left and Right and both of them
+    on Base, with -j 1 and with -j 4, and compares the output.
+    """
+
+    CURRENT_DIR_PATH = os.path.dirname(os.path.realpath(__file__))
+    THRIFT_EXECUTABLE_PATH = None
+    GENERATORS = ["cpp", "py", "go", "java:generated_annotations=undated", "js", "json"]
+
+    BASE = """
+namespace * base
+
+const i32 BASE_VERSION = 3
+
+enum Kind {
+  SMALL = 1,
+  LARGE = 2
+}
+
+struct Base {
+  1: required i32 id
+  2: optional string name
+  3: Kind kind = Kind.SMALL
+  4: list<map<string, set<i64>>> nested
+}
+
+exception BaseError {
+  1: string message
+}
+
+service BaseService {
+  Base get(1: i32 id) throws (1: BaseError error)
+}
+"""
+
+    SIDE = """
+include "Base.thrift"
+
+namespace * {name}
+
+const Base.Base {upper}_DEFAULT = {{ "id": Base.BASE_VERSION, "name": "{name}" }}
+
+union {name}Union {{
+  1: Base.Base base
+  2: Base.Kind kind
+}}
+
+service {name}Service extends Base.BaseService {{
+  {name}Union {name}(1: list<Base.Base> bases) throws (1: Base.BaseError error)
+  oneway void ping()
+}}
+"""
+
+    TOP = """
+include "Left.thrift"
+include "Right.thrift"
+
+namespace * top
+
+struct Top {
+  1: Left.LeftUnion left
+  2: Right.RightUnion right
+  3: map<Left.LeftUnion, Right.RightUnion> pairs
+}
+
+service TopService extends Left.LeftService {
+  Top combine(1: Left.LeftUnion left, 2: Right.RightUnion right)
+}
+"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp(dir=TestParallelGeneration.CURRENT_DIR_PATH)
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir, ignore_errors=True)
+
+    def write_diamond(self, left_field="left"):
+        self.write("Base.thrift", TestParallelGeneration.BASE)
+        self.write("Left.thrift", TestParallelGeneration.SIDE.format(name="Left", upper="LEFT")
+                   + "struct LeftOnly {\n  1: i32 %s\n}\n" % left_field)
+        self.write("Right.thrift", TestParallelGeneration.SIDE.format(name="Right", upper="RIGHT"))
+        self.write("Top.thrift", TestParallelGeneration.TOP)
+
+    def write(self, name, contents):
+        thrift_file = open(os.path.join(self.temp_dir, name), "w")
+        thrift_file.write(contents)
+        thrift_file.close()
+
+    def generate(self, jobs, out_name):
+        out_dir_path = os.path.join(self.temp_dir, out_name)
+        os.mkdir(out_dir_path)
+        command = [TestParallelGeneration.THRIFT_EXECUTABLE_PATH, "-r", "-j", str(jobs), "-o", out_dir_path]
+        for generator in TestParallelGeneration.GENERATORS:
+            command += ["-gen", generator]
+        command += [os.path.join(self.temp_dir, "Top.thrift")]
+        process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        stdout, stderr = process.communicate()
+        return process.returncode, stderr.decode("utf-8", "replace"), out_dir_path
+
+    def read_tree(self, root):
+        files = {}
+        for dir_path, _, file_names in os.walk(root):
+            for file_name in file_names:
+                path = os.path.join(dir_path, file_name)
+                contents_file = open(path, "rb")
+                files[os.path.relpath(path, root)] = contents_file.read()
+                contents_file.close()
+        return files
+
+    def test_parallel_output_matches_serial_output(self):
+        self.write_diamond()
+
+        returncode, stderr, serial_path = self.generate(1, "serial")
+        self.assertEqual(returncode, 0, stderr)
+        serial = self.read_tree(serial_path)
+        self.assertIn(os.path.join("gen-cpp", "Top_types.h"), serial)
+        self.assertIn(os.path.join("gen-py", "base", "ttypes.py"), serial)
+
+        for attempt in range(3):
+            returncode, stderr, parallel_path = self.generate(4, "parallel%d" % attempt)
+            self.assertEqual(returncode, 0, stderr)
+            parallel = self.read_tree(parallel_path)
+            self.assertEqual(sorted(parallel.keys()), sorted(serial.keys()))
+            for name in serial:
+                self.assertEqual(parallel[name], serial[name], name)
+
+    def test_parallel_failure_is_reported_after_the_other_programs(self):
+        # py rejects the field name when Left is generated, while Right may
+        # be generated on another thread at the same time
+        self.write_diamond(left_field="lambda")
+
+        returncode, stderr, out_dir_path = self.generate(4, "parallel")
+        self.assertEqual(returncode, 1, stderr)
+        self.assertIn("[FAILURE:", stderr)
+        self.assertIn("Cannot use reserved language keyword: \"lambda\"", stderr)
+
+        # the level of Base was complete, and Top was never started
+        generated = self.read_tree(out_dir_path)
+        self.assertIn(os.path.join("gen-cpp", "Base_types.h"), generated)
+        self.assertNotIn(os.path.join("gen-cpp", "Top_types.h"), generated)
+
+
+def suite():
+    suite = unittest.TestSuite()
+    loader = unittest.TestLoader()
+    suite.addTest(loader.loadTestsFromTestCase(TestParallelGeneration))
+    return suite
+
+
+if __name__ == "__main__":
+    # The path of Thrift compiler is passed as an argument to the test script.
+    # Remove it to not confuse the unit testing framework
+    TestParallelGeneration.THRIFT_EXECUTABLE_PATH = sys.argv[-1]
+    del sys.argv[-1]
+    unittest.main(defaultTest="suite", testRunner=unittest.TextTestRunner(verbosity=2))
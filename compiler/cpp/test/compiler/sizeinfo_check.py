@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements. See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership. The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+from __future__ import print_function
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import unittest
+
+
+class TestSizeinfo(unittest.TestCase):
+    """
+    Compiles static_asserts that hold the classes the cpp generator emits for
+    test/ThriftTest.thrift to the sizeof and padding the sizeinfo generator
+    reports for them.
+    """
+
+    CURRENT_DIR_PATH = os.path.dirname(os.path.realpath(__file__))
+    THRIFT_FILE_PATH = os.path.join(CURRENT_DIR_PATH, "..", "..", "..", "..", "test", "ThriftTest.thrift")
+    THRIFT_EXECUTABLE_PATH = None
+    CXX = None
+    INCLUDE_DIRS = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.temp_dir = tempfile.mkdtemp(dir=cls.CURRENT_DIR_PATH)
+        cls.generate("sizeinfo", cls.temp_dir)
+        cls.generate("json", cls.temp_dir)
+
+        report = open(os.path.join(cls.temp_dir, "ThriftTest.txt"), "r")
+        cls.layouts = cls.parse_report(report.read())
+        report.close()
+
+        program = open(os.path.join(cls.temp_dir, "ThriftTest.json"), "r")
+        cls.program = json.load(program)
+        program.close()
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.temp_dir, ignore_errors=True)
+
+    @classmethod
+    def generate(cls, generator, out_dir):
+        command = [cls.THRIFT_EXECUTABLE_PATH, "-gen", generator, "-out", out_dir, cls.THRIFT_FILE_PATH]
+        subprocess.check_call(command)
+
+    @staticmethod
+    def parse_report(report):
+        """Maps each class name to its (sizeof, padding) pairs, plain and compact_layout"""
+        layouts = {}
+        name = None
+        for line in report.splitlines():
+            header = re.match(r"^(?:struct|union|exception) (\w+)$", line)
+            if header:
+                name = header.group(1)
+                layouts[name] = {}
+                continue
+            layout = re.match(r"^  (C\+\+ layout|compact_layout): +sizeof (\d+), padding (\d+)$", line)
+            if layout and name is not None:
+                key = "plain" if layout.group(1) == "C++ layout" else "compact"
+                layouts[name][key] = (int(layout.group(2)), int(layout.group(3)))
+        return layouts
+
+    def static_asserts(self, key):
+        namespace = "::" + self.program["namespaces"]["cpp"].replace(".", "::")
+        lines = []
+        for struct in self.program["structs"]:
+            name = struct["name"]
+            self.assertIn(name, self.layouts)
+            size, padding = self.layouts[name][key]
+            cls = namespace + "::" + name
+
+            # everything in the class that is not padding
+            parts = []
+            if struct["isException"]:
+                parts.append("sizeof(::apache::thrift::TException)")
+                parts.append("sizeof(std::string)")
+            else:
+                parts.append("sizeof(::apache::thrift::TBase)")
+            for field in struct["fields"]:
+                parts.append("sizeof(%s::%s)" % (cls, field["name"]))
+            if any(field["required"] != "required" for field in struct["fields"]):
+                parts.append("sizeof(%s::__isset)" % cls)
+
+            lines.append('static_assert(sizeof(%s) == %d, "sizeof %s");' % (cls, size, name))
+            lines.append('static_assert(sizeof(%s) - (%s) == %d, "padding of %s");'
+                         % (cls, " + ".join(parts), padding, name))
+        return lines
+
+    def check_layout(self, key, generator):
+        out_dir = os.path.join(self.temp_dir, key)
+        os.mkdir(out_dir)
+        self.generate(generator, out_dir)
+
+        source_path = os.path.join(out_dir, "sizeinfo_check.cpp")
+        source = open(source_path, "w")
+        source.write('#include "ThriftTest_types.h"\n\n')
+        source.write("\n".join(self.static_asserts(key)) + "\n")
+        source.close()
+
+        command = [self.CXX, "-std=c++11", "-fsyntax-only", "-I", out_dir]
+        for include_dir in self.INCLUDE_DIRS:
+            command += ["-I", include_dir]
+        command += [source_path]
+        compiler = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        output = compiler.communicate()[0].decode("utf-8", "replace")
+        self.assertEqual(0, compiler.returncode, output)
+
+    def test_plain_layout(self):
+        self.check_layout("plain", "cpp")
+
+    def test_compact_layout(self):
+        self.check_layout("compact", "cpp:compact_layout")
+
+
+def suite():
+    suite = unittest.TestSuite()
+    loader = unittest.TestLoader()
+    suite.addTest(loader.loadTestsFromTestCase(TestSizeinfo))
+    return suite
+
+
+if __name__ == "__main__":
+    # The Thrift compiler, the C++ compiler and the include directories of
+    # the C++ library are passed as arguments to the test script. Remove them
+    # to not confuse the unit testing framework
+    TestSizeinfo.THRIFT_EXECUTABLE_PATH = sys.argv[1]
+    TestSizeinfo.CXX = sys.argv[2]
+    TestSizeinfo.INCLUDE_DIRS = sys.argv[3:]
+    del sys.argv[1:]
+    unittest.main(defaultTest="suite", testRunner=unittest.TextTestRunner(verbosity=2))
@@ -126,6 +126,90 @@ class TestStalenessCheck(unittest.TestCase):
 
         shutil.rmtree(temp_dir, ignore_errors=True)
 
+    def test_codegen_cache_of_included_file(self):
+        temp_dir = tempfile.mkdtemp(dir=TestStalenessCheck.CURRENT_DIR_PATH)
+
+        temp_included_file_path = os.path.join(temp_dir, "Included.thrift")
+        temp_including_file_path = os.path.join(temp_dir, "Including.thrift")
+        cache_dir_path = os.path.join(temp_dir, "cache")
+        depfile_path = os.path.join(temp_dir, "Including.d")
+
+        shutil.copy2(TestStalenessCheck.INCLUDED_THRIFT_FILE_PATH, temp_included_file_path)
+        shutil.copy2(TestStalenessCheck.INCLUDING_THRIFT_FILE_PATH, temp_including_file_path)
+
+        command = [TestStalenessCheck.THRIFT_EXECUTABLE_PATH, "-gen", "cpp", "-recurse", "-o", temp_dir,
+                   "--cache", cache_dir_path, "--depfile", depfile_path]
+        command += [temp_including_file_path]
+
+        subprocess.call(command)
+
+        included_constants_cpp_file_path = os.path.join(temp_dir, "gen-cpp", "Included_constants.cpp")
+
+        depfile = open(depfile_path, "r")
+        depfile_contents = depfile.read()
+        depfile.close()
+        self.assertIn(included_constants_cpp_file_path, depfile_contents)
+        self.assertIn(temp_included_file_path, depfile_contents)
+
+        # A cache hit must not even rewrite a generated file that was edited
+        included_constants_cpp_file = open(included_constants_cpp_file_path, "a")
+        included_constants_cpp_file.write("\n/* This is a comment */\n")
+        included_constants_cpp_file.close()
+
+        subprocess.call(command)
+
+        included_constants_cpp_file = open(included_constants_cpp_file_path, "r")
+        self.assertIn("/* This is a comment */", included_constants_cpp_file.read())
+        included_constants_cpp_file.close()
+
+        # Changing an included file invalidates the entry
+        temp_included_file = open(temp_included_file_path, "a")
+        temp_included_file.write("\nconst i32 an_integer = 42\n")
+        temp_included_file.close()
+
+        subprocess.call(command)
+
+        included_constants_cpp_file = open(included_constants_cpp_file_path, "r")
+        included_constants_cpp_contents = included_constants_cpp_file.read()
+        included_constants_cpp_file.close()
+        self.assertNotIn("/* This is a comment */", included_constants_cpp_contents)
+        self.assertIn("an_integer", included_constants_cpp_contents)
+
+        shutil.rmtree(temp_dir, ignore_errors=True)
+
+    def test_codegen_cache_of_deleted_output(self):
+        temp_dir = tempfile.mkdtemp(dir=TestStalenessCheck.CURRENT_DIR_PATH)
+
+        out_dir_path = os.path.join(temp_dir, "out")
+        cache_dir_path = os.path.join(temp_dir, "cache")
+        depfile_path = os.path.join(temp_dir, "Single.d")
+        os.mkdir(out_dir_path)
+
+        # Ruby writes its files without the conditional update stream, and the
+        # trailing separator must not end up doubled in the dependency file
+        command = [TestStalenessCheck.THRIFT_EXECUTABLE_PATH, "-gen", "rb", "-out", out_dir_path + "/",
+                   "--cache", cache_dir_path, "--depfile", depfile_path]
+        command += [TestStalenessCheck.SINGLE_THRIFT_FILE_PATH]
+
+        subprocess.call(command)
+
+        single_constants_rb_file_path = os.path.join(out_dir_path, "single_constants.rb")
+
+        depfile = open(depfile_path, "r")
+        depfile_contents = depfile.read()
+        depfile.close()
+        self.assertIn(single_constants_rb_file_path, depfile_contents)
+        self.assertNotIn("//", depfile_contents)
+
+        # A missing output invalidates the entry
+        os.remove(single_constants_rb_file_path)
+
+        subprocess.call(command)
+
+        self.assertTrue(os.path.exists(single_constants_rb_file_path))
+
+        shutil.rmtree(temp_dir, ignore_errors=True)
+
 
 def suite():
     suite = unittest.TestSuite()
@@ -877,6 +877,72 @@ thrift_binary_protocol_read_binary (ThriftProtocol *protocol,
   return xfer;
 }
 
+/* implements thrift_protocol_read_binary_view */
+gint32
+thrift_binary_protocol_read_binary_view (ThriftProtocol *protocol,
+                                         const guint8 **buf, guint32 *len,
+                                         GByteArray *scratch, GError **error)
+{
+  const guint8 *lent;
+  guint32 have;
+  gint32 ret;
+  gint32 xfer = 0;
+  gint32 read_len = 0;
+
+  g_return_val_if_fail (THRIFT_IS_BINARY_PROTOCOL (protocol), -1);
+
+  /* read the length into read_len */
+  if ((ret =
+       thrift_protocol_read_i32 (protocol, &read_len, error)) < 0)
+  {
+    return -1;
+  }
+  xfer += ret;
+
+  if (read_len < 0) {
+    g_set_error (error, THRIFT_PROTOCOL_ERROR,
+                 THRIFT_PROTOCOL_ERROR_NEGATIVE_SIZE,
+                 "got negative size of %d", read_len);
+    return -1;
+  }
+  *len = (guint32) read_len;
+
+  /* point into the transport's buffer if it holds the whole value... */
+  have = *len;
+  if ((lent = thrift_transport_borrow (protocol->transport,
+                                       &have, error)) != NULL)
+  {
+    if (!thrift_transport_consume (protocol->transport, *len, error))
+    {
+      return -1;
+    }
+    *buf = lent;
+    return xfer + read_len;
+  }
+
+  /* ...and copy into the caller's scratch array otherwise, but not before
+   * the transport has agreed to that many bytes */
+  if (!THRIFT_TRANSPORT_GET_CLASS (protocol->transport)->checkReadBytesAvailable
+        (protocol->transport, *len, error))
+  {
+    return -1;
+  }
+  g_byte_array_set_size (scratch, *len);
+  if (*len > 0)
+  {
+    if ((ret =
+         thrift_transport_read_all (protocol->transport,
+                                    scratch->data, *len, error)) < 0)
+    {
+      return -1;
+    }
+    xfer += ret;
+  }
+  *buf = scratch->data;
+
+  return xfer;
+}
+
 gint
 thrift_binary_protocol_get_min_serialized_size(ThriftProtocol *protocol, ThriftType type, GError **error)
 {
@@ -972,5 +1038,6 @@ thrift_binary_protocol_class_init (ThriftBinaryProtocolClass *klass)
   cls->read_double = thrift_binary_protocol_read_double;
   cls->read_string = thrift_binary_protocol_read_string;
   cls->read_binary = thrift_binary_protocol_read_binary;
+  cls->read_binary_view = thrift_binary_protocol_read_binary_view;
   cls->get_min_serialized_size = thrift_binary_protocol_get_min_serialized_size;
 }
@@ -275,6 +275,8 @@ thrift_compact_protocol_read_varint64 (ThriftCompactProtocol *protocol,
   guint64 val;
   gint shift;
   guint8 byte;
+  const guint8 *lent;
+  guint32 have;
 
   tp = THRIFT_PROTOCOL (protocol);
   xfer = 0;
@@ -282,6 +284,36 @@ thrift_compact_protocol_read_varint64 (ThriftCompactProtocol *protocol,
   shift = 0;
   byte = 0;
 
+  /* decode straight out of the transport's buffer when it can lend us the
+   * whole varint, instead of reading it one byte at a time */
+  have = 1;
+  if ((lent = thrift_transport_borrow (tp->transport, &have, error)) != NULL) {
+    guint32 i;
+    guint32 limit = have < 10 ? have : 10;
+
+    for (i = 0; i < limit; ++i) {
+      val |= (guint64)(lent[i] & 0x7f) << shift;
+      shift += 7;
+      if (!(lent[i] & 0x80)) {
+        if (!thrift_transport_consume (tp->transport, i + 1, error)) {
+          return -1;
+        }
+        *i64 = (gint64) val;
+        return i + 1;
+      }
+    }
+    if (limit == 10) {
+      g_set_error (error, THRIFT_PROTOCOL_ERROR,
+                   THRIFT_PROTOCOL_ERROR_INVALID_DATA,
+                   "variable-length int over 10 bytes");
+      return -1;
+    }
+
+    /* the buffer ends inside the varint; start over the slow way */
+    val = 0;
+    shift = 0;
+  }
+
   while (TRUE) {
     if ((ret = thrift_transport_read_all (tp->transport,
                                           (gpointer) &byte, 1, error)) < 0) {
@@ -1497,6 +1529,82 @@ thrift_compact_protocol_read_binary (ThriftProtocol *protocol,
   return xfer;
 }
 
+/* implements thrift_protocol_read_binary_view */
+gint32
+thrift_compact_protocol_read_binary_view (ThriftProtocol *protocol,
+                                          const guint8 **buf, guint32 *len,
+                                          GByteArray *scratch,
+                                          GError **error)
+{
+  ThriftCompactProtocol *cp;
+
+  const guint8 *lent;
+  guint32 have;
+  gint32 ret;
+  gint32 xfer;
+
+  gint32 read_len;
+
+  g_return_val_if_fail (THRIFT_IS_COMPACT_PROTOCOL (protocol), -1);
+
+  cp = THRIFT_COMPACT_PROTOCOL (protocol);
+
+  xfer = 0;
+  read_len = 0;
+
+  /* read the length into read_len */
+  if ((ret =
+       thrift_compact_protocol_read_varint32 (cp, &read_len, error)) < 0) {
+    return -1;
+  }
+  xfer += ret;
+
+  if (cp->string_limit > 0 && read_len > cp->string_limit) {
+    g_set_error (error, THRIFT_PROTOCOL_ERROR,
+                 THRIFT_PROTOCOL_ERROR_SIZE_LIMIT,
+                 "got size over limit (%d > %d)", read_len, cp->string_limit);
+    return -1;
+  }
+
+  if (read_len < 0) {
+    g_set_error (error, THRIFT_PROTOCOL_ERROR,
+                 THRIFT_PROTOCOL_ERROR_NEGATIVE_SIZE,
+                 "got negative size of %d", read_len);
+    return -1;
+  }
+  *len = (guint32) read_len;
+
+  /* point into the transport's buffer if it holds the whole value... */
+  have = *len;
+  if ((lent = thrift_transport_borrow (protocol->transport,
+                                       &have, error)) != NULL) {
+    if (!thrift_transport_consume (protocol->transport, *len, error)) {
+      return -1;
+    }
+    *buf = lent;
+    return xfer + read_len;
+  }
+
+  /* ...and copy into the caller's scratch array otherwise, but not before
+   * the transport has agreed to that many bytes */
+  if (!THRIFT_TRANSPORT_GET_CLASS (protocol->transport)->checkReadBytesAvailable
+        (protocol->transport, *len, error)) {
+    return -1;
+  }
+  g_byte_array_set_size (scratch, *len);
+  if (*len > 0) {
+    if ((ret =
+         thrift_transport_read_all (protocol->transport,
+                                    scratch->data, *len, error)) < 0) {
+      return -1;
+    }
+    xfer += ret;
+  }
+  *buf = scratch->data;
+
+  return xfer;
+}
+
 gint
 thrift_compact_protocol_get_min_serialized_size (ThriftProtocol *protocol, ThriftType type, GError **error)
 {
@@ -1660,6 +1768,7 @@ thrift_compact_protocol_class_init (ThriftCompactProtocolClass *klass)
   cls->read_double = thrift_compact_protocol_read_double;
   cls->read_string = thrift_compact_protocol_read_string;
   cls->read_binary = thrift_compact_protocol_read_binary;
+  cls->read_binary_view = thrift_compact_protocol_read_binary_view;
   cls->get_min_serialized_size = thrift_compact_protocol_get_min_serialized_size;
 }
 
@@ -419,6 +419,42 @@ thrift_protocol_read_binary (ThriftProtocol *protocol, gpointer *buf,
                                                             len, error);
 }
 
+gint32
+thrift_protocol_read_binary_view (ThriftProtocol *protocol,
+                                  const guint8 **buf, guint32 *len,
+                                  GByteArray *scratch, GError **error)
+{
+  return THRIFT_PROTOCOL_GET_CLASS (protocol)->read_binary_view (protocol,
+                                                                 buf, len,
+                                                                 scratch,
+                                                                 error);
+}
+
+/* by default, read an allocated copy and move it into scratch */
+static gint32
+thrift_protocol_real_read_binary_view (ThriftProtocol *protocol,
+                                       const guint8 **buf, guint32 *len,
+                                       GByteArray *scratch, GError **error)
+{
+  gpointer data = NULL;
+  gint32 ret;
+
+  if ((ret = thrift_protocol_read_binary (protocol, &data, len, error)) < 0)
+  {
+    return -1;
+  }
+
+  g_byte_array_set_size (scratch, 0);
+  if (*len > 0)
+  {
+    g_byte_array_append (scratch, data, *len);
+  }
+  g_free (data);
+
+  *buf = scratch->data;
+  return ret;
+}
+
 gint
 thrift_protocol_get_min_serialized_size (ThriftProtocol *protocol, ThriftType type, GError ** error)
 {
@@ -651,4 +687,5 @@ thrift_protocol_class_init (ThriftProtocolClass *cls)
   cls->read_string = thrift_protocol_read_string;
   cls->read_binary = thrift_protocol_read_binary;
   cls->get_min_serialized_size = thrift_protocol_get_min_serialized_size;
+  cls->read_binary_view = thrift_protocol_real_read_binary_view;
 }
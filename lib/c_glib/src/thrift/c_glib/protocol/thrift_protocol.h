@@ -173,6 +173,9 @@ struct _ThriftProtocolClass
   gint32 (*read_binary) (ThriftProtocol *protocol, gpointer *buf,
                          guint32 *len, GError **error);
   gint (*get_min_serialized_size) (ThriftProtocol *protocol, ThriftType type, GError **error);
+  gint32 (*read_binary_view) (ThriftProtocol *protocol, const guint8 **buf,
+                              guint32 *len, GByteArray *scratch,
+                              GError **error);
 };
 
 /* used by THRIFT_TYPE_PROTOCOL */
@@ -319,6 +322,19 @@ gint32 thrift_protocol_read_binary (ThriftProtocol *protocol,
                                     gpointer *buf, guint32 *len,
                                     GError **error);
 
+/*!
+ * Reads a string or binary value without allocating it.  On success *buf
+ * points either into the transport's own buffer, when the transport can
+ * lend the bytes (see thrift_transport_borrow), or into scratch, which is
+ * resized to hold a copy otherwise.  The bytes are not NUL-terminated and
+ * stay valid until the next read on the protocol or write to scratch.
+ * Reusing one scratch array across reads keeps them allocation-free.
+ */
+gint32 thrift_protocol_read_binary_view (ThriftProtocol *protocol,
+                                         const guint8 **buf, guint32 *len,
+                                         GByteArray *scratch,
+                                         GError **error);
+
 gint thrift_protocol_get_min_serialized_size (ThriftProtocol *protocol,
 		                              ThriftType type, GError **error);
 
@@ -478,6 +478,17 @@ thrift_protocol_decorator_read_binary (ThriftProtocol *protocol, gpointer *buf,
                                                             len, error);
 }
 
+gint32
+thrift_protocol_decorator_read_binary_view (ThriftProtocol *protocol,
+                             const guint8 **buf, guint32 *len,
+                             GByteArray *scratch, GError **error)
+{
+  ThriftProtocolDecorator *self = THRIFT_PROTOCOL_DECORATOR (protocol);
+
+  return THRIFT_PROTOCOL_GET_CLASS (self->concrete_protocol)->read_binary_view (self->concrete_protocol, buf,
+                                                            len, scratch, error);
+}
+
 
 static void
 thrift_protocol_decorator_set_property (GObject      *object,
@@ -620,4 +631,5 @@ thrift_protocol_decorator_class_init (ThriftProtocolDecoratorClass *klass)
   cls->read_double = thrift_protocol_decorator_read_double;
   cls->read_string = thrift_protocol_decorator_read_string;
   cls->read_binary = thrift_protocol_decorator_read_binary;
+  cls->read_binary_view = thrift_protocol_decorator_read_binary_view;
 }
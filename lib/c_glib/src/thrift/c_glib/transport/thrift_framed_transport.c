@@ -58,7 +58,7 @@ gboolean
 thrift_framed_transport_peek (ThriftTransport *transport, GError **error)
 {
   ThriftFramedTransport *t = THRIFT_FRAMED_TRANSPORT (transport);
-  return (t->r_buf->len > 0) || thrift_transport_peek (t->transport, error);
+  return (t->r_buf->len > t->r_pos) || thrift_transport_peek (t->transport, error);
 }
 
 /* implements thrift_transport_open */
@@ -77,6 +77,19 @@ thrift_framed_transport_close (ThriftTransport *transport, GError **error)
   return THRIFT_TRANSPORT_GET_CLASS (t->transport)->close (t->transport, error);
 }
 
+/* moves the read position forward; r_buf is only emptied once the whole
+ * frame has been read, so reads never have to move the rest of it down */
+static void
+thrift_framed_transport_advance (ThriftFramedTransport *t, guint32 len)
+{
+  t->r_pos += len;
+  if (t->r_pos == t->r_buf->len)
+  {
+    g_byte_array_set_size (t->r_buf, 0);
+    t->r_pos = 0;
+  }
+}
+
 /* reads a frame and puts it into the buffer */
 gboolean
 thrift_framed_transport_read_frame (ThriftTransport *transport,
@@ -93,7 +106,7 @@ thrift_framed_transport_read_frame (ThriftTransport *transport,
                              sizeof (sz),
                              error) == sizeof (sz))
   {
-    guchar *tmpdata;
+    guint32 have = t->r_buf->len;
 
     sz = ntohl (sz);
     if (sz > t->max_frame_size)
@@ -105,18 +118,20 @@ thrift_framed_transport_read_frame (ThriftTransport *transport,
       return result;
     }
 
-    /* create a buffer to hold the data and read that much data */
-    tmpdata = g_new0 (guchar, sz);
-    bytes = thrift_transport_read (t->transport, tmpdata, sz, error);
+    /* read the frame straight into the end of the buffer */
+    g_byte_array_set_size (t->r_buf, have + sz);
+    bytes = thrift_transport_read (t->transport, t->r_buf->data + have,
+                                   sz, error);
 
     if (bytes > 0 && (error == NULL || *error == NULL))
     {
-      /* add the data to the buffer */
-      g_byte_array_append (t->r_buf, tmpdata, bytes);
-
+      g_byte_array_set_size (t->r_buf, have + bytes);
       result = TRUE;
     }
-    g_free (tmpdata);
+    else
+    {
+      g_byte_array_set_size (t->r_buf, have);
+    }
   }
 
   return result;
@@ -129,18 +144,18 @@ thrift_framed_transport_read_slow (ThriftTransport *transport, gpointer buf,
 {
   ThriftFramedTransport *t = THRIFT_FRAMED_TRANSPORT (transport);
   guint32 want = len;
-  guint32 have = t->r_buf->len;
+  guint32 have = t->r_buf->len - t->r_pos;
   gint32 result = -1;
 
   /* we shouldn't hit this unless the buffer doesn't have enough to read */
-  g_assert (t->r_buf->len < want);
+  g_assert (have < want);
 
   /* first copy what we have in our buffer, if there is anything left */
   if (have > 0)
   {
-    memcpy (buf, t->r_buf, t->r_buf->len);
-    want -= t->r_buf->len;
-    t->r_buf = g_byte_array_remove_range (t->r_buf, 0, t->r_buf->len);
+    memcpy (buf, t->r_buf->data + t->r_pos, have);
+    want -= have;
+    thrift_framed_transport_advance (t, have);
   }
 
   /* read a frame of input and buffer it */
@@ -151,7 +166,7 @@ thrift_framed_transport_read_slow (ThriftTransport *transport, gpointer buf,
 
     /* copy the data into the buffer */
     memcpy ((guint8 *)buf + len - want, t->r_buf->data, give);
-    t->r_buf = g_byte_array_remove_range (t->r_buf, 0, give);
+    thrift_framed_transport_advance (t, give);
     want -= give;
 
     result = len - want;
@@ -175,16 +190,86 @@ thrift_framed_transport_read (ThriftTransport *transport, gpointer buf,
 
   /* if we have enough buffer data to fulfill the read, just use
    * a memcpy from the buffer */
-  if (len <= t->r_buf->len)
+  if (len <= t->r_buf->len - t->r_pos)
   {
-    memcpy (buf, t->r_buf->data, len);
-    g_byte_array_remove_range (t->r_buf, 0, len);
+    memcpy (buf, t->r_buf->data + t->r_pos, len);
+    thrift_framed_transport_advance (t, len);
     return len;
   }
 
   return thrift_framed_transport_read_slow (transport, buf, len, error);
 }
 
+/* overrides thrift_transport_read_all
+ * serves reads the buffer can satisfy without going through read() */
+gint32
+thrift_framed_transport_read_all (ThriftTransport *transport, gpointer buf,
+                                  guint32 len, GError **error)
+{
+  ThriftFramedTransport *t = THRIFT_FRAMED_TRANSPORT (transport);
+  ThriftTransportClass *ttc = THRIFT_TRANSPORT_GET_CLASS (transport);
+
+  if (len <= t->r_buf->len - t->r_pos)
+  {
+    if(!ttc->checkReadBytesAvailable (transport, len, error))
+    {
+      return -1;
+    }
+    memcpy (buf, t->r_buf->data + t->r_pos, len);
+    thrift_framed_transport_advance (t, len);
+    return len;
+  }
+
+  return THRIFT_TRANSPORT_CLASS (thrift_framed_transport_parent_class)->read_all (transport, buf,
+                                                                                  len, error);
+}
+
+/* implements thrift_transport_borrow
+ * lends out of the current frame; a new frame is only read by read() */
+const guint8 *
+thrift_framed_transport_borrow (ThriftTransport *transport, guint32 *len,
+                                GError **error)
+{
+  ThriftFramedTransport *t = THRIFT_FRAMED_TRANSPORT (transport);
+  guint32 have = t->r_buf->len - t->r_pos;
+
+  THRIFT_UNUSED_VAR (error);
+
+  if (have < *len)
+  {
+    return NULL;
+  }
+
+  *len = have;
+  return t->r_buf->data + t->r_pos;
+}
+
+/* implements thrift_transport_consume */
+gboolean
+thrift_framed_transport_consume (ThriftTransport *transport, guint32 len,
+                                 GError **error)
+{
+  ThriftFramedTransport *t = THRIFT_FRAMED_TRANSPORT (transport);
+  ThriftTransportClass *ttc = THRIFT_TRANSPORT_GET_CLASS (transport);
+
+  if(!ttc->checkReadBytesAvailable (transport, len, error))
+  {
+    return FALSE;
+  }
+
+  if (len > t->r_buf->len - t->r_pos)
+  {
+    g_set_error (error, THRIFT_TRANSPORT_ERROR,
+                 THRIFT_TRANSPORT_ERROR_RECEIVE,
+                 "unable to consume %u bytes from a frame with %u left",
+                 len, t->r_buf->len - t->r_pos);
+    return FALSE;
+  }
+
+  thrift_framed_transport_advance (t, len);
+  return TRUE;
+}
+
 /* implements thrift_transport_read_end
  * called when read is complete.  nothing to do on our end. */
 gboolean
@@ -285,6 +370,7 @@ thrift_framed_transport_init (ThriftFramedTransport *transport)
   transport->transport = NULL;
   transport->r_buf = g_byte_array_new ();
   transport->w_buf = g_byte_array_new ();
+  transport->r_pos = 0;
   transport->max_frame_size = DEFAULT_MAX_FRAME_SIZE;
 }
 
@@ -458,6 +544,9 @@ thrift_framed_transport_class_init (ThriftFramedTransportClass *cls)
   ttc->close = thrift_framed_transport_close;
   ttc->read = thrift_framed_transport_read;
   ttc->read_end = thrift_framed_transport_read_end;
+  ttc->read_all = thrift_framed_transport_read_all;
+  ttc->borrow = thrift_framed_transport_borrow;
+  ttc->consume = thrift_framed_transport_consume;
   ttc->write = thrift_framed_transport_write;
   ttc->write_end = thrift_framed_transport_write_end;
   ttc->flush = thrift_framed_transport_flush;
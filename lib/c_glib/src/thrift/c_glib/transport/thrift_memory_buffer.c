@@ -69,6 +69,32 @@ thrift_memory_buffer_close (ThriftTransport *transport, GError **error)
   return TRUE;
 }
 
+/* drops the bytes that have already been read from the front of buf, so
+ * that it only holds unread data again */
+static void
+thrift_memory_buffer_compact (ThriftMemoryBuffer *t)
+{
+  if (t->r_pos > 0)
+  {
+    g_byte_array_remove_range (t->buf, 0, t->r_pos);
+    t->r_pos = 0;
+  }
+}
+
+/* moves the read position forward.  Reads only advance r_pos instead of
+ * moving the rest of the buffer down each time; once everything has been
+ * read the buffer is emptied, which keeps its allocation. */
+static void
+thrift_memory_buffer_advance (ThriftMemoryBuffer *t, guint32 len)
+{
+  t->r_pos += len;
+  if (t->r_pos == t->buf->len)
+  {
+    g_byte_array_set_size (t->buf, 0);
+    t->r_pos = 0;
+  }
+}
+
 /* implements thrift_transport_read */
 gint32
 thrift_memory_buffer_read (ThriftTransport *transport, gpointer buf,
@@ -86,17 +112,86 @@ thrift_memory_buffer_read (ThriftTransport *transport, gpointer buf,
 
   /* if the requested bytes are more than what we have available,
    * just give all that we have the buffer */
-  if (t->buf->len < len)
+  if (t->buf->len - t->r_pos < len)
   {
-    give = t->buf->len;
+    give = t->buf->len - t->r_pos;
   }
 
-  memcpy (buf, t->buf->data, give);
-  g_byte_array_remove_range (t->buf, 0, give);
+  memcpy (buf, t->buf->data + t->r_pos, give);
+  thrift_memory_buffer_advance (t, give);
 
   return give;
 }
 
+/* overrides thrift_transport_read_all
+ * serves reads the buffer can satisfy without going through read() */
+gint32
+thrift_memory_buffer_read_all (ThriftTransport *transport, gpointer buf,
+                               guint32 len, GError **error)
+{
+  ThriftMemoryBuffer *t = THRIFT_MEMORY_BUFFER (transport);
+  ThriftTransportClass *ttc = THRIFT_TRANSPORT_GET_CLASS (transport);
+
+  if (len <= t->buf->len - t->r_pos)
+  {
+    if(!ttc->checkReadBytesAvailable (transport, len, error))
+    {
+      return -1;
+    }
+    memcpy (buf, t->buf->data + t->r_pos, len);
+    thrift_memory_buffer_advance (t, len);
+    return len;
+  }
+
+  return THRIFT_TRANSPORT_CLASS (thrift_memory_buffer_parent_class)->read_all (transport, buf,
+                                                                               len, error);
+}
+
+/* implements thrift_transport_borrow */
+const guint8 *
+thrift_memory_buffer_borrow (ThriftTransport *transport, guint32 *len,
+                             GError **error)
+{
+  ThriftMemoryBuffer *t = THRIFT_MEMORY_BUFFER (transport);
+  guint32 have = t->buf->len - t->r_pos;
+
+  THRIFT_UNUSED_VAR (error);
+
+  if (have < *len)
+  {
+    return NULL;
+  }
+
+  *len = have;
+  return t->buf->data + t->r_pos;
+}
+
+/* implements thrift_transport_consume */
+gboolean
+thrift_memory_buffer_consume (ThriftTransport *transport, guint32 len,
+                              GError **error)
+{
+  ThriftMemoryBuffer *t = THRIFT_MEMORY_BUFFER (transport);
+  ThriftTransportClass *ttc = THRIFT_TRANSPORT_GET_CLASS (transport);
+
+  if(!ttc->checkReadBytesAvailable (transport, len, error))
+  {
+    return FALSE;
+  }
+
+  if (len > t->buf->len - t->r_pos)
+  {
+    g_set_error (error, THRIFT_TRANSPORT_ERROR,
+                 THRIFT_TRANSPORT_ERROR_RECEIVE,
+                 "unable to consume %u bytes from buffer with %u bytes",
+                 len, t->buf->len - t->r_pos);
+    return FALSE;
+  }
+
+  thrift_memory_buffer_advance (t, len);
+  return TRUE;
+}
+
 /* implements thrift_transport_read_end
  * called when read is complete.  nothing to do on our end. */
 gboolean
@@ -118,6 +213,8 @@ thrift_memory_buffer_write (ThriftTransport *transport,
 
   THRIFT_UNUSED_VAR (error);
 
+  thrift_memory_buffer_compact (t);
+
   /* return an exception if the buffer doesn't have enough space. */
   if (len > t->buf_size - t->buf->len)
   {
@@ -156,7 +253,7 @@ thrift_memory_buffer_flush (ThriftTransport *transport, GError **error)
 static void
 thrift_memory_buffer_init (ThriftMemoryBuffer *t)
 {
-  THRIFT_UNUSED_VAR (t);
+  t->r_pos = 0;
 }
 
 /* destructor */
@@ -189,6 +286,7 @@ thrift_memory_buffer_get_property (GObject *object, guint property_id,
       g_value_set_uint (value, t->buf_size);
       break;
     case PROP_THRIFT_MEMORY_BUFFER_BUFFER:
+      thrift_memory_buffer_compact (t);
       g_value_set_pointer (value, (gpointer) (t->buf));
       break;
     case PROP_THRIFT_MEMORY_BUFFER_OWNER:
@@ -343,6 +441,9 @@ thrift_memory_buffer_class_init (ThriftMemoryBufferClass *cls)
   ttc->close = thrift_memory_buffer_close;
   ttc->read = thrift_memory_buffer_read;
   ttc->read_end = thrift_memory_buffer_read_end;
+  ttc->read_all = thrift_memory_buffer_read_all;
+  ttc->borrow = thrift_memory_buffer_borrow;
+  ttc->consume = thrift_memory_buffer_consume;
   ttc->write = thrift_memory_buffer_write;
   ttc->write_end = thrift_memory_buffer_write_end;
   ttc->flush = thrift_memory_buffer_flush;
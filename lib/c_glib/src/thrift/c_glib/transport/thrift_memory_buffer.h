@@ -52,6 +52,7 @@ struct _ThriftMemoryBuffer
   GByteArray *buf;
   guint32 buf_size;
   gboolean owner;
+  guint32 r_pos;
 };
 
 typedef struct _ThriftMemoryBufferClass ThriftMemoryBufferClass;
@@ -105,6 +105,22 @@ thrift_transport_read_all (ThriftTransport *transport, gpointer buf,
                                                            len, error);
 }
 
+const guint8 *
+thrift_transport_borrow (ThriftTransport *transport, guint32 *len,
+                         GError **error)
+{
+  return THRIFT_TRANSPORT_GET_CLASS (transport)->borrow (transport, len,
+                                                         error);
+}
+
+gboolean
+thrift_transport_consume (ThriftTransport *transport, guint32 len,
+                          GError **error)
+{
+  return THRIFT_TRANSPORT_GET_CLASS (transport)->consume (transport, len,
+                                                          error);
+}
+
 /* by default, peek returns true if and only if the transport is open */
 static gboolean
 thrift_transport_real_peek (ThriftTransport *transport, GError **error)
@@ -141,6 +157,30 @@ thrift_transport_real_read_all (ThriftTransport *transport, gpointer buf,
   return have;
 }
 
+/* by default, transports have nothing to lend */
+static const guint8 *
+thrift_transport_real_borrow (ThriftTransport *transport, guint32 *len,
+                              GError **error)
+{
+  THRIFT_UNUSED_VAR (transport);
+  THRIFT_UNUSED_VAR (len);
+  THRIFT_UNUSED_VAR (error);
+
+  return NULL;
+}
+
+static gboolean
+thrift_transport_real_consume (ThriftTransport *transport, guint32 len,
+                               GError **error)
+{
+  THRIFT_UNUSED_VAR (transport);
+
+  g_set_error (error, THRIFT_TRANSPORT_ERROR, THRIFT_TRANSPORT_ERROR_UNKNOWN,
+               "consume of %u bytes on a transport that does not borrow",
+               len);
+  return FALSE;
+}
+
 gboolean
 thrift_transport_updateKnownMessageSize(ThriftTransport *transport, glong size, GError **error)
 {
@@ -357,6 +397,10 @@ thrift_transport_class_init (ThriftTransportClass *cls)
   cls->peek = thrift_transport_real_peek;
   cls->read_all = thrift_transport_real_read_all;
 
+  /* and for borrow/consume, which only buffering transports support */
+  cls->borrow = thrift_transport_real_borrow;
+  cls->consume = thrift_transport_real_consume;
+
   cls->updateKnownMessageSize = thrift_transport_updateKnownMessageSize;
   cls->checkReadBytesAvailable = thrift_transport_checkReadBytesAvailable;
   cls->resetConsumedMessageSize = thrift_transport_resetConsumedMessageSize;
@@ -86,6 +86,10 @@ struct _ThriftTransportClass
   gboolean (*checkReadBytesAvailable) (ThriftTransport *transport, glong numBytes, GError **error);
   gboolean (*resetConsumedMessageSize) (ThriftTransport *transport, glong newSize, GError **error);
   gboolean (*countConsumedMessageBytes) (ThriftTransport *transport, glong numBytes, GError **error);
+  const guint8 * (*borrow) (ThriftTransport *transport, guint32 *len,
+                            GError **error);
+  gboolean (*consume) (ThriftTransport *transport, guint32 len,
+                       GError **error);
 };
 
 /* used by THRIFT_TYPE_TRANSPORT */
@@ -163,6 +167,27 @@ gboolean thrift_transport_flush (ThriftTransport *transport, GError **error);
 gint32 thrift_transport_read_all (ThriftTransport *transport, gpointer buf,
                                   guint32 len, GError **error);
 
+/*!
+ * Returns a pointer to at least *len bytes of buffered input without
+ * copying them, and sets *len to the number of bytes actually available.
+ * Returns NULL if the transport cannot lend that many bytes right now, in
+ * which case the caller should fall back to thrift_transport_read_all.
+ *
+ * The bytes are not consumed: call thrift_transport_consume once they have
+ * been used.  They stay valid until the next read or write on the
+ * transport.
+ * \public \memberof ThriftTransportInterface
+ */
+const guint8 *thrift_transport_borrow (ThriftTransport *transport,
+                                       guint32 *len, GError **error);
+
+/*!
+ * Consumes len bytes previously returned by thrift_transport_borrow.
+ * \public \memberof ThriftTransportInterface
+ */
+gboolean thrift_transport_consume (ThriftTransport *transport, guint32 len,
+                                   GError **error);
+
 /* define error/exception types */
 typedef enum
 {
@@ -0,0 +1,163 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/* Times decoding a frame of strings and integers with the binary and
+ * compact protocols, reading the strings both as allocated copies
+ * (thrift_protocol_read_string, as generated code does) and as views into
+ * the transport's buffer (thrift_protocol_read_binary_view).
+ *
+ * Usage: benchmarkprotocol [records] [iterations] */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <thrift/c_glib/protocol/thrift_protocol.h>
+#include <thrift/c_glib/protocol/thrift_binary_protocol.h>
+#include <thrift/c_glib/protocol/thrift_compact_protocol.h>
+#include <thrift/c_glib/transport/thrift_framed_transport.h>
+#include <thrift/c_glib/transport/thrift_memory_buffer.h>
+
+static const gchar VALUE[] = "a string of moderate length for the benchmark";
+
+/* one record is an i32, an i64 and a string */
+static void
+write_records (ThriftProtocol *protocol, ThriftTransport *transport,
+               gint records)
+{
+  gint i;
+
+  for (i = 0; i < records; ++i)
+  {
+    thrift_protocol_write_i32 (protocol, i, NULL);
+    thrift_protocol_write_i64 (protocol, (gint64) i << 20, NULL);
+    thrift_protocol_write_string (protocol, VALUE, NULL);
+  }
+  thrift_transport_flush (transport, NULL);
+}
+
+static gboolean
+read_records (ThriftProtocol *protocol, gint records, gboolean views,
+              GByteArray *scratch)
+{
+  gint i;
+  gint32 i32;
+  gint64 i64;
+  gchar *str;
+  const guint8 *view;
+  guint32 len;
+
+  for (i = 0; i < records; ++i)
+  {
+    if (thrift_protocol_read_i32 (protocol, &i32, NULL) < 0
+        || thrift_protocol_read_i64 (protocol, &i64, NULL) < 0)
+    {
+      return FALSE;
+    }
+    if (views)
+    {
+      if (thrift_protocol_read_binary_view (protocol, &view, &len,
+                                            scratch, NULL) < 0
+          || len != sizeof (VALUE) - 1)
+      {
+        return FALSE;
+      }
+    }
+    else
+    {
+      if (thrift_protocol_read_string (protocol, &str, NULL) < 0)
+      {
+        return FALSE;
+      }
+      g_free (str);
+    }
+  }
+  return TRUE;
+}
+
+static void
+run (const gchar *name, GType protocol_type, gboolean framed, gboolean views,
+     gint records, gint iterations)
+{
+  ThriftTransport *membuf;
+  ThriftTransport *transport;
+  ThriftProtocol *protocol;
+  GByteArray *scratch;
+  gint64 start, elapsed;
+  gint i;
+
+  membuf = g_object_new (THRIFT_TYPE_MEMORY_BUFFER, NULL);
+  if (framed)
+  {
+    transport = g_object_new (THRIFT_TYPE_FRAMED_TRANSPORT,
+                              "transport", membuf, NULL);
+  }
+  else
+  {
+    transport = g_object_ref (membuf);
+  }
+  protocol = g_object_new (protocol_type, "transport", transport, NULL);
+  scratch = g_byte_array_new ();
+
+  elapsed = 0;
+  for (i = 0; i < iterations; ++i)
+  {
+    write_records (protocol, transport, records);
+
+    start = g_get_monotonic_time ();
+    if (!read_records (protocol, records, views, scratch))
+    {
+      g_error ("%s: decoding failed", name);
+    }
+    elapsed += g_get_monotonic_time () - start;
+  }
+
+  g_print ("%-10s %-7s %-7s %8.1f ns/record\n", name,
+           framed ? "framed" : "memory", views ? "view" : "copy",
+           (gdouble) elapsed * 1000.0 / ((gdouble) records * iterations));
+
+  g_byte_array_unref (scratch);
+  g_object_unref (protocol);
+  g_object_unref (transport);
+  g_object_unref (membuf);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gint records = argc > 1 ? atoi (argv[1]) : 10000;
+  gint iterations = argc > 2 ? atoi (argv[2]) : 100;
+  gint framed, views;
+
+#if (!GLIB_CHECK_VERSION (2, 36, 0))
+  g_type_init ();
+#endif
+
+  for (framed = 0; framed < 2; ++framed)
+  {
+    for (views = 0; views < 2; ++views)
+    {
+      run ("binary", THRIFT_TYPE_BINARY_PROTOCOL, framed, views,
+           records, iterations);
+      run ("compact", THRIFT_TYPE_COMPACT_PROTOCOL, framed, views,
+           records, iterations);
+    }
+  }
+
+  return 0;
+}
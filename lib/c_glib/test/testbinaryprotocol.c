@@ -36,6 +36,7 @@
 #include <thrift/c_glib/transport/thrift_socket.h>
 #include <thrift/c_glib/transport/thrift_server_socket.h>
 #include <thrift/c_glib/transport/thrift_framed_transport.h>
+#include <thrift/c_glib/transport/thrift_memory_buffer.h>
 
 #define TEST_BOOL TRUE
 #define TEST_BYTE 123
@@ -839,6 +840,139 @@ thrift_server_many_frames (const int port)
   g_object_unref (tsocket);
 }
 
+static void
+test_read_binary_view (void)
+{
+  ThriftMemoryBuffer *tbuffer = NULL;
+  ThriftProtocol *protocol = NULL;
+  GByteArray *scratch = NULL;
+  const guint8 *buf = NULL;
+  guint32 len = 0;
+  const guint32 string_len = strlen (TEST_STRING);
+  const guint8 *data;
+  gint8 value_byte = 0;
+  int reads;
+  GError *error = NULL;
+
+  tbuffer = g_object_new (THRIFT_TYPE_MEMORY_BUFFER, NULL);
+  protocol = g_object_new (THRIFT_TYPE_BINARY_PROTOCOL, "transport",
+                           tbuffer, NULL);
+  scratch = g_byte_array_new ();
+
+  g_assert (thrift_binary_protocol_write_binary (protocol,
+                                                 (gpointer) TEST_STRING,
+                                                 string_len, NULL) > 0);
+  g_assert (thrift_binary_protocol_write_byte (protocol, TEST_BYTE, NULL) > 0);
+  data = tbuffer->buf->data;
+
+  /* the value is lent out of the memory buffer; only its length is read */
+  reads = transport_read_count;
+  g_assert_cmpint (thrift_protocol_read_binary_view (protocol, &buf, &len,
+                                                     scratch, &error),
+                   ==, 4 + string_len);
+  g_assert (error == NULL);
+  g_assert_cmpint (transport_read_count, ==, reads + 1);
+  g_assert_cmpuint (len, ==, string_len);
+  g_assert (buf == data + 4);
+  g_assert_cmpuint (scratch->len, ==, 0);
+  g_assert (memcmp (buf, TEST_STRING, len) == 0);
+
+  /* and consumed, so the next read carries on after it */
+  g_assert (thrift_binary_protocol_read_byte (protocol, &value_byte,
+                                              &error) > 0);
+  g_assert_cmpint (value_byte, ==, TEST_BYTE);
+
+  g_byte_array_unref (scratch);
+  g_object_unref (protocol);
+  g_object_unref (tbuffer);
+}
+
+static void
+test_read_binary_view_scratch (void)
+{
+  ThriftTransport *membuf = NULL;
+  ThriftTransport *transport = NULL;
+  ThriftProtocol *protocol = NULL;
+  GByteArray *scratch = NULL;
+  const guint8 *buf = NULL;
+  guint32 len = 0;
+  const guint32 string_len = strlen (TEST_STRING);
+  GError *error = NULL;
+
+  membuf = g_object_new (THRIFT_TYPE_MEMORY_BUFFER, NULL);
+  transport = g_object_new (THRIFT_TYPE_FRAMED_TRANSPORT,
+                            "transport", membuf, NULL);
+  protocol = g_object_new (THRIFT_TYPE_BINARY_PROTOCOL, "transport",
+                           transport, NULL);
+  scratch = g_byte_array_new ();
+
+  /* split the value across two frames, so neither can lend all of it */
+  g_assert (thrift_binary_protocol_write_i32 (protocol, string_len,
+                                              NULL) > 0);
+  g_assert (thrift_transport_write (transport, (gpointer) TEST_STRING, 10,
+                                    NULL));
+  g_assert (thrift_transport_flush (transport, NULL));
+  g_assert (thrift_transport_write (transport, (gpointer) (TEST_STRING + 10),
+                                    string_len - 10, NULL));
+  g_assert (thrift_transport_flush (transport, NULL));
+
+  g_assert_cmpint (thrift_protocol_read_binary_view (protocol, &buf, &len,
+                                                     scratch, &error),
+                   ==, 4 + string_len);
+  g_assert (error == NULL);
+  g_assert_cmpuint (len, ==, string_len);
+  g_assert (buf == scratch->data);
+  g_assert_cmpuint (scratch->len, ==, string_len);
+  g_assert (memcmp (buf, TEST_STRING, len) == 0);
+
+  g_byte_array_unref (scratch);
+  g_object_unref (protocol);
+  g_object_unref (transport);
+  g_object_unref (membuf);
+}
+
+static void
+test_read_binary_view_bad_size (void)
+{
+  ThriftTransport *tbuffer = NULL;
+  ThriftProtocol *protocol = NULL;
+  GByteArray *scratch = NULL;
+  const guint8 *buf = NULL;
+  guint32 len = 0;
+  GError *error = NULL;
+
+  tbuffer = g_object_new (THRIFT_TYPE_MEMORY_BUFFER,
+                          "remainingmessagesize", (glong) 64, NULL);
+  protocol = g_object_new (THRIFT_TYPE_BINARY_PROTOCOL, "transport",
+                           tbuffer, NULL);
+  scratch = g_byte_array_new ();
+
+  g_assert (thrift_binary_protocol_write_i32 (protocol, -1, NULL) > 0);
+  g_assert_cmpint (thrift_protocol_read_binary_view (protocol, &buf, &len,
+                                                     scratch, &error),
+                   ==, -1);
+  g_assert_error (error, THRIFT_PROTOCOL_ERROR,
+                  THRIFT_PROTOCOL_ERROR_NEGATIVE_SIZE);
+  g_clear_error (&error);
+
+  /* a size beyond what the transport allows is refused before the scratch
+   * array is grown to hold it */
+  g_assert (thrift_binary_protocol_write_i32 (protocol, 1000, NULL) > 0);
+  g_assert (thrift_transport_write (tbuffer, (gpointer) TEST_STRING, 10,
+                                    NULL));
+  g_assert_cmpint (thrift_protocol_read_binary_view (protocol, &buf, &len,
+                                                     scratch, &error),
+                   ==, -1);
+  g_assert_error (error, THRIFT_TRANSPORT_ERROR,
+                  THRIFT_TRANSPORT_ERROR_MAX_MESSAGE_SIZE_REACHED);
+  g_clear_error (&error);
+  g_assert_cmpuint (scratch->len, ==, 0);
+
+  g_byte_array_unref (scratch);
+  g_object_unref (protocol);
+  g_object_unref (tbuffer);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -854,6 +988,12 @@ main(int argc, char *argv[])
   g_test_add_func ("/testbinaryprotocol/ReadAndWriteComplexTypes", test_read_and_write_complex_types);
   g_test_add_func ("/testbinaryprotocol/ReadAndWriteManyFrames",
                    test_read_and_write_many_frames);
+  g_test_add_func ("/testbinaryprotocol/ReadBinaryView",
+                   test_read_binary_view);
+  g_test_add_func ("/testbinaryprotocol/ReadBinaryViewScratch",
+                   test_read_binary_view_scratch);
+  g_test_add_func ("/testbinaryprotocol/ReadBinaryViewBadSize",
+                   test_read_binary_view_bad_size);
 
   return g_test_run ();
 }
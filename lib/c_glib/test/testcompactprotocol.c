@@ -40,6 +40,7 @@
 #include <thrift/c_glib/transport/thrift_socket.h>
 #include <thrift/c_glib/transport/thrift_server_socket.h>
 #include <thrift/c_glib/transport/thrift_framed_transport.h>
+#include <thrift/c_glib/transport/thrift_memory_buffer.h>
 
 #define TEST_BOOL TRUE
 #define TEST_BYTE 123
@@ -1270,6 +1271,212 @@ thrift_server_many_frames (const int port)
   g_object_unref (tsocket);
 }
 
+static void
+test_read_binary_view (void)
+{
+  ThriftMemoryBuffer *tbuffer = NULL;
+  ThriftProtocol *protocol = NULL;
+  GByteArray *scratch = NULL;
+  const guint8 *buf = NULL;
+  guint32 len = 0;
+  const guint32 string_len = strlen (TEST_STRING);
+  const guint8 *data;
+  const guint8 too_long[11] = { 0x80, 0x80, 0x80, 0x80, 0x80,
+                                0x80, 0x80, 0x80, 0x80, 0x80, 0x01 };
+  gint64 value_64 = 0;
+  int reads;
+  GError *error = NULL;
+
+  tbuffer = g_object_new (THRIFT_TYPE_MEMORY_BUFFER, NULL);
+  protocol = g_object_new (THRIFT_TYPE_COMPACT_PROTOCOL, "transport",
+                           tbuffer, NULL);
+  scratch = g_byte_array_new ();
+
+  g_assert (thrift_compact_protocol_write_binary (protocol,
+                                                  (gpointer) TEST_STRING,
+                                                  string_len, NULL) > 0);
+  g_assert (thrift_compact_protocol_write_i64 (protocol, TEST_I64, NULL) > 0);
+  data = tbuffer->buf->data;
+
+  /* the length varint and the value are both lent out of the memory
+   * buffer, so nothing goes through read_all */
+  reads = transport_read_count;
+  g_assert_cmpint (thrift_protocol_read_binary_view (protocol, &buf, &len,
+                                                     scratch, &error),
+                   ==, 1 + string_len);
+  g_assert (error == NULL);
+  g_assert_cmpuint (len, ==, string_len);
+  g_assert (buf == data + 1);
+  g_assert_cmpuint (scratch->len, ==, 0);
+  g_assert (memcmp (buf, TEST_STRING, len) == 0);
+
+  g_assert (thrift_compact_protocol_read_i64 (protocol, &value_64,
+                                              &error) > 1);
+  g_assert (value_64 == TEST_I64);
+  g_assert_cmpint (transport_read_count, ==, reads);
+
+  /* a varint the buffer holds ten bytes of without it ending is refused */
+  g_assert (thrift_transport_write (THRIFT_TRANSPORT (tbuffer),
+                                    (gpointer) too_long, 11, NULL));
+  g_assert_cmpint (thrift_compact_protocol_read_i64 (protocol, &value_64,
+                                                     &error), ==, -1);
+  g_assert_error (error, THRIFT_PROTOCOL_ERROR,
+                  THRIFT_PROTOCOL_ERROR_INVALID_DATA);
+  g_clear_error (&error);
+
+  g_byte_array_unref (scratch);
+  g_object_unref (protocol);
+  g_object_unref (tbuffer);
+}
+
+static void
+test_read_binary_view_scratch (void)
+{
+  ThriftTransport *membuf = NULL;
+  ThriftTransport *transport = NULL;
+  ThriftProtocol *protocol = NULL;
+  GByteArray *scratch = NULL;
+  const guint8 *buf = NULL;
+  guint32 len = 0;
+  const guint32 string_len = strlen (TEST_STRING);
+  GError *error = NULL;
+
+  membuf = g_object_new (THRIFT_TYPE_MEMORY_BUFFER, NULL);
+  transport = g_object_new (THRIFT_TYPE_FRAMED_TRANSPORT,
+                            "transport", membuf, NULL);
+  protocol = g_object_new (THRIFT_TYPE_COMPACT_PROTOCOL, "transport",
+                           transport, NULL);
+  scratch = g_byte_array_new ();
+
+  /* split the value across two frames, so neither can lend all of it */
+  g_assert (thrift_compact_protocol_write_varint32
+              (THRIFT_COMPACT_PROTOCOL (protocol), string_len, NULL) > 0);
+  g_assert (thrift_transport_write (transport, (gpointer) TEST_STRING, 10,
+                                    NULL));
+  g_assert (thrift_transport_flush (transport, NULL));
+  g_assert (thrift_transport_write (transport, (gpointer) (TEST_STRING + 10),
+                                    string_len - 10, NULL));
+  g_assert (thrift_transport_flush (transport, NULL));
+
+  g_assert_cmpint (thrift_protocol_read_binary_view (protocol, &buf, &len,
+                                                     scratch, &error),
+                   ==, 1 + string_len);
+  g_assert (error == NULL);
+  g_assert_cmpuint (len, ==, string_len);
+  g_assert (buf == scratch->data);
+  g_assert_cmpuint (scratch->len, ==, string_len);
+  g_assert (memcmp (buf, TEST_STRING, len) == 0);
+
+  g_byte_array_unref (scratch);
+  g_object_unref (protocol);
+  g_object_unref (transport);
+  g_object_unref (membuf);
+}
+
+static void
+test_read_binary_view_split_varint (void)
+{
+  ThriftTransport *membuf = NULL;
+  ThriftFramedTransport *framed = NULL;
+  ThriftTransport *transport = NULL;
+  ThriftProtocol *protocol = NULL;
+  GByteArray *scratch = NULL;
+  const guint8 *buf = NULL;
+  guint32 len = 0;
+  guint8 value[300];
+  guint8 length[2];
+  gint8 value_byte = 0;
+  int reads;
+  guint32 i;
+  GError *error = NULL;
+
+  for (i = 0; i < sizeof (value); ++i) {
+    value[i] = (guint8) i;
+  }
+
+  membuf = g_object_new (THRIFT_TYPE_MEMORY_BUFFER, NULL);
+  framed = g_object_new (THRIFT_TYPE_FRAMED_TRANSPORT,
+                         "transport", membuf, NULL);
+  transport = THRIFT_TRANSPORT (framed);
+  protocol = g_object_new (THRIFT_TYPE_COMPACT_PROTOCOL, "transport",
+                           transport, NULL);
+  scratch = g_byte_array_new ();
+
+  /* the first frame ends after the first byte of the two byte varint 300 */
+  length[0] = 0x80 | (sizeof (value) & 0x7f);
+  length[1] = sizeof (value) >> 7;
+  g_assert (thrift_compact_protocol_write_byte (protocol, TEST_BYTE,
+                                                NULL) > 0);
+  g_assert (thrift_transport_write (transport, length, 1, NULL));
+  g_assert (thrift_transport_flush (transport, NULL));
+  g_assert (thrift_transport_write (transport, length + 1, 1, NULL));
+  g_assert (thrift_transport_write (transport, value, sizeof (value), NULL));
+  g_assert (thrift_transport_flush (transport, NULL));
+
+  g_assert (thrift_compact_protocol_read_byte (protocol, &value_byte,
+                                               &error) > 0);
+  g_assert_cmpint (value_byte, ==, TEST_BYTE);
+
+  /* the varint is read a byte at a time once the frame runs out, and the
+   * value is then lent out of the second frame */
+  reads = transport_read_count;
+  g_assert_cmpint (thrift_protocol_read_binary_view (protocol, &buf, &len,
+                                                     scratch, &error),
+                   ==, 2 + sizeof (value));
+  g_assert (error == NULL);
+  g_assert_cmpint (transport_read_count, ==, reads + 2);
+  g_assert_cmpuint (len, ==, sizeof (value));
+  g_assert (buf == framed->r_buf->data + 1);
+  g_assert_cmpuint (scratch->len, ==, 0);
+  g_assert (memcmp (buf, value, len) == 0);
+
+  g_byte_array_unref (scratch);
+  g_object_unref (protocol);
+  g_object_unref (framed);
+  g_object_unref (membuf);
+}
+
+static void
+test_read_binary_view_bad_size (void)
+{
+  ThriftTransport *tbuffer = NULL;
+  ThriftProtocol *protocol = NULL;
+  GByteArray *scratch = NULL;
+  const guint8 *buf = NULL;
+  guint32 len = 0;
+  GError *error = NULL;
+
+  tbuffer = g_object_new (THRIFT_TYPE_MEMORY_BUFFER, NULL);
+  protocol = g_object_new (THRIFT_TYPE_COMPACT_PROTOCOL, "transport",
+                           tbuffer, "string_limit", 10, NULL);
+  scratch = g_byte_array_new ();
+
+  g_assert (thrift_compact_protocol_write_varint32
+              (THRIFT_COMPACT_PROTOCOL (protocol), 0xffffffff, NULL) > 0);
+  g_assert_cmpint (thrift_protocol_read_binary_view (protocol, &buf, &len,
+                                                     scratch, &error),
+                   ==, -1);
+  g_assert_error (error, THRIFT_PROTOCOL_ERROR,
+                  THRIFT_PROTOCOL_ERROR_NEGATIVE_SIZE);
+  g_clear_error (&error);
+
+  g_assert (thrift_compact_protocol_write_binary (protocol,
+                                                  (gpointer) TEST_STRING,
+                                                  strlen (TEST_STRING),
+                                                  NULL) > 0);
+  g_assert_cmpint (thrift_protocol_read_binary_view (protocol, &buf, &len,
+                                                     scratch, &error),
+                   ==, -1);
+  g_assert_error (error, THRIFT_PROTOCOL_ERROR,
+                  THRIFT_PROTOCOL_ERROR_SIZE_LIMIT);
+  g_clear_error (&error);
+  g_assert_cmpuint (scratch->len, ==, 0);
+
+  g_byte_array_unref (scratch);
+  g_object_unref (protocol);
+  g_object_unref (tbuffer);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -1288,6 +1495,14 @@ main (int argc, char *argv[])
                    test_read_and_write_complex_types);
   g_test_add_func ("/testcompactprotocol/ReadAndWriteManyFrames",
                    test_read_and_write_many_frames);
+  g_test_add_func ("/testcompactprotocol/ReadBinaryView",
+                   test_read_binary_view);
+  g_test_add_func ("/testcompactprotocol/ReadBinaryViewScratch",
+                   test_read_binary_view_scratch);
+  g_test_add_func ("/testcompactprotocol/ReadBinaryViewSplitVarint",
+                   test_read_binary_view_split_varint);
+  g_test_add_func ("/testcompactprotocol/ReadBinaryViewBadSize",
+                   test_read_binary_view_bad_size);
 
   return g_test_run ();
 }
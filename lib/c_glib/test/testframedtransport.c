@@ -24,6 +24,7 @@
 #include <thrift/c_glib/transport/thrift_socket.h>
 #include <thrift/c_glib/transport/thrift_server_transport.h>
 #include <thrift/c_glib/transport/thrift_server_socket.h>
+#include <thrift/c_glib/transport/thrift_memory_buffer.h>
 
 #define TEST_DATA { 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j' }
 
@@ -160,6 +161,51 @@ test_read_and_write(void)
     }
 }
 
+/* test lending bytes straight out of a frame */
+static void
+test_borrow_from_frame (void)
+{
+  ThriftTransport *membuf = NULL;
+  ThriftTransport *transport = NULL;
+  guchar buf[10] = TEST_DATA;
+  guchar read[10];
+  const guint8 *lent;
+  guint32 len;
+  GError *error = NULL;
+
+  membuf = g_object_new (THRIFT_TYPE_MEMORY_BUFFER, NULL);
+  transport = g_object_new (THRIFT_TYPE_FRAMED_TRANSPORT,
+                            "transport", membuf, NULL);
+
+  g_assert (thrift_framed_transport_write (transport, buf, 10, NULL) == TRUE);
+  g_assert (thrift_framed_transport_flush (transport, NULL) == TRUE);
+
+  /* nothing is lent before the frame has been read */
+  len = 1;
+  g_assert (thrift_framed_transport_borrow (transport, &len, &error) == NULL);
+
+  g_assert (thrift_framed_transport_read (transport, read, 2, &error) == 2);
+  g_assert (memcmp (read, buf, 2) == 0);
+
+  len = 1;
+  lent = thrift_framed_transport_borrow (transport, &len, &error);
+  g_assert (lent != NULL);
+  g_assert (len == 8);
+  g_assert (memcmp (lent, buf + 2, 8) == 0);
+  g_assert (thrift_framed_transport_consume (transport, 3, &error) == TRUE);
+
+  g_assert (thrift_framed_transport_read_all (transport, read, 5, &error) == 5);
+  g_assert (memcmp (read, buf + 5, 5) == 0);
+  g_assert (error == NULL);
+
+  g_assert (thrift_framed_transport_consume (transport, 1, &error) == FALSE);
+  g_assert (error != NULL);
+  g_error_free (error);
+
+  g_object_unref (transport);
+  g_object_unref (membuf);
+}
+
 /* test reading from the transport after the peer has unexpectedly
    closed the connection */
 static void
@@ -318,6 +364,7 @@ main(int argc, char *argv[])
   g_test_add_func ("/testframedtransport/OpenAndClose", test_open_and_close);
   g_test_add_func ("/testframedtransport/ReadAndWrite", test_read_and_write);
   g_test_add_func ("/testframedtransport/ReadAfterPeerClose", test_read_after_peer_close);
+  g_test_add_func ("/testframedtransport/BorrowFromFrame", test_borrow_from_frame);
 
   return g_test_run ();
 }
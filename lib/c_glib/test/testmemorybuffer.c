@@ -199,6 +199,45 @@ test_read_and_write_external (void)
   g_object_unref (tbuffer);
 }
 
+static void
+test_borrow_and_consume (void)
+{
+  ThriftMemoryBuffer *tbuffer = NULL;
+  const guint8 *lent;
+  guint32 len;
+  gchar read[5];
+  GError *error = NULL;
+
+  tbuffer = g_object_new (THRIFT_TYPE_MEMORY_BUFFER, NULL);
+  g_assert (thrift_memory_buffer_write (THRIFT_TRANSPORT (tbuffer),
+                                      (gpointer) TEST_DATA, 10, &error) == TRUE);
+
+  /* can't lend more than is buffered */
+  len = 11;
+  g_assert (thrift_memory_buffer_borrow (THRIFT_TRANSPORT (tbuffer),
+                                         &len, &error) == NULL);
+  g_assert (error == NULL);
+
+  len = 4;
+  lent = thrift_memory_buffer_borrow (THRIFT_TRANSPORT (tbuffer), &len, &error);
+  g_assert (lent != NULL);
+  g_assert (len == 10);
+  g_assert (memcmp (lent, TEST_DATA, 10) == 0);
+  g_assert (thrift_memory_buffer_consume (THRIFT_TRANSPORT (tbuffer),
+                                          5, &error) == TRUE);
+
+  /* reads pick up after the consumed bytes */
+  g_assert (thrift_memory_buffer_read_all (THRIFT_TRANSPORT (tbuffer),
+                                           read, 5, &error) == 5);
+  g_assert (memcmp (read, TEST_DATA + 5, 5) == 0);
+
+  g_assert (thrift_memory_buffer_consume (THRIFT_TRANSPORT (tbuffer),
+                                          1, &error) == FALSE);
+  g_assert (error != NULL);
+  g_error_free (error);
+  g_object_unref (tbuffer);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -217,6 +256,7 @@ main(int argc, char *argv[])
   g_test_add_func ("/testmemorybuffer/ReadAndWrite", test_read_and_write);
   g_test_add_func ("/testmemorybuffer/ReadAndWriteUnlimited", test_read_and_write_default);
   g_test_add_func ("/testmemorybuffer/ReadAndWriteExternal", test_read_and_write_external);
+  g_test_add_func ("/testmemorybuffer/BorrowAndConsume", test_borrow_and_consume);
 
   return g_test_run ();
 }
@@ -19,6 +19,7 @@
 #ifndef _THRIFT_TDISPATCHPROCESSOR_H_
 #define _THRIFT_TDISPATCHPROCESSOR_H_ 1
 
+#include <typeinfo>
 #include <thrift/TProcessor.h>
 
 namespace apache {
@@ -39,9 +40,9 @@ public:
     protocol::TProtocol* inRaw = in.get();
     protocol::TProtocol* outRaw = out.get();
 
-    // Try to dynamic cast to the template protocol type
-    auto* specificIn = dynamic_cast<Protocol_*>(inRaw);
-    auto* specificOut = dynamic_cast<Protocol_*>(outRaw);
+    // Try to cast to the template protocol type
+    Protocol_* specificIn = specificProtocol(inRaw);
+    Protocol_* specificOut = outRaw == inRaw ? specificIn : specificProtocol(outRaw);
     if (specificIn && specificOut) {
       return processFast(specificIn, specificOut, connectionContext);
     }
@@ -69,6 +70,18 @@ public:
   }
 
 protected:
+  /**
+   * Cast prot to the template protocol type, or return nullptr if it is not
+   * one.  An exact match is the common case, and cheaper to detect than with
+   * a dynamic_cast.
+   */
+  static Protocol_* specificProtocol(protocol::TProtocol* prot) {
+    if (prot != nullptr && typeid(*prot) == typeid(Protocol_)) {
+      return static_cast<Protocol_*>(prot);
+    }
+    return dynamic_cast<Protocol_*>(prot);
+  }
+
   bool processFast(Protocol_* in, Protocol_* out, void* connectionContext) {
     std::string fname;
     protocol::TMessageType mtype;
@@ -0,0 +1,152 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef _THRIFT_TLAZYSTRUCT_H_
+#define _THRIFT_TLAZYSTRUCT_H_ 1
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include <thrift/Thrift.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+
+namespace apache {
+namespace thrift {
+
+/**
+ * Holder for a struct field annotated with cpp.lazy.
+ *
+ * When read from a binary protocol, the field keeps the encoded bytes
+ * instead of decoding them, and only decodes them when the value is first
+ * accessed.  If it is written to a binary protocol before then, the bytes are
+ * copied through unchanged, so a proxy can forward a large nested struct
+ * without ever decoding it.  Other protocols decode the field as it is read.
+ *
+ * Access through get(), operator-> or the conversion to a const reference.
+ * Since the first access of an undecoded field modifies it, even through a
+ * const reference, it must not be made from several threads at once.
+ */
+template <class Struct_>
+class TLazyStruct {
+public:
+  TLazyStruct() : decoded_(true) {}
+
+  TLazyStruct(const Struct_& value) : value_(value), decoded_(true) {}
+
+  TLazyStruct& operator=(const Struct_& value) {
+    value_ = value;
+    raw_.clear();
+    decoded_ = true;
+    return *this;
+  }
+
+  const Struct_& get() const {
+    decode();
+    return value_;
+  }
+
+  Struct_& get() {
+    decode();
+    return value_;
+  }
+
+  operator const Struct_&() const { return get(); }
+
+  const Struct_* operator->() const { return &get(); }
+
+  Struct_* operator->() { return &get(); }
+
+  /**
+   * Whether the value has been decoded (or was never encoded).
+   */
+  bool isDecoded() const { return decoded_; }
+
+  template <class Protocol_>
+  uint32_t read(Protocol_* iprot) {
+    uint32_t xfer = 0;
+    raw_.clear();
+    if (iprot->readRawBinary(protocol::T_STRUCT, raw_, xfer)) {
+      decoded_ = false;
+      return xfer;
+    }
+    decoded_ = true;
+    return value_.read(iprot);
+  }
+
+  template <class Protocol_>
+  uint32_t write(Protocol_* oprot) const {
+    uint32_t xfer = 0;
+    if (!decoded_ && oprot->writeRawBinary(raw_, xfer)) {
+      return xfer;
+    }
+    return get().write(oprot);
+  }
+
+  /**
+   * Encoded size under Protocol_, for structs generated with
+   * cpp:serialized_size.  The raw bytes are not necessarily in Protocol_'s
+   * encoding, so this decodes.
+   */
+  template <class Protocol_>
+  uint32_t serializedSize() const {
+    return get().template serializedSize<Protocol_>();
+  }
+
+  bool operator==(const TLazyStruct& rhs) const { return get() == rhs.get(); }
+
+  bool operator!=(const TLazyStruct& rhs) const { return !(*this == rhs); }
+
+  friend void swap(TLazyStruct& a, TLazyStruct& b) {
+    using ::std::swap;
+    swap(a.value_, b.value_);
+    swap(a.raw_, b.raw_);
+    swap(a.decoded_, b.decoded_);
+  }
+
+private:
+  void decode() const {
+    if (decoded_) {
+      return;
+    }
+    std::shared_ptr<transport::TMemoryBuffer> buffer(
+        new transport::TMemoryBuffer(reinterpret_cast<uint8_t*>(const_cast<char*>(raw_.data())),
+                                     static_cast<uint32_t>(raw_.size())));
+    protocol::TBinaryProtocolT<transport::TMemoryBuffer> prot(buffer);
+    value_.read(&prot);
+    raw_.clear();
+    decoded_ = true;
+  }
+
+  mutable Struct_ value_;
+  mutable std::string raw_;
+  mutable bool decoded_;
+};
+
+template <class Struct_>
+std::ostream& operator<<(std::ostream& out, const TLazyStruct<Struct_>& obj) {
+  return out << obj.get();
+}
+}
+} // apache::thrift
+
+#endif // #ifndef _THRIFT_TLAZYSTRUCT_H_
@@ -34,12 +34,14 @@
 #ifdef HAVE_INTTYPES_H
 #include <inttypes.h>
 #endif
+#include <cstddef>
 #include <string>
 #include <map>
 #include <list>
 #include <set>
 #include <vector>
 #include <exception>
+#include <iterator>
 #include <typeinfo>
 
 #include <thrift/TLogging.h>
@@ -50,9 +52,14 @@
 namespace apache {
 namespace thrift {
 
-class TEnumIterator
-    : public std::iterator<std::forward_iterator_tag, std::pair<int, const char*> > {
+class TEnumIterator {
 public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef std::pair<int, const char*> value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef value_type* pointer;
+  typedef value_type& reference;
+
   TEnumIterator(int n, int* enums, const char** names)
     : ii_(0), n_(n), enums_(enums), names_(names) {}
 
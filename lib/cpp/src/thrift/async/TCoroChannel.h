@@ -0,0 +1,101 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THRIFT_ASYNC_TCOROCHANNEL_H_
+#define _THRIFT_ASYNC_TCOROCHANNEL_H_ 1
+
+#include <memory>
+#include <thrift/async/TCoroutine.h>
+#include <thrift/protocol/TProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+
+namespace apache {
+namespace thrift {
+namespace async {
+
+/**
+ * The buffers and protocols used by a single outstanding coroutine call.
+ * Generated clients create one per call, which is what allows any number of
+ * calls to be in flight on the same client at once.
+ */
+class TCoroRequest {
+public:
+  explicit TCoroRequest(protocol::TProtocolFactory* protocolFactory)
+    : sendBuf_(new transport::TMemoryBuffer()),
+      recvBuf_(new transport::TMemoryBuffer()),
+      oprot_(protocolFactory->getProtocol(sendBuf_)),
+      iprot_(protocolFactory->getProtocol(recvBuf_)) {}
+
+  transport::TMemoryBuffer* getSendBuffer() { return sendBuf_.get(); }
+  transport::TMemoryBuffer* getRecvBuffer() { return recvBuf_.get(); }
+  protocol::TProtocol* getOutputProtocol() { return oprot_.get(); }
+  protocol::TProtocol* getInputProtocol() { return iprot_.get(); }
+
+private:
+  std::shared_ptr<transport::TMemoryBuffer> sendBuf_;
+  std::shared_ptr<transport::TMemoryBuffer> recvBuf_;
+  std::shared_ptr<protocol::TProtocol> oprot_;
+  std::shared_ptr<protocol::TProtocol> iprot_;
+};
+
+/**
+ * Coroutine counterpart of TAsyncChannel, used by the CoroClient classes
+ * generated with cpp:coroutines.  Each message is a complete serialized call
+ * or reply held in a TMemoryBuffer.
+ */
+class TCoroChannel {
+public:
+  virtual ~TCoroChannel() = default;
+
+  // is the channel in a good state?
+  virtual bool good() const = 0;
+
+  /**
+   * Send a message over the channel.
+   */
+  virtual TTask<void> sendMessage(transport::TMemoryBuffer* message) = 0;
+
+  /**
+   * Receive a message from the channel.
+   */
+  virtual TTask<void> recvMessage(transport::TMemoryBuffer* message) = 0;
+
+  /**
+   * Send a message over the channel and receive the response.  Channels that
+   * are shared by concurrent callers must override this so that responses are
+   * delivered to the call that is waiting for them.
+   */
+  virtual TTask<void> sendAndRecvMessage(transport::TMemoryBuffer* sendBuf,
+                                         transport::TMemoryBuffer* recvBuf) {
+    co_await sendMessage(sendBuf);
+    co_await recvMessage(recvBuf);
+  }
+
+  /**
+   * Send a oneway request, keeping it alive until it has been sent.
+   */
+  TTask<void> sendRequest(std::unique_ptr<TCoroRequest> request) {
+    co_await sendMessage(request->getSendBuffer());
+  }
+};
+}
+}
+} // apache::thrift::async
+
+#endif // #ifndef _THRIFT_ASYNC_TCOROCHANNEL_H_
@@ -0,0 +1,307 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THRIFT_ASYNC_TCOROUTINE_H_
+#define _THRIFT_ASYNC_TCOROUTINE_H_ 1
+
+/**
+ * Minimal C++20 coroutine runtime used by code generated with the
+ * cpp:coroutines option.
+ *
+ * The library itself is built as C++11, so everything coroutine related is
+ * header only and only available to translation units compiled as C++20.
+ * Nothing in here depends on a particular event loop: a TTask runs on
+ * whatever thread resumes it.
+ */
+#if !defined(__cpp_impl_coroutine)
+#error "thrift/async/TCoroutine.h requires a compiler with C++20 coroutine support"
+#endif
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <thrift/TOutput.h>
+
+namespace apache {
+namespace thrift {
+namespace async {
+
+template <class T>
+class TTask;
+
+namespace detail {
+
+class TTaskPromiseBase {
+public:
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <class Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      TTaskPromiseBase& promise = handle.promise();
+      if (promise.continuation_) {
+        return promise.continuation_;
+      }
+      if (promise.detached_) {
+        if (promise.exception_) {
+          try {
+            std::rethrow_exception(promise.exception_);
+          } catch (const std::exception& e) {
+            GlobalOutput.printf("TTask: detached task failed: %s", e.what());
+          } catch (...) {
+            GlobalOutput("TTask: detached task failed with an unknown exception");
+          }
+        }
+        handle.destroy();
+      }
+      return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+  void setContinuation(std::coroutine_handle<> continuation) noexcept {
+    continuation_ = continuation;
+  }
+  void setDetached() noexcept { detached_ = true; }
+
+protected:
+  void rethrowIfFailed() const {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+private:
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr exception_;
+  bool detached_ = false;
+};
+
+template <class T>
+class TTaskPromise : public TTaskPromiseBase {
+public:
+  TTask<T> get_return_object() noexcept;
+
+  template <class U>
+  void return_value(U&& value) {
+    value_.emplace(std::forward<U>(value));
+  }
+
+  T result() {
+    rethrowIfFailed();
+    return std::move(*value_);
+  }
+
+private:
+  std::optional<T> value_;
+};
+
+template <>
+class TTaskPromise<void> : public TTaskPromiseBase {
+public:
+  TTask<void> get_return_object() noexcept;
+
+  void return_void() const noexcept {}
+
+  void result() const { rethrowIfFailed(); }
+};
+} // detail
+
+/**
+ * A lazily started coroutine producing a T.
+ *
+ * The body does not run until the task is co_await'ed (or detached), and the
+ * awaiting coroutine is resumed directly when it finishes, so a chain of
+ * awaited tasks never involves a callback allocation or a trip through an
+ * event loop.  Exceptions thrown by the body propagate to the awaiter.
+ */
+template <class T>
+class TTask {
+public:
+  typedef detail::TTaskPromise<T> promise_type;
+
+  TTask() noexcept = default;
+  explicit TTask(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+  TTask(TTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+  TTask(const TTask&) = delete;
+
+  TTask& operator=(TTask&& other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  TTask& operator=(const TTask&) = delete;
+
+  ~TTask() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool valid() const noexcept { return static_cast<bool>(handle_); }
+
+  bool await_ready() const noexcept { return handle_.done(); }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    handle_.promise().setContinuation(awaiting);
+    return handle_;
+  }
+
+  T await_resume() { return handle_.promise().result(); }
+
+  /**
+   * Start the task without waiting for it.  The coroutine frame frees itself
+   * when the body finishes; an exception escaping the body is logged through
+   * GlobalOutput and otherwise dropped.
+   */
+  void detach() && {
+    std::coroutine_handle<promise_type> handle = std::exchange(handle_, nullptr);
+    handle.promise().setDetached();
+    handle.resume();
+  }
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <class T>
+inline TTask<T> TTaskPromise<T>::get_return_object() noexcept {
+  return TTask<T>(std::coroutine_handle<TTaskPromise<T> >::from_promise(*this));
+}
+
+inline TTask<void> TTaskPromise<void>::get_return_object() noexcept {
+  return TTask<void>(std::coroutine_handle<TTaskPromise<void> >::from_promise(*this));
+}
+
+class TSyncWaitState {
+public:
+  void notify() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    cond_.notify_one();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return done_; });
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool done_ = false;
+};
+
+/**
+ * Coroutine used by syncWait().  It only signals the waiting thread once its
+ * frame is suspended for the last time, so the frame can be destroyed as
+ * soon as the wait returns.
+ */
+class TSyncWaitTask {
+public:
+  class promise_type {
+  public:
+    struct FinalAwaiter {
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+        handle.promise().state_->notify();
+      }
+      void await_resume() const noexcept {}
+    };
+
+    TSyncWaitTask get_return_object() noexcept {
+      return TSyncWaitTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+  private:
+    friend class TSyncWaitTask;
+    TSyncWaitState* state_ = nullptr;
+    std::exception_ptr exception_;
+  };
+
+  explicit TSyncWaitTask(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+  TSyncWaitTask(const TSyncWaitTask&) = delete;
+  TSyncWaitTask& operator=(const TSyncWaitTask&) = delete;
+  ~TSyncWaitTask() { handle_.destroy(); }
+
+  void run() {
+    TSyncWaitState state;
+    handle_.promise().state_ = &state;
+    handle_.resume();
+    state.wait();
+    if (handle_.promise().exception_) {
+      std::rethrow_exception(handle_.promise().exception_);
+    }
+  }
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+};
+
+template <class T>
+TSyncWaitTask syncWaitHelper(TTask<T>& task, std::optional<T>& result) {
+  result.emplace(co_await task);
+}
+
+inline TSyncWaitTask syncWaitHelper(TTask<void>& task) {
+  co_await task;
+}
+} // detail
+
+/**
+ * Run a task from ordinary blocking code and wait for its result.
+ *
+ * The task starts on the calling thread.  If it suspends on something that is
+ * completed by another thread, such as an event loop running elsewhere, the
+ * calling thread blocks until the task has finished.  Exceptions thrown by
+ * the task are rethrown here.
+ */
+template <class T>
+T syncWait(TTask<T> task) {
+  std::optional<T> result;
+  detail::syncWaitHelper(task, result).run();
+  return std::move(*result);
+}
+
+inline void syncWait(TTask<void> task) {
+  detail::syncWaitHelper(task).run();
+}
+}
+}
+} // apache::thrift::async
+
+#endif // #ifndef _THRIFT_ASYNC_TCOROUTINE_H_
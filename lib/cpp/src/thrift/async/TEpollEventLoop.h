@@ -0,0 +1,237 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THRIFT_ASYNC_TEPOLLEVENTLOOP_H_
+#define _THRIFT_ASYNC_TEPOLLEVENTLOOP_H_ 1
+
+#include <atomic>
+#include <errno.h>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <vector>
+#include <thrift/async/TCoroutine.h>
+#include <thrift/transport/TTransportException.h>
+
+namespace apache {
+namespace thrift {
+namespace async {
+
+/**
+ * A single threaded epoll loop that resumes coroutines when the file
+ * descriptor they are waiting on becomes ready.  Linux only.
+ *
+ * run() must be called from exactly one thread; every other member may be
+ * called from any thread.  Coroutines that want to use a channel bound to
+ * this loop should first move onto the loop thread with
+ * co_await loop.schedule().
+ */
+class TEpollEventLoop {
+public:
+  class FdAwaiter {
+  public:
+    FdAwaiter(TEpollEventLoop* loop, int fd, uint32_t events)
+      : loop_(loop), fd_(fd), events_(events) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+      handle_ = handle;
+      loop_->arm(fd_, events_, this);
+    }
+    void await_resume() const noexcept {}
+
+  private:
+    friend class TEpollEventLoop;
+    TEpollEventLoop* loop_;
+    int fd_;
+    uint32_t events_;
+    std::coroutine_handle<> handle_;
+  };
+
+  class ScheduleAwaiter {
+  public:
+    explicit ScheduleAwaiter(TEpollEventLoop* loop) : loop_(loop) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { loop_->post(handle); }
+    void await_resume() const noexcept {}
+
+  private:
+    TEpollEventLoop* loop_;
+  };
+
+  TEpollEventLoop() : stopped_(false), wakeupPending_(false) {
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd_ < 0) {
+      int errno_copy = errno;
+      throw transport::TTransportException(transport::TTransportException::UNKNOWN,
+                                           "epoll_create1() failed",
+                                           errno_copy);
+    }
+    wakeupFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupFd_ < 0) {
+      int errno_copy = errno;
+      ::close(epollFd_);
+      throw transport::TTransportException(transport::TTransportException::UNKNOWN,
+                                           "eventfd() failed",
+                                           errno_copy);
+    }
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeupFd_, &ev) < 0) {
+      int errno_copy = errno;
+      ::close(wakeupFd_);
+      ::close(epollFd_);
+      throw transport::TTransportException(transport::TTransportException::UNKNOWN,
+                                           "epoll_ctl() failed",
+                                           errno_copy);
+    }
+  }
+
+  TEpollEventLoop(const TEpollEventLoop&) = delete;
+  TEpollEventLoop& operator=(const TEpollEventLoop&) = delete;
+
+  ~TEpollEventLoop() {
+    ::close(wakeupFd_);
+    ::close(epollFd_);
+  }
+
+  /**
+   * Dispatch events until stop() is called.
+   */
+  void run() {
+    struct epoll_event events[64];
+    while (!stopped_.load()) {
+      int n = ::epoll_wait(epollFd_, events, 64, -1);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        int errno_copy = errno;
+        throw transport::TTransportException(transport::TTransportException::UNKNOWN,
+                                             "epoll_wait() failed",
+                                             errno_copy);
+      }
+      for (int i = 0; i < n; ++i) {
+        if (events[i].data.ptr == nullptr) {
+          runPosted();
+        } else {
+          static_cast<FdAwaiter*>(events[i].data.ptr)->handle_.resume();
+        }
+      }
+    }
+    stopped_.store(false);
+  }
+
+  /**
+   * Make run() return after the current iteration.
+   */
+  void stop() {
+    stopped_.store(true);
+    wakeup();
+  }
+
+  /**
+   * Resume handle on the loop thread.
+   */
+  void post(std::coroutine_handle<> handle) {
+    {
+      std::lock_guard<std::mutex> lock(postedMutex_);
+      posted_.push_back(handle);
+      if (wakeupPending_) {
+        return;
+      }
+      wakeupPending_ = true;
+    }
+    wakeup();
+  }
+
+  /**
+   * co_await loop.schedule() continues the calling coroutine on the loop
+   * thread.
+   */
+  ScheduleAwaiter schedule() { return ScheduleAwaiter(this); }
+
+  /**
+   * Suspend until fd is readable (or has an error pending).  Only one
+   * coroutine may wait on a given descriptor at a time.
+   */
+  FdAwaiter waitReadable(int fd) { return FdAwaiter(this, fd, EPOLLIN | EPOLLRDHUP); }
+
+  /**
+   * Suspend until fd is writable (or has an error pending).
+   */
+  FdAwaiter waitWritable(int fd) { return FdAwaiter(this, fd, EPOLLOUT); }
+
+  /**
+   * Stop watching fd.  Call before closing a descriptor that may still be
+   * registered.
+   */
+  void forget(int fd) { ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr); }
+
+private:
+  void arm(int fd, uint32_t events, FdAwaiter* awaiter) {
+    struct epoll_event ev = {};
+    ev.events = events | EPOLLONESHOT;
+    ev.data.ptr = awaiter;
+    if (::epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev) < 0) {
+      if (errno != ENOENT || ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        int errno_copy = errno;
+        throw transport::TTransportException(transport::TTransportException::UNKNOWN,
+                                             "epoll_ctl() failed",
+                                             errno_copy);
+      }
+    }
+  }
+
+  void wakeup() {
+    uint64_t one = 1;
+    while (::write(wakeupFd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+  }
+
+  void runPosted() {
+    uint64_t count;
+    while (::read(wakeupFd_, &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+    std::vector<std::coroutine_handle<> > ready;
+    {
+      std::lock_guard<std::mutex> lock(postedMutex_);
+      ready.swap(posted_);
+      wakeupPending_ = false;
+    }
+    for (std::coroutine_handle<> handle : ready) {
+      handle.resume();
+    }
+  }
+
+  int epollFd_;
+  int wakeupFd_;
+  std::atomic<bool> stopped_;
+  std::mutex postedMutex_;
+  std::vector<std::coroutine_handle<> > posted_;
+  bool wakeupPending_;
+};
+}
+}
+} // apache::thrift::async
+
+#endif // #ifndef _THRIFT_ASYNC_TEPOLLEVENTLOOP_H_
@@ -0,0 +1,245 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THRIFT_ASYNC_TEPOLLSOCKETCHANNEL_H_
+#define _THRIFT_ASYNC_TEPOLLSOCKETCHANNEL_H_ 1
+
+#include <arpa/inet.h>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thrift/async/TCoroChannel.h>
+#include <thrift/async/TEpollEventLoop.h>
+#include <thrift/transport/TSocket.h>
+
+namespace apache {
+namespace thrift {
+namespace async {
+
+/**
+ * Framed (TFramedTransport compatible) coroutine channel over a connected
+ * TSocket, driven by a TEpollEventLoop.  It talks to TNonblockingServer or
+ * to any server using framed transport.
+ *
+ * The socket is switched to non-blocking mode.  All calls must be made on
+ * the loop thread.  Calls issued while another one is in progress wait their
+ * turn without blocking the thread, so a single channel can be shared by any
+ * number of coroutines.
+ */
+class TEpollSocketChannel : public TCoroChannel {
+public:
+  TEpollSocketChannel(TEpollEventLoop* loop, std::shared_ptr<transport::TSocket> socket)
+    : loop_(loop),
+      socket_(socket),
+      fd_(static_cast<int>(socket->getSocketFD())),
+      maxFrameSize_(static_cast<uint32_t>(socket->getConfiguration()->getMaxFrameSize())),
+      busy_(false),
+      error_(false) {
+    if (!socket_->isOpen()) {
+      throw transport::TTransportException(transport::TTransportException::NOT_OPEN,
+                                           "TEpollSocketChannel: socket is not open");
+    }
+    int flags = ::fcntl(fd_, F_GETFL, 0);
+    if (flags < 0 || ::fcntl(fd_, F_SETFL, flags | O_NONBLOCK) < 0) {
+      int errno_copy = errno;
+      throw transport::TTransportException(transport::TTransportException::UNKNOWN,
+                                           "TEpollSocketChannel: fcntl() failed",
+                                           errno_copy);
+    }
+  }
+
+  ~TEpollSocketChannel() override { loop_->forget(fd_); }
+
+  bool good() const override { return !error_ && socket_->isOpen(); }
+
+  TTask<void> sendMessage(transport::TMemoryBuffer* message) override {
+    co_await lock();
+    Unlocker unlocker(this);
+    co_await writeFrame(message);
+  }
+
+  TTask<void> recvMessage(transport::TMemoryBuffer* message) override {
+    co_await lock();
+    Unlocker unlocker(this);
+    co_await readFrame(message);
+  }
+
+  TTask<void> sendAndRecvMessage(transport::TMemoryBuffer* sendBuf,
+                                 transport::TMemoryBuffer* recvBuf) override {
+    co_await lock();
+    Unlocker unlocker(this);
+    co_await writeFrame(sendBuf);
+    co_await readFrame(recvBuf);
+  }
+
+  std::shared_ptr<transport::TSocket> getSocket() const { return socket_; }
+
+private:
+  class LockAwaiter {
+  public:
+    explicit LockAwaiter(TEpollSocketChannel* channel) : channel_(channel) {}
+
+    bool await_ready() const noexcept {
+      if (channel_->busy_) {
+        return false;
+      }
+      channel_->busy_ = true;
+      return true;
+    }
+    void await_suspend(std::coroutine_handle<> handle) { channel_->waiters_.push_back(handle); }
+    void await_resume() const noexcept {}
+
+  private:
+    TEpollSocketChannel* channel_;
+  };
+
+  class Unlocker {
+  public:
+    explicit Unlocker(TEpollSocketChannel* channel) : channel_(channel) {}
+    ~Unlocker() { channel_->unlock(); }
+
+  private:
+    TEpollSocketChannel* channel_;
+  };
+
+  LockAwaiter lock() { return LockAwaiter(this); }
+
+  void unlock() {
+    if (waiters_.empty()) {
+      busy_ = false;
+      return;
+    }
+    // Ownership passes straight to the next waiter.  Resume it through the
+    // loop so that a long queue does not grow the stack.
+    std::coroutine_handle<> next = waiters_.front();
+    waiters_.pop_front();
+    loop_->post(next);
+  }
+
+  void checkGood() {
+    if (error_) {
+      throw transport::TTransportException(transport::TTransportException::NOT_OPEN,
+                                           "TEpollSocketChannel: channel is in an error state");
+    }
+  }
+
+  TTask<void> writeFrame(transport::TMemoryBuffer* message) {
+    checkGood();
+    uint8_t* payload;
+    uint32_t payloadSize;
+    message->getBuffer(&payload, &payloadSize);
+    uint32_t header = htonl(payloadSize);
+
+    struct iovec iov[2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = payload;
+    iov[1].iov_len = payloadSize;
+    struct iovec* pending = iov;
+    int pendingCount = 2;
+
+    while (pendingCount > 0) {
+      struct msghdr msg = {};
+      msg.msg_iov = pending;
+      msg.msg_iovlen = pendingCount;
+      ssize_t sent = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+      if (sent < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          co_await loop_->waitWritable(fd_);
+          continue;
+        }
+        int errno_copy = errno;
+        error_ = true;
+        throw transport::TTransportException(transport::TTransportException::UNKNOWN,
+                                             "TEpollSocketChannel: sendmsg() failed",
+                                             errno_copy);
+      }
+      size_t remaining = static_cast<size_t>(sent);
+      while (pendingCount > 0 && remaining >= pending->iov_len) {
+        remaining -= pending->iov_len;
+        ++pending;
+        --pendingCount;
+      }
+      if (pendingCount > 0) {
+        pending->iov_base = static_cast<uint8_t*>(pending->iov_base) + remaining;
+        pending->iov_len -= remaining;
+      }
+    }
+  }
+
+  TTask<void> readFully(uint8_t* buf, uint32_t len) {
+    while (len > 0) {
+      ssize_t got = ::recv(fd_, buf, len, 0);
+      if (got < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          co_await loop_->waitReadable(fd_);
+          continue;
+        }
+        int errno_copy = errno;
+        error_ = true;
+        throw transport::TTransportException(transport::TTransportException::UNKNOWN,
+                                             "TEpollSocketChannel: recv() failed",
+                                             errno_copy);
+      }
+      if (got == 0) {
+        error_ = true;
+        throw transport::TTransportException(transport::TTransportException::END_OF_FILE,
+                                             "TEpollSocketChannel: connection closed by peer");
+      }
+      buf += got;
+      len -= static_cast<uint32_t>(got);
+    }
+  }
+
+  TTask<void> readFrame(transport::TMemoryBuffer* message) {
+    checkGood();
+    uint32_t header;
+    co_await readFully(reinterpret_cast<uint8_t*>(&header), sizeof(header));
+    uint32_t frameSize = ntohl(header);
+    if (frameSize > maxFrameSize_) {
+      error_ = true;
+      throw transport::TTransportException(transport::TTransportException::CORRUPTED_DATA,
+                                           "TEpollSocketChannel: frame size exceeds limit");
+    }
+    message->resetBuffer();
+    co_await readFully(message->getWritePtr(frameSize), frameSize);
+    message->wroteBytes(frameSize);
+  }
+
+  TEpollEventLoop* loop_;
+  std::shared_ptr<transport::TSocket> socket_;
+  int fd_;
+  uint32_t maxFrameSize_;
+  bool busy_;
+  bool error_;
+  std::deque<std::coroutine_handle<> > waiters_;
+};
+}
+}
+} // apache::thrift::async
+
+#endif // #ifndef _THRIFT_ASYNC_TEPOLLSOCKETCHANNEL_H_
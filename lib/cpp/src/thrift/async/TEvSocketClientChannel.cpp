@@ -0,0 +1,409 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <thrift/thrift-config.h>
+#include <thrift/async/TEvSocketClientChannel.h>
+#include <thrift/protocol/TProtocol.h>
+#include <thrift/protocol/TProtocolException.h>
+#include <thrift/transport/PlatformSocket.h>
+#include <thrift/transport/TBufferTransports.h>
+
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+
+#ifdef HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+#ifdef HAVE_ARPA_INET_H
+#include <arpa/inet.h>
+#endif
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
+#include <limits>
+
+using namespace apache::thrift::protocol;
+using apache::thrift::transport::TMemoryBuffer;
+using apache::thrift::transport::TTransportException;
+
+namespace apache {
+namespace thrift {
+namespace async {
+
+struct TEvSocketClientChannel::Call {
+  TEvSocketClientChannel* channel;
+  VoidCallback cob;
+  TMemoryBuffer* recvBuf;
+  int32_t seqid;       // sequence id on the wire
+  int32_t callerSeqid; // sequence id the client used
+  struct event* timer;
+};
+
+namespace {
+
+/**
+ * Replace the sequence id in the message header at the start of buf.
+ * Returns the length of the original header; the re-encoded header is left
+ * in header and the old sequence id in oldSeqid.
+ */
+uint32_t rewriteSeqid(TProtocolFactory* factory,
+                      uint8_t* buf,
+                      uint32_t len,
+                      int32_t seqid,
+                      int32_t& oldSeqid,
+                      const std::shared_ptr<TMemoryBuffer>& header) {
+  std::shared_ptr<TMemoryBuffer> in(new TMemoryBuffer(buf, len));
+  std::shared_ptr<TProtocol> iprot(factory->getProtocol(in));
+  std::string name;
+  TMessageType type;
+  iprot->readMessageBegin(name, type, oldSeqid);
+  uint32_t headerLen = len - in->available_read();
+
+  std::shared_ptr<TProtocol> oprot(factory->getProtocol(header));
+  header->resetBuffer();
+  oprot->writeMessageBegin(name, type, seqid);
+  return headerLen;
+}
+}
+
+TEvSocketClientChannel::TEvSocketClientChannel(const std::string& host,
+                                               int port,
+                                               struct event_base* eb,
+                                               std::shared_ptr<TProtocolFactory> protocolFactory,
+                                               Framing framing,
+                                               struct evdns_base* dnsbase)
+  : eb_(eb),
+    bev_(nullptr),
+    protocolFactory_(protocolFactory),
+    framing_(framing),
+    error_(false),
+    timedOut_(false),
+    recvTimeout_(0),
+    maxFrameSize_(static_cast<uint32_t>(TConfiguration::DEFAULT_MAX_FRAME_SIZE)),
+    nextSeqid_(0),
+    header_(new TMemoryBuffer()),
+    alive_(new bool(true)) {
+  if (framing_ == FRAMED && !protocolFactory_) {
+    throw TException("TEvSocketClientChannel: FRAMED mode needs a protocol factory");
+  }
+  bev_ = bufferevent_socket_new(eb_, -1, BEV_OPT_CLOSE_ON_FREE);
+  if (bev_ == nullptr) {
+    throw TException("bufferevent_socket_new failed");
+  }
+  bufferevent_setcb(bev_, readCallback, nullptr, eventCallback, this);
+  bufferevent_enable(bev_, EV_READ | EV_WRITE);
+  if (bufferevent_socket_connect_hostname(bev_, dnsbase, AF_UNSPEC, host.c_str(), port) != 0) {
+    bufferevent_free(bev_);
+    throw TTransportException(TTransportException::NOT_OPEN,
+                              "TEvSocketClientChannel: could not connect to " + host);
+  }
+}
+
+TEvSocketClientChannel::~TEvSocketClientChannel() {
+  *alive_ = false;
+  for (auto& entry : pending_) {
+    if (entry.second->timer != nullptr) {
+      event_free(entry.second->timer);
+    }
+    delete entry.second;
+  }
+  bufferevent_free(bev_);
+}
+
+void TEvSocketClientChannel::sendAndRecvMessage(const VoidCallback& cob,
+                                                TMemoryBuffer* sendBuf,
+                                                TMemoryBuffer* recvBuf) {
+  sendAndRecvMessage(cob, sendBuf, recvBuf, recvTimeout_);
+}
+
+void TEvSocketClientChannel::sendAndRecvMessage(const VoidCallback& cob,
+                                                TMemoryBuffer* sendBuf,
+                                                TMemoryBuffer* recvBuf,
+                                                int timeoutMs) {
+  if (error_) {
+    recvBuf->resetBuffer();
+    defer(cob);
+    return;
+  }
+
+  std::unique_ptr<Call> call(new Call());
+  call->channel = this;
+  call->cob = cob;
+  call->recvBuf = recvBuf;
+  call->seqid = nextSeqid_;
+  call->callerSeqid = 0;
+  call->timer = nullptr;
+  nextSeqid_ = nextSeqid_ == (std::numeric_limits<int32_t>::max)() ? 0 : nextSeqid_ + 1;
+
+  writeRequest(sendBuf, call.get());
+
+  if (timeoutMs > 0) {
+    call->timer = evtimer_new(eb_, timeoutCallback, call.get());
+    if (call->timer == nullptr) {
+      throw TException("evtimer_new failed");
+    }
+    struct timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    evtimer_add(call->timer, &tv);
+  }
+
+  if (framing_ == HEADER) {
+    sent_.push_back(call->seqid);
+  }
+  pending_[call->seqid] = call.release();
+}
+
+void TEvSocketClientChannel::sendMessage(const VoidCallback& cob, TMemoryBuffer* message) {
+  if (!error_) {
+    writeRequest(message, nullptr);
+  }
+  defer(cob);
+}
+
+void TEvSocketClientChannel::recvMessage(const VoidCallback& cob, TMemoryBuffer* message) {
+  (void)cob;
+  (void)message;
+  throw TProtocolException(TProtocolException::NOT_IMPLEMENTED,
+                           "Unexpected call to TEvSocketClientChannel::recvMessage");
+}
+
+void TEvSocketClientChannel::writeRequest(TMemoryBuffer* sendBuf, Call* call) {
+  uint8_t* buf;
+  uint32_t len;
+  sendBuf->getBuffer(&buf, &len);
+  struct evbuffer* output = bufferevent_get_output(bev_);
+
+  if (framing_ == HEADER) {
+    // THeaderProtocol has already framed the message
+    if (evbuffer_add(output, buf, len) != 0) {
+      throw TException("evbuffer_add failed");
+    }
+    return;
+  }
+
+  uint32_t headerLen = 0;
+  header_->resetBuffer();
+  if (call != nullptr) {
+    headerLen = rewriteSeqid(protocolFactory_.get(), buf, len, call->seqid, call->callerSeqid, header_);
+  }
+  uint8_t* headerBuf;
+  uint32_t newHeaderLen;
+  header_->getBuffer(&headerBuf, &newHeaderLen);
+
+  uint32_t frameSize = htonl(newHeaderLen + len - headerLen);
+  if (evbuffer_add(output, &frameSize, sizeof(frameSize)) != 0
+      || evbuffer_add(output, headerBuf, newHeaderLen) != 0
+      || evbuffer_add(output, buf + headerLen, len - headerLen) != 0) {
+    throw TException("evbuffer_add failed");
+  }
+}
+
+void TEvSocketClientChannel::readFrames() {
+  struct evbuffer* input = bufferevent_get_input(bev_);
+  while (!error_) {
+    size_t available = evbuffer_get_length(input);
+    uint32_t frameSize;
+    if (available < sizeof(frameSize)) {
+      return;
+    }
+    evbuffer_copyout(input, &frameSize, sizeof(frameSize));
+    frameSize = ntohl(frameSize);
+    if (frameSize > maxFrameSize_) {
+      fail("frame size exceeds limit");
+      return;
+    }
+    size_t total = sizeof(frameSize) + frameSize;
+    if (available < total) {
+      return;
+    }
+
+    uint8_t* data = evbuffer_pullup(input, static_cast<ev_ssize_t>(total));
+    Call* call;
+    try {
+      if (framing_ == HEADER) {
+        // THeaderTransport on the client side expects to see the whole frame
+        call = takeResponse(data, static_cast<uint32_t>(total));
+      } else {
+        call = takeResponse(data + sizeof(frameSize), frameSize);
+      }
+    } catch (const TException&) {
+      fail("malformed response");
+      return;
+    }
+    evbuffer_drain(input, total);
+
+    if (call != nullptr && !complete(call, false)) {
+      return;
+    }
+  }
+}
+
+TEvSocketClientChannel::Call* TEvSocketClientChannel::takeResponse(uint8_t* data, uint32_t size) {
+  int32_t seqid;
+  uint32_t headerLen = 0;
+  header_->resetBuffer();
+  if (framing_ == HEADER) {
+    if (sent_.empty()) {
+      throw TException("unexpected response");
+    }
+    seqid = sent_.front();
+    sent_.pop_front();
+  } else {
+    std::shared_ptr<TMemoryBuffer> in(new TMemoryBuffer(data, size));
+    std::shared_ptr<TProtocol> iprot(protocolFactory_->getProtocol(in));
+    std::string name;
+    TMessageType type;
+    iprot->readMessageBegin(name, type, seqid);
+  }
+
+  auto it = pending_.find(seqid);
+  if (it == pending_.end()) {
+    // the call timed out; drop the late response
+    return nullptr;
+  }
+  Call* call = it->second;
+
+  if (framing_ == FRAMED) {
+    int32_t wireSeqid;
+    headerLen = rewriteSeqid(protocolFactory_.get(), data, size, call->callerSeqid, wireSeqid, header_);
+  }
+  pending_.erase(it);
+
+  uint8_t* headerBuf;
+  uint32_t newHeaderLen;
+  header_->getBuffer(&headerBuf, &newHeaderLen);
+  call->recvBuf->resetBuffer();
+  call->recvBuf->write(headerBuf, newHeaderLen);
+  call->recvBuf->write(data + headerLen, size - headerLen);
+  return call;
+}
+
+/**
+ * Runs the callback of call and frees it.  Returns false if the callback
+ * destroyed the channel, in which case the caller must not touch it again.
+ */
+bool TEvSocketClientChannel::complete(Call* call, bool timedOut) {
+  if (call->timer != nullptr) {
+    event_free(call->timer);
+  }
+  VoidCallback cob;
+  cob.swap(call->cob);
+  delete call;
+
+  std::shared_ptr<bool> alive(alive_);
+  timedOut_ = timedOut;
+  try {
+    cob();
+  } catch (const std::exception& e) {
+    // don't propagate a C++ exception in C code (e.g. libevent)
+    GlobalOutput.printf("TEvSocketClientChannel: exception thrown by callback (ignored): %s",
+                        e.what());
+  }
+  if (!*alive) {
+    return false;
+  }
+  timedOut_ = false;
+  return true;
+}
+
+void TEvSocketClientChannel::fail(const std::string& reason) {
+  if (!error_) {
+    GlobalOutput.printf("TEvSocketClientChannel: %s", reason.c_str());
+  }
+  error_ = true;
+  bufferevent_disable(bev_, EV_READ | EV_WRITE);
+  sent_.clear();
+
+  // callbacks may start new calls, which fail without touching pending_
+  std::map<int32_t, Call*> failed;
+  failed.swap(pending_);
+  for (auto it = failed.begin(); it != failed.end(); ++it) {
+    it->second->recvBuf->resetBuffer();
+    if (!complete(it->second, false)) {
+      // the destructor only saw pending_, so free the calls still left here
+      for (++it; it != failed.end(); ++it) {
+        if (it->second->timer != nullptr) {
+          event_free(it->second->timer);
+        }
+        delete it->second;
+      }
+      return;
+    }
+  }
+}
+
+void TEvSocketClientChannel::defer(const VoidCallback& cob) {
+  struct timeval tv = {0, 0};
+  auto* copy = new VoidCallback(cob);
+  if (event_base_once(eb_, -1, EV_TIMEOUT, deferredCallback, copy, &tv) != 0) {
+    delete copy;
+    throw TException("event_base_once failed");
+  }
+}
+
+void TEvSocketClientChannel::readCallback(struct bufferevent* bev, void* arg) {
+  (void)bev;
+  static_cast<TEvSocketClientChannel*>(arg)->readFrames();
+}
+
+void TEvSocketClientChannel::eventCallback(struct bufferevent* bev, short what, void* arg) {
+  auto* self = static_cast<TEvSocketClientChannel*>(arg);
+  if (what & BEV_EVENT_CONNECTED) {
+    int one = 1;
+    setsockopt(bufferevent_getfd(bev), IPPROTO_TCP, TCP_NODELAY,
+               reinterpret_cast<const char*>(&one), sizeof(one));
+    return;
+  }
+  if (what & BEV_EVENT_EOF) {
+    self->fail("connection closed by peer");
+  } else if (what & BEV_EVENT_ERROR) {
+    self->fail(std::string("connection error: ")
+               + evutil_socket_error_to_string(EVUTIL_SOCKET_ERROR()));
+  }
+}
+
+void TEvSocketClientChannel::timeoutCallback(evutil_socket_t fd, short what, void* arg) {
+  (void)fd;
+  (void)what;
+  auto* call = static_cast<Call*>(arg);
+  TEvSocketClientChannel* self = call->channel;
+  // in HEADER mode the seqid stays in sent_ so the late response is consumed
+  self->pending_.erase(call->seqid);
+  call->recvBuf->resetBuffer();
+  self->complete(call, true);
+}
+
+void TEvSocketClientChannel::deferredCallback(evutil_socket_t fd, short what, void* arg) {
+  (void)fd;
+  (void)what;
+  std::unique_ptr<VoidCallback> cob(static_cast<VoidCallback*>(arg));
+  try {
+    (*cob)();
+  } catch (const std::exception& e) {
+    GlobalOutput.printf("TEvSocketClientChannel: exception thrown by callback (ignored): %s",
+                        e.what());
+  }
+}
+}
+}
+} // apache::thrift::async
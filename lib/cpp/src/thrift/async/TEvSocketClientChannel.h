@@ -0,0 +1,167 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THRIFT_TEVSOCKET_CLIENT_CHANNEL_H_
+#define _THRIFT_TEVSOCKET_CLIENT_CHANNEL_H_ 1
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <event2/util.h>
+#include <thrift/async/TAsyncChannel.h>
+#include <thrift/transport/TBufferTransports.h>
+
+struct event_base;
+struct evdns_base;
+struct bufferevent;
+
+namespace apache {
+namespace thrift {
+namespace protocol {
+class TProtocolFactory;
+}
+}
+}
+
+namespace apache {
+namespace thrift {
+namespace async {
+
+/**
+ * TAsyncChannel that talks to a framed server (TNonblockingServer, or any
+ * server using TFramedTransport or THeaderTransport) over a plain TCP
+ * connection driven by libevent.
+ *
+ * Any number of calls may be outstanding at once; requests are written as
+ * soon as they are made and each response is handed to the call it belongs
+ * to.  In FRAMED mode the channel gives every request its own sequence id on
+ * the wire and restores the caller's id in the response, so generated
+ * cob_style clients (which always send seqid 0) can share one connection.
+ * In HEADER mode the messages are produced by THeaderProtocol, which frames
+ * them itself; those are passed through untouched and responses are matched
+ * to requests in order.
+ *
+ * Each call can be given a receive timeout.  A call that times out
+ * completes with an empty response buffer, timedOut() returns true while its
+ * callback runs, and the late response is discarded when it arrives.  A
+ * connection error fails every outstanding and future call the same way,
+ * with error() returning true.
+ *
+ * A callback may destroy the channel; no further callbacks run after that.
+ *
+ * All methods must be called from the thread running the event_base.
+ */
+class TEvSocketClientChannel : public TAsyncChannel {
+public:
+  using TAsyncChannel::VoidCallback;
+
+  enum Framing { FRAMED, HEADER };
+
+  /**
+   * Connect to host:port.  The connection is made asynchronously; calls made
+   * before it is established are queued.  protocolFactory is the protocol
+   * the clients use and is required in FRAMED mode.
+   */
+  TEvSocketClientChannel(const std::string& host,
+                         int port,
+                         struct event_base* eb,
+                         std::shared_ptr<protocol::TProtocolFactory> protocolFactory,
+                         Framing framing = FRAMED,
+                         struct evdns_base* dnsbase = nullptr);
+  ~TEvSocketClientChannel() override;
+
+  void sendAndRecvMessage(const VoidCallback& cob,
+                          apache::thrift::transport::TMemoryBuffer* sendBuf,
+                          apache::thrift::transport::TMemoryBuffer* recvBuf) override;
+
+  /**
+   * Same as above with a timeout (in milliseconds, 0 for none) for this call
+   * only.
+   */
+  void sendAndRecvMessage(const VoidCallback& cob,
+                          apache::thrift::transport::TMemoryBuffer* sendBuf,
+                          apache::thrift::transport::TMemoryBuffer* recvBuf,
+                          int timeoutMs);
+
+  /**
+   * Send a oneway message.  cob runs from the event loop once the message
+   * has been queued for writing.
+   */
+  void sendMessage(const VoidCallback& cob,
+                   apache::thrift::transport::TMemoryBuffer* message) override;
+  void recvMessage(const VoidCallback& cob,
+                   apache::thrift::transport::TMemoryBuffer* message) override;
+
+  bool good() const override { return !error_; }
+  bool error() const override { return error_; }
+  bool timedOut() const override { return timedOut_; }
+
+  /**
+   * Default receive timeout in milliseconds for each call; 0 disables it.
+   */
+  void setRecvTimeout(int timeoutMs) { recvTimeout_ = timeoutMs; }
+  int getRecvTimeout() const { return recvTimeout_; }
+
+  void setMaxFrameSize(uint32_t maxFrameSize) { maxFrameSize_ = maxFrameSize; }
+  uint32_t getMaxFrameSize() const { return maxFrameSize_; }
+
+  /**
+   * Number of calls waiting for a response.
+   */
+  size_t getPendingCount() const { return pending_.size(); }
+
+private:
+  struct Call;
+
+  void writeRequest(apache::thrift::transport::TMemoryBuffer* sendBuf, Call* call);
+  void readFrames();
+  Call* takeResponse(uint8_t* data, uint32_t size);
+  bool complete(Call* call, bool timedOut);
+  void fail(const std::string& reason);
+  void defer(const VoidCallback& cob);
+
+  static void readCallback(struct bufferevent* bev, void* arg);
+  static void eventCallback(struct bufferevent* bev, short what, void* arg);
+  static void timeoutCallback(evutil_socket_t fd, short what, void* arg);
+  static void deferredCallback(evutil_socket_t fd, short what, void* arg);
+
+  struct event_base* eb_;
+  struct bufferevent* bev_;
+  std::shared_ptr<protocol::TProtocolFactory> protocolFactory_;
+  Framing framing_;
+  bool error_;
+  bool timedOut_;
+  int recvTimeout_;
+  uint32_t maxFrameSize_;
+  int32_t nextSeqid_;
+  // holds re-encoded message headers
+  std::shared_ptr<transport::TMemoryBuffer> header_;
+  std::map<int32_t, Call*> pending_;
+  // wire seqids in the order the requests were sent (HEADER mode only)
+  std::deque<int32_t> sent_;
+  // cleared by the destructor, so that code running a callback can tell
+  // whether the callback destroyed the channel
+  std::shared_ptr<bool> alive_;
+};
+}
+}
+} // apache::thrift::async
+
+#endif // #ifndef _THRIFT_TEVSOCKET_CLIENT_CHANNEL_H_
@@ -70,6 +70,15 @@ public:
     strict_write_ = strict_write;
   }
 
+  /**
+   * Switch to a new transport so this object can be reused.  Limits and
+   * strictness are kept.
+   */
+  void reset(std::shared_ptr<Transport_> trans) {
+    this->resetTransport(trans);
+    trans_ = trans.get();
+  }
+
   /**
    * Writing functions.
    */
@@ -119,6 +128,50 @@ public:
 
   inline uint32_t writeBinary(const std::string& str);
 
+  /**
+   * Size functions.  Each returns the number of bytes the matching write call
+   * would produce, so that generated serializedSize() methods can compute the
+   * encoded size of a struct without writing it.  Field ids are irrelevant to
+   * this encoding; lastFieldId is only there to match TCompactProtocolT.
+   */
+
+  static uint32_t sizeFieldBegin(const TType, const int16_t, int16_t&) { return 3; }
+
+  static uint32_t sizeBoolField(const int16_t, int16_t&) { return 4; }
+
+  static uint32_t sizeFieldStop() { return 1; }
+
+  static uint32_t sizeMapBegin(const uint32_t) { return 6; }
+
+  static uint32_t sizeListBegin(const uint32_t) { return 5; }
+
+  static uint32_t sizeSetBegin(const uint32_t) { return 5; }
+
+  static uint32_t sizeBool(const bool) { return 1; }
+
+  static uint32_t sizeByte(const int8_t) { return 1; }
+
+  static uint32_t sizeI16(const int16_t) { return 2; }
+
+  static uint32_t sizeI32(const int32_t) { return 4; }
+
+  static uint32_t sizeI64(const int64_t) { return 8; }
+
+  static uint32_t sizeDouble(const double) { return 8; }
+
+  template <typename StrType>
+  static uint32_t sizeString(const StrType& str) {
+    return 4 + static_cast<uint32_t>(str.size());
+  }
+
+  static uint32_t sizeBinary(const std::string& str) { return sizeString(str); }
+
+  /**
+   * Width of every value of the given type, or 0 if it depends on the value.
+   * Lets serializedSize() multiply instead of looping over containers.
+   */
+  static uint32_t fixedSize(const TType type) { return getFixedWidth(type); }
+
   /**
    * Reading functions
    */
@@ -166,6 +219,22 @@ public:
 
   inline uint32_t readBinary(std::string& str);
 
+  /**
+   * Skip over a value without decoding it.  Values of a fixed width, and
+   * lists, sets and maps of them, are consumed in one step rather than
+   * element by element.
+   */
+  uint32_t skip(TType type);
+
+  /**
+   * Read a value without decoding it, appending its encoding to raw.  Only
+   * the big endian (standard) encoding is captured; other byte orders return
+   * false without reading anything.
+   */
+  bool readRawBinary(TType type, std::string& raw, uint32_t& xfer);
+
+  bool writeRawBinary(const std::string& raw, uint32_t& xfer);
+
   int getMinSerializedSize(TType type);
 
   void checkReadBytesAvailable(TSet& set)
@@ -188,6 +257,21 @@ protected:
   template <typename StrType>
   uint32_t readStringBody(StrType& str, int32_t sz);
 
+  /// The encoded width of a value of the given type, or 0 if it varies.
+  static uint32_t getFixedWidth(TType type);
+
+  /// Consume len bytes from the transport.
+  void skipBytes(uint64_t len);
+
+  /// Check a string or container length read from the wire.
+  void checkSize(int32_t size, int32_t limit);
+
+  /// Read len bytes from the transport and append them to raw.
+  void captureBytes(std::string& raw, uint64_t len);
+
+  /// Read a value of the given type and append its encoding to raw.
+  uint32_t captureValue(TType type, std::string& raw);
+
   Transport_* trans_;
 
   int32_t string_limit_;
@@ -250,7 +334,34 @@ public:
     return std::shared_ptr<TProtocol>(prot);
   }
 
+  bool resetProtocol(const std::shared_ptr<TProtocol>& protocol,
+                     std::shared_ptr<TTransport> trans) override {
+    std::shared_ptr<Transport_> specific_trans = std::dynamic_pointer_cast<Transport_>(trans);
+    if (specific_trans) {
+      auto* prot = dynamic_cast<TBinaryProtocolT<Transport_, ByteOrder_>*>(protocol.get());
+      if (prot != nullptr) {
+        prot->reset(specific_trans);
+        configure(prot);
+        return true;
+      }
+    }
+    auto* prot = dynamic_cast<TBinaryProtocolT<TTransport, ByteOrder_>*>(protocol.get());
+    if (prot == nullptr) {
+      return false;
+    }
+    prot->reset(trans);
+    configure(prot);
+    return true;
+  }
+
 private:
+  template <class Protocol_>
+  void configure(Protocol_* prot) const {
+    prot->setStringSizeLimit(string_limit_);
+    prot->setContainerSizeLimit(container_limit_);
+    prot->setStrict(strict_read_, strict_write_);
+  }
+
   int32_t string_limit_;
   int32_t container_limit_;
   bool strict_read_;
@@ -23,7 +23,10 @@
 #include <thrift/protocol/TBinaryProtocol.h>
 #include <thrift/transport/TTransportException.h>
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
+#include <type_traits>
 
 namespace apache {
 namespace thrift {
@@ -461,6 +464,255 @@ uint32_t TBinaryProtocolT<Transport_, ByteOrder_>::readStringBody(StrType& str,
   return (uint32_t)size;
 }
 
+template <class Transport_, class ByteOrder_>
+uint32_t TBinaryProtocolT<Transport_, ByteOrder_>::skip(TType type) {
+  TInputRecursionTracker tracker(*this);
+
+  uint32_t width = getFixedWidth(type);
+  if (width > 0) {
+    skipBytes(width);
+    return width;
+  }
+
+  uint32_t result = 0;
+  switch (type) {
+  case T_STRING: {
+    int32_t size;
+    result += readI32(size);
+    checkSize(size, this->string_limit_);
+    skipBytes(static_cast<uint32_t>(size));
+    return result + static_cast<uint32_t>(size);
+  }
+  case T_STRUCT: {
+    std::string name;
+    TType ftype;
+    int16_t fid;
+    while (true) {
+      result += readFieldBegin(name, ftype, fid);
+      if (ftype == T_STOP) {
+        return result;
+      }
+      result += skip(ftype);
+    }
+  }
+  case T_MAP: {
+    TType keyType;
+    TType valType;
+    uint32_t size;
+    result += readMapBegin(keyType, valType, size);
+    uint32_t keyWidth = getFixedWidth(keyType);
+    uint32_t valWidth = getFixedWidth(valType);
+    if (keyWidth > 0 && valWidth > 0) {
+      uint64_t len = static_cast<uint64_t>(size) * (keyWidth + valWidth);
+      skipBytes(len);
+      return result + static_cast<uint32_t>(len);
+    }
+    for (uint32_t i = 0; i < size; i++) {
+      result += skip(keyType);
+      result += skip(valType);
+    }
+    return result;
+  }
+  case T_SET:
+  case T_LIST: {
+    TType elemType;
+    uint32_t size;
+    if (type == T_SET) {
+      result += readSetBegin(elemType, size);
+    } else {
+      result += readListBegin(elemType, size);
+    }
+    uint32_t elemWidth = getFixedWidth(elemType);
+    if (elemWidth > 0) {
+      uint64_t len = static_cast<uint64_t>(size) * elemWidth;
+      skipBytes(len);
+      return result + static_cast<uint32_t>(len);
+    }
+    for (uint32_t i = 0; i < size; i++) {
+      result += skip(elemType);
+    }
+    return result;
+  }
+  default:
+    break;
+  }
+
+  throw TProtocolException(TProtocolException::INVALID_DATA, "invalid TType");
+}
+
+template <class Transport_, class ByteOrder_>
+bool TBinaryProtocolT<Transport_, ByteOrder_>::readRawBinary(TType type,
+                                                             std::string& raw,
+                                                             uint32_t& xfer) {
+  if (!std::is_same<ByteOrder_, TNetworkBigEndian>::value) {
+    return false;
+  }
+  xfer += captureValue(type, raw);
+  return true;
+}
+
+template <class Transport_, class ByteOrder_>
+bool TBinaryProtocolT<Transport_, ByteOrder_>::writeRawBinary(const std::string& raw,
+                                                              uint32_t& xfer) {
+  if (!std::is_same<ByteOrder_, TNetworkBigEndian>::value) {
+    return false;
+  }
+  auto size = static_cast<uint32_t>(raw.size());
+  this->trans_->write(reinterpret_cast<const uint8_t*>(raw.data()), size);
+  xfer += size;
+  return true;
+}
+
+template <class Transport_, class ByteOrder_>
+uint32_t TBinaryProtocolT<Transport_, ByteOrder_>::getFixedWidth(TType type) {
+  switch (type) {
+  case T_BOOL:
+  case T_BYTE:
+    return 1;
+  case T_I16:
+    return 2;
+  case T_I32:
+    return 4;
+  case T_I64:
+  case T_DOUBLE:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+template <class Transport_, class ByteOrder_>
+void TBinaryProtocolT<Transport_, ByteOrder_>::skipBytes(uint64_t len) {
+  while (len > 0) {
+    auto chunk = static_cast<uint32_t>(
+        (std::min)(len, static_cast<uint64_t>((std::numeric_limits<int32_t>::max)())));
+    len -= chunk;
+
+    // Try to borrow first
+    uint32_t got = chunk;
+    if (this->trans_->borrow(nullptr, &got)) {
+      this->trans_->consume(chunk);
+      continue;
+    }
+
+    uint8_t scratch[512];
+    while (chunk > 0) {
+      uint32_t part = (std::min)(chunk, static_cast<uint32_t>(sizeof(scratch)));
+      this->trans_->readAll(scratch, part);
+      chunk -= part;
+    }
+  }
+}
+
+template <class Transport_, class ByteOrder_>
+void TBinaryProtocolT<Transport_, ByteOrder_>::checkSize(int32_t size, int32_t limit) {
+  if (size < 0) {
+    throw TProtocolException(TProtocolException::NEGATIVE_SIZE);
+  } else if (limit > 0 && size > limit) {
+    throw TProtocolException(TProtocolException::SIZE_LIMIT);
+  }
+}
+
+template <class Transport_, class ByteOrder_>
+void TBinaryProtocolT<Transport_, ByteOrder_>::captureBytes(std::string& raw, uint64_t len) {
+  this->trans_->checkReadBytesAvailable(static_cast<long int>(len));
+  size_t offset = raw.size();
+  raw.resize(offset + static_cast<size_t>(len));
+  this->trans_->readAll(reinterpret_cast<uint8_t*>(&raw[offset]), static_cast<uint32_t>(len));
+}
+
+template <class Transport_, class ByteOrder_>
+uint32_t TBinaryProtocolT<Transport_, ByteOrder_>::captureValue(TType type, std::string& raw) {
+  TInputRecursionTracker tracker(*this);
+
+  uint32_t width = getFixedWidth(type);
+  if (width > 0) {
+    captureBytes(raw, width);
+    return width;
+  }
+
+  // the header is copied as is, then decoded from the copy
+  size_t offset = raw.size();
+  int32_t sizei;
+  switch (type) {
+  case T_STRING: {
+    captureBytes(raw, 4);
+    std::memcpy(&sizei, &raw[offset], 4);
+    sizei = static_cast<int32_t>(ByteOrder_::fromWire32(sizei));
+    checkSize(sizei, this->string_limit_);
+    captureBytes(raw, static_cast<uint32_t>(sizei));
+    return 4 + static_cast<uint32_t>(sizei);
+  }
+  case T_STRUCT: {
+    uint32_t result = 0;
+    while (true) {
+      offset = raw.size();
+      captureBytes(raw, 1);
+      result += 1;
+      auto ftype = static_cast<TType>(static_cast<int8_t>(raw[offset]));
+      if (ftype == T_STOP) {
+        return result;
+      }
+      captureBytes(raw, 2);
+      result += 2;
+      result += captureValue(ftype, raw);
+    }
+  }
+  case T_MAP: {
+    captureBytes(raw, 6);
+    auto keyType = static_cast<TType>(static_cast<int8_t>(raw[offset]));
+    auto valType = static_cast<TType>(static_cast<int8_t>(raw[offset + 1]));
+    std::memcpy(&sizei, &raw[offset + 2], 4);
+    sizei = static_cast<int32_t>(ByteOrder_::fromWire32(sizei));
+    checkSize(sizei, this->container_limit_);
+    auto size = static_cast<uint32_t>(sizei);
+    TMap map(keyType, valType, size);
+    checkReadBytesAvailable(map);
+
+    uint32_t result = 6;
+    uint32_t keyWidth = getFixedWidth(keyType);
+    uint32_t valWidth = getFixedWidth(valType);
+    if (keyWidth > 0 && valWidth > 0) {
+      uint64_t len = static_cast<uint64_t>(size) * (keyWidth + valWidth);
+      captureBytes(raw, len);
+      return result + static_cast<uint32_t>(len);
+    }
+    for (uint32_t i = 0; i < size; i++) {
+      result += captureValue(keyType, raw);
+      result += captureValue(valType, raw);
+    }
+    return result;
+  }
+  case T_SET:
+  case T_LIST: {
+    captureBytes(raw, 5);
+    auto elemType = static_cast<TType>(static_cast<int8_t>(raw[offset]));
+    std::memcpy(&sizei, &raw[offset + 1], 4);
+    sizei = static_cast<int32_t>(ByteOrder_::fromWire32(sizei));
+    checkSize(sizei, this->container_limit_);
+    auto size = static_cast<uint32_t>(sizei);
+    TList list(elemType, size);
+    checkReadBytesAvailable(list);
+
+    uint32_t result = 5;
+    uint32_t elemWidth = getFixedWidth(elemType);
+    if (elemWidth > 0) {
+      uint64_t len = static_cast<uint64_t>(size) * elemWidth;
+      captureBytes(raw, len);
+      return result + static_cast<uint32_t>(len);
+    }
+    for (uint32_t i = 0; i < size; i++) {
+      result += captureValue(elemType, raw);
+    }
+    return result;
+  }
+  default:
+    break;
+  }
+
+  throw TProtocolException(TProtocolException::INVALID_DATA, "invalid TType");
+}
+
 // Return the minimum number of bytes a type will consume on the wire
 template <class Transport_, class ByteOrder_>
 int TBinaryProtocolT<Transport_, ByteOrder_>::getMinSerializedSize(TType type)
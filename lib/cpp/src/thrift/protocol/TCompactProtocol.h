@@ -102,6 +102,25 @@ public:
 
   ~TCompactProtocolT() override { free(string_buf_); }
 
+  void setStringSizeLimit(int32_t string_limit) { string_limit_ = string_limit; }
+
+  void setContainerSizeLimit(int32_t container_limit) { container_limit_ = container_limit; }
+
+  /**
+   * Switch to a new transport so this object can be reused.  Any half-read
+   * or half-written struct state is dropped; the string buffer is kept.
+   */
+  void reset(std::shared_ptr<Transport_> trans) {
+    this->resetTransport(trans);
+    trans_ = trans.get();
+    while (!lastField_.empty()) {
+      lastField_.pop();
+    }
+    lastFieldId_ = 0;
+    booleanField_.name = nullptr;
+    boolValue_.hasBoolValue = false;
+  }
+
   /**
    * Writing functions
    */
@@ -140,6 +159,79 @@ public:
 
   uint32_t writeBinary(const std::string& str);
 
+  /**
+   * Size functions.  Each returns the number of bytes the matching write call
+   * would produce, so that generated serializedSize() methods can compute the
+   * encoded size of a struct without writing it.  lastFieldId plays the part
+   * of lastFieldId_ for the struct being sized and must start at 0.
+   */
+
+  static uint32_t sizeFieldBegin(const TType, const int16_t fieldId, int16_t& lastFieldId) {
+    uint32_t size = 1;
+    if (!(fieldId > lastFieldId && fieldId - lastFieldId <= 15)) {
+      size += sizeI16(fieldId);
+    }
+    lastFieldId = fieldId;
+    return size;
+  }
+
+  // The value of a bool field is folded into its header.
+  static uint32_t sizeBoolField(const int16_t fieldId, int16_t& lastFieldId) {
+    return sizeFieldBegin(T_BOOL, fieldId, lastFieldId);
+  }
+
+  static uint32_t sizeFieldStop() { return 1; }
+
+  static uint32_t sizeMapBegin(const uint32_t size) {
+    return size == 0 ? 1 : sizeVarint32(size) + 1;
+  }
+
+  static uint32_t sizeListBegin(const uint32_t size) {
+    return static_cast<int32_t>(size) <= 14 ? 1 : 1 + sizeVarint32(size);
+  }
+
+  static uint32_t sizeSetBegin(const uint32_t size) { return sizeListBegin(size); }
+
+  static uint32_t sizeBool(const bool) { return 1; }
+
+  static uint32_t sizeByte(const int8_t) { return 1; }
+
+  static uint32_t sizeI16(const int16_t i16) { return sizeI32(i16); }
+
+  static uint32_t sizeI32(const int32_t i32) {
+    return sizeVarint32((static_cast<uint32_t>(i32) << 1) ^ static_cast<uint32_t>(i32 >> 31));
+  }
+
+  static uint32_t sizeI64(const int64_t i64) {
+    return sizeVarint64((static_cast<uint64_t>(i64) << 1) ^ static_cast<uint64_t>(i64 >> 63));
+  }
+
+  static uint32_t sizeDouble(const double) { return 8; }
+
+  template <typename StrType>
+  static uint32_t sizeString(const StrType& str) {
+    auto len = static_cast<uint32_t>(str.size());
+    return sizeVarint32(len) + len;
+  }
+
+  static uint32_t sizeBinary(const std::string& str) { return sizeString(str); }
+
+  /**
+   * Width of every value of the given type, or 0 if it depends on the value.
+   * Lets serializedSize() multiply instead of looping over containers.
+   */
+  static uint32_t fixedSize(const TType type) {
+    switch (type) {
+    case T_BOOL:
+    case T_BYTE:
+      return 1;
+    case T_DOUBLE:
+      return 8;
+    default:
+      return 0;
+    }
+  }
+
   int getMinSerializedSize(TType type);
 
   void checkReadBytesAvailable(TSet& set)
@@ -180,6 +272,24 @@ protected:
   uint32_t i32ToZigzag(const int32_t n);
   inline int8_t getCompactType(const TType ttype);
 
+  static uint32_t sizeVarint32(uint32_t n) {
+    uint32_t size = 1;
+    while (n >= 0x80) {
+      n >>= 7;
+      ++size;
+    }
+    return size;
+  }
+
+  static uint32_t sizeVarint64(uint64_t n) {
+    uint32_t size = 1;
+    while (n >= 0x80) {
+      n >>= 7;
+      ++size;
+    }
+    return size;
+  }
+
 public:
   uint32_t readMessageBegin(std::string& name, TMessageType& messageType, int32_t& seqid);
 
@@ -269,6 +379,28 @@ public:
     return std::shared_ptr<TProtocol>(prot);
   }
 
+  bool resetProtocol(const std::shared_ptr<TProtocol>& protocol,
+                     std::shared_ptr<TTransport> trans) override {
+    std::shared_ptr<Transport_> specific_trans = std::dynamic_pointer_cast<Transport_>(trans);
+    if (specific_trans) {
+      auto* prot = dynamic_cast<TCompactProtocolT<Transport_>*>(protocol.get());
+      if (prot != nullptr) {
+        prot->reset(specific_trans);
+        prot->setStringSizeLimit(string_limit_);
+        prot->setContainerSizeLimit(container_limit_);
+        return true;
+      }
+    }
+    auto* prot = dynamic_cast<TCompactProtocol*>(protocol.get());
+    if (prot == nullptr) {
+      return false;
+    }
+    prot->reset(trans);
+    prot->setStringSizeLimit(string_limit_);
+    prot->setContainerSizeLimit(container_limit_);
+    return true;
+  }
+
 private:
   int32_t string_limit_;
   int32_t container_limit_;
@@ -28,6 +28,19 @@ uint32_t TProtocol::skip_virt(TType type) {
   return ::apache::thrift::protocol::skip(*this, type);
 }
 
+bool TProtocol::readRawBinary_virt(TType type, std::string& raw, uint32_t& xfer) {
+  THRIFT_UNUSED_VARIABLE(type);
+  THRIFT_UNUSED_VARIABLE(raw);
+  THRIFT_UNUSED_VARIABLE(xfer);
+  return false;
+}
+
+bool TProtocol::writeRawBinary_virt(const std::string& raw, uint32_t& xfer) {
+  THRIFT_UNUSED_VARIABLE(raw);
+  THRIFT_UNUSED_VARIABLE(xfer);
+  return false;
+}
+
 TProtocolFactory::~TProtocolFactory() = default;
 
 }}} // apache::thrift::protocol
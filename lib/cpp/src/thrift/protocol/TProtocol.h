@@ -517,6 +517,27 @@ public:
   }
   virtual uint32_t skip_virt(TType type);
 
+  /**
+   * Read a value without decoding it, appending its TBinaryProtocol encoding
+   * to raw, for fields that are decoded on first use (cpp.lazy).  Protocols
+   * with any other encoding return false without reading anything.
+   */
+  bool readRawBinary(TType type, std::string& raw, uint32_t& xfer) {
+    T_VIRTUAL_CALL();
+    return readRawBinary_virt(type, raw, xfer);
+  }
+  virtual bool readRawBinary_virt(TType type, std::string& raw, uint32_t& xfer);
+
+  /**
+   * Write a value captured by readRawBinary() as is.  Protocols with any
+   * other encoding return false without writing anything.
+   */
+  bool writeRawBinary(const std::string& raw, uint32_t& xfer) {
+    T_VIRTUAL_CALL();
+    return writeRawBinary_virt(raw, xfer);
+  }
+  virtual bool writeRawBinary_virt(const std::string& raw, uint32_t& xfer);
+
   inline std::shared_ptr<TTransport> getTransport() { return ptrans_; }
 
   // TODO: remove these two calls, they are for backwards
@@ -555,6 +576,16 @@ protected:
       recursion_limit_(ptrans->getConfiguration()->getRecursionLimit())
   {}
 
+  /**
+   * Rebinds the protocol to a new transport, as if freshly constructed.
+   */
+  void resetTransport(std::shared_ptr<TTransport> ptrans) {
+    ptrans_ = ptrans;
+    input_recursion_depth_ = 0;
+    output_recursion_depth_ = 0;
+    recursion_limit_ = ptrans->getConfiguration()->getRecursionLimit();
+  }
+
   virtual void checkReadBytesAvailable(TSet& set)
   {
       ptrans_->checkReadBytesAvailable(set.size_ * getMinSerializedSize(set.elemType_));
@@ -595,6 +626,18 @@ public:
     (void)outTrans;
     return getProtocol(inTrans);
   }
+
+  /**
+   * Point a protocol previously returned by getProtocol() at trans so it can
+   * be reused.  Returns false if this factory does not support that, in
+   * which case the caller should call getProtocol() instead.
+   */
+  virtual bool resetProtocol(const std::shared_ptr<TProtocol>& protocol,
+                             std::shared_ptr<TTransport> trans) {
+    (void)protocol;
+    (void)trans;
+    return false;
+  }
 };
 
 /**
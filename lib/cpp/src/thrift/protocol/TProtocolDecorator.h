@@ -141,6 +141,15 @@ public:
   uint32_t readString_virt(std::string& str) override { return protocol->readString(str); }
   uint32_t readBinary_virt(std::string& str) override { return protocol->readBinary(str); }
 
+  uint32_t skip_virt(TType type) override { return protocol->skip(type); }
+
+  bool readRawBinary_virt(TType type, std::string& raw, uint32_t& xfer) override {
+    return protocol->readRawBinary(type, raw, xfer);
+  }
+  bool writeRawBinary_virt(const std::string& raw, uint32_t& xfer) override {
+    return protocol->writeRawBinary(raw, xfer);
+  }
+
 private:
   shared_ptr<TProtocol> protocol;
 };
@@ -0,0 +1,979 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THRIFT_PROTOCOL_TVIEW_H_
+#define _THRIFT_PROTOCOL_TVIEW_H_ 1
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <thrift/TConfiguration.h>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/protocol/TProtocol.h>
+#include <thrift/protocol/TProtocolException.h>
+#include <thrift/transport/TTransport.h>
+
+/**
+ * Read-only views of binary and compact encoded data.
+ *
+ * The cpp:views generator option emits a FooView<Reader_> class template for
+ * every struct Foo, with one accessor per field. A view does not copy or
+ * decode anything up front: on the first access it scans the fields once,
+ * remembering where each value starts, and then decodes only the values that
+ * are asked for. Strings come back as TStringView pointing into the buffer,
+ * nested structs as views, and lists, sets and maps as views that decode
+ * their elements while being iterated.
+ *
+ * Reader_ is TBinaryViewReader or TCompactViewReader. The buffer must outlive
+ * every view into it. The first access modifies the view, even through a
+ * const reference, so a view must not be shared between threads before it
+ * has been accessed once. Malformed data throws TProtocolException, and no
+ * read goes past the end of the buffer.
+ */
+
+namespace apache {
+namespace thrift {
+namespace protocol {
+
+/**
+ * A string or binary value inside an encoded buffer
+ */
+class TStringView {
+public:
+  TStringView() : data_(nullptr), size_(0) {}
+
+  TStringView(const char* data, uint32_t size) : data_(data), size_(size) {}
+
+  TStringView(const char* str) : data_(str), size_(static_cast<uint32_t>(std::strlen(str))) {}
+
+  TStringView(const std::string& str)
+    : data_(str.data()), size_(static_cast<uint32_t>(str.size())) {}
+
+  const char* data() const { return data_; }
+
+  uint32_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  const char* begin() const { return data_; }
+
+  const char* end() const { return data_ + size_; }
+
+  std::string str() const { return std::string(data_, size_); }
+
+  bool operator==(const TStringView& rhs) const {
+    return size_ == rhs.size_ && (size_ == 0 || std::memcmp(data_, rhs.data_, size_) == 0);
+  }
+
+  bool operator!=(const TStringView& rhs) const { return !(*this == rhs); }
+
+private:
+  const char* data_;
+  uint32_t size_;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const TStringView& str) {
+  return out.write(str.data(), str.size());
+}
+
+namespace detail {
+namespace view {
+
+inline void need(const uint8_t* p, const uint8_t* end, uint64_t len) {
+  if (static_cast<uint64_t>(end - p) < len) {
+    throw TProtocolException(TProtocolException::INVALID_DATA,
+                             "Value extends past the end of the buffer");
+  }
+}
+
+/**
+ * Every element takes at least one byte, which bounds the sizes worth trying
+ */
+inline uint32_t checkSize(int64_t size, const uint8_t* p, const uint8_t* end, uint32_t perElement) {
+  if (size < 0) {
+    throw TProtocolException(TProtocolException::NEGATIVE_SIZE);
+  }
+  need(p, end, static_cast<uint64_t>(size) * perElement);
+  return static_cast<uint32_t>(size);
+}
+
+inline void checkDepth(int depth) {
+  if (depth > TConfiguration::DEFAULT_RECURSION_DEPTH) {
+    throw TProtocolException(TProtocolException::DEPTH_LIMIT);
+  }
+}
+
+/**
+ * Width of the values of type that are encoded at a fixed width, else 0
+ */
+inline uint32_t fixedWidth(TType type, bool compact) {
+  switch (type) {
+  case T_BOOL:
+  case T_BYTE:
+    return 1;
+  case T_DOUBLE:
+    return 8;
+  case T_I16:
+    return compact ? 0 : 2;
+  case T_I32:
+    return compact ? 0 : 4;
+  case T_I64:
+    return compact ? 0 : 8;
+  default:
+    return 0;
+  }
+}
+
+} // namespace view
+} // namespace detail
+
+/**
+ * Decodes the binary protocol in place
+ */
+template <class ByteOrder_>
+class TBinaryViewReaderT {
+public:
+  static bool readFieldBegin(const uint8_t*& p,
+                             const uint8_t* end,
+                             int16_t& lastId,
+                             TType& type,
+                             int16_t& id,
+                             const uint8_t*& value) {
+    (void)lastId;
+    type = static_cast<TType>(readByte(p, end));
+    if (type == T_STOP) {
+      return false;
+    }
+    id = readI16(p, end);
+    value = p;
+    return true;
+  }
+
+  static void skipFieldValue(const uint8_t*& p, const uint8_t* end, TType type) {
+    skip(p, end, type);
+  }
+
+  static bool readBoolField(const uint8_t* value, const uint8_t* end) {
+    return readBool(value, end);
+  }
+
+  static bool readBool(const uint8_t*& p, const uint8_t* end) { return readByte(p, end) != 0; }
+
+  static int8_t readByte(const uint8_t*& p, const uint8_t* end) {
+    detail::view::need(p, end, 1);
+    return static_cast<int8_t>(*p++);
+  }
+
+  static int16_t readI16(const uint8_t*& p, const uint8_t* end) {
+    uint16_t bits;
+    detail::view::need(p, end, sizeof(bits));
+    std::memcpy(&bits, p, sizeof(bits));
+    p += sizeof(bits);
+    return static_cast<int16_t>(ByteOrder_::fromWire16(bits));
+  }
+
+  static int32_t readI32(const uint8_t*& p, const uint8_t* end) {
+    uint32_t bits;
+    detail::view::need(p, end, sizeof(bits));
+    std::memcpy(&bits, p, sizeof(bits));
+    p += sizeof(bits);
+    return static_cast<int32_t>(ByteOrder_::fromWire32(bits));
+  }
+
+  static int64_t readI64(const uint8_t*& p, const uint8_t* end) {
+    uint64_t bits;
+    detail::view::need(p, end, sizeof(bits));
+    std::memcpy(&bits, p, sizeof(bits));
+    p += sizeof(bits);
+    return static_cast<int64_t>(ByteOrder_::fromWire64(bits));
+  }
+
+  static double readDouble(const uint8_t*& p, const uint8_t* end) {
+    uint64_t bits = static_cast<uint64_t>(readI64(p, end));
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  static TStringView readString(const uint8_t*& p, const uint8_t* end) {
+    uint32_t size = detail::view::checkSize(readI32(p, end), p, end, 1);
+    TStringView str(reinterpret_cast<const char*>(p), size);
+    p += size;
+    return str;
+  }
+
+  static void readListBegin(const uint8_t*& p, const uint8_t* end, TType& elemType, uint32_t& size) {
+    elemType = static_cast<TType>(readByte(p, end));
+    size = detail::view::checkSize(readI32(p, end), p, end, 1);
+  }
+
+  static void readMapBegin(const uint8_t*& p,
+                           const uint8_t* end,
+                           TType& keyType,
+                           TType& valType,
+                           uint32_t& size) {
+    keyType = static_cast<TType>(readByte(p, end));
+    valType = static_cast<TType>(readByte(p, end));
+    size = detail::view::checkSize(readI32(p, end), p, end, 2);
+  }
+
+  static void readMessageBegin(const uint8_t*& p,
+                               const uint8_t* end,
+                               TStringView& name,
+                               TMessageType& messageType,
+                               int32_t& seqid) {
+    int32_t sz = readI32(p, end);
+    if (sz < 0) {
+      if ((sz & static_cast<int32_t>(0xffff0000)) != static_cast<int32_t>(0x80010000)) {
+        throw TProtocolException(TProtocolException::BAD_VERSION, "Bad version identifier");
+      }
+      messageType = static_cast<TMessageType>(sz & 0x000000ff);
+      name = readString(p, end);
+    } else {
+      // Without a version header the name comes first
+      uint32_t size = detail::view::checkSize(sz, p, end, 1);
+      name = TStringView(reinterpret_cast<const char*>(p), size);
+      p += size;
+      messageType = static_cast<TMessageType>(readByte(p, end));
+    }
+    seqid = readI32(p, end);
+  }
+
+  static void skip(const uint8_t*& p, const uint8_t* end, TType type, int depth = 0) {
+    uint32_t width = detail::view::fixedWidth(type, false);
+    if (width > 0) {
+      detail::view::need(p, end, width);
+      p += width;
+      return;
+    }
+
+    TType keyType, valType;
+    uint32_t size;
+    switch (type) {
+    case T_STRING:
+      readString(p, end);
+      return;
+    case T_STRUCT: {
+      detail::view::checkDepth(++depth);
+      int16_t lastId = 0, id;
+      const uint8_t* value;
+      while (readFieldBegin(p, end, lastId, valType, id, value)) {
+        skip(p, end, valType, depth);
+      }
+      return;
+    }
+    case T_LIST:
+    case T_SET:
+      readListBegin(p, end, valType, size);
+      keyType = T_STOP;
+      break;
+    case T_MAP:
+      readMapBegin(p, end, keyType, valType, size);
+      break;
+    default:
+      throw TProtocolException(TProtocolException::INVALID_DATA, "Invalid data");
+    }
+
+    // Containers of fixed-width elements are skipped in one step
+    detail::view::checkDepth(++depth);
+    uint32_t keyWidth = keyType == T_STOP ? 0 : detail::view::fixedWidth(keyType, false);
+    uint32_t valWidth = detail::view::fixedWidth(valType, false);
+    if (valWidth > 0 && (keyType == T_STOP || keyWidth > 0)) {
+      detail::view::need(p, end, static_cast<uint64_t>(size) * (keyWidth + valWidth));
+      p += static_cast<uint64_t>(size) * (keyWidth + valWidth);
+      return;
+    }
+    for (uint32_t i = 0; i < size; ++i) {
+      if (keyType != T_STOP) {
+        skip(p, end, keyType, depth);
+      }
+      skip(p, end, valType, depth);
+    }
+  }
+};
+
+typedef TBinaryViewReaderT<TNetworkBigEndian> TBinaryViewReader;
+
+/**
+ * Decodes the compact protocol in place
+ */
+class TCompactViewReader {
+public:
+  /**
+   * Bool fields keep their value in the field header, so value points at the
+   * header for them
+   */
+  static bool readFieldBegin(const uint8_t*& p,
+                             const uint8_t* end,
+                             int16_t& lastId,
+                             TType& type,
+                             int16_t& id,
+                             const uint8_t*& value) {
+    detail::view::need(p, end, 1);
+    uint8_t header = *p;
+    if (header == detail::compact::CT_STOP) {
+      ++p;
+      return false;
+    }
+    value = p++;
+    int16_t modifier = static_cast<int16_t>((header & 0xf0) >> 4);
+    if (modifier == 0) {
+      id = readI16(p, end);
+    } else {
+      id = static_cast<int16_t>(lastId + modifier);
+    }
+    lastId = id;
+    type = getTType(header & 0x0f);
+    if (type != T_BOOL) {
+      value = p;
+    }
+    return true;
+  }
+
+  static void skipFieldValue(const uint8_t*& p, const uint8_t* end, TType type) {
+    if (type != T_BOOL) {
+      skip(p, end, type);
+    }
+  }
+
+  static bool readBoolField(const uint8_t* value, const uint8_t* end) {
+    (void)end;
+    return (*value & 0x0f) == detail::compact::CT_BOOLEAN_TRUE;
+  }
+
+  static bool readBool(const uint8_t*& p, const uint8_t* end) {
+    return readByte(p, end) == detail::compact::CT_BOOLEAN_TRUE;
+  }
+
+  static int8_t readByte(const uint8_t*& p, const uint8_t* end) {
+    detail::view::need(p, end, 1);
+    return static_cast<int8_t>(*p++);
+  }
+
+  static int16_t readI16(const uint8_t*& p, const uint8_t* end) {
+    return static_cast<int16_t>(zigzagToI32(static_cast<uint32_t>(readVarint(p, end))));
+  }
+
+  static int32_t readI32(const uint8_t*& p, const uint8_t* end) {
+    return zigzagToI32(static_cast<uint32_t>(readVarint(p, end)));
+  }
+
+  static int64_t readI64(const uint8_t*& p, const uint8_t* end) {
+    uint64_t n = readVarint(p, end);
+    return static_cast<int64_t>(n >> 1) ^ -static_cast<int64_t>(n & 1);
+  }
+
+  static double readDouble(const uint8_t*& p, const uint8_t* end) {
+    uint64_t bits;
+    detail::view::need(p, end, sizeof(bits));
+    std::memcpy(&bits, p, sizeof(bits));
+    p += sizeof(bits);
+    bits = TNetworkLittleEndian::fromWire64(bits);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  static TStringView readString(const uint8_t*& p, const uint8_t* end) {
+    uint32_t size = readSize(p, end, 1);
+    TStringView str(reinterpret_cast<const char*>(p), size);
+    p += size;
+    return str;
+  }
+
+  static void readListBegin(const uint8_t*& p, const uint8_t* end, TType& elemType, uint32_t& size) {
+    uint8_t sizeAndType = static_cast<uint8_t>(readByte(p, end));
+    size = (sizeAndType >> 4) & 0x0f;
+    if (size == 15) {
+      size = readSize(p, end, 1);
+    } else {
+      detail::view::need(p, end, size);
+    }
+    elemType = getTType(sizeAndType & 0x0f);
+  }
+
+  static void readMapBegin(const uint8_t*& p,
+                           const uint8_t* end,
+                           TType& keyType,
+                           TType& valType,
+                           uint32_t& size) {
+    size = readSize(p, end, 2);
+    keyType = valType = T_STOP;
+    if (size > 0) {
+      uint8_t kvType = static_cast<uint8_t>(readByte(p, end));
+      keyType = getTType(kvType >> 4);
+      valType = getTType(kvType & 0x0f);
+    }
+  }
+
+  static void readMessageBegin(const uint8_t*& p,
+                               const uint8_t* end,
+                               TStringView& name,
+                               TMessageType& messageType,
+                               int32_t& seqid) {
+    typedef TCompactProtocolT<transport::TTransport> Protocol;
+    if (readByte(p, end) != Protocol::PROTOCOL_ID) {
+      throw TProtocolException(TProtocolException::BAD_VERSION, "Bad protocol identifier");
+    }
+    int8_t versionAndType = readByte(p, end);
+    if ((versionAndType & Protocol::VERSION_MASK) != Protocol::VERSION_N) {
+      throw TProtocolException(TProtocolException::BAD_VERSION, "Bad protocol version");
+    }
+    // the type sits in the top three bits, as in TCompactProtocolT
+    messageType = static_cast<TMessageType>((versionAndType >> 5) & 0x07);
+    seqid = static_cast<int32_t>(readVarint(p, end));
+    name = readString(p, end);
+  }
+
+  static void skip(const uint8_t*& p, const uint8_t* end, TType type, int depth = 0) {
+    uint32_t width = detail::view::fixedWidth(type, true);
+    if (width > 0) {
+      detail::view::need(p, end, width);
+      p += width;
+      return;
+    }
+
+    TType keyType, valType;
+    uint32_t size;
+    switch (type) {
+    case T_I16:
+    case T_I32:
+    case T_I64:
+      readVarint(p, end);
+      return;
+    case T_STRING:
+      readString(p, end);
+      return;
+    case T_STRUCT: {
+      detail::view::checkDepth(++depth);
+      int16_t lastId = 0, id;
+      const uint8_t* value;
+      while (readFieldBegin(p, end, lastId, valType, id, value)) {
+        skipFieldValue(p, end, valType, depth);
+      }
+      return;
+    }
+    case T_LIST:
+    case T_SET:
+      readListBegin(p, end, valType, size);
+      keyType = T_STOP;
+      break;
+    case T_MAP:
+      readMapBegin(p, end, keyType, valType, size);
+      break;
+    default:
+      throw TProtocolException(TProtocolException::INVALID_DATA, "Invalid data");
+    }
+
+    detail::view::checkDepth(++depth);
+    uint32_t keyWidth = keyType == T_STOP ? 0 : detail::view::fixedWidth(keyType, true);
+    uint32_t valWidth = detail::view::fixedWidth(valType, true);
+    if (size > 0 && valWidth > 0 && (keyType == T_STOP || keyWidth > 0)) {
+      detail::view::need(p, end, static_cast<uint64_t>(size) * (keyWidth + valWidth));
+      p += static_cast<uint64_t>(size) * (keyWidth + valWidth);
+      return;
+    }
+    for (uint32_t i = 0; i < size; ++i) {
+      if (keyType != T_STOP) {
+        skip(p, end, keyType, depth);
+      }
+      skip(p, end, valType, depth);
+    }
+  }
+
+private:
+  static void skipFieldValue(const uint8_t*& p, const uint8_t* end, TType type, int depth) {
+    if (type != T_BOOL) {
+      skip(p, end, type, depth);
+    }
+  }
+
+  static uint64_t readVarint(const uint8_t*& p, const uint8_t* end) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 70; shift += 7) {
+      detail::view::need(p, end, 1);
+      uint8_t byte = *p++;
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    throw TProtocolException(TProtocolException::INVALID_DATA, "Variable-length int over 10 bytes.");
+  }
+
+  static uint32_t readSize(const uint8_t*& p, const uint8_t* end, uint32_t perElement) {
+    return detail::view::checkSize(static_cast<int32_t>(readVarint(p, end)), p, end, perElement);
+  }
+
+  static int32_t zigzagToI32(uint32_t n) {
+    return static_cast<int32_t>(n >> 1) ^ -static_cast<int32_t>(n & 1);
+  }
+
+  static TType getTType(uint8_t type) {
+    switch (type) {
+    case detail::compact::CT_BOOLEAN_TRUE:
+    case detail::compact::CT_BOOLEAN_FALSE:
+      return T_BOOL;
+    case detail::compact::CT_BYTE:
+      return T_BYTE;
+    case detail::compact::CT_I16:
+      return T_I16;
+    case detail::compact::CT_I32:
+      return T_I32;
+    case detail::compact::CT_I64:
+      return T_I64;
+    case detail::compact::CT_DOUBLE:
+      return T_DOUBLE;
+    case detail::compact::CT_BINARY:
+      return T_STRING;
+    case detail::compact::CT_LIST:
+      return T_LIST;
+    case detail::compact::CT_SET:
+      return T_SET;
+    case detail::compact::CT_MAP:
+      return T_MAP;
+    case detail::compact::CT_STRUCT:
+      return T_STRUCT;
+    default:
+      throw TProtocolException(TProtocolException::INVALID_DATA,
+                               "don't know what type: " + std::to_string(type));
+    }
+  }
+};
+
+/**
+ * How values of type Value_ are decoded: the wire type they are expected
+ * with, and read(), which decodes one and moves p past it. The primary
+ * template covers views, which know how to read themselves.
+ */
+template <class Reader_, class Value_, class Enable_ = void>
+struct TViewValue {
+  static const TType type = Value_::viewType;
+  static Value_ read(const uint8_t*& p, const uint8_t* end) { return Value_::__read(p, end); }
+};
+
+template <class Reader_>
+struct TViewValue<Reader_, bool> {
+  static const TType type = T_BOOL;
+  static bool read(const uint8_t*& p, const uint8_t* end) { return Reader_::readBool(p, end); }
+};
+
+template <class Reader_>
+struct TViewValue<Reader_, int8_t> {
+  static const TType type = T_BYTE;
+  static int8_t read(const uint8_t*& p, const uint8_t* end) { return Reader_::readByte(p, end); }
+};
+
+template <class Reader_>
+struct TViewValue<Reader_, int16_t> {
+  static const TType type = T_I16;
+  static int16_t read(const uint8_t*& p, const uint8_t* end) { return Reader_::readI16(p, end); }
+};
+
+template <class Reader_>
+struct TViewValue<Reader_, int32_t> {
+  static const TType type = T_I32;
+  static int32_t read(const uint8_t*& p, const uint8_t* end) { return Reader_::readI32(p, end); }
+};
+
+template <class Reader_>
+struct TViewValue<Reader_, int64_t> {
+  static const TType type = T_I64;
+  static int64_t read(const uint8_t*& p, const uint8_t* end) { return Reader_::readI64(p, end); }
+};
+
+template <class Reader_>
+struct TViewValue<Reader_, double> {
+  static const TType type = T_DOUBLE;
+  static double read(const uint8_t*& p, const uint8_t* end) { return Reader_::readDouble(p, end); }
+};
+
+template <class Reader_>
+struct TViewValue<Reader_, TStringView> {
+  static const TType type = T_STRING;
+  static TStringView read(const uint8_t*& p, const uint8_t* end) {
+    return Reader_::readString(p, end);
+  }
+};
+
+template <class Reader_, class Value_>
+struct TViewValue<Reader_, Value_, typename std::enable_if<std::is_enum<Value_>::value>::type> {
+  static const TType type = T_I32;
+  static Value_ read(const uint8_t*& p, const uint8_t* end) {
+    return static_cast<Value_>(Reader_::readI32(p, end));
+  }
+};
+
+/**
+ * Decodes the value of a field, which differs from other values only for
+ * bools in the compact protocol
+ */
+template <class Reader_, class Value_>
+struct TViewField {
+  static Value_ read(const uint8_t* value, const uint8_t* end) {
+    return TViewValue<Reader_, Value_>::read(value, end);
+  }
+};
+
+template <class Reader_>
+struct TViewField<Reader_, bool> {
+  static bool read(const uint8_t* value, const uint8_t* end) {
+    return Reader_::readBoolField(value, end);
+  }
+};
+
+/**
+ * Base of the generated struct views. Derived_ provides
+ * static int __slot(int16_t id, TType type), mapping the id and wire type of
+ * each of its Fields_ fields to a slot of the index, and -1 to anything else.
+ *
+ * A default constructed view stands for an unset struct: every field is
+ * unset and every accessor returns its default.
+ */
+template <class Derived_, class Reader_, std::size_t Fields_>
+class TStructView {
+public:
+  static const TType viewType = T_STRUCT;
+
+  TStructView() : begin_(nullptr), end_(nullptr), indexed_(true) { clearIndex(); }
+
+  /**
+   * A view of the struct at the start of data. Bytes after its stop field
+   * are ignored.
+   */
+  TStructView(const uint8_t* data, uint32_t size)
+    : begin_(data), end_(data + size), indexed_(false) {}
+
+  /**
+   * False for a view of an unset struct
+   */
+  bool __valid() const { return begin_ != nullptr; }
+
+  /**
+   * The encoded struct, through its stop field
+   */
+  const uint8_t* __data() const { return begin_; }
+
+  uint32_t __size() const {
+    index();
+    return static_cast<uint32_t>(end_ - begin_);
+  }
+
+  static Derived_ __read(const uint8_t*& p, const uint8_t* end) {
+    Derived_ view(p, static_cast<uint32_t>(end - p));
+    p += view.__size();
+    return view;
+  }
+
+protected:
+  /**
+   * Where the value of the field in slot starts, or nullptr if it is unset
+   */
+  const uint8_t* __field(std::size_t slot) const {
+    index();
+    return fields_[slot];
+  }
+
+  template <class Value_>
+  Value_ __get(std::size_t slot, const Value_& defaultValue) const {
+    const uint8_t* value = __field(slot);
+    return value != nullptr ? TViewField<Reader_, Value_>::read(value, end_) : defaultValue;
+  }
+
+private:
+  void clearIndex() const {
+    for (std::size_t i = 0; i < Fields_; ++i) {
+      fields_[i] = nullptr;
+    }
+  }
+
+  /**
+   * Records where each known field starts and where the struct ends. A field
+   * that occurs twice is taken from its last occurrence, as read() would.
+   */
+  void index() const {
+    if (indexed_) {
+      return;
+    }
+    clearIndex();
+    const uint8_t* p = begin_;
+    int16_t lastId = 0;
+    int16_t id;
+    TType type;
+    const uint8_t* value;
+    while (Reader_::readFieldBegin(p, end_, lastId, type, id, value)) {
+      int slot = Derived_::__slot(id, type);
+      if (slot >= 0) {
+        fields_[slot] = value;
+      }
+      Reader_::skipFieldValue(p, end_, type);
+    }
+    end_ = p;
+    indexed_ = true;
+  }
+
+  const uint8_t* begin_;
+  mutable const uint8_t* end_;
+  mutable bool indexed_;
+  mutable const uint8_t* fields_[Fields_ > 0 ? Fields_ : 1];
+};
+
+/**
+ * View of a list, or of a set with Type_ T_SET, whose elements are decoded
+ * one at a time while iterating
+ */
+template <class Reader_, class Value_, TType Type_ = T_LIST>
+class TListView {
+public:
+  static const TType viewType = Type_;
+
+  typedef Value_ value_type;
+
+  class const_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Value_ value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Value_* pointer;
+    typedef const Value_& reference;
+
+    const_iterator() : pos_(nullptr), end_(nullptr), remaining_(0) {}
+
+    const_iterator(const uint8_t* pos, const uint8_t* end, uint32_t remaining)
+      : pos_(pos), end_(end), remaining_(remaining) {
+      load();
+    }
+
+    reference operator*() const { return value_; }
+
+    pointer operator->() const { return &value_; }
+
+    const_iterator& operator++() {
+      --remaining_;
+      load();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    // Iterators of the same list are equal when as many elements remain
+    bool operator==(const const_iterator& rhs) const { return remaining_ == rhs.remaining_; }
+
+    bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+
+  private:
+    void load() {
+      if (remaining_ > 0) {
+        value_ = TViewValue<Reader_, Value_>::read(pos_, end_);
+      }
+    }
+
+    const uint8_t* pos_;
+    const uint8_t* end_;
+    uint32_t remaining_;
+    Value_ value_;
+  };
+
+  typedef const_iterator iterator;
+
+  TListView() : elements_(nullptr), end_(nullptr), size_(0) {}
+
+  TListView(const uint8_t* data, uint32_t size) : elements_(data), end_(data + size), size_(0) {
+    TType elemType;
+    Reader_::readListBegin(elements_, end_, elemType, size_);
+    if (size_ > 0 && elemType != TViewValue<Reader_, Value_>::type) {
+      throw TProtocolException(TProtocolException::INVALID_DATA, "Unexpected element type");
+    }
+  }
+
+  uint32_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  const_iterator begin() const { return const_iterator(elements_, end_, size_); }
+
+  const_iterator end() const { return const_iterator(); }
+
+  static TListView __read(const uint8_t*& p, const uint8_t* end) {
+    TListView view(p, static_cast<uint32_t>(end - p));
+    Reader_::skip(p, end, Type_);
+    return view;
+  }
+
+private:
+  const uint8_t* elements_;
+  const uint8_t* end_;
+  uint32_t size_;
+};
+
+template <class Reader_, class Value_>
+using TSetView = TListView<Reader_, Value_, T_SET>;
+
+/**
+ * View of a map, whose entries are decoded one at a time while iterating
+ */
+template <class Reader_, class Key_, class Value_>
+class TMapView {
+public:
+  static const TType viewType = T_MAP;
+
+  typedef std::pair<Key_, Value_> value_type;
+
+  class const_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef std::pair<Key_, Value_> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type& reference;
+
+    const_iterator() : pos_(nullptr), end_(nullptr), remaining_(0) {}
+
+    const_iterator(const uint8_t* pos, const uint8_t* end, uint32_t remaining)
+      : pos_(pos), end_(end), remaining_(remaining) {
+      load();
+    }
+
+    reference operator*() const { return entry_; }
+
+    pointer operator->() const { return &entry_; }
+
+    const_iterator& operator++() {
+      --remaining_;
+      load();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const const_iterator& rhs) const { return remaining_ == rhs.remaining_; }
+
+    bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+
+  private:
+    void load() {
+      if (remaining_ > 0) {
+        entry_.first = TViewValue<Reader_, Key_>::read(pos_, end_);
+        entry_.second = TViewValue<Reader_, Value_>::read(pos_, end_);
+      }
+    }
+
+    const uint8_t* pos_;
+    const uint8_t* end_;
+    uint32_t remaining_;
+    value_type entry_;
+  };
+
+  typedef const_iterator iterator;
+
+  TMapView() : entries_(nullptr), end_(nullptr), size_(0) {}
+
+  TMapView(const uint8_t* data, uint32_t size) : entries_(data), end_(data + size), size_(0) {
+    TType keyType, valType;
+    Reader_::readMapBegin(entries_, end_, keyType, valType, size_);
+    if (size_ > 0 && (keyType != TViewValue<Reader_, Key_>::type
+                      || valType != TViewValue<Reader_, Value_>::type)) {
+      throw TProtocolException(TProtocolException::INVALID_DATA, "Unexpected entry type");
+    }
+  }
+
+  uint32_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  const_iterator begin() const { return const_iterator(entries_, end_, size_); }
+
+  const_iterator end() const { return const_iterator(); }
+
+  static TMapView __read(const uint8_t*& p, const uint8_t* end) {
+    TMapView view(p, static_cast<uint32_t>(end - p));
+    Reader_::skip(p, end, T_MAP);
+    return view;
+  }
+
+private:
+  const uint8_t* entries_;
+  const uint8_t* end_;
+  uint32_t size_;
+};
+
+/**
+ * View of a message: its header, and its body as a view of the arguments
+ * or result struct, such as body<Calculator_add_argsView<Reader_> >()
+ */
+template <class Reader_>
+class TMessageView {
+public:
+  TMessageView(const uint8_t* data, uint32_t size) : body_(data), end_(data + size) {
+    Reader_::readMessageBegin(body_, end_, name_, type_, seqid_);
+  }
+
+  TStringView name() const { return name_; }
+
+  TMessageType type() const { return type_; }
+
+  int32_t seqid() const { return seqid_; }
+
+  template <class View_>
+  View_ body() const {
+    return View_(body_, static_cast<uint32_t>(end_ - body_));
+  }
+
+private:
+  const uint8_t* body_;
+  const uint8_t* end_;
+  TStringView name_;
+  TMessageType type_;
+  int32_t seqid_;
+};
+
+/**
+ * A view of the bytes trans has buffered, without reading them. For the
+ * TMemoryBuffer that TNonblockingServer hands to processors this is the
+ * whole request frame.
+ */
+template <class View_>
+View_ borrowView(transport::TTransport* trans) {
+  uint32_t len = 0;
+  const uint8_t* data = trans->borrow(nullptr, &len);
+  if (data == nullptr) {
+    throw TProtocolException(TProtocolException::NOT_IMPLEMENTED,
+                             "Transport cannot lend its buffer");
+  }
+  return View_(data, len);
+}
+
+} // namespace protocol
+} // namespace thrift
+} // namespace apache
+
+#endif // #define _THRIFT_PROTOCOL_TVIEW_H_ 1
@@ -473,6 +473,14 @@ public:
 
   uint32_t skip_virt(TType type) override { return static_cast<Protocol_*>(this)->skip(type); }
 
+  bool readRawBinary_virt(TType type, std::string& raw, uint32_t& xfer) override {
+    return static_cast<Protocol_*>(this)->readRawBinary(type, raw, xfer);
+  }
+
+  bool writeRawBinary_virt(const std::string& raw, uint32_t& xfer) override {
+    return static_cast<Protocol_*>(this)->writeRawBinary(raw, xfer);
+  }
+
   /*
    * Provide a default skip() implementation that uses non-virtual read
    * methods.
@@ -488,6 +496,15 @@ public:
     return ::apache::thrift::protocol::skip(*prot, type);
   }
 
+  /*
+   * Only the binary protocol can capture values without decoding them.
+   */
+  bool readRawBinary(TType /* type */, std::string& /* raw */, uint32_t& /* xfer */) {
+    return false;
+  }
+
+  bool writeRawBinary(const std::string& /* raw */, uint32_t& /* xfer */) { return false; }
+
   /*
    * Provide a default readBool() implementation for use with
    * std::vector<bool>, that behaves the same as reading into a normal bool.
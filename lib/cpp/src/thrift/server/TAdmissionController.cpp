@@ -0,0 +1,223 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thrift/TApplicationException.h>
+#include <thrift/server/TAdmissionController.h>
+
+namespace apache {
+namespace thrift {
+namespace server {
+
+using apache::thrift::TApplicationException;
+using apache::thrift::concurrency::Guard;
+using apache::thrift::protocol::TMessageType;
+using apache::thrift::protocol::TProtocol;
+using std::shared_ptr;
+
+TAdmissionController::TAdmissionController(int64_t initialLimit)
+  : limit_(initialLimit), inFlight_(0), rejected_(0) {
+  if (initialLimit < 1) {
+    throw std::invalid_argument("initialLimit must be greater than zero");
+  }
+}
+
+TAdmissionController::~TAdmissionController() = default;
+
+bool TAdmissionController::tryAcquire() {
+  Guard g(mutex_);
+  if (inFlight_ >= limit_) {
+    ++rejected_;
+    return false;
+  }
+  ++inFlight_;
+  return true;
+}
+
+void TAdmissionController::release(int64_t latencyUs, bool dropped) {
+  Guard g(mutex_);
+  limit_ = (std::max)(int64_t(1), update(limit_, inFlight_, latencyUs, dropped));
+  if (inFlight_ > 0) {
+    --inFlight_;
+  }
+}
+
+int64_t TAdmissionController::getLimit() const {
+  Guard g(mutex_);
+  return limit_;
+}
+
+int64_t TAdmissionController::getInFlight() const {
+  Guard g(mutex_);
+  return inFlight_;
+}
+
+uint64_t TAdmissionController::getRejectedCount() const {
+  Guard g(mutex_);
+  return rejected_;
+}
+
+void TAdmissionController::rejectRequest(TProtocol* in, TProtocol* out) {
+  std::string fname;
+  TMessageType mtype;
+  int32_t seqid;
+  in->readMessageBegin(fname, mtype, seqid);
+  in->skip(protocol::T_STRUCT);
+  in->readMessageEnd();
+  in->getTransport()->readEnd();
+
+  if (mtype == protocol::T_ONEWAY) {
+    return;
+  }
+
+  TApplicationException x(TApplicationException::INTERNAL_ERROR,
+                          "Server overloaded, request to " + fname + " rejected");
+  out->writeMessageBegin(fname, protocol::T_EXCEPTION, seqid);
+  x.write(out);
+  out->writeMessageEnd();
+  out->getTransport()->writeEnd();
+  out->getTransport()->flush();
+}
+
+TAIMDAdmissionController::TAIMDAdmissionController(int64_t initialLimit,
+                                                   int64_t minLimit,
+                                                   int64_t maxLimit,
+                                                   double backoffRatio,
+                                                   int64_t latencyThresholdUs)
+  : TAdmissionController(initialLimit),
+    minLimit_(minLimit),
+    maxLimit_(maxLimit),
+    backoffRatio_(backoffRatio),
+    latencyThresholdUs_(latencyThresholdUs) {
+  if (minLimit < 1 || maxLimit < minLimit) {
+    throw std::invalid_argument("limits must satisfy 1 <= minLimit <= maxLimit");
+  }
+  if (backoffRatio <= 0.0 || backoffRatio >= 1.0) {
+    throw std::invalid_argument("backoffRatio must be between 0 and 1");
+  }
+}
+
+int64_t TAIMDAdmissionController::update(int64_t limit,
+                                         int64_t inFlight,
+                                         int64_t latencyUs,
+                                         bool dropped) {
+  if (dropped || latencyUs > latencyThresholdUs_) {
+    limit = static_cast<int64_t>(limit * backoffRatio_);
+  } else if (inFlight * 2 >= limit) {
+    // only grow while the limit is actually being used
+    ++limit;
+  }
+  return (std::min)(maxLimit_, (std::max)(minLimit_, limit));
+}
+
+TGradientAdmissionController::TGradientAdmissionController(int64_t initialLimit,
+                                                           int64_t minLimit,
+                                                           int64_t maxLimit,
+                                                           double smoothing,
+                                                           double tolerance,
+                                                           int64_t longWindow)
+  : TAdmissionController(initialLimit),
+    minLimit_(minLimit),
+    maxLimit_(maxLimit),
+    smoothing_(smoothing),
+    tolerance_(tolerance),
+    longWindow_(longWindow),
+    samples_(0),
+    longLatencyUs_(0.0),
+    estimatedLimit_(static_cast<double>(initialLimit)) {
+  if (minLimit < 1 || maxLimit < minLimit) {
+    throw std::invalid_argument("limits must satisfy 1 <= minLimit <= maxLimit");
+  }
+  if (smoothing <= 0.0 || smoothing > 1.0) {
+    throw std::invalid_argument("smoothing must be in (0, 1]");
+  }
+  if (tolerance < 1.0) {
+    throw std::invalid_argument("tolerance must be at least 1");
+  }
+  if (longWindow < 1) {
+    throw std::invalid_argument("longWindow must be greater than zero");
+  }
+}
+
+int64_t TGradientAdmissionController::update(int64_t limit,
+                                             int64_t inFlight,
+                                             int64_t latencyUs,
+                                             bool dropped) {
+  const double sample = static_cast<double>((std::max)(int64_t(1), latencyUs));
+
+  // exponential moving average over roughly longWindow_ samples
+  ++samples_;
+  longLatencyUs_ += (sample - longLatencyUs_) / static_cast<double>((std::min)(samples_, longWindow_));
+
+  double gradient = 0.5;
+  if (!dropped) {
+    gradient = (std::max)(0.5, (std::min)(1.0, tolerance_ * longLatencyUs_ / sample));
+  }
+
+  // Do not grow the limit when the server is not using it, otherwise an idle
+  // period would let it drift up without any evidence that it is sustainable.
+  if (gradient >= 1.0 && inFlight * 2 < limit) {
+    return limit;
+  }
+
+  const double newLimit = estimatedLimit_ * gradient + std::sqrt(estimatedLimit_);
+  estimatedLimit_ = estimatedLimit_ * (1.0 - smoothing_) + newLimit * smoothing_;
+  estimatedLimit_ = (std::min)(static_cast<double>(maxLimit_),
+                               (std::max)(static_cast<double>(minLimit_), estimatedLimit_));
+  return static_cast<int64_t>(estimatedLimit_);
+}
+
+TAdmissionControlProcessor::TAdmissionControlProcessor(const shared_ptr<TProcessor>& processor,
+                                                       const shared_ptr<TAdmissionController>& controller)
+  : processor_(processor), controller_(controller) {
+}
+
+bool TAdmissionControlProcessor::process(shared_ptr<TProtocol> in,
+                                         shared_ptr<TProtocol> out,
+                                         void* connectionContext) {
+  // Wait for the request to arrive so that idle time on a persistent
+  // connection is neither counted as latency nor holding a permit.
+  if (!in->getTransport()->peek()) {
+    return false;
+  }
+
+  if (!controller_->tryAcquire()) {
+    TAdmissionController::rejectRequest(in.get(), out.get());
+    return true;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  bool result = false;
+  try {
+    result = processor_->process(in, out, connectionContext);
+  } catch (...) {
+    controller_->release(std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start).count(),
+                         true);
+    throw;
+  }
+  controller_->release(std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start).count());
+  return result;
+}
+}
+}
+} // apache::thrift::server
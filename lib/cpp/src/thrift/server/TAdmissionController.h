@@ -0,0 +1,190 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THRIFT_SERVER_TADMISSIONCONTROLLER_H_
+#define _THRIFT_SERVER_TADMISSIONCONTROLLER_H_ 1
+
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <thrift/TProcessor.h>
+#include <thrift/concurrency/Mutex.h>
+#include <thrift/protocol/TProtocol.h>
+
+namespace apache {
+namespace thrift {
+namespace server {
+
+/**
+ * An admission controller decides whether a request that has been received
+ * may be processed or must be rejected immediately.  It tracks the number of
+ * requests in flight and adjusts its concurrency limit from the latency
+ * observed when each request completes.
+ *
+ * Servers call tryAcquire() once a request is available and, if it returned
+ * true, release() exactly once when that request is finished.  Subclasses
+ * implement the limit algorithm in update(), which is called with the
+ * controller lock held.
+ */
+class TAdmissionController {
+public:
+  /**
+   * @param initialLimit the concurrency limit before any samples are taken
+   * @throws std::invalid_argument if initialLimit is less than 1
+   */
+  explicit TAdmissionController(int64_t initialLimit);
+
+  virtual ~TAdmissionController();
+
+  /**
+   * Attempt to admit a request.
+   *
+   * @return true if the request may proceed; the caller must then call
+   *         release().  false if the request must be rejected.
+   */
+  bool tryAcquire();
+
+  /**
+   * Finish a previously admitted request.
+   *
+   * @param latencyUs time the request spent in the server, in microseconds
+   * @param dropped   true if the request failed or timed out rather than
+   *                  completing normally
+   */
+  void release(int64_t latencyUs, bool dropped = false);
+
+  /**
+   * Get the current concurrency limit.
+   */
+  int64_t getLimit() const;
+
+  /**
+   * Get the number of admitted requests that have not been released.
+   */
+  int64_t getInFlight() const;
+
+  /**
+   * Get the number of requests rejected since construction.
+   */
+  uint64_t getRejectedCount() const;
+
+  /**
+   * Read one message from in, discard it and answer with a
+   * TApplicationException on out (unless the message was oneway).  This is
+   * the fast reject path used by servers when tryAcquire() fails.
+   */
+  static void rejectRequest(protocol::TProtocol* in, protocol::TProtocol* out);
+
+protected:
+  /**
+   * Compute the new concurrency limit after a request completed.
+   *
+   * @param limit     the current limit
+   * @param inFlight  requests in flight at the time the sample was taken,
+   *                  including the one being released
+   * @param latencyUs latency of the request, in microseconds
+   * @param dropped   whether the request failed or timed out
+   * @return the new limit; values below 1 are raised to 1
+   */
+  virtual int64_t update(int64_t limit, int64_t inFlight, int64_t latencyUs, bool dropped) = 0;
+
+private:
+  mutable apache::thrift::concurrency::Mutex mutex_;
+  int64_t limit_;
+  int64_t inFlight_;
+  uint64_t rejected_;
+};
+
+/**
+ * Additive increase / multiplicative decrease.  The limit grows by one for
+ * every successful request observed while at least half of the limit is in
+ * use, and is multiplied by backoffRatio whenever a request is dropped or
+ * takes longer than latencyThresholdUs.
+ */
+class TAIMDAdmissionController : public TAdmissionController {
+public:
+  TAIMDAdmissionController(int64_t initialLimit = 20,
+                           int64_t minLimit = 1,
+                           int64_t maxLimit = 1000,
+                           double backoffRatio = 0.9,
+                           int64_t latencyThresholdUs = 5000000);
+
+protected:
+  int64_t update(int64_t limit, int64_t inFlight, int64_t latencyUs, bool dropped) override;
+
+private:
+  int64_t minLimit_;
+  int64_t maxLimit_;
+  double backoffRatio_;
+  int64_t latencyThresholdUs_;
+};
+
+/**
+ * Gradient based limit.  A long term average of the request latency is
+ * compared with the latest sample; while the two are close the limit grows
+ * by a queue allowance of sqrt(limit), and when the latency rises above
+ * tolerance times the long term average the limit shrinks proportionally.
+ * The result is smoothed to avoid oscillation.
+ */
+class TGradientAdmissionController : public TAdmissionController {
+public:
+  TGradientAdmissionController(int64_t initialLimit = 20,
+                               int64_t minLimit = 1,
+                               int64_t maxLimit = 1000,
+                               double smoothing = 0.2,
+                               double tolerance = 1.5,
+                               int64_t longWindow = 600);
+
+protected:
+  int64_t update(int64_t limit, int64_t inFlight, int64_t latencyUs, bool dropped) override;
+
+private:
+  int64_t minLimit_;
+  int64_t maxLimit_;
+  double smoothing_;
+  double tolerance_;
+  int64_t longWindow_;
+  int64_t samples_;
+  double longLatencyUs_;
+  double estimatedLimit_;
+};
+
+/**
+ * Processor decorator that applies an admission controller to every request
+ * handled by the wrapped processor.  Requests that are not admitted are
+ * answered with a TApplicationException without reaching the handler.
+ */
+class TAdmissionControlProcessor : public apache::thrift::TProcessor {
+public:
+  TAdmissionControlProcessor(const std::shared_ptr<apache::thrift::TProcessor>& processor,
+                             const std::shared_ptr<TAdmissionController>& controller);
+
+  bool process(std::shared_ptr<protocol::TProtocol> in,
+               std::shared_ptr<protocol::TProtocol> out,
+               void* connectionContext) override;
+
+private:
+  std::shared_ptr<apache::thrift::TProcessor> processor_;
+  std::shared_ptr<TAdmissionController> controller_;
+};
+}
+}
+} // apache::thrift::server
+
+#endif // #ifndef _THRIFT_SERVER_TADMISSIONCONTROLLER_H_
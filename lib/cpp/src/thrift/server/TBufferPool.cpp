@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <thrift/server/TBufferPool.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace apache {
+namespace thrift {
+namespace server {
+
+using apache::thrift::concurrency::Guard;
+
+TBufferPool::TBufferPool(size_t limit,
+                         uint32_t minBufferSize,
+                         uint32_t maxCachedSize,
+                         size_t maxCachedPerClass)
+  : limit_(limit),
+    minBufferSize_(1),
+    maxCachedSize_(maxCachedSize),
+    maxCachedPerClass_(maxCachedPerClass),
+    stats_() {
+  while (minBufferSize_ < minBufferSize) {
+    minBufferSize_ <<= 1;
+  }
+  for (uint64_t classSize = minBufferSize_; classSize <= maxCachedSize_; classSize <<= 1) {
+    freeLists_.emplace_back();
+  }
+}
+
+TBufferPool::~TBufferPool() {
+  trim();
+}
+
+int TBufferPool::sizeClass(uint32_t size) const {
+  if (size > maxCachedSize_) {
+    return -1;
+  }
+  uint64_t classSize = minBufferSize_;
+  int cls = 0;
+  while (classSize < size) {
+    classSize <<= 1;
+    ++cls;
+  }
+  return static_cast<size_t>(cls) < freeLists_.size() ? cls : -1;
+}
+
+uint8_t* TBufferPool::allocate(uint32_t* size) {
+  int cls = sizeClass(*size);
+  uint32_t actual = cls < 0 ? *size : minBufferSize_ << cls;
+
+  {
+    Guard g(mutex_);
+    if (cls >= 0 && !freeLists_[cls].empty()) {
+      uint8_t* buffer = freeLists_[cls].back();
+      freeLists_[cls].pop_back();
+      stats_.bytesCached -= actual;
+      stats_.bytesInUse += actual;
+      stats_.peakBytesInUse = (std::max)(stats_.peakBytesInUse, stats_.bytesInUse);
+      ++stats_.allocations;
+      ++stats_.hits;
+      *size = actual;
+      return buffer;
+    }
+
+    if (limit_ > 0) {
+      makeRoom(actual);
+      if (stats_.bytesInUse + stats_.bytesCached + actual > limit_) {
+        ++stats_.refusals;
+        return nullptr;
+      }
+    }
+
+    // account for the buffer before allocating it so that concurrent
+    // allocations cannot overshoot the limit together
+    stats_.bytesInUse += actual;
+    stats_.peakBytesInUse = (std::max)(stats_.peakBytesInUse, stats_.bytesInUse);
+    ++stats_.allocations;
+  }
+
+  auto* buffer = static_cast<uint8_t*>(std::malloc(actual == 0 ? 1 : actual));
+  if (buffer == nullptr) {
+    Guard g(mutex_);
+    stats_.bytesInUse -= actual;
+    --stats_.allocations;
+    throw std::bad_alloc();
+  }
+  *size = actual;
+  return buffer;
+}
+
+bool TBufferPool::grow(uint32_t borrowed, uint32_t size) {
+  if (size <= borrowed) {
+    return true;
+  }
+  size_t extra = size - borrowed;
+
+  Guard g(mutex_);
+  if (limit_ > 0) {
+    makeRoom(extra);
+    if (stats_.bytesInUse + stats_.bytesCached + extra > limit_) {
+      ++stats_.refusals;
+      return false;
+    }
+  }
+  stats_.bytesInUse += extra;
+  stats_.peakBytesInUse = (std::max)(stats_.peakBytesInUse, stats_.bytesInUse);
+  return true;
+}
+
+void TBufferPool::release(uint8_t* buffer, uint32_t size, uint32_t borrowed) {
+  if (buffer == nullptr) {
+    return;
+  }
+
+  int cls = sizeClass(size);
+  {
+    Guard g(mutex_);
+    stats_.bytesInUse -= borrowed;
+    if (cls >= 0 && (minBufferSize_ << cls) == size
+        && freeLists_[cls].size() < maxCachedPerClass_
+        && (limit_ == 0 || stats_.bytesInUse + stats_.bytesCached + size <= limit_)) {
+      freeLists_[cls].push_back(buffer);
+      stats_.bytesCached += size;
+      return;
+    }
+  }
+  std::free(buffer);
+}
+
+void TBufferPool::makeRoom(size_t need) {
+  // largest buffers first: fewest frees for the most memory
+  for (size_t cls = freeLists_.size(); cls-- > 0;) {
+    std::vector<uint8_t*>& freeList = freeLists_[cls];
+    while (!freeList.empty() && stats_.bytesInUse + stats_.bytesCached + need > limit_) {
+      std::free(freeList.back());
+      freeList.pop_back();
+      stats_.bytesCached -= static_cast<size_t>(minBufferSize_) << cls;
+    }
+  }
+}
+
+void TBufferPool::trim() {
+  Guard g(mutex_);
+  for (auto& freeList : freeLists_) {
+    for (uint8_t* buffer : freeList) {
+      std::free(buffer);
+    }
+    freeList.clear();
+  }
+  stats_.bytesCached = 0;
+}
+
+size_t TBufferPool::getBytesInUse() const {
+  Guard g(mutex_);
+  return stats_.bytesInUse;
+}
+
+TBufferPoolStats TBufferPool::getStats() const {
+  Guard g(mutex_);
+  return stats_;
+}
+}
+}
+} // apache::thrift::server
@@ -0,0 +1,157 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THRIFT_SERVER_TBUFFERPOOL_H_
+#define _THRIFT_SERVER_TBUFFERPOOL_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <thrift/concurrency/Mutex.h>
+
+namespace apache {
+namespace thrift {
+namespace server {
+
+/**
+ * Counters describing a TBufferPool, as returned by TBufferPool::getStats().
+ */
+struct TBufferPoolStats {
+  /// Bytes currently lent out
+  size_t bytesInUse;
+  /// Highest value bytesInUse has reached
+  size_t peakBytesInUse;
+  /// Bytes held in free lists, ready to be lent out again
+  size_t bytesCached;
+  /// Successful calls to allocate()
+  uint64_t allocations;
+  /// Allocations that were satisfied from a free list
+  uint64_t hits;
+  /// Allocations refused because of the memory limit
+  uint64_t refusals;
+};
+
+/**
+ * A pool of malloc()ed buffers in power of two size classes, shared by many
+ * users that each need a buffer only some of the time (for example the
+ * connections of a TNonblockingServer, which only need one while a request
+ * is being read or a response written).
+ *
+ * Released buffers are kept on a free list for their size class and handed
+ * out again, which avoids both holding memory in idle users and the
+ * malloc()/realloc() churn of allocating per use.  Requests larger than the
+ * largest class are allocated exactly and freed on release.
+ *
+ * The memory held by the pool, both lent out and cached, can be capped.  An
+ * allocation that does not fit first releases cached buffers and is refused
+ * if it still does not fit.
+ *
+ * All methods are thread safe.
+ */
+class TBufferPool {
+public:
+  /**
+   * @param limit            the most memory, in bytes, the pool may hold;
+   *                         0 for no limit
+   * @param minBufferSize    the smallest size class; rounded up to a power
+   *                         of two
+   * @param maxCachedSize    the largest size class; larger buffers are not
+   *                         cached
+   * @param maxCachedPerClass the most free buffers kept for each class
+   */
+  explicit TBufferPool(size_t limit = 0,
+                       uint32_t minBufferSize = 1024,
+                       uint32_t maxCachedSize = 16 * 1024 * 1024,
+                       size_t maxCachedPerClass = 1024);
+
+  ~TBufferPool();
+
+  /**
+   * Borrow a buffer of at least *size bytes.
+   *
+   * @param size on input the number of bytes needed, on output the actual
+   *             size of the returned buffer
+   * @return the buffer, or nullptr if the memory limit does not allow it
+   * @throws std::bad_alloc if the system is out of memory
+   */
+  uint8_t* allocate(uint32_t* size);
+
+  /**
+   * Charge the pool for a borrowed buffer that its user grew with realloc().
+   * Cached buffers are released to make room as in allocate().
+   *
+   * @param borrowed the size the pool has been charged for so far
+   * @param size     the current size of the buffer
+   * @return false, leaving the charge unchanged, if the memory limit does
+   *         not allow the growth
+   */
+  bool grow(uint32_t borrowed, uint32_t size);
+
+  /**
+   * Give back a buffer obtained from allocate().  The buffer may have been
+   * grown with realloc() by its user in the meantime.
+   *
+   * @param buffer   the buffer; nullptr is ignored
+   * @param size     the current size of the buffer
+   * @param borrowed the size the pool has been charged for: the size
+   *                 allocate() returned, or the last size passed to grow()
+   */
+  void release(uint8_t* buffer, uint32_t size, uint32_t borrowed);
+
+  void release(uint8_t* buffer, uint32_t size) { release(buffer, size, size); }
+
+  /**
+   * Free every cached buffer.
+   */
+  void trim();
+
+  /**
+   * Get the memory limit, 0 if there is none.
+   */
+  size_t getLimit() const { return limit_; }
+
+  /**
+   * Get the number of bytes currently lent out.
+   */
+  size_t getBytesInUse() const;
+
+  TBufferPoolStats getStats() const;
+
+private:
+  /// Index of the size class for size, or -1 if it is not cached
+  int sizeClass(uint32_t size) const;
+
+  /// Free cached buffers until need more bytes fit under the limit; called
+  /// with mutex_ held.
+  void makeRoom(size_t need);
+
+  const size_t limit_;
+  uint32_t minBufferSize_;
+  const uint32_t maxCachedSize_;
+  const size_t maxCachedPerClass_;
+
+  mutable apache::thrift::concurrency::Mutex mutex_;
+  std::vector<std::vector<uint8_t*> > freeLists_;
+  TBufferPoolStats stats_;
+};
+}
+}
+} // apache::thrift::server
+
+#endif // #ifndef _THRIFT_SERVER_TBUFFERPOOL_H_
@@ -47,6 +47,26 @@ TConnectedClient::TConnectedClient(const shared_ptr<TProcessor>& processor,
 
 TConnectedClient::~TConnectedClient() = default;
 
+void TConnectedClient::reset(const shared_ptr<TProcessor>& processor,
+                             const shared_ptr<TProtocol>& inputProtocol,
+                             const shared_ptr<TProtocol>& outputProtocol,
+                             const shared_ptr<TServerEventHandler>& eventHandler,
+                             const shared_ptr<TTransport>& client) {
+  processor_ = processor;
+  inputProtocol_ = inputProtocol;
+  outputProtocol_ = outputProtocol;
+  eventHandler_ = eventHandler;
+  client_ = client;
+  opaqueContext_ = nullptr;
+}
+
+void TConnectedClient::release() {
+  processor_.reset();
+  eventHandler_.reset();
+  client_.reset();
+  opaqueContext_ = nullptr;
+}
+
 void TConnectedClient::run() {
   if (eventHandler_) {
     opaqueContext_ = eventHandler_->createContext(inputProtocol_, outputProtocol_);
@@ -78,6 +78,32 @@ public:
    */
   void run() override /* override */;
 
+  /**
+   * Reinitialize a finished client for a new connection, taking the same
+   * arguments as the constructor.  Used by servers that pool clients.
+   */
+  void reset(
+      const std::shared_ptr<apache::thrift::TProcessor>& processor,
+      const std::shared_ptr<apache::thrift::protocol::TProtocol>& inputProtocol,
+      const std::shared_ptr<apache::thrift::protocol::TProtocol>& outputProtocol,
+      const std::shared_ptr<apache::thrift::server::TServerEventHandler>& eventHandler,
+      const std::shared_ptr<apache::thrift::transport::TTransport>& client);
+
+  /**
+   * Drop the references a finished client holds to its processor, event
+   * handler and connection.  The protocols are kept so that they can be
+   * reused through reset().
+   */
+  void release();
+
+  std::shared_ptr<apache::thrift::protocol::TProtocol> getInputProtocol() const {
+    return inputProtocol_;
+  }
+
+  std::shared_ptr<apache::thrift::protocol::TProtocol> getOutputProtocol() const {
+    return outputProtocol_;
+  }
+
 protected:
   /**
    * Cleanup after a client.  This happens if the client disconnects,
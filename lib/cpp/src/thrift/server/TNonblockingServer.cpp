@@ -26,16 +26,9 @@
 #include <thrift/transport/PlatformSocket.h>
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 
-#ifdef HAVE_POLL_H
-#include <poll.h>
-#elif HAVE_SYS_POLL_H
-#include <sys/poll.h>
-#elif HAVE_SYS_SELECT_H
-#include <sys/select.h>
-#endif
-
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
@@ -63,6 +56,10 @@
 #include <sched.h>
 #endif
 
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
 #ifndef AF_LOCAL
 #define AF_LOCAL AF_UNIX
 #endif
@@ -148,6 +145,15 @@ private:
   /// Read buffer size
   uint32_t readBufferSize_;
 
+  /// Pool the buffers are borrowed from, if the server has one
+  TBufferPool* bufferPool_;
+
+  /// Size of the read buffer as borrowed from bufferPool_, 0 if none
+  uint32_t readBorrowed_;
+
+  /// Size of the output buffer as borrowed from bufferPool_, 0 if none
+  uint32_t writeBorrowed_;
+
   /// Write buffer
   uint8_t* writeBuffer_;
 
@@ -185,6 +191,48 @@ private:
   /// Thrift call context, if any
   void* connectionContext_;
 
+  /// Admission controller that admitted the request in progress, if any
+  std::shared_ptr<TAdmissionController> admissionController_;
+
+  /// When the request in progress was admitted
+  std::chrono::steady_clock::time_point admitTime_;
+
+  /**
+   * Ask the server's admission controller, if any, whether the request that
+   * was just read may be processed.
+   *
+   * @return true if the request may be processed, false to reject it.
+   */
+  bool admitRequest();
+
+  /**
+   * Report completion of an admitted request to its admission controller.
+   *
+   * @param dropped true if the request did not complete normally.
+   */
+  void releaseAdmission(bool dropped);
+
+  /**
+   * Borrow a read buffer of at least readWant_ bytes from bufferPool_.
+   *
+   * @return false if the pool refused it.
+   */
+  bool borrowReadBuffer();
+
+  /**
+   * Borrow an output buffer from bufferPool_ and install it in
+   * outputTransport_.
+   *
+   * @return false if the pool refused it.
+   */
+  bool borrowWriteBuffer();
+
+  /// Give the read buffer back to bufferPool_, if it was borrowed.
+  void releaseReadBuffer();
+
+  /// Give the output buffer back to bufferPool_, if it was borrowed.
+  void releaseWriteBuffer();
+
   /// Go into read mode
   void setRead() { setFlags(EV_READ | EV_PERSIST); }
 
@@ -217,15 +265,18 @@ public:
               TNonblockingIOThread* ioThread) {
     readBuffer_ = nullptr;
     readBufferSize_ = 0;
+    readBorrowed_ = 0;
+    writeBorrowed_ = 0;
 
     ioThread_ = ioThread;
     server_ = ioThread->getServer();
 
     // Allocate input and output transports these only need to be allocated
     // once per TConnection (they don't need to be reallocated on init() call)
+    // With a buffer pool the output buffer is borrowed per request instead.
     inputTransport_.reset(new TMemoryBuffer(readBuffer_, readBufferSize_));
-    outputTransport_.reset(
-        new TMemoryBuffer(static_cast<uint32_t>(server_->getWriteBufferDefaultSize())));
+    outputTransport_.reset(new TMemoryBuffer(
+        server_->getBufferPool() ? 0 : static_cast<uint32_t>(server_->getWriteBufferDefaultSize())));
 
     tSocket_ =  socket;
 
@@ -374,6 +425,7 @@ private:
 void TNonblockingServer::TConnection::init(TNonblockingIOThread* ioThread) {
   ioThread_ = ioThread;
   server_ = ioThread->getServer();
+  bufferPool_ = server_->getBufferPool().get();
   appState_ = APP_INIT;
   eventFlags_ = 0;
 
@@ -387,6 +439,7 @@ void TNonblockingServer::TConnection::init(TNonblockingIOThread* ioThread) {
 
   socketState_ = SOCKET_RECV_FRAMING;
   callsForResize_ = 0;
+  admissionController_.reset();
 
   // get input/transports
   factoryInputTransport_ = server_->getInputTransportFactory()->getTransport(inputTransport_);
@@ -418,6 +471,28 @@ void TNonblockingServer::TConnection::setSocket(std::shared_ptr<TSocket> socket)
   tSocket_ = socket;
 }
 
+bool TNonblockingServer::TConnection::admitRequest() {
+  std::shared_ptr<TAdmissionController> controller = server_->getAdmissionController();
+  if (!controller) {
+    return true;
+  }
+  if (!controller->tryAcquire()) {
+    return false;
+  }
+  admissionController_ = controller;
+  admitTime_ = std::chrono::steady_clock::now();
+  return true;
+}
+
+void TNonblockingServer::TConnection::releaseAdmission(bool dropped) {
+  if (admissionController_) {
+    admissionController_->release(std::chrono::duration_cast<std::chrono::microseconds>(
+                                      std::chrono::steady_clock::now() - admitTime_).count(),
+                                  dropped);
+    admissionController_.reset();
+  }
+}
+
 void TNonblockingServer::TConnection::workSocket() {
   int got = 0, left = 0, sent = 0;
   uint32_t fetch = 0;
@@ -593,6 +668,12 @@ void TNonblockingServer::TConnection::transition() {
   case APP_READ_REQUEST:
     // We are done reading the request, package the read buffer into transport
     // and get back some data from the dispatch function
+    if (bufferPool_ && !borrowWriteBuffer()) {
+      GlobalOutput("TNonblockingServer: buffer pool exhausted, closing connection");
+      server_->bufferPoolExhausted();
+      close();
+      return;
+    }
     if (server_->getHeaderTransport()) {
       inputTransport_->resetBuffer(readBuffer_, readBufferPos_);
       outputTransport_->resetBuffer();
@@ -610,7 +691,18 @@ void TNonblockingServer::TConnection::transition() {
 
     server_->incrementActiveProcessors();
 
-    if (server_->isThreadPoolProcessing()) {
+    if (!admitRequest()) {
+      // Overloaded: answer with an exception right here on the IO thread
+      // rather than queueing more work for the processor.
+      try {
+        TAdmissionController::rejectRequest(inputProtocol_.get(), outputProtocol_.get());
+      } catch (const TException& tx) {
+        GlobalOutput.printf("TNonblockingServer: failed to reject request: %s", tx.what());
+        server_->decrementActiveProcessors();
+        close();
+        return;
+      }
+    } else if (server_->isThreadPoolProcessing()) {
       // We are setting up a Task to do this work and we will wait on it
 
       // Create task and dispatch to the thread manager
@@ -678,8 +770,24 @@ void TNonblockingServer::TConnection::transition() {
     // the writeBuffer_ for actual writing by the libevent thread
 
     server_->decrementActiveProcessors();
+    releaseAdmission(false);
     // Get the result of the operation
     outputTransport_->getBuffer(&writeBuffer_, &writeBufferSize_);
+    // The request has been consumed
+    releaseReadBuffer();
+
+    // A response that outgrew the borrowed buffer has had it reallocated;
+    // charge the pool for the growth, or drop the response if it is too big
+    if (writeBorrowed_ != 0) {
+      uint32_t grown = outputTransport_->getBufferSize();
+      if (!bufferPool_->grow(writeBorrowed_, grown)) {
+        GlobalOutput("TNonblockingServer: buffer pool exhausted, closing connection");
+        server_->bufferPoolExhausted();
+        close();
+        return;
+      }
+      writeBorrowed_ = (std::max)(writeBorrowed_, grown);
+    }
 
     // If the function call generated return data, then move into the send
     // state and get going
@@ -727,6 +835,7 @@ void TNonblockingServer::TConnection::transition() {
     writeBuffer_ = nullptr;
     writeBufferPos_ = 0;
     writeBufferSize_ = 0;
+    releaseWriteBuffer();
 
     // Into read4 state we go
     socketState_ = SOCKET_RECV_FRAMING;
@@ -742,9 +851,16 @@ void TNonblockingServer::TConnection::transition() {
   case APP_READ_FRAME_SIZE:
     readWant_ += 4;
 
-    // We just read the request length
-    // Double the buffer size until it is big enough
-    if (readWant_ > readBufferSize_) {
+    if (bufferPool_) {
+      if (!borrowReadBuffer()) {
+        GlobalOutput("TNonblockingServer: buffer pool exhausted, closing connection");
+        server_->bufferPoolExhausted();
+        close();
+        return;
+      }
+    } else if (readWant_ > readBufferSize_) {
+      // We just read the request length
+      // Double the buffer size until it is big enough
       if (readBufferSize_ == 0) {
         readBufferSize_ = 1;
       }
@@ -843,6 +959,7 @@ void TNonblockingServer::TConnection::setFlags(short eventFlags) {
  */
 void TNonblockingServer::TConnection::close() {
   setIdle();
+  releaseAdmission(true);
 
   if (serverEventHandler_) {
     serverEventHandler_->deleteContext(connectionContext_, inputProtocol_, outputProtocol_);
@@ -859,11 +976,19 @@ void TNonblockingServer::TConnection::close() {
   // release processor and handler
   processor_.reset();
 
+  releaseReadBuffer();
+  releaseWriteBuffer();
+
   // Give this object back to the server that owns it
   server_->returnConnection(this);
 }
 
 void TNonblockingServer::TConnection::checkIdleBufferMemLimit(size_t readLimit, size_t writeLimit) {
+  if (bufferPool_) {
+    // pooled buffers are given back after every request anyway
+    return;
+  }
+
   if (readLimit > 0 && readBufferSize_ > readLimit) {
     free(readBuffer_);
     readBuffer_ = nullptr;
@@ -877,6 +1002,51 @@ void TNonblockingServer::TConnection::checkIdleBufferMemLimit(size_t readLimit,
   }
 }
 
+bool TNonblockingServer::TConnection::borrowReadBuffer() {
+  assert(readBorrowed_ == 0);
+  uint32_t size = readWant_;
+  readBuffer_ = bufferPool_->allocate(&size);
+  if (readBuffer_ == nullptr) {
+    return false;
+  }
+  readBufferSize_ = size;
+  readBorrowed_ = size;
+  return true;
+}
+
+bool TNonblockingServer::TConnection::borrowWriteBuffer() {
+  assert(writeBorrowed_ == 0);
+  uint32_t size = static_cast<uint32_t>(server_->getWriteBufferDefaultSize());
+  uint8_t* buffer = bufferPool_->allocate(&size);
+  if (buffer == nullptr) {
+    return false;
+  }
+  // the buffer holds no data yet, so reset it after taking ownership
+  outputTransport_->resetBuffer(buffer, size, TMemoryBuffer::TAKE_OWNERSHIP);
+  outputTransport_->resetBuffer();
+  writeBorrowed_ = size;
+  return true;
+}
+
+void TNonblockingServer::TConnection::releaseReadBuffer() {
+  if (readBorrowed_ != 0) {
+    inputTransport_->resetBuffer(nullptr, 0);
+    bufferPool_->release(readBuffer_, readBufferSize_, readBorrowed_);
+    readBuffer_ = nullptr;
+    readBufferSize_ = 0;
+    readBorrowed_ = 0;
+  }
+}
+
+void TNonblockingServer::TConnection::releaseWriteBuffer() {
+  if (writeBorrowed_ != 0) {
+    uint32_t size;
+    uint8_t* buffer = outputTransport_->releaseBuffer(&size);
+    bufferPool_->release(buffer, size, writeBorrowed_);
+    writeBorrowed_ = 0;
+  }
+}
+
 TNonblockingServer::~TNonblockingServer() {
   // Close any active connections (moves them to the idle connection stack)
   while (activeConnections_.size()) {
@@ -1036,7 +1206,12 @@ void TNonblockingServer::setThreadManager(std::shared_ptr<ThreadManager> threadM
 
 bool TNonblockingServer::serverOverloaded() {
   size_t activeConnections = numTConnections_ - connectionStack_.size();
-  if (numActiveProcessors_ > maxActiveProcessors_ || activeConnections > maxConnections_) {
+  if (bufferPoolExhausted_ && bufferPool_
+      && bufferPool_->getBytesInUse() <= overloadHysteresis_ * bufferPool_->getLimit()) {
+    bufferPoolExhausted_ = false;
+  }
+  if (numActiveProcessors_ > maxActiveProcessors_ || activeConnections > maxConnections_
+      || bufferPoolExhausted_) {
     if (!overloaded_) {
       GlobalOutput.printf("TNonblockingServer: overload condition begun.");
       overloaded_ = true;
@@ -1172,7 +1347,9 @@ TNonblockingIOThread::TNonblockingIOThread(TNonblockingServer* server,
     eventBase_(nullptr),
     ownEventBase_(false),
     serverEvent_{},
-    notificationEvent_{} {
+    notificationEvent_{},
+    notifications_(nullptr),
+    stopRequested_(false) {
   notificationPipeFDs_[0] = -1;
   notificationPipeFDs_[1] = -1;
 }
@@ -1193,6 +1370,9 @@ TNonblockingIOThread::~TNonblockingIOThread() {
     listenSocket_ = THRIFT_INVALID_SOCKET;
   }
 
+  if (notificationPipeFDs_[1] == notificationPipeFDs_[0]) {
+    notificationPipeFDs_[1] = THRIFT_INVALID_SOCKET;
+  }
   for (auto notificationPipeFD : notificationPipeFDs_) {
     if (notificationPipeFD >= 0) {
       if (0 != ::THRIFT_CLOSESOCKET(notificationPipeFD)) {
@@ -1202,9 +1382,26 @@ TNonblockingIOThread::~TNonblockingIOThread() {
       notificationPipeFD = THRIFT_INVALID_SOCKET;
     }
   }
+
+  // anything still queued belongs to connections the server is tearing down
+  Notification* pending = notifications_.exchange(nullptr);
+  while (pending != nullptr) {
+    Notification* next = pending->next;
+    delete pending;
+    pending = next;
+  }
 }
 
 void TNonblockingIOThread::createNotificationPipe() {
+#ifdef HAVE_SYS_EVENTFD_H
+  int efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (efd >= 0) {
+    notificationPipeFDs_[0] = efd;
+    notificationPipeFDs_[1] = efd;
+    return;
+  }
+  GlobalOutput.perror("TNonblockingServer::createNotificationPipe eventfd ", errno);
+#endif
   if (evutil_socketpair(AF_LOCAL, SOCK_STREAM, 0, notificationPipeFDs_) == -1) {
     GlobalOutput.perror("TNonblockingServer::createNotificationPipe ", EVUTIL_SOCKET_ERROR());
     throw TException("can't create notification pipe");
@@ -1289,88 +1486,94 @@ void TNonblockingIOThread::registerEvents() {
         "event_add() failed on task-done notification event");
   }
   GlobalOutput.printf("TNonblocking: IO thread #%d registered for notify.", number_);
+
+  // stop() may have been called before there was a doorbell to ring
+  if (stopRequested_.load() && !ringDoorbell()) {
+    throw TException("TNonblockingServer::serve(): failed to ring task-done doorbell");
+  }
 }
 
 bool TNonblockingIOThread::notify(TNonblockingServer::TConnection* conn) {
-  auto fd = getNotificationSendFD();
-  if (fd < 0) {
+  if (conn == nullptr) {
+    // this is the command to stop our thread
+    stopRequested_.store(true);
+    return getNotificationSendFD() < 0 || ringDoorbell();
+  }
+  if (getNotificationSendFD() < 0) {
     return false;
   }
 
-  int ret = -1;
-  long kSize = sizeof(conn);
-  const char * pos = (const char *)const_cast_sockopt(&conn);
-
-#if defined(HAVE_POLL_H) || defined(HAVE_SYS_POLL_H)
-  struct pollfd pfd = {fd, POLLOUT, 0};
-
-  while (kSize > 0) {
-    pfd.revents = 0;
-    ret = poll(&pfd, 1, -1);
-    if (ret < 0) {
-      return false;
-    } else if (ret == 0) {
-      continue;
-    }
-
-    if (pfd.revents & POLLHUP || pfd.revents & POLLERR) {
-      ::THRIFT_CLOSESOCKET(fd);
-      return false;
-    }
-
-    if (pfd.revents & POLLOUT) {
-      ret = send(fd, pos, kSize, 0);
-      if (ret < 0) {
-        if (errno == EAGAIN) {
-          continue;
-        }
+  auto* notification = new Notification;
+  notification->connection = conn;
+  Notification* head = notifications_.load(std::memory_order_relaxed);
+  do {
+    notification->next = head;
+  } while (!notifications_.compare_exchange_weak(head,
+                                                 notification,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed));
+
+  // The IO thread takes the whole list per wakeup, so only the push that
+  // finds it empty needs to wake it up.  Once published the node may already
+  // have been handled and deleted, so it must not be touched again.
+  return head != nullptr || ringDoorbell() || !withdraw(conn);
+}
 
-        ::THRIFT_CLOSESOCKET(fd);
-        return false;
+bool TNonblockingIOThread::withdraw(TNonblockingServer::TConnection* conn) {
+  Notification* pending = notifications_.exchange(nullptr, std::memory_order_acquire);
+  Notification* kept = nullptr;
+  Notification* keptTail = nullptr;
+  bool found = false;
+  while (pending != nullptr) {
+    Notification* next = pending->next;
+    if (!found && pending->connection == conn) {
+      delete pending;
+      found = true;
+    } else {
+      pending->next = nullptr;
+      if (keptTail == nullptr) {
+        kept = pending;
+      } else {
+        keptTail->next = pending;
       }
-
-      kSize -= ret;
-      pos += ret;
+      keptTail = pending;
     }
+    pending = next;
   }
-#else
-  fd_set wfds, efds;
-
-  while (kSize > 0) {
-    FD_ZERO(&wfds);
-    FD_ZERO(&efds);
-    FD_SET(fd, &wfds);
-    FD_SET(fd, &efds);
-    ret = select(static_cast<int>(fd + 1), nullptr, &wfds, &efds, nullptr);
-    if (ret < 0) {
-      return false;
-    } else if (ret == 0) {
-      continue;
-    }
 
-    if (FD_ISSET(fd, &efds)) {
-      ::THRIFT_CLOSESOCKET(fd);
-      return false;
+  // Put back what other threads queued; they rely on the doorbell as well,
+  // so ring it again in case the failure was transient.
+  if (kept != nullptr) {
+    Notification* head = notifications_.load(std::memory_order_relaxed);
+    do {
+      keptTail->next = head;
+    } while (!notifications_.compare_exchange_weak(head,
+                                                   kept,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed));
+    if (head == nullptr) {
+      ringDoorbell();
     }
+  }
+  return found;
+}
 
-    if (FD_ISSET(fd, &wfds)) {
-      ret = send(fd, pos, kSize, 0);
-      if (ret < 0) {
-        if (errno == EAGAIN) {
-          continue;
-        }
-
-        ::THRIFT_CLOSESOCKET(fd);
-        return false;
-      }
-
-      kSize -= ret;
-      pos += ret;
-    }
+bool TNonblockingIOThread::ringDoorbell() {
+  auto fd = getNotificationSendFD();
+#ifdef HAVE_SYS_EVENTFD_H
+  if (fd == getNotificationRecvFD()) {
+    uint64_t one = 1;
+    // the counter cannot realistically overflow, so EAGAIN cannot happen
+    return ::write(fd, &one, sizeof(one)) == static_cast<ssize_t>(sizeof(one));
   }
 #endif
-
-  return true;
+  const char one = 1;
+  if (send(fd, &one, 1, 0) == 1) {
+    return true;
+  }
+  // a full socket buffer means the IO thread has wakeups pending anyway
+  return THRIFT_GET_SOCKET_ERROR == THRIFT_EWOULDBLOCK
+         || THRIFT_GET_SOCKET_ERROR == THRIFT_EAGAIN;
 }
 
 /* static */
@@ -1379,37 +1582,56 @@ void TNonblockingIOThread::notifyHandler(evutil_socket_t fd, short which, void*
   assert(ioThread);
   (void)which;
 
-  while (true) {
-    TNonblockingServer::TConnection* connection = nullptr;
-    const int kSize = sizeof(connection);
-    long nBytes = recv(fd, cast_sockopt(&connection), kSize, 0);
-    if (nBytes == kSize) {
-      if (connection == nullptr) {
-        // this is the command to stop our thread, exit the handler!
-        ioThread->breakLoop(false);
-        return;
-      }
-      connection->transition();
-    } else if (nBytes > 0) {
-      // throw away these bytes and hope that next time we get a solid read
-      GlobalOutput.printf("notifyHandler: Bad read of %d bytes, wanted %d", nBytes, kSize);
+  // Clear the doorbell before taking the queue: a push that lands after the
+  // exchange below rings it again, so no notification can be missed.
+#ifdef HAVE_SYS_EVENTFD_H
+  if (fd == ioThread->getNotificationSendFD()) {
+    // one read resets the eventfd counter
+    uint64_t count;
+    if (::read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+      GlobalOutput.perror("TNonblocking: notifyHandler read() failed: ", errno);
       ioThread->breakLoop(true);
       return;
-    } else if (nBytes == 0) {
+    }
+  } else
+#endif
+  {
+    char drain[64];
+    long nBytes;
+    while ((nBytes = recv(fd, cast_sockopt(drain), sizeof(drain), 0)) > 0) {
+    }
+    if (nBytes == 0) {
       GlobalOutput.printf("notifyHandler: Notify socket closed!");
       ioThread->breakLoop(false);
-      // exit the loop
-      break;
-    } else { // nBytes < 0
-      if (THRIFT_GET_SOCKET_ERROR != THRIFT_EWOULDBLOCK
-          && THRIFT_GET_SOCKET_ERROR != THRIFT_EAGAIN) {
-        GlobalOutput.perror("TNonblocking: notifyHandler read() failed: ", THRIFT_GET_SOCKET_ERROR);
-        ioThread->breakLoop(true);
-        return;
-      }
-      // exit the loop
-      break;
+      return;
     }
+    if (THRIFT_GET_SOCKET_ERROR != THRIFT_EWOULDBLOCK
+        && THRIFT_GET_SOCKET_ERROR != THRIFT_EAGAIN) {
+      GlobalOutput.perror("TNonblocking: notifyHandler read() failed: ", THRIFT_GET_SOCKET_ERROR);
+      ioThread->breakLoop(true);
+      return;
+    }
+  }
+
+  // Reverse the list so connections are handled in the order they finished
+  Notification* pending = ioThread->notifications_.exchange(nullptr, std::memory_order_acquire);
+  Notification* ordered = nullptr;
+  while (pending != nullptr) {
+    Notification* next = pending->next;
+    pending->next = ordered;
+    ordered = pending;
+    pending = next;
+  }
+  while (ordered != nullptr) {
+    Notification* next = ordered->next;
+    TNonblockingServer::TConnection* connection = ordered->connection;
+    delete ordered;
+    ordered = next;
+    connection->transition();
+  }
+
+  if (ioThread->stopRequested_.exchange(false)) {
+    ioThread->breakLoop(false);
   }
 }
 
@@ -21,7 +21,10 @@
 #define _THRIFT_SERVER_TNONBLOCKINGSERVER_H_ 1
 
 #include <thrift/Thrift.h>
+#include <atomic>
 #include <memory>
+#include <thrift/server/TAdmissionController.h>
+#include <thrift/server/TBufferPool.h>
 #include <thrift/server/TServer.h>
 #include <thrift/transport/PlatformSocket.h>
 #include <thrift/transport/TBufferTransports.h>
@@ -98,6 +101,14 @@ inline SOCKOPT_CAST_T* cast_sockopt(T* v) {
  * operates a set of IO threads (by default only one). It assumes that
  * all incoming requests are framed with a 4 byte length indicator and
  * writes out responses using the same framing.
+ *
+ * Each request is read from, and its response written to, a TMemoryBuffer.
+ * With protocol factories specialized on that transport, such as
+ * TBinaryProtocolFactoryT<TMemoryBuffer>, and a processor generated with the
+ * cpp:templates option and instantiated for the same protocol, such as
+ * ServiceProcessorT<TBinaryProtocolT<TMemoryBuffer> >, requests are decoded,
+ * dispatched and encoded without virtual calls into the protocol or the
+ * transport.
  */
 
 /// Overload condition actions.
@@ -207,6 +218,9 @@ private:
   /// Action to take when we're overloaded.
   TOverloadAction overloadAction_;
 
+  /// Optional controller deciding which requests may be processed.
+  std::shared_ptr<TAdmissionController> admissionController_;
+
   /**
    * The write buffer is initialized (and when idleWriteBufferLimit_ is checked
    * and found to be exceeded, reinitialized) to this size.
@@ -236,6 +250,15 @@ private:
    */
   int32_t resizeBufferEveryN_;
 
+  /// Optional pool that TConnection read and write buffers are borrowed from.
+  std::shared_ptr<TBufferPool> bufferPool_;
+
+  /**
+   * Set when bufferPool_ refused a buffer; cleared by serverOverloaded() once
+   * the pool is back under the hysteresis fraction of its limit.
+   */
+  std::atomic<bool> bufferPoolExhausted_;
+
   /// Set if we are currently in an overloaded state.
   bool overloaded_;
 
@@ -294,6 +317,7 @@ private:
     idleReadBufferLimit_ = IDLE_READ_BUFFER_LIMIT;
     idleWriteBufferLimit_ = IDLE_WRITE_BUFFER_LIMIT;
     resizeBufferEveryN_ = RESIZE_BUFFER_EVERY_N;
+    bufferPoolExhausted_ = false;
     overloaded_ = false;
     nConnectionsDropped_ = 0;
     nTotalConnectionsDropped_ = 0;
@@ -497,6 +521,30 @@ public:
     maxActiveProcessors_ = maxActiveProcessors;
   }
 
+  /**
+   * Get the admission controller applied to incoming requests, if any.
+   *
+   * @return the admission controller or an empty pointer.
+   */
+  std::shared_ptr<TAdmissionController> getAdmissionController() const {
+    Guard g(connMutex_);
+    return admissionController_;
+  }
+
+  /**
+   * Set an admission controller that adapts the number of requests
+   * processed at once to the observed latency.  A request that is not
+   * admitted is answered with a TApplicationException directly on the IO
+   * thread, without being handed to the processor or the thread pool.
+   * Pass an empty pointer to disable admission control.
+   *
+   * @param controller the admission controller to use.
+   */
+  void setAdmissionController(const std::shared_ptr<TAdmissionController>& controller) {
+    Guard g(connMutex_);
+    admissionController_ = controller;
+  }
+
   /**
    * Get the maximum allowed frame size.
    *
@@ -566,7 +614,9 @@ public:
    * This function checks the maximums for open connections and connections
    * currently in processing, and sets an overload condition if they are
    * exceeded.  The overload will persist until both values are below the
-   * current hysteresis fraction of their maximums.
+   * current hysteresis fraction of their maximums.  A buffer pool that has
+   * refused a buffer because of its memory limit also counts as overload,
+   * until the memory in use drops below the same fraction of the limit.
    *
    * @return true if an overload condition exists, false if not.
    */
@@ -648,6 +698,37 @@ public:
    */
   void setIdleWriteBufferLimit(size_t limit) { idleWriteBufferLimit_ = limit; }
 
+  /**
+   * Get the pool connection buffers are borrowed from, if any.
+   *
+   * @return the buffer pool or an empty pointer.
+   */
+  std::shared_ptr<TBufferPool> getBufferPool() const { return bufferPool_; }
+
+  /**
+   * Have connections borrow their read and write buffers from a pool shared
+   * by the whole server, instead of each keeping buffers of its own.  A
+   * connection then holds a read buffer only from the moment a frame header
+   * arrives until the request has been processed, and a write buffer only
+   * until the response has been sent; idle connections hold none, and the
+   * idle buffer limits and resizeBufferEveryN have no effect.
+   *
+   * If the pool has a memory limit, a connection whose buffer is refused is
+   * closed and the server enters the overload state (see serverOverloaded()).
+   * The same happens to a connection whose response grew its write buffer
+   * past what the limit allows; the growth is only charged once the response
+   * is complete, so the limit can be exceeded by the responses being built.
+   * Must be called before serve().
+   *
+   * @param pool the buffer pool, or an empty pointer to disable pooling.
+   */
+  void setBufferPool(const std::shared_ptr<TBufferPool>& pool) { bufferPool_ = pool; }
+
+  /**
+   * Note that the buffer pool refused a connection buffer.
+   */
+  void bufferPoolExhausted() { bufferPoolExhausted_ = true; }
+
   /**
    * Get # of calls made between buffer size checks.  0 means disabled.
    *
@@ -755,7 +836,8 @@ public:
   // only be called after the thread has been started.
   Thread::id_t getThreadId() const { return threadId_; }
 
-  // Returns the send-fd for task complete notifications.
+  // Returns the send-fd for task complete notifications.  This is the same
+  // descriptor as the read-fd when an eventfd is used.
   evutil_socket_t getNotificationSendFD() const { return notificationPipeFDs_[1]; }
 
   // Returns the read-fd for task complete notifications.
@@ -785,9 +867,9 @@ public:
 private:
   /**
    * C-callable event handler for signaling task completion.  Provides a
-   * callback that libevent can understand that will read a connection
-   * object's address from a pipe and call connection->transition() for
-   * that object.
+   * callback that libevent can understand that will clear the doorbell,
+   * take every queued connection and call connection->transition() for
+   * each of them in the order they were queued.
    *
    * @param fd the descriptor the event occurred on.
    */
@@ -808,9 +890,18 @@ private:
   /// Exits the loop ASAP in case of shutdown or error.
   void breakLoop(bool error);
 
-  /// Create the pipe used to notify I/O process of task completion.
+  /// Create the eventfd (or, where there is none, the socket pair) used as
+  /// the doorbell for task completion notifications.
   void createNotificationPipe();
 
+  /// Wake up the event loop.  Returns false if the doorbell is broken.
+  bool ringDoorbell();
+
+  /// Takes conn's notification back out of the queue after the doorbell
+  /// could not be rung for it, since the caller is about to close conn.
+  /// Returns false if the IO thread has already taken it.
+  bool withdraw(TNonblockingServer::TConnection* conn);
+
   /// Unregisters our events for notification and listen sockets.
   void cleanupEvents();
 
@@ -846,9 +937,25 @@ private:
   /// Used with eventBase_ for task completion notification
   struct event notificationEvent_;
 
-  /// File descriptors for pipe used for task completion notification.
+  /// File descriptors for the task completion doorbell; both are the same
+  /// descriptor when an eventfd is used.
   evutil_socket_t notificationPipeFDs_[2];
 
+  /// A connection waiting to be transitioned by this thread.
+  struct Notification {
+    TNonblockingServer::TConnection* connection;
+    Notification* next;
+  };
+
+  /// Connections handed back by notify(), most recent first.  Producers push
+  /// with a CAS; the IO thread takes the whole list at once, and only the
+  /// push that finds the list empty rings the doorbell.
+  std::atomic<Notification*> notifications_;
+
+  /// Set by notify(nullptr); checked after each batch of notifications and
+  /// before entering the event loop so that an early stop() is not lost.
+  std::atomic<bool> stopRequested_;
+
   /// Actual IO Thread
   std::shared_ptr<Thread> thread_;
 };
@@ -18,6 +18,7 @@
  */
 
 #include <algorithm>
+#include <memory>
 #include <stdexcept>
 #include <stdint.h>
 #include <thrift/server/TServerFramework.h>
@@ -44,7 +45,8 @@ TServerFramework::TServerFramework(const shared_ptr<TProcessorFactory>& processo
   : TServer(processorFactory, serverTransport, transportFactory, protocolFactory),
     clients_(0),
     hwm_(0),
-    limit_(INT64_MAX) {
+    limit_(INT64_MAX),
+    connectionPoolSize_(0) {
 }
 
 TServerFramework::TServerFramework(const shared_ptr<TProcessor>& processor,
@@ -54,7 +56,8 @@ TServerFramework::TServerFramework(const shared_ptr<TProcessor>& processor,
   : TServer(processor, serverTransport, transportFactory, protocolFactory),
     clients_(0),
     hwm_(0),
-    limit_(INT64_MAX) {
+    limit_(INT64_MAX),
+    connectionPoolSize_(0) {
 }
 
 TServerFramework::TServerFramework(const shared_ptr<TProcessorFactory>& processorFactory,
@@ -71,7 +74,8 @@ TServerFramework::TServerFramework(const shared_ptr<TProcessorFactory>& processo
             outputProtocolFactory),
     clients_(0),
     hwm_(0),
-    limit_(INT64_MAX) {
+    limit_(INT64_MAX),
+    connectionPoolSize_(0) {
 }
 
 TServerFramework::TServerFramework(const shared_ptr<TProcessor>& processor,
@@ -88,10 +92,15 @@ TServerFramework::TServerFramework(const shared_ptr<TProcessor>& processor,
             outputProtocolFactory),
     clients_(0),
     hwm_(0),
-    limit_(INT64_MAX) {
+    limit_(INT64_MAX),
+    connectionPoolSize_(0) {
 }
 
-TServerFramework::~TServerFramework() = default;
+TServerFramework::~TServerFramework() {
+  for (TConnectedClient* pClient : connectionPool_) {
+    delete pClient;
+  }
+}
 
 template <typename T>
 static void releaseOneDescriptor(const string& name, T& pTransport) {
@@ -144,22 +153,57 @@ void TServerFramework::serve() {
 
       client = serverTransport_->accept();
 
-      inputTransport = inputTransportFactory_->getTransport(client);
-      outputTransport = outputTransportFactory_->getTransport(client);
-      if (!outputProtocolFactory_) {
-        inputProtocol = inputProtocolFactory_->getProtocol(inputTransport, outputTransport);
-        outputProtocol = inputProtocol;
+      // THeaderProtocol wraps its own transport, so only plain protocol
+      // pairs are reused.
+      std::unique_ptr<TConnectedClient> pooled(outputProtocolFactory_ ? takePooledClient()
+                                                                      : nullptr);
+      if (pooled) {
+        inputProtocol = pooled->getInputProtocol();
+        outputProtocol = pooled->getOutputProtocol();
+        inputTransport = inputProtocol->getTransport();
+        outputTransport = outputProtocol->getTransport();
+        if (!inputTransportFactory_->resetTransport(inputTransport, client)) {
+          inputTransport = inputTransportFactory_->getTransport(client);
+        }
+        if (!outputTransportFactory_->resetTransport(outputTransport, client)) {
+          outputTransport = outputTransportFactory_->getTransport(client);
+        }
+        if (!inputProtocolFactory_->resetProtocol(inputProtocol, inputTransport)) {
+          inputProtocol = inputProtocolFactory_->getProtocol(inputTransport);
+        }
+        if (!outputProtocolFactory_->resetProtocol(outputProtocol, outputTransport)) {
+          outputProtocol = outputProtocolFactory_->getProtocol(outputTransport);
+        }
       } else {
-        inputProtocol = inputProtocolFactory_->getProtocol(inputTransport);
-        outputProtocol = outputProtocolFactory_->getProtocol(outputTransport);
+        inputTransport = inputTransportFactory_->getTransport(client);
+        outputTransport = outputTransportFactory_->getTransport(client);
+        if (!outputProtocolFactory_) {
+          inputProtocol = inputProtocolFactory_->getProtocol(inputTransport, outputTransport);
+          outputProtocol = inputProtocol;
+        } else {
+          inputProtocol = inputProtocolFactory_->getProtocol(inputTransport);
+          outputProtocol = outputProtocolFactory_->getProtocol(outputTransport);
+        }
+      }
+
+      shared_ptr<TProcessor> processor = getProcessor(inputProtocol, outputProtocol, client);
+      shared_ptr<TAdmissionController> admissionController = getAdmissionController();
+      if (admissionController) {
+        processor.reset(new TAdmissionControlProcessor(processor, admissionController));
+      }
+
+      if (pooled) {
+        pooled->reset(processor, inputProtocol, outputProtocol, eventHandler_, client);
+      } else {
+        pooled.reset(new TConnectedClient(processor,
+                                          inputProtocol,
+                                          outputProtocol,
+                                          eventHandler_,
+                                          client));
       }
 
       newlyConnectedClient(shared_ptr<TConnectedClient>(
-          new TConnectedClient(getProcessor(inputProtocol, outputProtocol, client),
-                               inputProtocol,
-                               outputProtocol,
-                               eventHandler_,
-                               client),
+          pooled.release(),
           bind(&TServerFramework::disposeConnectedClient, this, std::placeholders::_1)));
 
     } catch (TTransportException& ttx) {
@@ -213,6 +257,36 @@ void TServerFramework::setConcurrentClientLimit(int64_t newLimit) {
   }
 }
 
+shared_ptr<TAdmissionController> TServerFramework::getAdmissionController() const {
+  Synchronized sync(mon_);
+  return admissionController_;
+}
+
+void TServerFramework::setAdmissionController(const shared_ptr<TAdmissionController>& controller) {
+  Synchronized sync(mon_);
+  admissionController_ = controller;
+}
+
+size_t TServerFramework::getConnectionPoolSize() const {
+  Synchronized sync(mon_);
+  return connectionPoolSize_;
+}
+
+void TServerFramework::setConnectionPoolSize(size_t poolSize) {
+  std::vector<TConnectedClient*> excess;
+  {
+    Synchronized sync(mon_);
+    connectionPoolSize_ = poolSize;
+    while (connectionPool_.size() > connectionPoolSize_) {
+      excess.push_back(connectionPool_.back());
+      connectionPool_.pop_back();
+    }
+  }
+  for (TConnectedClient* pClient : excess) {
+    delete pClient;
+  }
+}
+
 void TServerFramework::stop() {
   // Order is important because serve() releases serverTransport_ when it is
   // interrupted, which closes the socket that interruptChildren uses.
@@ -232,6 +306,15 @@ void TServerFramework::newlyConnectedClient(const shared_ptr<TConnectedClient>&
 
 void TServerFramework::disposeConnectedClient(TConnectedClient* pClient) {
   onClientDisconnected(pClient);
+  pClient->release();
+
+  {
+    Synchronized sync(mon_);
+    if (connectionPool_.size() < connectionPoolSize_) {
+      connectionPool_.push_back(pClient);
+      pClient = nullptr;
+    }
+  }
   delete pClient;
 
   Synchronized sync(mon_);
@@ -240,6 +323,16 @@ void TServerFramework::disposeConnectedClient(TConnectedClient* pClient) {
   }
 }
 
+TConnectedClient* TServerFramework::takePooledClient() {
+  Synchronized sync(mon_);
+  if (connectionPool_.empty()) {
+    return nullptr;
+  }
+  TConnectedClient* pClient = connectionPool_.back();
+  connectionPool_.pop_back();
+  return pClient;
+}
+
 }
 }
 } // apache::thrift::server
@@ -22,8 +22,10 @@
 
 #include <memory>
 #include <stdint.h>
+#include <vector>
 #include <thrift/TProcessor.h>
 #include <thrift/concurrency/Monitor.h>
+#include <thrift/server/TAdmissionController.h>
 #include <thrift/server/TConnectedClient.h>
 #include <thrift/server/TServer.h>
 #include <thrift/transport/TServerTransport.h>
@@ -121,6 +123,40 @@ public:
    */
   virtual void setConcurrentClientLimit(int64_t newLimit);
 
+  /**
+   * Get the admission controller applied to requests, if any.
+   * \returns the admission controller or an empty pointer
+   */
+  virtual std::shared_ptr<TAdmissionController> getAdmissionController() const;
+
+  /**
+   * Set an admission controller that limits the number of requests being
+   * processed at once, independently of the number of connected clients.
+   * Requests that are not admitted are answered with a
+   * TApplicationException.  Only clients accepted after this call are
+   * affected.  Pass an empty pointer to disable admission control.
+   * \param[in]  controller  the admission controller to use
+   */
+  virtual void setAdmissionController(const std::shared_ptr<TAdmissionController>& controller);
+
+  /**
+   * Get the number of disconnected clients kept for reuse.
+   * \returns the connection pool size
+   */
+  virtual size_t getConnectionPoolSize() const;
+
+  /**
+   * Keep up to poolSize disconnected clients, along with their protocol and
+   * transport objects, and reuse them for new connections instead of
+   * allocating new ones.  Protocols and transports are only reused when
+   * their factories support it (see TProtocolFactory::resetProtocol and
+   * TTransportFactory::resetTransport), and never when the server uses
+   * THeaderProtocol (no output protocol factory).
+   * The default value used if this is not called is 0, which disables pooling.
+   * \param[in]  poolSize  the number of clients to keep
+   */
+  virtual void setConnectionPoolSize(size_t poolSize);
+
 protected:
   /**
    * A client has connected.  The implementation is responsible for managing the
@@ -157,6 +193,11 @@ private:
    */
   void disposeConnectedClient(TConnectedClient* pClient);
 
+  /**
+   * Take a client from the connection pool, or nullptr if it is empty.
+   */
+  TConnectedClient* takePooledClient();
+
   /**
    * Monitor for limiting the number of concurrent clients.
    */
@@ -176,6 +217,21 @@ private:
    * The limit on the number of concurrent clients.
    */
   int64_t limit_;
+
+  /**
+   * Optional admission controller wrapped around each client's processor.
+   */
+  std::shared_ptr<TAdmissionController> admissionController_;
+
+  /**
+   * The maximum number of disconnected clients kept for reuse.
+   */
+  size_t connectionPoolSize_;
+
+  /**
+   * Disconnected clients kept for reuse.
+   */
+  std::vector<TConnectedClient*> connectionPool_;
 };
 }
 }
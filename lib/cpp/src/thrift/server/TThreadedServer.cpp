@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include <algorithm>
 #include <string>
 #include <memory>
 #include <thrift/concurrency/ThreadFactory.h>
@@ -45,7 +46,9 @@ TThreadedServer::TThreadedServer(const shared_ptr<TProcessorFactory>& processorF
                                  const shared_ptr<TProtocolFactory>& protocolFactory,
                                  const shared_ptr<ThreadFactory>& threadFactory)
   : TServerFramework(processorFactory, serverTransport, transportFactory, protocolFactory),
-    threadFactory_(threadFactory) {
+    threadFactory_(threadFactory),
+    idleThreadLimit_(0),
+    stopWorkers_(false) {
 }
 
 TThreadedServer::TThreadedServer(const shared_ptr<TProcessor>& processor,
@@ -54,7 +57,9 @@ TThreadedServer::TThreadedServer(const shared_ptr<TProcessor>& processor,
                                  const shared_ptr<TProtocolFactory>& protocolFactory,
                                  const shared_ptr<ThreadFactory>& threadFactory)
   : TServerFramework(processor, serverTransport, transportFactory, protocolFactory),
-    threadFactory_(threadFactory) {
+    threadFactory_(threadFactory),
+    idleThreadLimit_(0),
+    stopWorkers_(false) {
 }
 
 TThreadedServer::TThreadedServer(const shared_ptr<TProcessorFactory>& processorFactory,
@@ -70,7 +75,9 @@ TThreadedServer::TThreadedServer(const shared_ptr<TProcessorFactory>& processorF
                      outputTransportFactory,
                      inputProtocolFactory,
                      outputProtocolFactory),
-    threadFactory_(threadFactory) {
+    threadFactory_(threadFactory),
+    idleThreadLimit_(0),
+    stopWorkers_(false) {
 }
 
 TThreadedServer::TThreadedServer(const shared_ptr<TProcessor>& processor,
@@ -86,7 +93,9 @@ TThreadedServer::TThreadedServer(const shared_ptr<TProcessor>& processor,
                      outputTransportFactory,
                      inputProtocolFactory,
                      outputProtocolFactory),
-    threadFactory_(threadFactory) {
+    threadFactory_(threadFactory),
+    idleThreadLimit_(0),
+    stopWorkers_(false) {
 }
 
 TThreadedServer::~TThreadedServer() = default;
@@ -100,9 +109,35 @@ void TThreadedServer::serve() {
     clientMonitor_.wait();
   }
 
+  // Release the parked threads and wait for all workers to exit
+  stopWorkers_ = true;
+  for (TConnectedClientWorker* pWorker : idleWorkers_) {
+    pWorker->monitor_.notify();
+  }
+  idleWorkers_.clear();
+  while (!workerMap_.empty()) {
+    clientMonitor_.wait();
+  }
+  stopWorkers_ = false;
+
   drainDeadClients();
 }
 
+size_t TThreadedServer::getIdleThreadLimit() const {
+  Synchronized sync(clientMonitor_);
+  return idleThreadLimit_;
+}
+
+void TThreadedServer::setIdleThreadLimit(size_t limit) {
+  Synchronized sync(clientMonitor_);
+  idleThreadLimit_ = limit;
+  while (idleWorkers_.size() > idleThreadLimit_) {
+    // the worker sees it has no client and exits
+    idleWorkers_.back()->monitor_.notify();
+    idleWorkers_.pop_back();
+  }
+}
+
 void TThreadedServer::drainDeadClients() {
   // we're in a monitor here
   while (!deadClientMap_.empty()) {
@@ -110,10 +145,32 @@ void TThreadedServer::drainDeadClients() {
     it->second->join();
     deadClientMap_.erase(it);
   }
+  while (!deadWorkerThreads_.empty()) {
+    deadWorkerThreads_.back()->join();
+    deadWorkerThreads_.pop_back();
+  }
 }
 
 void TThreadedServer::onClientConnected(const shared_ptr<TConnectedClient>& pClient) {
   Synchronized sync(clientMonitor_);
+  if (!idleWorkers_.empty()) {
+    TConnectedClientWorker* pWorker = idleWorkers_.back();
+    idleWorkers_.pop_back();
+    pWorker->pClient_ = pClient;
+    activeClientMap_.insert(ClientMap::value_type(pClient.get(), shared_ptr<Thread>()));
+    pWorker->monitor_.notify();
+    return;
+  }
+
+  if (idleThreadLimit_ > 0) {
+    shared_ptr<TConnectedClientWorker> pWorker = make_shared<TConnectedClientWorker>(*this, pClient);
+    shared_ptr<Thread> pThread = threadFactory_->newThread(pWorker);
+    workerMap_.insert(WorkerMap::value_type(pWorker.get(), pThread));
+    activeClientMap_.insert(ClientMap::value_type(pClient.get(), shared_ptr<Thread>()));
+    pThread->start();
+    return;
+  }
+
   shared_ptr<TConnectedClientRunner> pRunnable = make_shared<TConnectedClientRunner>(pClient);
   shared_ptr<Thread> pThread = threadFactory_->newThread(pRunnable);
   pRunnable->thread(pThread);
@@ -126,8 +183,11 @@ void TThreadedServer::onClientDisconnected(TConnectedClient* pClient) {
   drainDeadClients(); // use the outgoing thread to do some maintenance on our dead client backlog
   auto it = activeClientMap_.find(pClient);
   if (it != activeClientMap_.end()) {
-    auto end = it;
-    deadClientMap_.insert(it, ++end);
+    if (it->second) {
+      auto end = it;
+      deadClientMap_.insert(it, ++end);
+    }
+    // clients run by a worker leave the thread to the worker
     activeClientMap_.erase(it);
   }
   if (activeClientMap_.empty()) {
@@ -146,6 +206,54 @@ void TThreadedServer::TConnectedClientRunner::run() /* override */ {
   pClient_.reset(); // The client is done - release it here rather than in the destructor for safety
 }
 
+TThreadedServer::TConnectedClientWorker::TConnectedClientWorker(TThreadedServer& server,
+                                                                const shared_ptr<TConnectedClient>& pClient)
+  : server_(server), monitor_(&server.clientMonitor_), pClient_(pClient) {
+}
+
+TThreadedServer::TConnectedClientWorker::~TConnectedClientWorker() = default;
+
+void TThreadedServer::TConnectedClientWorker::run() /* override */ {
+  for (;;) {
+    shared_ptr<TConnectedClient> pClient;
+    {
+      Synchronized sync(monitor_);
+      // A parked worker leaves the idle list when it is given a client, when
+      // the server stops or when setIdleThreadLimit lowers the limit
+      while (!pClient_ && !server_.stopWorkers_
+             && std::find(server_.idleWorkers_.begin(), server_.idleWorkers_.end(), this)
+                != server_.idleWorkers_.end()) {
+        monitor_.wait();
+      }
+      if (!pClient_) {
+        break;
+      }
+      pClient.swap(pClient_);
+    }
+
+    pClient->run();
+    pClient.reset(); // disconnects the client; must happen outside the monitor
+
+    Synchronized sync(monitor_);
+    if (server_.stopWorkers_ || server_.idleWorkers_.size() >= server_.idleThreadLimit_) {
+      break;
+    }
+    server_.idleWorkers_.push_back(this);
+  }
+
+  // Hand our thread to the server to be joined and let serve() know when
+  // the last worker is gone
+  Synchronized sync(monitor_);
+  auto it = server_.workerMap_.find(this);
+  if (it != server_.workerMap_.end()) {
+    server_.deadWorkerThreads_.push_back(it->second);
+    server_.workerMap_.erase(it);
+  }
+  if (server_.workerMap_.empty()) {
+    server_.clientMonitor_.notify();
+  }
+}
+
 }
 }
 } // apache::thrift::server
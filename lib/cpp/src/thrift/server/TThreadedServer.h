@@ -21,6 +21,7 @@
 #define _THRIFT_SERVER_TTHREADEDSERVER_H_ 1
 
 #include <map>
+#include <vector>
 #include <thrift/concurrency/Monitor.h>
 #include <thrift/concurrency/ThreadFactory.h>
 #include <thrift/concurrency/Thread.h>
@@ -85,6 +86,21 @@ public:
    */
   void serve() override;
 
+  /**
+   * Get the number of idle client threads kept waiting for a new client.
+   * \returns the idle thread limit
+   */
+  virtual size_t getIdleThreadLimit() const;
+
+  /**
+   * Keep up to limit client threads parked after their client disconnects
+   * and hand them the next clients instead of starting a new thread for
+   * each one.  The default value used if this is not called is 0, which
+   * starts and joins one thread per client.
+   * \param[in]  limit  the number of idle threads to keep
+   */
+  virtual void setIdleThreadLimit(size_t limit);
+
 protected:
   /**
    * Drain recently connected clients by joining their threads - this is done lazily because
@@ -121,6 +137,23 @@ protected:
     std::shared_ptr<TConnectedClient> pClient_;
   };
 
+  /**
+   * Runs clients one after another on the same thread, parking in between
+   * while the server's idle thread limit allows.
+   */
+  class TConnectedClientWorker : public apache::thrift::concurrency::Runnable
+  {
+  public:
+    TConnectedClientWorker(TThreadedServer& server, const std::shared_ptr<TConnectedClient>& pClient);
+    ~TConnectedClientWorker() override;
+    void run() override /* override */;
+  private:
+    friend class TThreadedServer;
+    TThreadedServer& server_;
+    apache::thrift::concurrency::Monitor monitor_; // shares clientMonitor_'s mutex
+    std::shared_ptr<TConnectedClient> pClient_;
+  };
+
   apache::thrift::concurrency::Monitor clientMonitor_;
 
   typedef std::map<TConnectedClient *, std::shared_ptr<apache::thrift::concurrency::Thread> > ClientMap;
@@ -134,6 +167,34 @@ protected:
    * A map of clients that have disconnected but their threads have not been joined
    */
   ClientMap deadClientMap_;
+
+  /**
+   * The maximum number of parked client threads.
+   */
+  size_t idleThreadLimit_;
+
+  /**
+   * Set while serve() is shutting down parked client threads.
+   */
+  bool stopWorkers_;
+
+  /**
+   * Parked client threads waiting for a client.
+   */
+  std::vector<TConnectedClientWorker*> idleWorkers_;
+
+  typedef std::map<TConnectedClientWorker*, std::shared_ptr<apache::thrift::concurrency::Thread> > WorkerMap;
+
+  /**
+   * All running client threads that were started as workers.  Clients run
+   * by a worker appear in activeClientMap_ without a thread.
+   */
+  WorkerMap workerMap_;
+
+  /**
+   * Worker threads that have exited but have not been joined.
+   */
+  std::vector<std::shared_ptr<apache::thrift::concurrency::Thread> > deadWorkerThreads_;
 };
 
 }
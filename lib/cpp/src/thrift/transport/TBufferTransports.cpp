@@ -227,6 +227,27 @@ void TFramedTransport::writeSlow(const uint8_t* buf, uint32_t len) {
   while (new_size < len + have) {
     new_size = new_size > 0 ? new_size * 2 : 1;
   }
+  resizeWriteBuffer(new_size);
+
+  // Copy the data into the new buffer.
+  memcpy(wBase_, buf, len);
+  wBase_ += len;
+}
+
+void TFramedTransport::reserve(uint32_t len) {
+  auto have = static_cast<uint32_t>(wBase_ - wBuf_.get());
+  if (len <= static_cast<uint32_t>(wBound_ - wBase_)) {
+    return;
+  }
+  if (len + have < have /* overflow */ || len + have > 0x7fffffff) {
+    throw TTransportException(TTransportException::BAD_ARGS,
+                              "Attempted to write over 2 GB to TFramedTransport.");
+  }
+  resizeWriteBuffer(len + have);
+}
+
+void TFramedTransport::resizeWriteBuffer(uint32_t new_size) {
+  auto have = static_cast<uint32_t>(wBase_ - wBuf_.get());
 
   // TODO(dreiss): Consider modifying this class to use malloc/free
   // so we can use realloc here.
@@ -242,10 +263,6 @@ void TFramedTransport::writeSlow(const uint8_t* buf, uint32_t len) {
   wBufSize_ = new_size;
   wBase_ = wBuf_.get() + have;
   wBound_ = wBuf_.get() + wBufSize_;
-
-  // Copy the data into the new buffer.
-  memcpy(wBase_, buf, len);
-  wBase_ += len;
 }
 
 void TFramedTransport::flush() {
@@ -371,9 +388,12 @@ void TMemoryBuffer::ensureCanWrite(uint32_t len) {
   }
 
   // Always grow to the next bigger power of two:
-  const double suggested_buffer_size = std::exp2(std::ceil(std::log2(required_buffer_size)));
+  uint64_t suggested_buffer_size = 1;
+  while (suggested_buffer_size < required_buffer_size) {
+    suggested_buffer_size <<= 1;
+  }
   // Unless the power of two exceeds maxBufferSize_:
-  const uint64_t new_size = static_cast<uint64_t>((std::min)(suggested_buffer_size, static_cast<double>(maxBufferSize_)));
+  const uint64_t new_size = (std::min)(suggested_buffer_size, static_cast<uint64_t>(maxBufferSize_));
 
   // Allocate into a new pointer so we don't bork ours if it fails.
   auto* new_buffer = static_cast<uint8_t*>(std::realloc(buffer_, static_cast<std::size_t>(new_size)));
@@ -264,6 +264,17 @@ public:
 
   std::shared_ptr<TTransport> getUnderlyingTransport() { return transport_; }
 
+  /**
+   * Switch to a new underlying transport, discarding anything buffered for
+   * the old one.  The buffers themselves are kept, so a server can reuse
+   * this object for its next connection.
+   */
+  void reset(std::shared_ptr<TTransport> transport) {
+    transport_ = transport;
+    initPointers();
+    resetConsumedMessageSize();
+  }
+
   /*
    * TVirtualTransport provides a default implementation of readAll().
    * We want to use the TBufferBase version instead.
@@ -301,6 +312,16 @@ public:
   std::shared_ptr<TTransport> getTransport(std::shared_ptr<TTransport> trans) override {
     return std::shared_ptr<TTransport>(new TBufferedTransport(trans));
   }
+
+  bool resetTransport(const std::shared_ptr<TTransport>& transport,
+                      std::shared_ptr<TTransport> trans) override {
+    auto* buffered = dynamic_cast<TBufferedTransport*>(transport.get());
+    if (buffered == nullptr) {
+      return false;
+    }
+    buffered->reset(trans);
+    return true;
+  }
 };
 
 /**
@@ -377,8 +398,26 @@ public:
 
   const uint8_t* borrowSlow(uint8_t* buf, uint32_t* len) override;
 
+  /**
+   * Make room for len more bytes in the current frame with at most one
+   * reallocation.  Callers that know the encoded size of a message up front
+   * (see the generated serializedSize()) can use this to avoid the repeated
+   * doubling that writeSlow() would otherwise do.
+   */
+  void reserve(uint32_t len);
+
   std::shared_ptr<TTransport> getUnderlyingTransport() { return transport_; }
 
+  /**
+   * Switch to a new underlying transport, discarding any partial frame read
+   * from or written for the old one.  The buffers themselves are kept.
+   */
+  void reset(std::shared_ptr<TTransport> transport) {
+    transport_ = transport;
+    initPointers();
+    resetConsumedMessageSize();
+  }
+
   /*
    * TVirtualTransport provides a default implementation of readAll().
    * We want to use the TBufferBase version instead.
@@ -409,6 +448,9 @@ protected:
    */
   virtual bool readFrame();
 
+  /// Move the frame being written into a buffer of new_size bytes.
+  void resizeWriteBuffer(uint32_t new_size);
+
   void initPointers() {
     setReadBuffer(nullptr, 0);
     setWriteBuffer(wBuf_.get(), wBufSize_);
@@ -444,6 +486,16 @@ public:
   std::shared_ptr<TTransport> getTransport(std::shared_ptr<TTransport> trans) override {
     return std::shared_ptr<TTransport>(new TFramedTransport(trans));
   }
+
+  bool resetTransport(const std::shared_ptr<TTransport>& transport,
+                      std::shared_ptr<TTransport> trans) override {
+    auto* framed = dynamic_cast<TFramedTransport*>(transport.get());
+    if (framed == nullptr) {
+      return false;
+    }
+    framed->reset(trans);
+    return true;
+  }
 };
 
 /**
@@ -643,6 +695,28 @@ public:
     // Our old self gets destroyed.
   }
 
+  /**
+   * Hand the buffer over to the caller, leaving this object empty as if
+   * constructed with a size of zero.  Only a buffer this object owns can be
+   * released.
+   *
+   * @param sz  Set to the size of the returned buffer.
+   * @return The buffer, which the caller must eventually free().
+   * @throws TTransportException(BAD_ARGS) if the buffer is not owned.
+   */
+  uint8_t* releaseBuffer(uint32_t* sz) {
+    if (!owner_) {
+      throw TTransportException(TTransportException::BAD_ARGS,
+                                "TMemoryBuffer cannot release a buffer it does not own.");
+    }
+    uint8_t* buf = buffer_;
+    uint32_t maxSize = maxBufferSize_;
+    *sz = bufferSize_;
+    initCommon(nullptr, 0, true, 0);
+    maxBufferSize_ = maxSize;
+    return buf;
+  }
+
   std::string readAsString(uint32_t len) {
     std::string str;
     (void)readAppendToString(str, len);
@@ -684,6 +758,10 @@ public:
     return wBase_;
   }
 
+  // Grows the buffer, at most once, so that len more bytes can be written
+  // without reallocating.
+  void reserve(uint32_t len) { ensureCanWrite(len); }
+
   // Informs the buffer that the client has written 'len' bytes into storage
   // that had been provided by getWritePtr().
   void wroteBytes(uint32_t len);
@@ -0,0 +1,357 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <thrift/thrift-config.h>
+
+#include <algorithm>
+#include <cstring>
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
+#include <thrift/transport/TChainedBuffer.h>
+
+namespace apache {
+namespace thrift {
+namespace transport {
+
+namespace {
+/// Most segments handed to a single sendmsg() call
+const int MAX_IOVECS = 64;
+
+std::shared_ptr<uint8_t> allocateBlock(uint32_t size) {
+  return std::shared_ptr<uint8_t>(new uint8_t[size], std::default_delete<uint8_t[]>());
+}
+}
+
+const uint32_t TChainedBuffer::DEFAULT_SEGMENT_SIZE;
+const uint32_t TChainedBuffer::MAX_SEGMENT_SIZE;
+
+TChainedBuffer::TChainedBuffer(uint32_t segmentSize, std::shared_ptr<TConfiguration> config)
+  : TVirtualTransport(config),
+    tailWritable_(false),
+    initialSegmentSize_((std::max)(segmentSize, 1u)),
+    nextSegmentSize_(initialSegmentSize_) {
+}
+
+void TChainedBuffer::syncSegments() {
+  if (segments_.empty()) {
+    return;
+  }
+  segments_.front().begin = rBase_;
+  if (tailWritable_) {
+    segments_.back().end = wBase_;
+  }
+  if (segments_.size() == 1) {
+    // reads of the last segment may extend to whatever has been written since
+    rBound_ = segments_.front().end;
+  }
+}
+
+bool TChainedBuffer::nextSegment() {
+  if (segments_.size() > 1) {
+    segments_.pop_front();
+    rBase_ = segments_.front().begin;
+    rBound_ = (segments_.size() == 1 && tailWritable_) ? wBase_ : segments_.front().end;
+    return true;
+  }
+
+  if (!segments_.empty()) {
+    Segment& last = segments_.front();
+    if (!tailWritable_) {
+      segments_.clear();
+      rBase_ = rBound_ = nullptr;
+    } else if (last.block.use_count() == 1) {
+      // all read and nobody else refers to it: start writing at the front again
+      last.begin = last.end = last.block.get();
+      rBase_ = rBound_ = wBase_ = last.begin;
+    }
+  }
+  return false;
+}
+
+void TChainedBuffer::addSegment(uint32_t len) {
+  syncSegments();
+  if (segments_.size() == 1 && rBase_ == rBound_) {
+    // the only segment is full and all read
+    segments_.clear();
+  }
+
+  uint32_t size = (std::max)(len, nextSegmentSize_);
+  nextSegmentSize_ = (std::min)(nextSegmentSize_ * 2, MAX_SEGMENT_SIZE);
+  nextSegmentSize_ = (std::max)(nextSegmentSize_, initialSegmentSize_);
+
+  std::shared_ptr<uint8_t> block = allocateBlock(size);
+  Segment segment = {block, block.get(), block.get(), block.get() + size};
+  segments_.push_back(segment);
+
+  tailWritable_ = true;
+  setWriteBuffer(segment.begin, size);
+  if (segments_.size() == 1) {
+    setReadBuffer(segment.begin, 0);
+  }
+}
+
+void TChainedBuffer::addSharedSegment(const std::shared_ptr<uint8_t>& block,
+                                      uint8_t* begin,
+                                      uint8_t* end) {
+  syncSegments();
+  if (tailWritable_) {
+    // whatever is appended next must go after the shared data
+    tailWritable_ = false;
+    setWriteBuffer(nullptr, 0);
+  }
+
+  Segment segment = {block, begin, end, end};
+  segments_.push_back(segment);
+  if (segments_.size() == 1) {
+    rBase_ = begin;
+    rBound_ = end;
+  }
+}
+
+uint32_t TChainedBuffer::take(uint8_t* buf, uint32_t len) {
+  syncSegments();
+
+  uint32_t got = 0;
+  while (got < len) {
+    auto avail = static_cast<uint32_t>(rBound_ - rBase_);
+    if (avail == 0) {
+      if (!nextSegment()) {
+        break;
+      }
+      continue;
+    }
+    uint32_t give = (std::min)(avail, len - got);
+    if (buf != nullptr) {
+      std::memcpy(buf + got, rBase_, give);
+    }
+    rBase_ += give;
+    got += give;
+  }
+  return got;
+}
+
+uint32_t TChainedBuffer::readSlow(uint8_t* buf, uint32_t len) {
+  return take(buf, len);
+}
+
+void TChainedBuffer::writeSlow(const uint8_t* buf, uint32_t len) {
+  if (tailWritable_) {
+    // fill what is left of the last segment before starting another
+    uint32_t space = (std::min)(static_cast<uint32_t>(wBound_ - wBase_), len);
+    std::memcpy(wBase_, buf, space);
+    wBase_ += space;
+    buf += space;
+    len -= space;
+    if (len == 0) {
+      return;
+    }
+  }
+
+  addSegment(len);
+  std::memcpy(wBase_, buf, len);
+  wBase_ += len;
+}
+
+const uint8_t* TChainedBuffer::borrowSlow(uint8_t* buf, uint32_t* len) {
+  (void)buf;
+  syncSegments();
+  while (rBase_ == rBound_ && nextSegment()) {
+  }
+
+  if (static_cast<ptrdiff_t>(*len) <= rBound_ - rBase_) {
+    *len = static_cast<uint32_t>(rBound_ - rBase_);
+    return rBase_;
+  }
+  if (available_read() < *len) {
+    return nullptr;
+  }
+
+  // The request spans segments: gather just those bytes into a segment of
+  // their own so that the caller can consume() them in place.
+  uint32_t need = *len;
+  std::shared_ptr<uint8_t> block = allocateBlock(need);
+  take(block.get(), need);
+  syncSegments();
+
+  Segment segment = {block, block.get(), block.get() + need, block.get() + need};
+  segments_.push_front(segment);
+  setReadBuffer(segment.begin, need);
+  return rBase_;
+}
+
+uint32_t TChainedBuffer::available_read() const {
+  uint32_t total = 0;
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const Segment& segment = segments_[i];
+    const uint8_t* begin = i == 0 ? rBase_ : segment.begin;
+    const uint8_t* end = (i == segments_.size() - 1 && tailWritable_) ? wBase_ : segment.end;
+    total += static_cast<uint32_t>(end - begin);
+  }
+  return total;
+}
+
+size_t TChainedBuffer::countSegments() const {
+  size_t count = 0;
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const Segment& segment = segments_[i];
+    const uint8_t* begin = i == 0 ? rBase_ : segment.begin;
+    const uint8_t* end = (i == segments_.size() - 1 && tailWritable_) ? wBase_ : segment.end;
+    if (begin != end) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+std::shared_ptr<TChainedBuffer> TChainedBuffer::clone() {
+  std::shared_ptr<TChainedBuffer> result(
+      new TChainedBuffer(initialSegmentSize_, getConfiguration()));
+  result->append(*this);
+  return result;
+}
+
+std::shared_ptr<TChainedBuffer> TChainedBuffer::split(uint32_t len) {
+  if (available_read() < len) {
+    throw TTransportException(TTransportException::END_OF_FILE,
+                              "TChainedBuffer::split() beyond the end of the data");
+  }
+
+  std::shared_ptr<TChainedBuffer> result(
+      new TChainedBuffer(initialSegmentSize_, getConfiguration()));
+  syncSegments();
+  while (len > 0) {
+    auto avail = static_cast<uint32_t>(rBound_ - rBase_);
+    if (avail == 0) {
+      nextSegment();
+      continue;
+    }
+    uint32_t give = (std::min)(avail, len);
+    result->addSharedSegment(segments_.front().block, rBase_, rBase_ + give);
+    rBase_ += give;
+    len -= give;
+  }
+  return result;
+}
+
+void TChainedBuffer::append(const TChainedBuffer& other) {
+  if (&other == this) {
+    std::shared_ptr<TChainedBuffer> copy = clone();
+    append(*copy);
+    return;
+  }
+
+  for (size_t i = 0; i < other.segments_.size(); ++i) {
+    const Segment& segment = other.segments_[i];
+    uint8_t* begin = i == 0 ? other.rBase_ : segment.begin;
+    uint8_t* end = (i == other.segments_.size() - 1 && other.tailWritable_) ? other.wBase_
+                                                                            : segment.end;
+    if (begin != end) {
+      addSharedSegment(segment.block, begin, end);
+    }
+  }
+}
+
+uint32_t TChainedBuffer::writeTo(THRIFT_SOCKET socket) {
+  syncSegments();
+
+#ifdef HAVE_SYS_SOCKET_H
+  struct iovec iov[MAX_IOVECS];
+  int count = 0;
+  for (auto it = segments_.begin(); it != segments_.end() && count < MAX_IOVECS; ++it) {
+    if (it->begin != it->end) {
+      iov[count].iov_base = it->begin;
+      iov[count].iov_len = static_cast<size_t>(it->end - it->begin);
+      ++count;
+    }
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  struct msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+
+  int flags = 0;
+#ifdef MSG_NOSIGNAL
+  flags |= MSG_NOSIGNAL;
+#endif // ifdef MSG_NOSIGNAL
+  auto sent = static_cast<int>(sendmsg(socket, &msg, flags));
+#else
+  // no scatter/gather send; one segment at a time
+  while (rBase_ == rBound_ && nextSegment()) {
+  }
+  if (rBase_ == rBound_) {
+    return 0;
+  }
+  auto sent = static_cast<int>(
+      send(socket, const_cast_sockopt(rBase_), static_cast<int>(rBound_ - rBase_), 0));
+#endif
+
+  if (sent < 0) {
+    int errno_copy = THRIFT_GET_SOCKET_ERROR;
+    if (errno_copy == THRIFT_EWOULDBLOCK || errno_copy == THRIFT_EAGAIN) {
+      return 0;
+    }
+    if (errno_copy == THRIFT_EPIPE || errno_copy == THRIFT_ECONNRESET
+        || errno_copy == THRIFT_ENOTCONN) {
+      throw TTransportException(TTransportException::NOT_OPEN, "TChainedBuffer::writeTo()",
+                                errno_copy);
+    }
+    throw TTransportException(TTransportException::UNKNOWN, "TChainedBuffer::writeTo()",
+                              errno_copy);
+  }
+
+  return take(nullptr, static_cast<uint32_t>(sent));
+}
+
+std::string TChainedBuffer::getBufferAsString() const {
+  std::string str;
+  str.reserve(available_read());
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const Segment& segment = segments_[i];
+    const uint8_t* begin = i == 0 ? rBase_ : segment.begin;
+    const uint8_t* end = (i == segments_.size() - 1 && tailWritable_) ? wBase_ : segment.end;
+    str.append(reinterpret_cast<const char*>(begin), static_cast<size_t>(end - begin));
+  }
+  return str;
+}
+
+void TChainedBuffer::resetBuffer() {
+  if (tailWritable_ && segments_.back().block.use_count() == 1) {
+    Segment last = segments_.back();
+    segments_.clear();
+    last.begin = last.end = last.block.get();
+    segments_.push_back(last);
+    setReadBuffer(last.begin, 0);
+    setWriteBuffer(last.begin, static_cast<uint32_t>(last.limit - last.begin));
+  } else {
+    segments_.clear();
+    tailWritable_ = false;
+    setReadBuffer(nullptr, 0);
+    setWriteBuffer(nullptr, 0);
+  }
+  nextSegmentSize_ = initialSegmentSize_;
+}
+}
+}
+} // apache::thrift::transport
@@ -0,0 +1,181 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _THRIFT_TRANSPORT_TCHAINEDBUFFER_H_
+#define _THRIFT_TRANSPORT_TCHAINEDBUFFER_H_ 1
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include <thrift/transport/PlatformSocket.h>
+#include <thrift/transport/TBufferTransports.h>
+
+namespace apache {
+namespace thrift {
+namespace transport {
+
+/**
+ * An in-memory transport made of a chain of segments, as an alternative to
+ * TMemoryBuffer for large or sliced messages.
+ *
+ * Where TMemoryBuffer grows by reallocating (and so copying) everything
+ * written so far, TChainedBuffer appends a new segment when the last one is
+ * full, so data is copied exactly once on the way in.  Segment sizes double
+ * from the initial segment size up to MAX_SEGMENT_SIZE.
+ *
+ * Segments are reference counted and may be shared between buffers: clone()
+ * and split() produce new buffers that refer to the same memory rather than
+ * copying it, which makes it cheap to cut a stream of frames apart or to
+ * hand the same payload to several consumers.  Shared memory is never
+ * written to again; only the writer that created a segment appends to it.
+ *
+ * Reads use the TBufferBase fast paths within a segment.  A borrow() that
+ * spans a segment boundary gathers just the requested bytes into a small new
+ * segment, so protocols keep their zero-copy borrow/consume path.  The
+ * unread contents can be sent to a socket with a single scatter/gather
+ * system call using writeTo().
+ *
+ * Like TMemoryBuffer, a TChainedBuffer is not thread safe.
+ */
+class TChainedBuffer : public TVirtualTransport<TChainedBuffer, TBufferBase> {
+public:
+  static const uint32_t DEFAULT_SEGMENT_SIZE = 4096;
+  static const uint32_t MAX_SEGMENT_SIZE = 1024 * 1024;
+
+  /**
+   * @param segmentSize the size of the first segment allocated for writes.
+   */
+  explicit TChainedBuffer(uint32_t segmentSize = DEFAULT_SEGMENT_SIZE,
+                          std::shared_ptr<TConfiguration> config = nullptr);
+
+  bool isOpen() const override { return true; }
+
+  bool peek() override { return available_read() > 0; }
+
+  void open() override {}
+
+  void close() override {}
+
+  /**
+   * Get the number of bytes that can be read.
+   */
+  uint32_t available_read() const;
+
+  /**
+   * Get the number of segments holding unread data.
+   */
+  size_t countSegments() const;
+
+  /**
+   * Create a buffer holding the same unread data, sharing this buffer's
+   * memory.  Neither buffer's contents are affected by later reads or
+   * writes on the other.
+   */
+  std::shared_ptr<TChainedBuffer> clone();
+
+  /**
+   * Remove the first len unread bytes from this buffer and return them as a
+   * new buffer that shares the memory.
+   *
+   * @throws TTransportException(END_OF_FILE) if fewer than len bytes are
+   *         available.
+   */
+  std::shared_ptr<TChainedBuffer> split(uint32_t len);
+
+  /**
+   * Append the unread contents of another buffer without copying them.  The
+   * other buffer is left unchanged.
+   */
+  void append(const TChainedBuffer& other);
+
+  /**
+   * Send as much unread data as the socket accepts, in one scatter/gather
+   * system call where the platform has one, and consume what was sent.
+   *
+   * @param socket a connected socket, blocking or not.
+   * @return the number of bytes sent; 0 if a non-blocking socket is full.
+   * @throws TTransportException if the send fails.
+   */
+  uint32_t writeTo(THRIFT_SOCKET socket);
+
+  /**
+   * Get a copy of the unread data, without consuming it.
+   */
+  std::string getBufferAsString() const;
+
+  /**
+   * Discard all data.  Every segment is released except the last, which is
+   * kept for further writes if no other buffer shares it.
+   */
+  void resetBuffer();
+
+  /*
+   * TVirtualTransport provides a default implementation of readAll().
+   * We want to use the TBufferBase version instead.
+   */
+  uint32_t readAll(uint8_t* buf, uint32_t len) { return TBufferBase::readAll(buf, len); }
+
+protected:
+  uint32_t readSlow(uint8_t* buf, uint32_t len) override;
+
+  void writeSlow(const uint8_t* buf, uint32_t len) override;
+
+  const uint8_t* borrowSlow(uint8_t* buf, uint32_t* len) override;
+
+private:
+  /// A view onto part of a reference counted block of memory
+  struct Segment {
+    std::shared_ptr<uint8_t> block;
+    uint8_t* begin;
+    uint8_t* end;
+    uint8_t* limit;
+  };
+
+  /// Store the read and write positions back into the first and last segments.
+  void syncSegments();
+
+  /// Drop the exhausted first segment and start reading the next one.
+  bool nextSegment();
+
+  /// Start a new segment for writes with room for at least len bytes.
+  void addSegment(uint32_t len);
+
+  /// Append a read-only view of [begin, end) of a block.
+  void addSharedSegment(const std::shared_ptr<uint8_t>& block, uint8_t* begin, uint8_t* end);
+
+  /// Copy up to len bytes out and consume them; buf may be null to discard.
+  uint32_t take(uint8_t* buf, uint32_t len);
+
+  std::deque<Segment> segments_;
+
+  /// Whether the last segment belongs to this buffer and can be appended to.
+  bool tailWritable_;
+
+  /// Size of the first segment allocated for writes.
+  const uint32_t initialSegmentSize_;
+
+  /// Size of the next segment allocated for writes.
+  uint32_t nextSegmentSize_;
+};
+}
+}
+} // apache::thrift::transport
+
+#endif // #ifndef _THRIFT_TRANSPORT_TCHAINEDBUFFER_H_
@@ -109,6 +109,15 @@ public:
 
   void resizeTransformBuffer(uint32_t additionalSize = 0);
 
+  /**
+   * Make room for len more bytes of payload, growing the transform buffer
+   * along with the write buffer so that flush() does not reallocate either.
+   */
+  void reserve(uint32_t len) {
+    TFramedTransport::reserve(len);
+    resizeTransformBuffer();
+  }
+
   uint16_t getProtocolId() const;
   void setProtocolId(uint16_t protoId) { this->protoId = protoId; }
 
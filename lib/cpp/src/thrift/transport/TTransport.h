@@ -349,6 +349,18 @@ public:
   virtual std::shared_ptr<TTransport> getTransport(std::shared_ptr<TTransport> trans) {
     return trans;
   }
+
+  /**
+   * Point a transport previously returned by getTransport() at trans so it
+   * can be reused.  Returns false if this factory does not support that, in
+   * which case the caller should call getTransport() instead.
+   */
+  virtual bool resetTransport(const std::shared_ptr<TTransport>& transport,
+                              std::shared_ptr<TTransport> trans) {
+    (void)transport;
+    (void)trans;
+    return false;
+  }
 };
 }
 }
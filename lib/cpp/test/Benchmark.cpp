@@ -27,6 +27,7 @@
 #include "thrift/protocol/TBinaryProtocol.h"
 #include "thrift/transport/TBufferTransports.h"
 #include "gen-cpp/DebugProtoTest_types.h"
+#include "gen-cpp/ParentService.h"
 
 #ifdef HAVE_SYS_TIME_H
 #include <sys/time.h>
@@ -48,6 +49,42 @@ public:
   }
 };
 
+class BenchmarkHandler : public apache::thrift::test::ParentServiceIf {
+public:
+  BenchmarkHandler() : strings_(10, "a string to return") {}
+
+  void getStrings(std::vector<std::string>& _return) override { _return = strings_; }
+
+  int32_t incrementGeneration() override { return 0; }
+  int32_t getGeneration() override { return 0; }
+  void addString(const std::string&) override {}
+  void getDataWait(std::string&, const int32_t) override {}
+  void onewayWait() override {}
+  void exceptionWait(const std::string&) override {}
+  void unexpectedExceptionWait(const std::string&) override {}
+
+private:
+  std::vector<std::string> strings_;
+};
+
+// Process the same encoded request num times, the way TNonblockingServer does.
+double processRequests(apache::thrift::TProcessor& processor,
+                       const std::shared_ptr<apache::thrift::protocol::TProtocol>& in,
+                       const std::shared_ptr<apache::thrift::protocol::TProtocol>& out,
+                       apache::thrift::transport::TMemoryBuffer& inBuf,
+                       apache::thrift::transport::TMemoryBuffer& outBuf,
+                       uint8_t* request,
+                       uint32_t requestSize,
+                       int num) {
+  Timer timer;
+  for (int i = 0; i < num; i++) {
+    inBuf.resetBuffer(request, requestSize);
+    outBuf.resetBuffer();
+    processor.process(in, out, nullptr);
+  }
+  return timer.frame();
+}
+
 int main() {
   using namespace thrift::test::debug;
   using namespace apache::thrift::transport;
@@ -239,6 +276,42 @@ int main() {
     cout << " Double read big endian: " << num / (1000 * elapsed) << " kHz" << endl;
   }
 
+  num = 200000;
+
+  {
+    using apache::thrift::test::ParentServiceClient;
+    using apache::thrift::test::ParentServiceProcessor;
+    using apache::thrift::test::ParentServiceProcessorT;
+
+    std::shared_ptr<TMemoryBuffer> requestBuf(new TMemoryBuffer());
+    ParentServiceClient client(std::make_shared<TBinaryProtocol>(requestBuf));
+    client.send_getStrings();
+    uint8_t* request;
+    uint32_t requestSize;
+    requestBuf->getBuffer(&request, &requestSize);
+
+    std::shared_ptr<BenchmarkHandler> handler(new BenchmarkHandler());
+    std::shared_ptr<TMemoryBuffer> inBuf(new TMemoryBuffer());
+    std::shared_ptr<TMemoryBuffer> outBuf(new TMemoryBuffer());
+
+    {
+      ParentServiceProcessor processor(handler);
+      std::shared_ptr<TProtocol> in(new TBinaryProtocol(inBuf));
+      std::shared_ptr<TProtocol> out(new TBinaryProtocol(outBuf));
+      double elapsed
+          = processRequests(processor, in, out, *inBuf, *outBuf, request, requestSize, num);
+      cout << "Process generic: " << num / (1000 * elapsed) << " kHz" << endl;
+    }
+
+    {
+      ParentServiceProcessorT<TBinaryProtocolT<TMemoryBuffer> > processor(handler);
+      std::shared_ptr<TProtocol> in(new TBinaryProtocolT<TMemoryBuffer>(inBuf));
+      std::shared_ptr<TProtocol> out(new TBinaryProtocolT<TMemoryBuffer>(outBuf));
+      double elapsed
+          = processRequests(processor, in, out, *inBuf, *outBuf, request, requestSize, num);
+      cout << "Process templated: " << num / (1000 * elapsed) << " kHz" << endl;
+    }
+  }
 
   return 0;
 }
@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+#include "gen-cpp/CompactLayoutTest_types.h"
+
+#define BOOST_TEST_MODULE CompactLayoutTest
+#include <boost/test/unit_test.hpp>
+
+using namespace thrift::test::compact;
+using apache::thrift::protocol::TBinaryProtocol;
+using apache::thrift::transport::TMemoryBuffer;
+
+BOOST_AUTO_TEST_CASE(test_isset_words) {
+  // optional and default flags are packed into separate 64-bit words
+  BOOST_CHECK_EQUAL(sizeof(uint64_t), sizeof(_Padded__isset));
+  BOOST_CHECK_EQUAL(2 * sizeof(uint64_t), sizeof(_Mixed__isset));
+  BOOST_CHECK_EQUAL(3 * sizeof(uint64_t), sizeof(_Wide__isset));
+
+  // the fields are still read and written by name
+  Mixed m;
+  BOOST_CHECK(!m.__isset.name);
+  BOOST_CHECK(m.__isset.active);
+  BOOST_CHECK(m.__isset.flags);
+  m.__isset.name = true;
+  m.__set_stamp(42);
+  bool stamp = m.__isset.stamp;
+  BOOST_CHECK(stamp);
+  BOOST_CHECK(m.__isset.name);
+  m.__isset.name = false;
+  BOOST_CHECK(!m.__isset.name);
+}
+
+BOOST_AUTO_TEST_CASE(test_member_order) {
+  // the three bytes share a word rather than being padded to one each
+  BOOST_CHECK_LE(sizeof(Padded), sizeof(void*) + 3 * sizeof(int64_t) + sizeof(_Padded__isset));
+
+  Padded p;
+  p.__set_a(1);
+  p.__set_b(2);
+  p.__set_c(3);
+  p.__set_d(4);
+  p.__set_e(5);
+
+  // the wire format still follows the field ids
+  std::shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer());
+  TBinaryProtocol protocol(buffer);
+  p.write(&protocol);
+  uint8_t* data;
+  uint32_t size;
+  buffer->getBuffer(&data, &size);
+  BOOST_REQUIRE_GT(size, 3u);
+  BOOST_CHECK_EQUAL(1, data[2]); // field id of a
+  BOOST_CHECK_EQUAL(1, data[3]); // value of a
+
+  Padded copy;
+  copy.read(&protocol);
+  BOOST_CHECK(copy == p);
+  BOOST_CHECK_EQUAL(5, copy.e);
+}
+
+BOOST_AUTO_TEST_CASE(test_equality) {
+  Mixed a;
+  Mixed b;
+  BOOST_CHECK(a == b);
+
+  // unset optional fields are not compared
+  a.name = "ignored";
+  BOOST_CHECK(a == b);
+  a.__set_name("set");
+  BOOST_CHECK(a != b);
+  b.__set_name("set");
+  BOOST_CHECK(a == b);
+
+  // presence differs even though the values match
+  a.__isset.active = false;
+  BOOST_CHECK(a != b);
+  b.__isset.active = false;
+  BOOST_CHECK(a == b);
+
+  // fields of default requiredness are compared whether set or not
+  a.values.push_back(1);
+  BOOST_CHECK(a != b);
+  b.values = a.values;
+  b.__isset.values = true;
+  BOOST_CHECK(a.__isset != b.__isset);
+  BOOST_CHECK(a == b);
+
+  Wide w1;
+  Wide w2;
+  w1.__set_f65(65);
+  BOOST_CHECK(w1 != w2);
+  w2.__set_f65(65);
+  BOOST_CHECK(w1 == w2);
+}
+
+BOOST_AUTO_TEST_CASE(test_roundtrip) {
+  Wide w;
+  w.__set_f1(1);
+  w.__set_f64(64);
+  w.__set_f65(65);
+  w.__set_note("note");
+
+  std::shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer());
+  TBinaryProtocol protocol(buffer);
+  w.write(&protocol);
+
+  Wide copy;
+  copy.read(&protocol);
+  BOOST_CHECK(copy == w);
+  BOOST_CHECK(copy.__isset.f1);
+  BOOST_CHECK(!copy.__isset.f2);
+  BOOST_CHECK(copy.__isset.f64);
+  BOOST_CHECK(copy.__isset.f65);
+  BOOST_CHECK_EQUAL(65, copy.f65);
+  BOOST_CHECK_EQUAL("note", copy.note);
+}
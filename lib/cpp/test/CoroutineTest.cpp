@@ -0,0 +1,304 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#define BOOST_TEST_MODULE CoroutineTest
+#include <boost/test/unit_test.hpp>
+#include <limits>
+#include <memory>
+#include <sys/socket.h>
+
+#include <thrift/async/TAsyncProtocolProcessor.h>
+#include <thrift/async/TCoroChannel.h>
+#include <thrift/async/TEpollEventLoop.h>
+#include <thrift/async/TEpollSocketChannel.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+
+#include "gen-cpp/Calculator.h"
+
+using apache::thrift::async::TAsyncBufferProcessor;
+using apache::thrift::async::TAsyncProtocolProcessor;
+using apache::thrift::async::TCoroChannel;
+using apache::thrift::async::TEpollEventLoop;
+using apache::thrift::async::TEpollSocketChannel;
+using apache::thrift::async::TTask;
+using apache::thrift::async::syncWait;
+using apache::thrift::protocol::TBinaryProtocolFactory;
+using apache::thrift::transport::TMemoryBuffer;
+using apache::thrift::transport::TSocket;
+using apache::thrift::transport::TTransportException;
+using corotest::CalculatorCoroClient;
+using corotest::CalculatorCoroIf;
+using corotest::CalculatorCoroProcessor;
+using corotest::Overflow;
+using corotest::Point;
+using std::shared_ptr;
+
+/**
+ * Something to co_await that the test releases by hand.
+ */
+class Gate {
+public:
+  bool await_ready() const noexcept { return open_; }
+  void await_suspend(std::coroutine_handle<> handle) { waiter_ = handle; }
+  void await_resume() const noexcept {}
+
+  void open() {
+    open_ = true;
+    if (waiter_) {
+      std::exchange(waiter_, nullptr).resume();
+    }
+  }
+
+  bool waiting() const { return static_cast<bool>(waiter_); }
+
+private:
+  bool open_ = false;
+  std::coroutine_handle<> waiter_;
+};
+
+class CalculatorHandler : public CalculatorCoroIf {
+public:
+  TTask<std::string> ping() override { co_return "pong"; }
+
+  TTask<int32_t> add(const int32_t a, const int32_t b) override {
+    if ((b > 0 && a > std::numeric_limits<int32_t>::max() - b)
+        || (b < 0 && a < std::numeric_limits<int32_t>::min() - b)) {
+      Overflow ouch;
+      ouch.message = "overflow";
+      throw ouch;
+    }
+    co_return a + b;
+  }
+
+  TTask<Point> translate(const Point& p, const int32_t dx, const int32_t dy) override {
+    Point moved;
+    moved.x = p.x + dx;
+    moved.y = p.y + dy;
+    co_return moved;
+  }
+
+  TTask<void> wait() override { co_await gate; }
+
+  TTask<void> fire(const int32_t n) override {
+    fired += n;
+    co_return;
+  }
+
+  Gate gate;
+  int32_t fired = 0;
+};
+
+/**
+ * Runs a TAsyncBufferProcessor and resumes the caller when it calls back,
+ * which may happen before process() returns or at any later time.
+ */
+class ProcessAwaiter {
+public:
+  ProcessAwaiter(TAsyncBufferProcessor* processor,
+                 shared_ptr<TMemoryBuffer> in,
+                 shared_ptr<TMemoryBuffer> out)
+    : processor_(processor), in_(in), out_(out) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    processor_->process([this](bool) {
+      done_ = true;
+      if (suspended_) {
+        handle_.resume();
+      }
+    }, in_, out_);
+    suspended_ = !done_;
+    return suspended_;
+  }
+
+  void await_resume() const noexcept {}
+
+private:
+  TAsyncBufferProcessor* processor_;
+  shared_ptr<TMemoryBuffer> in_;
+  shared_ptr<TMemoryBuffer> out_;
+  std::coroutine_handle<> handle_;
+  bool done_ = false;
+  bool suspended_ = false;
+};
+
+/**
+ * Channel that hands every message straight to a processor in the same
+ * thread.
+ */
+class LoopbackChannel : public TCoroChannel {
+public:
+  explicit LoopbackChannel(shared_ptr<TAsyncBufferProcessor> processor) : processor_(processor) {}
+
+  bool good() const override { return true; }
+
+  TTask<void> sendMessage(TMemoryBuffer* message) override {
+    shared_ptr<TMemoryBuffer> out(new TMemoryBuffer());
+    co_await ProcessAwaiter(processor_.get(), copy(message), out);
+  }
+
+  TTask<void> recvMessage(TMemoryBuffer*) override {
+    throw TTransportException(TTransportException::NOT_OPEN, "recvMessage not supported");
+  }
+
+  TTask<void> sendAndRecvMessage(TMemoryBuffer* sendBuf, TMemoryBuffer* recvBuf) override {
+    shared_ptr<TMemoryBuffer> out(new TMemoryBuffer());
+    co_await ProcessAwaiter(processor_.get(), copy(sendBuf), out);
+    recvBuf->resetBuffer();
+    recvBuf->write(reinterpret_cast<const uint8_t*>(out->getBufferAsString().data()),
+                   static_cast<uint32_t>(out->available_read()));
+  }
+
+private:
+  static shared_ptr<TMemoryBuffer> copy(TMemoryBuffer* message) {
+    shared_ptr<TMemoryBuffer> in(new TMemoryBuffer());
+    uint8_t* buf;
+    uint32_t len;
+    message->getBuffer(&buf, &len);
+    in->write(buf, len);
+    return in;
+  }
+
+  shared_ptr<TAsyncBufferProcessor> processor_;
+};
+
+struct Fixture {
+  Fixture()
+    : handler(new CalculatorHandler()),
+      protocolFactory(new TBinaryProtocolFactory()),
+      processor(new TAsyncProtocolProcessor(
+          shared_ptr<CalculatorCoroProcessor>(new CalculatorCoroProcessor(handler)),
+          protocolFactory)) {}
+
+  shared_ptr<CalculatorHandler> handler;
+  shared_ptr<TBinaryProtocolFactory> protocolFactory;
+  shared_ptr<TAsyncBufferProcessor> processor;
+};
+
+TTask<void> setWhenDone(TTask<void> task, bool* done) {
+  co_await task;
+  *done = true;
+}
+
+BOOST_FIXTURE_TEST_SUITE(CoroutineTest, Fixture)
+
+BOOST_AUTO_TEST_CASE(test_calls) {
+  CalculatorCoroClient client(shared_ptr<TCoroChannel>(new LoopbackChannel(processor)),
+                              protocolFactory);
+
+  BOOST_CHECK_EQUAL(3, syncWait(client.add(1, 2)));
+  BOOST_CHECK_EQUAL("pong", syncWait(client.ping()));
+
+  Point p;
+  p.x = 1;
+  p.y = 2;
+  Point moved = syncWait(client.translate(p, 10, 20));
+  BOOST_CHECK_EQUAL(11, moved.x);
+  BOOST_CHECK_EQUAL(22, moved.y);
+
+  BOOST_CHECK_THROW(syncWait(client.add(std::numeric_limits<int32_t>::max(), 1)), Overflow);
+
+  syncWait(client.fire(5));
+  BOOST_CHECK_EQUAL(5, handler->fired);
+}
+
+BOOST_AUTO_TEST_CASE(test_arguments_are_captured_at_call_time) {
+  CalculatorCoroClient client(shared_ptr<TCoroChannel>(new LoopbackChannel(processor)),
+                              protocolFactory);
+
+  TTask<Point> task;
+  {
+    Point p;
+    p.x = 7;
+    p.y = 8;
+    task = client.translate(p, 1, 1);
+  }
+  Point moved = syncWait(std::move(task));
+  BOOST_CHECK_EQUAL(8, moved.x);
+  BOOST_CHECK_EQUAL(9, moved.y);
+}
+
+BOOST_AUTO_TEST_CASE(test_handler_suspends) {
+  CalculatorCoroClient client(shared_ptr<TCoroChannel>(new LoopbackChannel(processor)),
+                              protocolFactory);
+
+  bool done = false;
+  setWhenDone(client.wait(), &done).detach();
+  BOOST_CHECK(handler->gate.waiting());
+  BOOST_CHECK(!done);
+
+  handler->gate.open();
+  BOOST_CHECK(done);
+}
+
+TTask<void> serveConnection(TEpollEventLoop* loop,
+                            TEpollSocketChannel* channel,
+                            TAsyncBufferProcessor* processor) {
+  for (;;) {
+    shared_ptr<TMemoryBuffer> in(new TMemoryBuffer());
+    shared_ptr<TMemoryBuffer> out(new TMemoryBuffer());
+    try {
+      co_await channel->recvMessage(in.get());
+    } catch (const TTransportException&) {
+      break;
+    }
+    co_await ProcessAwaiter(processor, in, out);
+    if (out->available_read() > 0) {
+      co_await channel->sendMessage(out.get());
+    }
+  }
+  loop->stop();
+}
+
+TTask<void> callConcurrently(CalculatorCoroClient* client, int32_t i, int* remaining) {
+  int32_t sum = co_await client->add(i, i);
+  BOOST_CHECK_EQUAL(2 * i, sum);
+  if (--*remaining == 0) {
+    // closing the connection makes the server side finish and stop the loop
+    static_cast<TEpollSocketChannel*>(client->getChannel().get())->getSocket()->close();
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_epoll_socket_channel) {
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  shared_ptr<TSocket> clientSocket(new TSocket(fds[0]));
+  shared_ptr<TSocket> serverSocket(new TSocket(fds[1]));
+
+  TEpollEventLoop loop;
+  TEpollSocketChannel serverChannel(&loop, serverSocket);
+  CalculatorCoroClient client(shared_ptr<TCoroChannel>(new TEpollSocketChannel(&loop, clientSocket)),
+                              protocolFactory);
+
+  serveConnection(&loop, &serverChannel, processor.get()).detach();
+
+  // All calls are issued before any of them completes; the channel queues
+  // them and the server answers them one at a time.
+  const int calls = 100;
+  int remaining = calls;
+  for (int32_t i = 0; i < calls; ++i) {
+    callConcurrently(&client, i, &remaining).detach();
+  }
+  loop.run();
+  BOOST_CHECK_EQUAL(0, remaining);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,42 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+namespace cpp corotest
+
+// services for CoroutineTest.cpp, generated with cpp:coroutines
+
+struct Point {
+  1: i32 x,
+  2: i32 y
+}
+
+exception Overflow {
+  1: string message
+}
+
+service CoroBase {
+  string ping()
+}
+
+service Calculator extends CoroBase {
+  i32 add(1: i32 a, 2: i32 b) throws (1: Overflow ouch),
+  Point translate(1: Point p, 2: i32 dx, 3: i32 dy),
+  void wait(),
+  oneway void fire(1: i32 n)
+}
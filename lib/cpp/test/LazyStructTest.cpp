@@ -0,0 +1,184 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+#include "gen-cpp/LazyStructTest_types.h"
+
+#define BOOST_TEST_MODULE LazyStructTest
+#include <boost/test/unit_test.hpp>
+
+using namespace thrift::test::lazy;
+using apache::thrift::protocol::T_STRUCT;
+using apache::thrift::protocol::TBinaryProtocol;
+using apache::thrift::protocol::TBinaryProtocolT;
+using apache::thrift::protocol::TCompactProtocol;
+using apache::thrift::protocol::TProtocolException;
+using apache::thrift::transport::TBufferedTransport;
+using apache::thrift::transport::TMemoryBuffer;
+using std::shared_ptr;
+using std::string;
+
+static Envelope makeEnvelope() {
+  Payload payload;
+  payload.blob = string(10000, 'x');
+  for (int64_t i = 0; i < 1000; ++i) {
+    payload.numbers.push_back(i * i);
+  }
+  payload.weights[1] = 0.5;
+  payload.weights[2] = 0.25;
+  payload.names.push_back("first");
+  payload.names.push_back("second");
+  payload.flags.insert(7);
+
+  Envelope envelope;
+  envelope.id = 42;
+  envelope.__set_payload(payload);
+  envelope.trailer = "end";
+  return envelope;
+}
+
+static string serialize(const Envelope& envelope) {
+  shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer());
+  TBinaryProtocol protocol(buffer);
+  envelope.write(&protocol);
+  return buffer->getBufferAsString();
+}
+
+static shared_ptr<TMemoryBuffer> bufferOf(const string& data) {
+  shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer());
+  buffer->write(reinterpret_cast<const uint8_t*>(data.data()), static_cast<uint32_t>(data.size()));
+  return buffer;
+}
+
+BOOST_AUTO_TEST_CASE(test_decoded_on_access) {
+  const Envelope original = makeEnvelope();
+  const string data = serialize(original);
+
+  Envelope copy;
+  TBinaryProtocol protocol(bufferOf(data));
+  BOOST_CHECK_EQUAL(data.size(), copy.read(&protocol));
+  BOOST_CHECK(!copy.payload.isDecoded());
+  BOOST_CHECK_EQUAL(42, copy.id);
+  BOOST_CHECK_EQUAL("end", copy.trailer);
+
+  BOOST_CHECK_EQUAL(10000u, copy.payload->blob.size());
+  BOOST_CHECK(copy.payload.isDecoded());
+  const Payload& payload = copy.payload;
+  BOOST_CHECK_EQUAL(999 * 999, payload.numbers.back());
+  BOOST_CHECK(copy == original);
+}
+
+BOOST_AUTO_TEST_CASE(test_forward_without_decoding) {
+  const string data = serialize(makeEnvelope());
+
+  Envelope proxy;
+  TBinaryProtocol in(bufferOf(data));
+  proxy.read(&in);
+  proxy.id = 43;
+
+  shared_ptr<TMemoryBuffer> output(new TMemoryBuffer());
+  TBinaryProtocol out(output);
+  proxy.write(&out);
+  BOOST_CHECK(!proxy.payload.isDecoded());
+
+  // only the id differs
+  string forwarded = output->getBufferAsString();
+  BOOST_REQUIRE_EQUAL(data.size(), forwarded.size());
+  BOOST_CHECK(data != forwarded);
+  Envelope check;
+  TBinaryProtocol checkIn(bufferOf(forwarded));
+  check.read(&checkIn);
+  BOOST_CHECK_EQUAL(43, check.id);
+  BOOST_CHECK(check.payload.get() == makeEnvelope().payload.get());
+}
+
+BOOST_AUTO_TEST_CASE(test_other_protocols) {
+  const Envelope original = makeEnvelope();
+
+  // the compact protocol decodes as it reads
+  shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer());
+  TCompactProtocol compact(buffer);
+  original.write(&compact);
+  Envelope copy;
+  copy.read(&compact);
+  BOOST_CHECK(copy.payload.isDecoded());
+  BOOST_CHECK(copy == original);
+
+  // encoded bytes are decoded for a protocol that cannot take them
+  Envelope lazy;
+  TBinaryProtocol binary(bufferOf(serialize(original)));
+  lazy.read(&binary);
+  lazy.write(&compact);
+  BOOST_CHECK(lazy.payload.isDecoded());
+  Envelope roundtrip;
+  roundtrip.read(&compact);
+  BOOST_CHECK(roundtrip == original);
+}
+
+BOOST_AUTO_TEST_CASE(test_assign_and_swap) {
+  const string data = serialize(makeEnvelope());
+  Envelope a;
+  TBinaryProtocol protocol(bufferOf(data));
+  a.read(&protocol);
+
+  Envelope b;
+  b.payload = Payload();
+  using std::swap;
+  swap(a, b);
+  BOOST_CHECK(!b.payload.isDecoded());
+  BOOST_CHECK(a.payload.isDecoded());
+  BOOST_CHECK(a.payload->blob.empty());
+  BOOST_CHECK_EQUAL(10000u, b.payload->blob.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_skip_unknown_fields) {
+  const string data = serialize(makeEnvelope());
+
+  // unknown payloads are skipped in bulk
+  EnvelopeHeader header;
+  shared_ptr<TMemoryBuffer> buffer = bufferOf(data);
+  TBinaryProtocolT<TMemoryBuffer> protocol(buffer);
+  BOOST_CHECK_EQUAL(data.size(), header.read(&protocol));
+  BOOST_CHECK_EQUAL(42, header.id);
+  BOOST_CHECK_EQUAL("end", header.trailer);
+  BOOST_CHECK_EQUAL(0u, buffer->available_read());
+
+  // a transport that cannot lend that many bytes
+  shared_ptr<TBufferedTransport> buffered(new TBufferedTransport(bufferOf(data), 64));
+  TBinaryProtocol streamed(buffered);
+  BOOST_CHECK_EQUAL(data.size(), streamed.skip(T_STRUCT));
+}
+
+BOOST_AUTO_TEST_CASE(test_skip_limits) {
+  const string data = serialize(makeEnvelope());
+
+  TBinaryProtocol limited(bufferOf(data), 0, 100, false, true);
+  BOOST_CHECK_THROW(limited.skip(T_STRUCT), TProtocolException);
+
+  Envelope lazy;
+  TBinaryProtocol lazyLimited(bufferOf(data), 0, 100, false, true);
+  BOOST_CHECK_THROW(lazy.read(&lazyLimited), TProtocolException);
+
+  // truncated input
+  TBinaryProtocol truncated(bufferOf(data.substr(0, data.size() / 2)));
+  BOOST_CHECK_THROW(truncated.skip(T_STRUCT), std::exception);
+}
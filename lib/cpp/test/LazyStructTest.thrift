@@ -0,0 +1,44 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+// Generated with --gen cpp for LazyStructTest.cpp
+
+namespace cpp thrift.test.lazy
+
+struct Payload {
+  1: string blob
+  2: list<i64> numbers
+  3: map<i32, double> weights
+  4: list<string> names
+  5: set<i16> flags
+}
+
+struct Envelope {
+  1: i32 id
+  2: Payload payload (cpp.lazy)
+  3: optional Payload extra (cpp.lazy)
+  4: string trailer
+}
+
+// What a reader that does not know about the payloads sees
+struct EnvelopeHeader {
+  1: i32 id
+  4: string trailer
+}
@@ -0,0 +1,162 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <limits>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+#include "gen-cpp/SerializedSizeTest_types.h"
+
+#define BOOST_TEST_MODULE SerializedSizeTest
+#include <boost/test/unit_test.hpp>
+
+using namespace thrift::test::size;
+using apache::thrift::protocol::TBinaryProtocolT;
+using apache::thrift::protocol::TCompactProtocolT;
+using apache::thrift::transport::TFramedTransport;
+using apache::thrift::transport::TMemoryBuffer;
+using std::shared_ptr;
+using std::string;
+
+typedef TBinaryProtocolT<TMemoryBuffer> Binary;
+typedef TCompactProtocolT<TMemoryBuffer> Compact;
+
+template <class Protocol_, class Struct_>
+static void checkSize(const Struct_& value) {
+  shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer());
+  Protocol_ proto(buffer);
+  value.write(&proto);
+  // compare against the bytes on the wire: write() does not count the stop
+  // byte of a null reference
+  BOOST_CHECK_EQUAL(buffer->available_read(), value.template serializedSize<Protocol_>());
+}
+
+template <class Struct_>
+static void checkBoth(const Struct_& value) {
+  checkSize<Binary>(value);
+  checkSize<Compact>(value);
+}
+
+static Everything makeEverything() {
+  Everything value;
+  value.flag = true;
+  value.tiny = -3;
+  value.small = -20000;
+  value.medium = (std::numeric_limits<int32_t>::min)();
+  value.large = 1LL << 50;
+  value.real = 2.5;
+  value.text = string(200, 't');
+  value.blob = string(3, '\0');
+  value.color = Color::BLUE;
+  for (int32_t i = -50; i < 50; ++i) {
+    value.ints.push_back(i * 1000);
+  }
+  value.bools.assign(20, true);
+  value.reals.insert(1.0);
+  value.reals.insert(-1.0);
+  for (int16_t i = 0; i < 10; ++i) {
+    value.fixed_map[i] = -static_cast<int64_t>(i) << 40;
+  }
+  Point point;
+  point.x = 1;
+  point.y = -70000;
+  value.nested["a"].push_back(point);
+  value.nested["b"];
+  value.colors.push_back(Color::RED);
+  value.colors.push_back(Color::BLUE);
+  value.origin = point;
+  value.__set_corner(point);
+  value.__set_note("note");
+  value.far_flag = false;
+  value.far_field = 123456;
+  value.chain.label = "head";
+  value.chain.__set_child(std::make_shared<Node>());
+  value.chain.child->label = "tail";
+  return value;
+}
+
+BOOST_AUTO_TEST_CASE(empty_structs) {
+  checkBoth(Point());
+  checkBoth(Node());
+  checkBoth(Everything());
+  checkBoth(Outcome());
+}
+
+BOOST_AUTO_TEST_CASE(populated_structs) {
+  Everything value = makeEverything();
+  checkBoth(value);
+  checkBoth(value.chain);
+
+  Outcome outcome;
+  outcome.__set_value(value);
+  checkBoth(outcome);
+
+  Failure failure;
+  failure.message = "failed";
+  failure.code = -1;
+  outcome.__isset.value = false;
+  outcome.__set_failure(failure);
+  checkBoth(outcome);
+}
+
+BOOST_AUTO_TEST_CASE(null_reference) {
+  // a set but null cpp.ref field is written as an empty struct
+  Node node;
+  node.__isset.child = true;
+  checkBoth(node);
+}
+
+BOOST_AUTO_TEST_CASE(fixed_size_is_constant) {
+  Point point;
+  BOOST_CHECK_EQUAL(15u, point.serializedSize<Binary>());
+  point.x = -1;
+  point.y = (std::numeric_limits<int32_t>::max)();
+  BOOST_CHECK_EQUAL(15u, point.serializedSize<Binary>());
+
+  // varints in compact: 1 header + 1 byte, 1 header + 5 bytes, stop
+  BOOST_CHECK_EQUAL(9u, point.serializedSize<Compact>());
+}
+
+BOOST_AUTO_TEST_CASE(reserve_once) {
+  Everything value = makeEverything();
+  uint32_t size = value.serializedSize<Binary>();
+
+  shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer(16));
+  buffer->reserve(size);
+  uint32_t capacity = buffer->getBufferSize();
+  BOOST_CHECK_GE(capacity, size);
+  Binary proto(buffer);
+  value.write(&proto);
+  BOOST_CHECK_EQUAL(capacity, buffer->getBufferSize());
+
+  shared_ptr<TMemoryBuffer> sink(new TMemoryBuffer());
+  shared_ptr<TFramedTransport> framed(new TFramedTransport(sink, 16));
+  framed->reserve(size);
+  TBinaryProtocolT<TFramedTransport> framedProto(framed);
+  value.write(&framedProto);
+  framed->flush();
+  BOOST_CHECK_EQUAL(size + 4, sink->available_read());
+
+  // reserving less than what is free is a no-op
+  framed->reserve(1);
+  value.write(&framedProto);
+  framed->flush();
+  BOOST_CHECK_EQUAL(2 * (size + 4), sink->available_read());
+}
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+// Generated with --gen cpp:serialized_size for SerializedSizeTest.cpp
+
+namespace cpp thrift.test.size
+
+enum Color {
+  RED = 1,
+  BLUE = 300
+}
+
+typedef i64 Timestamp
+
+struct Point {
+  1: i32 x
+  2: i32 y
+}
+
+struct Node {
+  1: string label
+  2: optional Node & child
+}
+
+struct Everything {
+  1: bool flag
+  2: i8 tiny
+  3: i16 small
+  4: i32 medium
+  5: Timestamp large
+  6: double real
+  7: string text
+  8: binary blob
+  9: Color color
+  10: list<i32> ints
+  11: list<bool> bools
+  12: set<double> reals
+  13: map<i16, i64> fixed_map
+  14: map<string, list<Point>> nested
+  15: list<Color> colors
+  16: Point origin
+  17: optional Point corner
+  18: optional string note
+  40: bool far_flag
+  200: i32 far_field
+  201: Node chain
+}
+
+exception Failure {
+  1: string message
+  2: i32 code
+}
+
+struct Outcome {
+  1: optional Everything value
+  2: optional Failure failure
+}
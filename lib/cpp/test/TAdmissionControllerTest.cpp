@@ -0,0 +1,156 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <thrift/TApplicationException.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/server/TAdmissionController.h>
+#include <thrift/transport/TBufferTransports.h>
+
+BOOST_AUTO_TEST_SUITE(TAdmissionControllerTest)
+
+using apache::thrift::TApplicationException;
+using apache::thrift::protocol::TBinaryProtocol;
+using apache::thrift::protocol::TMessageType;
+using apache::thrift::server::TAdmissionController;
+using apache::thrift::server::TAIMDAdmissionController;
+using apache::thrift::server::TGradientAdmissionController;
+using apache::thrift::transport::TMemoryBuffer;
+using std::shared_ptr;
+
+BOOST_AUTO_TEST_CASE(test_aimd_limit) {
+  TAIMDAdmissionController uut(2, 1, 3, 0.5, 1000);
+
+  BOOST_CHECK(uut.tryAcquire());
+  BOOST_CHECK(uut.tryAcquire());
+  BOOST_CHECK(!uut.tryAcquire());
+  BOOST_CHECK_EQUAL(1u, uut.getRejectedCount());
+  BOOST_CHECK_EQUAL(2, uut.getInFlight());
+
+  // fast completion at full utilization grows the limit
+  uut.release(10);
+  BOOST_CHECK_EQUAL(3, uut.getLimit());
+  BOOST_CHECK_EQUAL(1, uut.getInFlight());
+
+  // never above maxLimit
+  BOOST_CHECK(uut.tryAcquire());
+  BOOST_CHECK(uut.tryAcquire());
+  uut.release(10);
+  BOOST_CHECK_EQUAL(3, uut.getLimit());
+
+  // slow completion backs off
+  uut.release(5000);
+  BOOST_CHECK_EQUAL(1, uut.getLimit());
+
+  // dropped requests back off, but never below minLimit
+  uut.release(10, true);
+  BOOST_CHECK_EQUAL(1, uut.getLimit());
+  BOOST_CHECK_EQUAL(0, uut.getInFlight());
+}
+
+BOOST_AUTO_TEST_CASE(test_aimd_idle_does_not_grow) {
+  TAIMDAdmissionController uut(10);
+  for (int i = 0; i < 100; ++i) {
+    BOOST_CHECK(uut.tryAcquire());
+    uut.release(10);
+  }
+  BOOST_CHECK_EQUAL(10, uut.getLimit());
+}
+
+BOOST_AUTO_TEST_CASE(test_gradient_limit) {
+  TGradientAdmissionController uut(10, 1, 100);
+
+  // steady latency under load lets the limit grow
+  for (int i = 0; i < 50; ++i) {
+    for (int j = 0; j < uut.getLimit(); ++j) {
+      BOOST_CHECK(uut.tryAcquire());
+    }
+    while (uut.getInFlight() > 0) {
+      uut.release(1000);
+    }
+  }
+  const int64_t grown = uut.getLimit();
+  BOOST_CHECK_GT(grown, 10);
+
+  // a latency spike shrinks it again
+  for (int i = 0; i < 20; ++i) {
+    BOOST_CHECK(uut.tryAcquire());
+    uut.release(100000);
+  }
+  BOOST_CHECK_LT(uut.getLimit(), grown);
+  BOOST_CHECK_GE(uut.getLimit(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid_arguments) {
+  BOOST_CHECK_THROW(TAIMDAdmissionController(0), std::invalid_argument);
+  BOOST_CHECK_THROW(TAIMDAdmissionController(10, 5, 4), std::invalid_argument);
+  BOOST_CHECK_THROW(TAIMDAdmissionController(10, 1, 100, 1.5), std::invalid_argument);
+  BOOST_CHECK_THROW(TGradientAdmissionController(10, 1, 100, 0.0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_reject_request) {
+  shared_ptr<TMemoryBuffer> request(new TMemoryBuffer());
+  shared_ptr<TMemoryBuffer> response(new TMemoryBuffer());
+  TBinaryProtocol in(request);
+  TBinaryProtocol out(response);
+
+  in.writeMessageBegin("testVoid", apache::thrift::protocol::T_CALL, 42);
+  in.writeStructBegin("testVoid_args");
+  in.writeFieldBegin("thing", apache::thrift::protocol::T_I32, 1);
+  in.writeI32(7);
+  in.writeFieldEnd();
+  in.writeFieldStop();
+  in.writeStructEnd();
+  in.writeMessageEnd();
+
+  TAdmissionController::rejectRequest(&in, &out);
+  BOOST_CHECK_EQUAL(0u, request->available_read());
+
+  std::string fname;
+  TMessageType mtype;
+  int32_t seqid;
+  out.readMessageBegin(fname, mtype, seqid);
+  BOOST_CHECK_EQUAL("testVoid", fname);
+  BOOST_CHECK_EQUAL(apache::thrift::protocol::T_EXCEPTION, mtype);
+  BOOST_CHECK_EQUAL(42, seqid);
+  TApplicationException x;
+  x.read(&out);
+  out.readMessageEnd();
+  BOOST_CHECK_EQUAL(TApplicationException::INTERNAL_ERROR, x.getType());
+}
+
+BOOST_AUTO_TEST_CASE(test_reject_oneway_request) {
+  shared_ptr<TMemoryBuffer> request(new TMemoryBuffer());
+  shared_ptr<TMemoryBuffer> response(new TMemoryBuffer());
+  TBinaryProtocol in(request);
+  TBinaryProtocol out(response);
+
+  in.writeMessageBegin("testOneway", apache::thrift::protocol::T_ONEWAY, 1);
+  in.writeStructBegin("testOneway_args");
+  in.writeFieldStop();
+  in.writeStructEnd();
+  in.writeMessageEnd();
+
+  TAdmissionController::rejectRequest(&in, &out);
+  BOOST_CHECK_EQUAL(0u, request->available_read());
+  BOOST_CHECK_EQUAL(0u, response->available_read());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -26,7 +26,10 @@
 using std::shared_ptr;
 using apache::thrift::transport::TMemoryBuffer;
 using apache::thrift::transport::TBufferedTransport;
+using apache::thrift::transport::TBufferedTransportFactory;
 using apache::thrift::transport::TFramedTransport;
+using apache::thrift::transport::TFramedTransportFactory;
+using apache::thrift::transport::TTransport;
 using apache::thrift::transport::test::TShortReadTransport;
 using std::string;
 
@@ -635,5 +638,56 @@ BOOST_AUTO_TEST_CASE( test_FramedTransport_Empty_Flush ) {
   BOOST_CHECK_EQUAL(buffer->getBufferAsString(), output2);
 }
 
+BOOST_AUTO_TEST_CASE( test_BufferedTransport_Reset ) {
+  shared_ptr<TMemoryBuffer> buffer1(new TMemoryBuffer());
+  shared_ptr<TMemoryBuffer> buffer2(new TMemoryBuffer());
+  buffer1->write((const uint8_t*)"abcd", 4);
+  buffer2->write((const uint8_t*)"wxyz", 4);
+
+  TBufferedTransportFactory factory;
+  shared_ptr<TTransport> trans = factory.getTransport(buffer1);
+
+  // leave unread and unflushed data behind; none of it may leak through
+  uint8_t buf[4];
+  BOOST_CHECK_EQUAL(trans->read(buf, 1), 1u);
+  trans->write((const uint8_t*)"lost", 4);
+
+  BOOST_REQUIRE(factory.resetTransport(trans, buffer2));
+  BOOST_CHECK(dynamic_cast<TBufferedTransport*>(trans.get())->getUnderlyingTransport() == buffer2);
+  BOOST_CHECK_EQUAL(trans->readAll(buf, 4), 4u);
+  BOOST_CHECK(!memcmp(buf, "wxyz", 4));
+  trans->write((const uint8_t*)"kept", 4);
+  trans->flush();
+  BOOST_CHECK_EQUAL(buffer2->getBufferAsString(), "kept");
+  // the buffered transport had drained buffer1; "lost" must not appear
+  BOOST_CHECK_EQUAL(buffer1->getBufferAsString(), "");
+
+  // a transport from a different factory is not reset
+  BOOST_CHECK(!factory.resetTransport(buffer1, buffer2));
+}
+
+BOOST_AUTO_TEST_CASE( test_FramedTransport_Reset ) {
+  shared_ptr<TMemoryBuffer> buffer1(new TMemoryBuffer());
+  shared_ptr<TMemoryBuffer> buffer2(new TMemoryBuffer());
+  buffer1->write((const uint8_t*)"\x00\x00\x00\x04""abcd", 8);
+  buffer2->write((const uint8_t*)"\x00\x00\x00\x02""yz", 6);
+
+  TFramedTransportFactory factory;
+  shared_ptr<TTransport> trans = factory.getTransport(buffer1);
+
+  uint8_t buf[4];
+  BOOST_CHECK_EQUAL(trans->read(buf, 1), 1u);
+  trans->write((const uint8_t*)"lost", 4);
+
+  BOOST_REQUIRE(factory.resetTransport(trans, buffer2));
+  BOOST_CHECK_EQUAL(trans->readAll(buf, 2), 2u);
+  BOOST_CHECK(!memcmp(buf, "yz", 2));
+  trans->write((const uint8_t*)"a", 1);
+  trans->flush();
+  BOOST_CHECK_EQUAL(buffer2->getBufferAsString(), string("\x00\x00\x00\x01""a", 5));
+
+  BOOST_CHECK(!TBufferedTransportFactory().resetTransport(trans, buffer1));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
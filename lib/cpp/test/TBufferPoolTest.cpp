@@ -0,0 +1,177 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <string>
+#include <thrift/server/TBufferPool.h>
+#include <thrift/transport/TBufferTransports.h>
+
+BOOST_AUTO_TEST_SUITE(TBufferPoolTest)
+
+using apache::thrift::server::TBufferPool;
+using apache::thrift::server::TBufferPoolStats;
+using apache::thrift::transport::TMemoryBuffer;
+using apache::thrift::transport::TTransportException;
+
+BOOST_AUTO_TEST_CASE(test_size_classes) {
+  TBufferPool uut(0, 1000, 8192);
+
+  uint32_t size = 1;
+  uint8_t* small = uut.allocate(&size);
+  BOOST_REQUIRE(small != nullptr);
+  BOOST_CHECK_EQUAL(1024u, size);
+
+  size = 1025;
+  uint8_t* medium = uut.allocate(&size);
+  BOOST_CHECK_EQUAL(2048u, size);
+
+  // larger than the largest class: exact size, never cached
+  size = 10000;
+  uint8_t* large = uut.allocate(&size);
+  BOOST_CHECK_EQUAL(10000u, size);
+  BOOST_CHECK_EQUAL(1024u + 2048u + 10000u, uut.getBytesInUse());
+
+  uut.release(small, 1024);
+  uut.release(medium, 2048);
+  uut.release(large, 10000);
+
+  TBufferPoolStats stats = uut.getStats();
+  BOOST_CHECK_EQUAL(0u, stats.bytesInUse);
+  BOOST_CHECK_EQUAL(1024u + 2048u + 10000u, stats.peakBytesInUse);
+  BOOST_CHECK_EQUAL(1024u + 2048u, stats.bytesCached);
+  BOOST_CHECK_EQUAL(3u, stats.allocations);
+  BOOST_CHECK_EQUAL(0u, stats.hits);
+}
+
+BOOST_AUTO_TEST_CASE(test_reuse) {
+  TBufferPool uut;
+
+  uint32_t size = 100;
+  uint8_t* first = uut.allocate(&size);
+  uut.release(first, size);
+
+  size = 1000;
+  uint8_t* second = uut.allocate(&size);
+  BOOST_CHECK(first == second);
+  BOOST_CHECK_EQUAL(1u, uut.getStats().hits);
+  BOOST_CHECK_EQUAL(0u, uut.getStats().bytesCached);
+  uut.release(second, size);
+
+  uut.trim();
+  BOOST_CHECK_EQUAL(0u, uut.getStats().bytesCached);
+}
+
+BOOST_AUTO_TEST_CASE(test_regrown_buffer) {
+  TBufferPool uut(0, 1024, 4096);
+
+  uint32_t size = 1024;
+  uint8_t* buffer = uut.allocate(&size);
+  buffer = static_cast<uint8_t*>(std::realloc(buffer, 3000));
+  BOOST_REQUIRE(buffer != nullptr);
+
+  // not a class size any more, so it is freed rather than cached
+  uut.release(buffer, 3000, size);
+  BOOST_CHECK_EQUAL(0u, uut.getBytesInUse());
+  BOOST_CHECK_EQUAL(0u, uut.getStats().bytesCached);
+}
+
+BOOST_AUTO_TEST_CASE(test_limit) {
+  TBufferPool uut(4096, 1024, 4096);
+
+  uint32_t size = 2048;
+  uint8_t* first = uut.allocate(&size);
+  size = 2048;
+  uint8_t* second = uut.allocate(&size);
+  BOOST_REQUIRE(first != nullptr && second != nullptr);
+
+  size = 1024;
+  BOOST_CHECK(uut.allocate(&size) == nullptr);
+  BOOST_CHECK_EQUAL(1u, uut.getStats().refusals);
+
+  // cached buffers make way for a different size class
+  uut.release(first, 2048);
+  uut.release(second, 2048);
+  BOOST_CHECK_EQUAL(4096u, uut.getStats().bytesCached);
+  size = 4096;
+  uint8_t* third = uut.allocate(&size);
+  BOOST_REQUIRE(third != nullptr);
+  BOOST_CHECK_EQUAL(0u, uut.getStats().bytesCached);
+  BOOST_CHECK_EQUAL(4096u, uut.getBytesInUse());
+  uut.release(third, size);
+}
+
+BOOST_AUTO_TEST_CASE(test_grow) {
+  TBufferPool uut(8192, 1024, 4096);
+
+  uint32_t size = 1024;
+  uint8_t* buffer = uut.allocate(&size);
+  BOOST_REQUIRE(buffer != nullptr);
+
+  TMemoryBuffer transport(0);
+  transport.resetBuffer(buffer, size, TMemoryBuffer::TAKE_OWNERSHIP);
+  transport.resetBuffer();
+  std::string data(3000, 'x');
+  transport.write(reinterpret_cast<const uint8_t*>(data.data()), static_cast<uint32_t>(data.size()));
+  BOOST_CHECK_EQUAL(4096u, transport.getBufferSize());
+
+  BOOST_CHECK(uut.grow(size, transport.getBufferSize()));
+  BOOST_CHECK_EQUAL(4096u, uut.getBytesInUse());
+  BOOST_CHECK_EQUAL(4096u, uut.getStats().peakBytesInUse);
+
+  // past the limit: refused, and the charge stays as it was
+  BOOST_CHECK(!uut.grow(4096, 16384));
+  BOOST_CHECK_EQUAL(4096u, uut.getBytesInUse());
+  BOOST_CHECK_EQUAL(1u, uut.getStats().refusals);
+
+  uint32_t released = 0;
+  buffer = transport.releaseBuffer(&released);
+  uut.release(buffer, released, 4096);
+  BOOST_CHECK_EQUAL(0u, uut.getBytesInUse());
+  BOOST_CHECK_EQUAL(4096u, uut.getStats().bytesCached);
+}
+
+BOOST_AUTO_TEST_CASE(test_memory_buffer_release) {
+  TBufferPool uut;
+
+  uint32_t size = 1024;
+  uint8_t* buffer = uut.allocate(&size);
+  TMemoryBuffer transport(0);
+  transport.resetBuffer(buffer, size, TMemoryBuffer::TAKE_OWNERSHIP);
+  transport.resetBuffer();
+  transport.write(reinterpret_cast<const uint8_t*>("abcd"), 4);
+  BOOST_CHECK_EQUAL("abcd", transport.getBufferAsString());
+
+  uint32_t released = 0;
+  BOOST_CHECK(transport.releaseBuffer(&released) == buffer);
+  BOOST_CHECK_EQUAL(size, released);
+  BOOST_CHECK_EQUAL(0u, transport.getBufferSize());
+  uut.release(buffer, released, size);
+  BOOST_CHECK_EQUAL(1024u, uut.getStats().bytesCached);
+
+  // still usable after giving its buffer away
+  transport.write(reinterpret_cast<const uint8_t*>("ef"), 2);
+  BOOST_CHECK_EQUAL("ef", transport.getBufferAsString());
+
+  uint8_t data[4];
+  TMemoryBuffer observer(data, sizeof(data));
+  BOOST_CHECK_THROW(observer.releaseBuffer(&released), TTransportException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,219 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/transport/TChainedBuffer.h>
+
+BOOST_AUTO_TEST_SUITE(TChainedBufferTest)
+
+using apache::thrift::protocol::TBinaryProtocolT;
+using apache::thrift::protocol::TCompactProtocolT;
+using apache::thrift::transport::TChainedBuffer;
+using apache::thrift::transport::TTransportException;
+using std::shared_ptr;
+using std::string;
+
+static void writeString(TChainedBuffer& buffer, const string& str) {
+  buffer.write(reinterpret_cast<const uint8_t*>(str.data()), static_cast<uint32_t>(str.size()));
+}
+
+static string readString(TChainedBuffer& buffer, uint32_t len) {
+  std::vector<uint8_t> data(len);
+  uint32_t got = buffer.read(data.data(), len);
+  return string(reinterpret_cast<const char*>(data.data()), got);
+}
+
+BOOST_AUTO_TEST_CASE(test_write_read_segments) {
+  TChainedBuffer uut(8);
+  writeString(uut, "abcdef");
+  writeString(uut, "ghijkl");
+  writeString(uut, "mnopqrstuvwxyz");
+
+  // 8 byte segment, then 16 bytes, then the rest: nothing was moved
+  BOOST_CHECK_EQUAL(3u, uut.countSegments());
+  BOOST_CHECK_EQUAL(26u, uut.available_read());
+  BOOST_CHECK_EQUAL("abcdefghijklmnopqrstuvwxyz", uut.getBufferAsString());
+
+  BOOST_CHECK_EQUAL("abc", readString(uut, 3));
+  BOOST_CHECK_EQUAL("defghijklmno", readString(uut, 12));
+  BOOST_CHECK_EQUAL(2u, uut.countSegments());
+  BOOST_CHECK_EQUAL("pqrstuvwxyz", readString(uut, 100));
+  BOOST_CHECK_EQUAL(0u, uut.available_read());
+  BOOST_CHECK(!uut.peek());
+
+  // interleaved writes and reads in the same segment
+  writeString(uut, "12");
+  BOOST_CHECK_EQUAL("1", readString(uut, 1));
+  writeString(uut, "34");
+  BOOST_CHECK_EQUAL("234", readString(uut, 3));
+}
+
+BOOST_AUTO_TEST_CASE(test_borrow_across_segments) {
+  TChainedBuffer uut(4);
+  writeString(uut, "abcd");
+  writeString(uut, "efgh");
+
+  uint32_t len = 3;
+  const uint8_t* data = uut.borrow(nullptr, &len);
+  BOOST_REQUIRE(data != nullptr);
+  BOOST_CHECK_EQUAL(4u, len);
+  uut.consume(3);
+
+  // "d" is in the first segment, "efg" in the second
+  len = 4;
+  data = uut.borrow(nullptr, &len);
+  BOOST_REQUIRE(data != nullptr);
+  BOOST_CHECK_EQUAL(4u, len);
+  BOOST_CHECK_EQUAL("defg", string(reinterpret_cast<const char*>(data), 4));
+  uut.consume(4);
+  BOOST_CHECK_EQUAL("h", uut.getBufferAsString());
+
+  len = 2;
+  BOOST_CHECK(uut.borrow(nullptr, &len) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(test_protocol_roundtrip) {
+  // tiny segments so that nearly every field spans a boundary
+  shared_ptr<TChainedBuffer> buffer(new TChainedBuffer(3));
+  TBinaryProtocolT<TChainedBuffer> binary(buffer);
+  TCompactProtocolT<TChainedBuffer> compact(buffer);
+
+  binary.writeI32(0x01020304);
+  binary.writeI64(-1234567890123LL);
+  binary.writeString(string(100, 'x'));
+  binary.writeDouble(3.25);
+  compact.writeI64(987654321);
+  compact.writeString("compact");
+
+  int32_t i32;
+  int64_t i64;
+  string str;
+  double d;
+  binary.readI32(i32);
+  binary.readI64(i64);
+  binary.readString(str);
+  binary.readDouble(d);
+  BOOST_CHECK_EQUAL(0x01020304, i32);
+  BOOST_CHECK_EQUAL(-1234567890123LL, i64);
+  BOOST_CHECK_EQUAL(string(100, 'x'), str);
+  BOOST_CHECK_EQUAL(3.25, d);
+  compact.readI64(i64);
+  compact.readString(str);
+  BOOST_CHECK_EQUAL(987654321, i64);
+  BOOST_CHECK_EQUAL("compact", str);
+  BOOST_CHECK_EQUAL(0u, buffer->available_read());
+}
+
+BOOST_AUTO_TEST_CASE(test_clone) {
+  TChainedBuffer uut(4);
+  writeString(uut, "abcdef");
+  BOOST_CHECK_EQUAL("a", readString(uut, 1));
+
+  shared_ptr<TChainedBuffer> copy = uut.clone();
+  BOOST_CHECK_EQUAL("bcdef", copy->getBufferAsString());
+
+  // each side reads and writes independently
+  writeString(uut, "ghi");
+  writeString(*copy, "XYZ");
+  BOOST_CHECK_EQUAL("bc", readString(uut, 2));
+  BOOST_CHECK_EQUAL("defghi", uut.getBufferAsString());
+  BOOST_CHECK_EQUAL("bcdefXYZ", copy->getBufferAsString());
+}
+
+BOOST_AUTO_TEST_CASE(test_split_frames) {
+  TChainedBuffer uut(16);
+  writeString(uut, "first");
+  writeString(uut, "second");
+  writeString(uut, "third");
+
+  shared_ptr<TChainedBuffer> first = uut.split(5);
+  shared_ptr<TChainedBuffer> second = uut.split(6);
+  BOOST_CHECK_EQUAL("first", first->getBufferAsString());
+  BOOST_CHECK_EQUAL("second", second->getBufferAsString());
+  BOOST_CHECK_EQUAL("third", uut.getBufferAsString());
+  BOOST_CHECK_THROW(uut.split(6), TTransportException);
+
+  // the remainder can still be appended to without disturbing the frames
+  writeString(uut, "fourth");
+  BOOST_CHECK_EQUAL("thirdfourth", uut.getBufferAsString());
+  BOOST_CHECK_EQUAL("second", readString(*second, 100));
+  BOOST_CHECK_EQUAL("first", first->getBufferAsString());
+}
+
+BOOST_AUTO_TEST_CASE(test_append) {
+  TChainedBuffer head;
+  TChainedBuffer body;
+  writeString(head, "head:");
+  writeString(body, "body");
+
+  head.append(body);
+  writeString(head, ":tail");
+  BOOST_CHECK_EQUAL(3u, head.countSegments());
+  BOOST_CHECK_EQUAL("head:body:tail", head.getBufferAsString());
+  BOOST_CHECK_EQUAL("body", body.getBufferAsString());
+
+  head.append(head);
+  BOOST_CHECK_EQUAL("head:body:tailhead:body:tail", head.getBufferAsString());
+}
+
+BOOST_AUTO_TEST_CASE(test_write_to_socket) {
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+  TChainedBuffer uut(4);
+  writeString(uut, "scat");
+  writeString(uut, "ter/");
+  writeString(uut, "gather");
+  BOOST_CHECK_GT(uut.countSegments(), 1u);
+
+  uint32_t sent = 0;
+  while (uut.available_read() > 0) {
+    sent += uut.writeTo(fds[0]);
+  }
+  BOOST_CHECK_EQUAL(14u, sent);
+
+  char received[32];
+  ssize_t got = ::recv(fds[1], received, sizeof(received), 0);
+  BOOST_CHECK_EQUAL("scatter/gather", string(received, got > 0 ? got : 0));
+  BOOST_CHECK_EQUAL(0u, uut.writeTo(fds[0]));
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(test_reset) {
+  TChainedBuffer uut(4);
+  writeString(uut, "abcdefghij");
+  uut.resetBuffer();
+  BOOST_CHECK_EQUAL(0u, uut.available_read());
+  BOOST_CHECK_EQUAL(0u, uut.countSegments());
+
+  writeString(uut, "xyz");
+  BOOST_CHECK_EQUAL(1u, uut.countSegments());
+  BOOST_CHECK_EQUAL("xyz", readString(uut, 3));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
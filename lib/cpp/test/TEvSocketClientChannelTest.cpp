@@ -0,0 +1,309 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#define BOOST_TEST_MODULE TEvSocketClientChannelTest
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "thrift/async/TEvSocketClientChannel.h"
+#include "thrift/concurrency/Monitor.h"
+#include "thrift/concurrency/ThreadFactory.h"
+#include "thrift/protocol/TBinaryProtocol.h"
+#include "thrift/protocol/THeaderProtocol.h"
+#include "thrift/server/TNonblockingServer.h"
+#include "thrift/transport/TNonblockingServerSocket.h"
+
+#include "gen-cpp/ParentService.h"
+
+#include <event.h>
+
+using apache::thrift::async::TEvSocketClientChannel;
+using apache::thrift::concurrency::Guard;
+using apache::thrift::concurrency::Monitor;
+using apache::thrift::concurrency::Mutex;
+using apache::thrift::concurrency::Runnable;
+using apache::thrift::concurrency::Thread;
+using apache::thrift::concurrency::ThreadFactory;
+using apache::thrift::protocol::TBinaryProtocolFactory;
+using apache::thrift::protocol::THeaderProtocolFactory;
+using apache::thrift::protocol::TProtocolFactory;
+using apache::thrift::server::TNonblockingServer;
+using apache::thrift::server::TServerEventHandler;
+using apache::thrift::test::ParentServiceCobClient;
+using apache::thrift::test::ParentServiceIf;
+using apache::thrift::test::ParentServiceProcessor;
+using apache::thrift::transport::TNonblockingServerSocket;
+using apache::thrift::transport::TTransportException;
+using std::shared_ptr;
+
+struct Handler : public ParentServiceIf {
+  Handler() : generation_(0) {}
+
+  int32_t incrementGeneration() override { return ++generation_; }
+  int32_t getGeneration() override { return generation_; }
+  void getDataWait(std::string& _return, const int32_t length) override {
+    // the server has no thread manager, so this holds up the whole connection
+    std::this_thread::sleep_for(std::chrono::milliseconds(length));
+    _return.assign(static_cast<size_t>(length), 'x');
+  }
+
+  // dummy overrides not used in this test
+  void addString(const std::string&) override {}
+  void getStrings(std::vector<std::string>&) override {}
+  void onewayWait() override {}
+  void exceptionWait(const std::string&) override {}
+  void unexpectedExceptionWait(const std::string&) override {}
+
+  int32_t generation_;
+};
+
+class Fixture {
+private:
+  struct ListenEventHandler : public TServerEventHandler {
+    ListenEventHandler() : listenMonitor_(&mutex_), ready_(false) {}
+
+    void preServe() override {
+      Guard g(listenMonitor_.mutex());
+      ready_ = true;
+      listenMonitor_.notify();
+    }
+
+    void waitReady() {
+      Guard g(listenMonitor_.mutex());
+      while (!ready_) {
+        listenMonitor_.wait();
+      }
+    }
+
+    Mutex mutex_;
+    Monitor listenMonitor_;
+    bool ready_;
+  };
+
+  struct Runner : public Runnable {
+    explicit Runner(shared_ptr<TNonblockingServer> server) : server_(server) {}
+    void run() override { server_->serve(); }
+    shared_ptr<TNonblockingServer> server_;
+  };
+
+protected:
+  Fixture() : handler(new Handler()), eb(event_base_new()) {}
+
+  ~Fixture() {
+    stopServer();
+    client.reset();
+    channel.reset();
+    event_base_free(eb);
+  }
+
+  void startServer(bool header = false) {
+    shared_ptr<ListenEventHandler> listenHandler(new ListenEventHandler());
+    server.reset(new TNonblockingServer(shared_ptr<ParentServiceProcessor>(
+                                            new ParentServiceProcessor(handler)),
+                                        shared_ptr<TNonblockingServerSocket>(
+                                            new TNonblockingServerSocket(0))));
+    if (header) {
+      // no output protocol factory means header transport
+      server->setInputProtocolFactory(shared_ptr<TProtocolFactory>(new THeaderProtocolFactory()));
+      server->setOutputProtocolFactory(shared_ptr<TProtocolFactory>());
+    }
+    server->setServerEventHandler(listenHandler);
+    thread = ThreadFactory(false).newThread(shared_ptr<Runnable>(new Runner(server)));
+    thread->start();
+    listenHandler->waitReady();
+  }
+
+  void stopServer() {
+    if (server) {
+      server->stop();
+      thread->join();
+      // the runner holds a reference too; drop both to close the listen socket
+      thread.reset();
+      server.reset();
+    }
+  }
+
+  void connect(TEvSocketClientChannel::Framing framing = TEvSocketClientChannel::FRAMED) {
+    if (framing == TEvSocketClientChannel::HEADER) {
+      protocolFactory.reset(new THeaderProtocolFactory());
+    } else {
+      protocolFactory.reset(new TBinaryProtocolFactory());
+    }
+    channel.reset(new TEvSocketClientChannel("localhost",
+                                             server->getListenPort(),
+                                             eb,
+                                             protocolFactory,
+                                             framing));
+    client.reset(new ParentServiceCobClient(channel, protocolFactory.get()));
+  }
+
+  void pipelinedCalls() {
+    const int32_t calls = 100;
+    std::vector<int32_t> results;
+    for (int32_t i = 0; i < calls; ++i) {
+      client->incrementGeneration([&](ParentServiceCobClient* c) {
+        results.push_back(c->recv_incrementGeneration());
+        if (results.size() == static_cast<size_t>(calls)) {
+          event_base_loopbreak(eb);
+        }
+      });
+    }
+    BOOST_CHECK_EQUAL(static_cast<size_t>(calls), channel->getPendingCount());
+
+    event_base_dispatch(eb);
+    BOOST_REQUIRE_EQUAL(static_cast<size_t>(calls), results.size());
+    for (int32_t i = 0; i < calls; ++i) {
+      BOOST_CHECK_EQUAL(i + 1, results[i]);
+    }
+    BOOST_CHECK_EQUAL(0u, channel->getPendingCount());
+  }
+
+  shared_ptr<Handler> handler;
+  event_base* eb;
+  shared_ptr<TNonblockingServer> server;
+  shared_ptr<Thread> thread;
+  shared_ptr<TProtocolFactory> protocolFactory;
+  shared_ptr<TEvSocketClientChannel> channel;
+  shared_ptr<ParentServiceCobClient> client;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TEvSocketClientChannelTest, Fixture)
+
+BOOST_AUTO_TEST_CASE(test_pipelined_calls) {
+  startServer();
+  connect();
+  pipelinedCalls();
+}
+
+BOOST_AUTO_TEST_CASE(test_pipelined_calls_header) {
+  startServer(true);
+  connect(TEvSocketClientChannel::HEADER);
+  pipelinedCalls();
+}
+
+BOOST_AUTO_TEST_CASE(test_call_timeout) {
+  startServer();
+  connect();
+
+  bool slowTimedOut = false;
+  int32_t generation = 0;
+  channel->setRecvTimeout(50);
+  client->getDataWait([&](ParentServiceCobClient* c) {
+    slowTimedOut = channel->timedOut();
+    std::string data;
+    BOOST_CHECK_THROW(c->recv_getDataWait(data), TTransportException);
+  }, 300);
+
+  // queued behind the slow call; its response must not be mistaken for the
+  // one the timed out call never consumed
+  channel->setRecvTimeout(0);
+  client->incrementGeneration([&](ParentServiceCobClient* c) {
+    BOOST_CHECK(!channel->timedOut());
+    generation = c->recv_incrementGeneration();
+    event_base_loopbreak(eb);
+  });
+
+  event_base_dispatch(eb);
+  BOOST_CHECK(slowTimedOut);
+  BOOST_CHECK_EQUAL(1, generation);
+  BOOST_CHECK(channel->good());
+}
+
+BOOST_AUTO_TEST_CASE(test_connection_failure) {
+  startServer();
+  int port = server->getListenPort();
+  stopServer();
+
+  protocolFactory.reset(new TBinaryProtocolFactory());
+  channel.reset(new TEvSocketClientChannel("localhost", port, eb, protocolFactory));
+  client.reset(new ParentServiceCobClient(channel, protocolFactory.get()));
+
+  int failed = 0;
+  for (int i = 0; i < 2; ++i) {
+    client->incrementGeneration([&](ParentServiceCobClient* c) {
+      BOOST_CHECK_THROW(c->recv_incrementGeneration(), TTransportException);
+      if (++failed == 2) {
+        event_base_loopbreak(eb);
+      }
+    });
+  }
+
+  event_base_dispatch(eb);
+  BOOST_CHECK_EQUAL(2, failed);
+  BOOST_CHECK(channel->error());
+  BOOST_CHECK(!channel->good());
+}
+
+BOOST_AUTO_TEST_CASE(test_callback_destroys_channel) {
+  startServer();
+  connect();
+
+  client->getGeneration([&](ParentServiceCobClient* c) {
+    c->recv_getGeneration();
+    event_base_loopbreak(eb);
+  });
+  event_base_dispatch(eb);
+
+  const int32_t calls = 10;
+  int completed = 0;
+  for (int32_t i = 0; i < calls; ++i) {
+    client->incrementGeneration([&](ParentServiceCobClient* c) {
+      ++completed;
+      BOOST_CHECK_EQUAL(1, c->recv_incrementGeneration());
+      client.reset();
+      channel.reset();
+    });
+  }
+
+  // send the requests, then let the responses pile up so that they are all
+  // read at once and the first callback runs with the rest still buffered
+  event_base_loop(eb, EVLOOP_NONBLOCK);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  event_base_dispatch(eb);
+  BOOST_CHECK_EQUAL(1, completed);
+  BOOST_CHECK(!channel);
+}
+
+BOOST_AUTO_TEST_CASE(test_callback_destroys_failed_channel) {
+  startServer();
+  int port = server->getListenPort();
+  stopServer();
+
+  protocolFactory.reset(new TBinaryProtocolFactory());
+  channel.reset(new TEvSocketClientChannel("localhost", port, eb, protocolFactory));
+  client.reset(new ParentServiceCobClient(channel, protocolFactory.get()));
+
+  int failed = 0;
+  for (int i = 0; i < 3; ++i) {
+    client->incrementGeneration([&](ParentServiceCobClient* c) {
+      ++failed;
+      BOOST_CHECK_THROW(c->recv_incrementGeneration(), TTransportException);
+      client.reset();
+      channel.reset();
+    });
+  }
+
+  event_base_dispatch(eb);
+  BOOST_CHECK_EQUAL(1, failed);
+  BOOST_CHECK(!channel);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
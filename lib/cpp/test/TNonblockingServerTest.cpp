@@ -19,10 +19,15 @@
 
 #define BOOST_TEST_MODULE TNonblockingServerTest
 #include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
 
 #include "thrift/concurrency/Monitor.h"
 #include "thrift/concurrency/Thread.h"
+#include "thrift/concurrency/ThreadManager.h"
+#include "thrift/server/TAdmissionController.h"
 #include "thrift/server/TNonblockingServer.h"
 #include "thrift/transport/TNonblockingServerSocket.h"
 
@@ -35,14 +40,44 @@ using apache::thrift::concurrency::Monitor;
 using apache::thrift::concurrency::Mutex;
 using apache::thrift::concurrency::ThreadFactory;
 using apache::thrift::concurrency::Runnable;
+using apache::thrift::concurrency::Synchronized;
 using apache::thrift::concurrency::Thread;
 using apache::thrift::concurrency::ThreadFactory;
+using apache::thrift::concurrency::ThreadManager;
 using apache::thrift::server::TServerEventHandler;
 using std::make_shared;
 using std::shared_ptr;
 
 using namespace apache::thrift;
 
+typedef protocol::TBinaryProtocolT<transport::TMemoryBuffer> MemoryBinaryProtocol;
+
+/**
+ * Processor specialized on the protocol the server uses, counting the calls
+ * that take the templated path.
+ */
+class CountingProcessor : public test::ParentServiceProcessorT<MemoryBinaryProtocol> {
+public:
+  CountingProcessor(shared_ptr<test::ParentServiceIf> handler)
+    : test::ParentServiceProcessorT<MemoryBinaryProtocol>(handler), templatedCalls(0) {}
+
+  int templatedCalls;
+
+protected:
+  bool dispatchCallTemplated(MemoryBinaryProtocol* in,
+                             MemoryBinaryProtocol* out,
+                             const std::string& fname,
+                             int32_t seqid,
+                             void* callContext) override {
+    ++templatedCalls;
+    return test::ParentServiceProcessorT<MemoryBinaryProtocol>::dispatchCallTemplated(in,
+                                                                                      out,
+                                                                                      fname,
+                                                                                      seqid,
+                                                                                      callContext);
+  }
+};
+
 struct Handler : public test::ParentServiceIf {
   void addString(const std::string& s) override { strings_.push_back(s); }
   void getStrings(std::vector<std::string>& _return) override { _return = strings_; }
@@ -57,6 +92,41 @@ struct Handler : public test::ParentServiceIf {
   void unexpectedExceptionWait(const std::string&) override {}
 };
 
+/**
+ * Holds every getDataWait call until the gate is opened, keeping its request
+ * in flight
+ */
+struct GateHandler : public Handler {
+  GateHandler() : entered_(0), open_(false) {}
+
+  void getDataWait(std::string& _return, const int32_t length) override {
+    Synchronized sync(gate_);
+    ++entered_;
+    gate_.notifyAll();
+    while (!open_) {
+      gate_.wait();
+    }
+    _return.assign(static_cast<size_t>(length), 'x');
+  }
+
+  void waitEntered(int entered) {
+    Synchronized sync(gate_);
+    while (entered_ < entered) {
+      gate_.wait();
+    }
+  }
+
+  void open() {
+    Synchronized sync(gate_);
+    open_ = true;
+    gate_.notifyAll();
+  }
+
+  Monitor gate_;
+  int entered_;
+  bool open_;
+};
+
 class Fixture {
 private:
   struct ListenEventHandler : public TServerEventHandler {
@@ -77,6 +147,10 @@ private:
     int port;
     shared_ptr<event_base> userEventBase;
     shared_ptr<TProcessor> processor;
+    shared_ptr<protocol::TProtocolFactory> protocolFactory;
+    shared_ptr<ThreadManager> threadManager;
+    shared_ptr<server::TBufferPool> bufferPool;
+    shared_ptr<server::TAdmissionController> admissionController;
     shared_ptr<server::TNonblockingServer> server;
     shared_ptr<ListenEventHandler> listenHandler;
     shared_ptr<transport::TNonblockingServerSocket> socket;
@@ -104,8 +178,13 @@ private:
     void startServer(int retry_count) {
       try {
         socket.reset(new transport::TNonblockingServerSocket(port));
-        server.reset(new server::TNonblockingServer(processor, socket));
+        server.reset(new server::TNonblockingServer(processor,
+                                                    protocolFactory,
+                                                    socket,
+                                                    threadManager));
         server->setServerEventHandler(listenHandler);
+        server->setBufferPool(bufferPool);
+        server->setAdmissionController(admissionController);
         if (userEventBase) {
           server->registerEvents(userEventBase.get());
         }
@@ -126,7 +205,9 @@ private:
   };
 
 protected:
-  Fixture() : processor(new test::ParentServiceProcessor(make_shared<Handler>())) {}
+  Fixture()
+    : protocolFactory_(new protocol::TBinaryProtocolFactory()),
+      processor(new test::ParentServiceProcessor(make_shared<Handler>())) {}
 
   ~Fixture() {
     if (server) {
@@ -141,11 +222,33 @@ protected:
     userEventBase_.reset(user_event_base, EventDeleter());
   }
 
+  void setThreadManager(shared_ptr<ThreadManager> threadManager) {
+    threadManager_ = threadManager;
+  }
+
+  void setBufferPool(shared_ptr<server::TBufferPool> bufferPool) {
+    bufferPool_ = bufferPool;
+  }
+
+  void setAdmissionController(shared_ptr<server::TAdmissionController> admissionController) {
+    admissionController_ = admissionController;
+  }
+
+  void setProcessor(shared_ptr<TProcessor> processor,
+                    shared_ptr<protocol::TProtocolFactory> protocolFactory) {
+    this->processor = processor;
+    protocolFactory_ = protocolFactory;
+  }
+
   int startServer(int port) {
     shared_ptr<Runner> runner(new Runner);
     runner->port = port;
     runner->processor = processor;
+    runner->protocolFactory = protocolFactory_;
     runner->userEventBase = userEventBase_;
+    runner->threadManager = threadManager_;
+    runner->bufferPool = bufferPool_;
+    runner->admissionController = admissionController_;
 
     shared_ptr<ThreadFactory> threadFactory(
         new ThreadFactory(false));
@@ -170,7 +273,11 @@ protected:
 
 private:
   shared_ptr<event_base> userEventBase_;
-  shared_ptr<test::ParentServiceProcessor> processor;
+  shared_ptr<ThreadManager> threadManager_;
+  shared_ptr<server::TBufferPool> bufferPool_;
+  shared_ptr<server::TAdmissionController> admissionController_;
+  shared_ptr<protocol::TProtocolFactory> protocolFactory_;
+  shared_ptr<TProcessor> processor;
 protected:
   shared_ptr<server::TNonblockingServer> server;
 private:
@@ -180,6 +287,14 @@ private:
 
 BOOST_AUTO_TEST_SUITE(TNonblockingServerTest)
 
+// The server gives its buffers back only after the client has its answer
+static bool waitForIdle(const shared_ptr<server::TBufferPool>& pool) {
+  for (int i = 0; i < 100 && pool->getBytesInUse() != 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return pool->getBytesInUse() == 0;
+}
+
 BOOST_FIXTURE_TEST_CASE(get_specified_port, Fixture) {
   int specified_port = startServer(12345);
   BOOST_REQUIRE_GE(specified_port, 12345);
@@ -212,4 +327,221 @@ BOOST_FIXTURE_TEST_CASE(provide_event_base, Fixture) {
 #endif
 }
 
+BOOST_FIXTURE_TEST_CASE(thread_pool_processing, Fixture) {
+  // Every request is handed to a worker and its completion queued back to
+  // the IO thread, so this exercises the task-done notification path.
+  shared_ptr<ThreadManager> threadManager = ThreadManager::newSimpleThreadManager(4);
+  threadManager->threadFactory(make_shared<ThreadFactory>());
+  threadManager->start();
+  setThreadManager(threadManager);
+  startServer(0);
+  int port = server->getListenPort();
+
+  const int clients = 8;
+  const int calls = 2000;
+  std::atomic<int> succeeded(0);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < clients; ++i) {
+    threads.emplace_back([&]() {
+      shared_ptr<transport::TSocket> socket(new transport::TSocket("localhost", port));
+      socket->open();
+      test::ParentServiceClient client(make_shared<protocol::TBinaryProtocol>(
+          make_shared<transport::TFramedTransport>(socket)));
+      for (int j = 0; j < calls; ++j) {
+        client.getGeneration();
+        ++succeeded;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  BOOST_CHECK_EQUAL(clients * calls, succeeded.load());
+  BOOST_TEST_MESSAGE("thread pool processing: " << clients * calls << " calls in "
+                     << elapsed.count() << " ms");
+
+  server->stop();
+  threadManager->stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(notify_stress, Fixture) {
+  // Many workers finish at once and push their completions onto the queue of
+  // the one IO thread while it takes and handles them.
+  shared_ptr<ThreadManager> threadManager = ThreadManager::newSimpleThreadManager(16);
+  threadManager->threadFactory(make_shared<ThreadFactory>());
+  threadManager->start();
+  setThreadManager(threadManager);
+  startServer(0);
+  BOOST_REQUIRE_EQUAL(1u, server->getNumIOThreads());
+  int port = server->getListenPort();
+
+  const int clients = 32;
+  const int calls = 500;
+  std::atomic<int> succeeded(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < clients; ++i) {
+    threads.emplace_back([&]() {
+      shared_ptr<transport::TSocket> socket(new transport::TSocket("localhost", port));
+      socket->open();
+      test::ParentServiceClient client(make_shared<protocol::TBinaryProtocol>(
+          make_shared<transport::TFramedTransport>(socket)));
+      for (int j = 0; j < calls; ++j) {
+        client.getGeneration();
+        ++succeeded;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BOOST_CHECK_EQUAL(clients * calls, succeeded.load());
+
+  server->stop();
+  threadManager->stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(templated_processor, Fixture) {
+  shared_ptr<CountingProcessor> counting(new CountingProcessor(make_shared<Handler>()));
+  setProcessor(counting,
+               make_shared<protocol::TBinaryProtocolFactoryT<transport::TMemoryBuffer> >());
+  startServer(0);
+
+  BOOST_CHECK(canCommunicate(server->getListenPort()));
+  BOOST_CHECK_EQUAL(2, counting->templatedCalls);
+}
+
+BOOST_FIXTURE_TEST_CASE(buffer_pool, Fixture) {
+  shared_ptr<server::TBufferPool> pool(new server::TBufferPool(1024 * 1024));
+  setBufferPool(pool);
+  startServer(0);
+  int port = server->getListenPort();
+
+  BOOST_CHECK(canCommunicate(port));
+
+  // each call borrows a read and a write buffer; the second call reuses them
+  server::TBufferPoolStats stats = pool->getStats();
+  BOOST_CHECK_EQUAL(4u, stats.allocations);
+  BOOST_CHECK_EQUAL(2u, stats.hits);
+  BOOST_CHECK_EQUAL(0u, stats.refusals);
+  BOOST_CHECK(!server->serverOverloaded());
+}
+
+BOOST_FIXTURE_TEST_CASE(buffer_pool_exhausted, Fixture) {
+  shared_ptr<server::TBufferPool> pool(new server::TBufferPool(2048, 1024));
+  setBufferPool(pool);
+  startServer(0);
+  int port = server->getListenPort();
+
+  // leave no room for the connection's buffers
+  uint32_t size = 2048;
+  uint8_t* hog = pool->allocate(&size);
+  BOOST_CHECK_THROW(canCommunicate(port), transport::TTransportException);
+  BOOST_CHECK_EQUAL(1u, pool->getStats().refusals);
+  BOOST_CHECK(server->serverOverloaded());
+
+  pool->release(hog, size);
+  BOOST_CHECK(!server->serverOverloaded());
+  BOOST_CHECK(canCommunicate(port));
+}
+
+BOOST_FIXTURE_TEST_CASE(buffer_pool_grown_response, Fixture) {
+  shared_ptr<server::TBufferPool> pool(new server::TBufferPool(16 * 1024, 1024));
+  setBufferPool(pool);
+  startServer(0);
+  int port = server->getListenPort();
+
+  shared_ptr<transport::TSocket> socket(new transport::TSocket("localhost", port));
+  socket->open();
+  test::ParentServiceClient client(make_shared<protocol::TBinaryProtocol>(
+      make_shared<transport::TFramedTransport>(socket)));
+  for (int i = 0; i < 3; ++i) {
+    client.addString(std::string(2000, 'x'));
+  }
+  BOOST_CHECK_LT(pool->getStats().peakBytesInUse, 8192u);
+
+  // the response grows the 1 KiB write buffer to 8 KiB, and the pool is
+  // charged for all of it
+  std::vector<std::string> strings;
+  client.getStrings(strings);
+  BOOST_CHECK_EQUAL(3u, strings.size());
+  BOOST_CHECK(waitForIdle(pool));
+  server::TBufferPoolStats stats = pool->getStats();
+  BOOST_CHECK_GE(stats.peakBytesInUse, 8192u);
+  BOOST_CHECK_EQUAL(0u, stats.refusals);
+}
+
+BOOST_FIXTURE_TEST_CASE(buffer_pool_response_too_large, Fixture) {
+  shared_ptr<server::TBufferPool> pool(new server::TBufferPool(8192, 1024));
+  setBufferPool(pool);
+  startServer(0);
+  int port = server->getListenPort();
+
+  shared_ptr<transport::TSocket> socket(new transport::TSocket("localhost", port));
+  socket->open();
+  test::ParentServiceClient client(make_shared<protocol::TBinaryProtocol>(
+      make_shared<transport::TFramedTransport>(socket)));
+  for (int i = 0; i < 3; ++i) {
+    client.addString(std::string(3000, 'x'));
+  }
+
+  // each request fits, but the response would take a 16 KiB write buffer
+  std::vector<std::string> strings;
+  BOOST_CHECK_THROW(client.getStrings(strings), transport::TTransportException);
+  BOOST_CHECK_EQUAL(1u, pool->getStats().refusals);
+  BOOST_CHECK(waitForIdle(pool));
+  BOOST_CHECK_LE(pool->getStats().peakBytesInUse, 8192u);
+}
+
+BOOST_FIXTURE_TEST_CASE(admission_control, Fixture) {
+  shared_ptr<GateHandler> handler(new GateHandler);
+  setProcessor(make_shared<test::ParentServiceProcessor>(handler),
+               make_shared<protocol::TBinaryProtocolFactory>());
+  shared_ptr<ThreadManager> threadManager = ThreadManager::newSimpleThreadManager(4);
+  threadManager->threadFactory(make_shared<ThreadFactory>());
+  threadManager->start();
+  setThreadManager(threadManager);
+  shared_ptr<server::TAdmissionController> controller(
+      new server::TAIMDAdmissionController(1, 1, 1));
+  setAdmissionController(controller);
+  startServer(0);
+  int port = server->getListenPort();
+
+  std::vector<shared_ptr<test::ParentServiceClient> > clients;
+  for (int i = 0; i < 3; ++i) {
+    shared_ptr<transport::TSocket> socket(new transport::TSocket("localhost", port));
+    socket->open();
+    clients.push_back(make_shared<test::ParentServiceClient>(make_shared<protocol::TBinaryProtocol>(
+        make_shared<transport::TFramedTransport>(socket))));
+  }
+
+  // the first client holds the only slot
+  std::string data;
+  std::thread holder([&]() { clients[0]->getDataWait(data, 3); });
+  handler->waitEntered(1);
+
+  // the others are turned away on the IO thread, never reaching a worker
+  BOOST_CHECK_THROW(clients[1]->addString("a"), TApplicationException);
+  BOOST_CHECK_THROW(clients[2]->addString("b"), TApplicationException);
+  BOOST_CHECK_EQUAL(2u, controller->getRejectedCount());
+
+  handler->open();
+  holder.join();
+  BOOST_CHECK_EQUAL("xxx", data);
+
+  // the connections survive a rejection
+  clients[1]->addString("c");
+  std::vector<std::string> strings;
+  clients[2]->getStrings(strings);
+  BOOST_REQUIRE_EQUAL(1u, strings.size());
+  BOOST_CHECK_EQUAL("c", strings[0]);
+
+  server->stop();
+  threadManager->stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -24,11 +24,14 @@
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
 #include <boost/thread.hpp>
+#include <thrift/TApplicationException.h>
+#include <thrift/server/TAdmissionController.h>
 #include <thrift/server/TSimpleServer.h>
 #include <thrift/server/TThreadPoolServer.h>
 #include <thrift/server/TThreadedServer.h>
 #include <memory>
 #include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/TServerSocket.h>
 #include <thrift/transport/TSocket.h>
 #include <thrift/transport/TTransport.h>
@@ -44,12 +47,14 @@ using apache::thrift::protocol::TBinaryProtocol;
 using apache::thrift::protocol::TBinaryProtocolFactory;
 using apache::thrift::protocol::TProtocol;
 using apache::thrift::protocol::TProtocolFactory;
+using apache::thrift::transport::TBufferedTransportFactory;
 using apache::thrift::transport::TServerSocket;
 using apache::thrift::transport::TServerTransport;
 using apache::thrift::transport::TSocket;
 using apache::thrift::transport::TTransport;
 using apache::thrift::transport::TTransportException;
 using apache::thrift::transport::TTransportFactory;
+using apache::thrift::server::TAIMDAdmissionController;
 using apache::thrift::server::TServer;
 using apache::thrift::server::TServerEventHandler;
 using apache::thrift::server::TSimpleServer;
@@ -64,6 +69,7 @@ using apache::thrift::test::ParentServiceIfFactory;
 using apache::thrift::test::ParentServiceIfSingletonFactory;
 using apache::thrift::test::ParentServiceProcessor;
 using apache::thrift::test::ParentServiceProcessorFactory;
+using apache::thrift::TApplicationException;
 using apache::thrift::TProcessor;
 using apache::thrift::TProcessorFactory;
 using boost::posix_time::milliseconds;
@@ -142,6 +148,43 @@ protected:
   std::vector<std::string> strings_;
 };
 
+/**
+ * Holds every getDataWait call until the gate is opened, keeping its request
+ * in flight
+ */
+class GateHandler : public ParentHandler {
+public:
+  GateHandler() : entered_(0), open_(false) {}
+
+  void getDataWait(std::string& _return, const int32_t length) override {
+    Synchronized sync(gate_);
+    ++entered_;
+    gate_.notifyAll();
+    while (!open_) {
+      gate_.wait();
+    }
+    _return.assign(static_cast<size_t>(length), 'x');
+  }
+
+  void waitEntered(int entered) {
+    Synchronized sync(gate_);
+    while (entered_ < entered) {
+      gate_.wait();
+    }
+  }
+
+  void open() {
+    Synchronized sync(gate_);
+    open_ = true;
+    gate_.notifyAll();
+  }
+
+private:
+  Monitor gate_;
+  int entered_;
+  bool open_;
+};
+
 void autoSocketCloser(TSocket* pSock) {
   pSock->close();
   delete pSock;
@@ -375,6 +418,24 @@ BOOST_FIXTURE_TEST_CASE(test_threaded_stress,
   stress(10, boost::posix_time::seconds(3));
 }
 
+BOOST_FIXTURE_TEST_CASE(test_threaded_pooled,
+                        TServerIntegrationProcessorTestFixture<TThreadedServer>) {
+  pServer->setInputTransportFactory(make_shared<TBufferedTransportFactory>());
+  pServer->setOutputTransportFactory(make_shared<TBufferedTransportFactory>());
+  pServer->setConnectionPoolSize(4);
+  pServer->setIdleThreadLimit(4);
+  baseline(10, 10, "pooled connections and parked threads");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_threaded_pooled_stress,
+                        TServerIntegrationProcessorTestFixture<TThreadedServer>) {
+  pServer->setInputTransportFactory(make_shared<TBufferedTransportFactory>());
+  pServer->setOutputTransportFactory(make_shared<TBufferedTransportFactory>());
+  pServer->setConnectionPoolSize(4);
+  pServer->setIdleThreadLimit(2);
+  stress(10, boost::posix_time::seconds(3));
+}
+
 BOOST_FIXTURE_TEST_CASE(test_threadpool_factory,
                         TServerIntegrationProcessorFactoryTestFixture<TThreadPoolServer>) {
   pServer->getThreadManager()->threadFactory(
@@ -534,3 +595,50 @@ BOOST_AUTO_TEST_CASE(test_concurrent_client_limit) {
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(TServerIntegrationAdmissionTest)
+
+BOOST_AUTO_TEST_CASE(test_admission_control) {
+  shared_ptr<GateHandler> handler(new GateHandler);
+  TServerIntegrationTestFixture<TThreadedServer> fixture(
+      make_shared<ParentServiceProcessor>(handler));
+  shared_ptr<TAIMDAdmissionController> controller(new TAIMDAdmissionController(1, 1, 1));
+  fixture.pServer->setAdmissionController(controller);
+  fixture.startServer();
+
+  std::vector<shared_ptr<TSocket> > sockets;
+  std::vector<shared_ptr<ParentServiceClient> > clients;
+  for (int i = 0; i < 3; ++i) {
+    shared_ptr<TSocket> pClientSock(new TSocket("localhost", fixture.getServerPort()),
+                                    autoSocketCloser);
+    pClientSock->open();
+    sockets.push_back(pClientSock);
+    clients.push_back(make_shared<ParentServiceClient>(make_shared<TBinaryProtocol>(pClientSock)));
+  }
+
+  // the first client holds the only slot
+  std::string data;
+  boost::thread holder([&]() { clients[0]->getDataWait(data, 3); });
+  handler->waitEntered(1);
+
+  // the others are turned away without reaching the handler
+  BOOST_CHECK_THROW(clients[1]->incrementGeneration(), TApplicationException);
+  BOOST_CHECK_THROW(clients[2]->incrementGeneration(), TApplicationException);
+  BOOST_CHECK_EQUAL(2u, controller->getRejectedCount());
+
+  handler->open();
+  holder.join();
+  BOOST_CHECK_EQUAL("xxx", data);
+
+  // the slot is given back when the processor returns, just after the answer
+  for (int i = 0; i < 100 && controller->getInFlight() != 0; ++i) {
+    boost::this_thread::sleep(milliseconds(10));
+  }
+  BOOST_REQUIRE_EQUAL(0, controller->getInFlight());
+
+  // the connections survive a rejection
+  BOOST_CHECK_EQUAL(1, clients[1]->incrementGeneration());
+  BOOST_CHECK_EQUAL(2, clients[2]->incrementGeneration());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
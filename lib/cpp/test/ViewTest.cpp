@@ -0,0 +1,254 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <vector>
+
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
+#include <thrift/protocol/TView.h>
+#include <thrift/transport/TBufferTransports.h>
+#include "gen-cpp/ViewTest_types.h"
+#include "gen-cpp/ViewTest_views.h"
+
+#define BOOST_TEST_MODULE ViewTest
+#include <boost/test/unit_test.hpp>
+
+using namespace thrift::test::views;
+using apache::thrift::protocol::T_CALL;
+using apache::thrift::protocol::T_STRING;
+using apache::thrift::protocol::T_STRUCT;
+using apache::thrift::protocol::TBinaryProtocol;
+using apache::thrift::protocol::TBinaryViewReader;
+using apache::thrift::protocol::TCompactProtocol;
+using apache::thrift::protocol::TCompactViewReader;
+using apache::thrift::protocol::TMessageView;
+using apache::thrift::protocol::TProtocol;
+using apache::thrift::protocol::TProtocolException;
+using apache::thrift::protocol::TStringView;
+using apache::thrift::protocol::borrowView;
+using apache::thrift::transport::TMemoryBuffer;
+using std::shared_ptr;
+using std::string;
+
+static Record makeRecord() {
+  Record record;
+  record.id = 1234567890123LL;
+  record.name = "router";
+  record.active = true;
+  record.__set_origin(Point());
+  record.origin.x = -3;
+  record.origin.y = 4;
+  for (int32_t i = 0; i < 20; ++i) {
+    Point point;
+    point.x = i;
+    point.y = i * i;
+    record.path.push_back(point);
+  }
+  record.counts["a"] = 1;
+  record.counts["b"] = -2;
+  record.tags.insert(7);
+  record.tags.insert(300);
+  record.color = Color::RED;
+  record.score = 0.75;
+  record.blob = string("\0\1\2\3", 4);
+  record.flags.push_back(true);
+  record.flags.push_back(false);
+  record.grid.resize(2);
+  record.grid[1].push_back(5);
+  record.late = true;
+  record.__isset.limit = false;
+  return record;
+}
+
+template <class Protocol_, class Struct_>
+static string serialize(const Struct_& value) {
+  shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer());
+  Protocol_ protocol(buffer);
+  value.write(&protocol);
+  return buffer->getBufferAsString();
+}
+
+template <class Reader_>
+static RecordView<Reader_> viewOf(const string& data) {
+  return RecordView<Reader_>(reinterpret_cast<const uint8_t*>(data.data()),
+                             static_cast<uint32_t>(data.size()));
+}
+
+template <class Reader_>
+static void checkRecord(const RecordView<Reader_>& view) {
+  BOOST_CHECK_EQUAL(1234567890123LL, view.id());
+  BOOST_CHECK(view.name() == "router");
+  BOOST_CHECK(view.active());
+  BOOST_CHECK(view.has_origin());
+  BOOST_CHECK_EQUAL(-3, view.origin().x());
+  BOOST_CHECK_EQUAL(4, view.origin().y());
+
+  BOOST_REQUIRE_EQUAL(20u, view.path().size());
+  int32_t i = 0;
+  for (const PointView<Reader_>& point : view.path()) {
+    BOOST_CHECK_EQUAL(i, point.x());
+    BOOST_CHECK_EQUAL(i * i, point.y());
+    ++i;
+  }
+  BOOST_CHECK_EQUAL(20, i);
+
+  std::map<string, int32_t> counts;
+  for (const auto& entry : view.counts()) {
+    counts[entry.first.str()] = entry.second;
+  }
+  BOOST_CHECK(counts == makeRecord().counts);
+  std::vector<int16_t> tags(view.tags().begin(), view.tags().end());
+  BOOST_REQUIRE_EQUAL(2u, tags.size());
+  BOOST_CHECK_EQUAL(7, tags[0]);
+  BOOST_CHECK_EQUAL(300, tags[1]);
+
+  BOOST_CHECK_EQUAL(Color::RED, view.color());
+  BOOST_CHECK_EQUAL(0.75, view.score());
+  BOOST_CHECK(view.blob() == string("\0\1\2\3", 4));
+  std::vector<bool> flags(view.flags().begin(), view.flags().end());
+  BOOST_CHECK(flags == makeRecord().flags);
+  BOOST_REQUIRE_EQUAL(2u, view.grid().size());
+  BOOST_CHECK(view.grid().begin()->empty());
+  BOOST_CHECK_EQUAL(5, *(++view.grid().begin())->begin());
+  BOOST_CHECK(view.late());
+  BOOST_CHECK(!view.has_limit());
+  BOOST_CHECK_EQUAL(100, view.limit());
+}
+
+BOOST_AUTO_TEST_CASE(test_binary_view) {
+  const string data = serialize<TBinaryProtocol>(makeRecord());
+  RecordView<TBinaryViewReader> view = viewOf<TBinaryViewReader>(data);
+  checkRecord(view);
+  BOOST_CHECK_EQUAL(data.size(), view.__size());
+}
+
+BOOST_AUTO_TEST_CASE(test_compact_view) {
+  const string data = serialize<TCompactProtocol>(makeRecord());
+  RecordView<TCompactViewReader> view = viewOf<TCompactViewReader>(data);
+  checkRecord(view);
+  BOOST_CHECK_EQUAL(data.size(), view.__size());
+}
+
+BOOST_AUTO_TEST_CASE(test_unset_fields) {
+  Record record;
+  record.__isset.name = false;
+  const string data = serialize<TCompactProtocol>(record);
+  RecordView<TCompactViewReader> view = viewOf<TCompactViewReader>(data);
+
+  BOOST_CHECK(!view.has_origin());
+  BOOST_CHECK(!view.origin().__valid());
+  BOOST_CHECK_EQUAL(0, view.origin().x());
+  BOOST_CHECK(view.path().empty());
+  BOOST_CHECK(view.path().begin() == view.path().end());
+  BOOST_CHECK_EQUAL(Color::GREEN, view.color());
+  BOOST_CHECK(!view.active());
+  BOOST_CHECK(!view.late());
+
+  // an empty view of nothing at all
+  RecordView<TBinaryViewReader> none;
+  BOOST_CHECK(!none.has_id());
+  BOOST_CHECK(none.name().empty());
+  BOOST_CHECK_EQUAL(100, none.limit());
+}
+
+BOOST_AUTO_TEST_CASE(test_skip_unknown_fields) {
+  RecordV2 record;
+  record.id = 9;
+  record.name = "v2";
+  record.extra[1].push_back("one");
+  record.extra[2].push_back("two");
+  record.extra_point.x = 1;
+  record.extra_flag = true;
+  record.late = true;
+
+  const string binary = serialize<TBinaryProtocol>(record);
+  RecordView<TBinaryViewReader> binaryView = viewOf<TBinaryViewReader>(binary);
+  BOOST_CHECK_EQUAL(9, binaryView.id());
+  BOOST_CHECK(binaryView.name() == "v2");
+  BOOST_CHECK(binaryView.late());
+  BOOST_CHECK_EQUAL(binary.size(), binaryView.__size());
+
+  const string compact = serialize<TCompactProtocol>(record);
+  RecordView<TCompactViewReader> compactView = viewOf<TCompactViewReader>(compact);
+  BOOST_CHECK_EQUAL(9, compactView.id());
+  BOOST_CHECK(compactView.name() == "v2");
+  BOOST_CHECK(compactView.late());
+  BOOST_CHECK_EQUAL(compact.size(), compactView.__size());
+}
+
+BOOST_AUTO_TEST_CASE(test_malformed) {
+  const string data = serialize<TBinaryProtocol>(makeRecord());
+
+  // truncated input is caught while indexing
+  RecordView<TBinaryViewReader> truncated
+      = viewOf<TBinaryViewReader>(data.substr(0, data.size() - 10));
+  BOOST_CHECK_THROW(truncated.id(), TProtocolException);
+
+  // a string length past the end of the buffer
+  string corrupt = data;
+  const string name("router");
+  size_t pos = corrupt.find(name);
+  BOOST_REQUIRE(pos != string::npos);
+  corrupt[pos - 4] = '\x7f';
+  BOOST_CHECK_THROW(viewOf<TBinaryViewReader>(corrupt).name(), TProtocolException);
+}
+
+/**
+ * What a processor of TNonblockingServer sees: a TMemoryBuffer over the
+ * frame it received
+ */
+template <class Protocol_, class Reader_>
+static void checkCallFrame() {
+  shared_ptr<TMemoryBuffer> output(new TMemoryBuffer());
+  Protocol_ protocol(output);
+  protocol.writeMessageBegin("route", T_CALL, 17);
+  protocol.writeStructBegin("Router_route_args");
+  protocol.writeFieldBegin("record", T_STRUCT, 1);
+  makeRecord().write(&protocol);
+  protocol.writeFieldEnd();
+  protocol.writeFieldBegin("destination", T_STRING, 2);
+  protocol.writeString(string("backend-3"));
+  protocol.writeFieldEnd();
+  protocol.writeFieldStop();
+  protocol.writeStructEnd();
+  protocol.writeMessageEnd();
+
+  uint8_t* frame;
+  uint32_t frameSize;
+  output->getBuffer(&frame, &frameSize);
+  shared_ptr<TMemoryBuffer> input(new TMemoryBuffer());
+  input->resetBuffer(frame, frameSize);
+
+  TMessageView<Reader_> message = borrowView<TMessageView<Reader_> >(input.get());
+  BOOST_CHECK(message.name() == "route");
+  BOOST_CHECK_EQUAL(T_CALL, message.type());
+  BOOST_CHECK_EQUAL(17, message.seqid());
+  Router_route_argsView<Reader_> args = message.template body<Router_route_argsView<Reader_> >();
+  BOOST_CHECK(args.destination() == "backend-3");
+  BOOST_CHECK(args.record().name() == "router");
+  BOOST_CHECK_EQUAL(19, (++args.record().path().begin())->y() + 18);
+
+  // nothing was consumed, so the frame can still be forwarded or read
+  BOOST_CHECK_EQUAL(frameSize, input->available_read());
+}
+
+BOOST_AUTO_TEST_CASE(test_frame_buffer) {
+  checkCallFrame<TBinaryProtocol, TBinaryViewReader>();
+  checkCallFrame<TCompactProtocol, TCompactViewReader>();
+}
@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+// Generated with --gen cpp:views for ViewTest.cpp
+
+namespace cpp thrift.test.views
+
+enum Color {
+  RED = 1
+  GREEN = 2
+}
+
+struct Point {
+  1: i32 x
+  2: i32 y
+}
+
+struct Record {
+  1: i64 id
+  2: string name
+  3: bool active
+  4: optional Point origin
+  5: list<Point> path
+  6: map<string, i32> counts
+  7: set<i16> tags
+  8: Color color = Color.GREEN
+  9: double score
+  10: binary blob
+  11: list<bool> flags
+  12: list<list<i32>> grid
+  30: bool late
+  31: optional i32 limit = 100
+}
+
+// A newer Record, with fields the views of Record do not know about
+struct RecordV2 {
+  1: i64 id
+  2: string name
+  3: bool active
+  4: optional Point origin
+  13: map<i32, list<string>> extra
+  14: Point extra_point
+  15: bool extra_flag
+  30: bool late
+}
+
+service Router {
+  void route(1: Record record, 2: string destination)
+}
@@ -0,0 +1,68 @@
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements. See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership. The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+
+enum Kind {
+  SMALL = 1,
+  LARGE = 2,
+}
+
+typedef list<i32> Samples
+
+struct Point {
+  1: i32 x,
+  2: i32 y,
+}
+
+union Shape {
+  1: Point center,
+  2: list<Point> outline,
+  3: string name,
+}
+
+struct Measurement {
+  1: required i64 id,
+  2: string name,
+  3: bool valid,
+  4: i8 flags,
+  5: i16 channel,
+  6: double value,
+  7: binary raw,
+  8: Kind kind = Kind.SMALL,
+  9: Point origin,
+  10: list<Point> path,
+  11: set<string> labels,
+  12: map<string, i64> counters,
+  13: Samples samples,
+  14: map<double, string> thresholds,
+  15: list<list<i32>> grid,
+  16: optional list<i64> history,
+  17: optional string comment,
+  18: list<i32> defaults = [1, 2, 3],
+  19: Shape shape,
+}
+
+exception MeasurementError {
+  1: string message,
+  2: Measurement measurement,
+}
+
+service MeasurementService {
+  Measurement record(1: Measurement measurement) throws (1: MeasurementError error),
+}
@@ -0,0 +1,192 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+package tests
+
+import (
+	"bytes"
+	"context"
+	"testing"
+
+	"github.com/apache/thrift/lib/go/test/gopath/src/fastpathstest"
+	"github.com/apache/thrift/lib/go/thrift"
+)
+
+// opaqueProtocol hides the concrete protocol, so that generated code takes the
+// generic path through thrift.TProtocol
+type opaqueProtocol struct {
+	thrift.TProtocol
+}
+
+type protocolMaker func(thrift.TTransport) thrift.TProtocol
+
+var fastPathProtocols = map[string]protocolMaker{
+	"binary": func(t thrift.TTransport) thrift.TProtocol {
+		return thrift.NewTBinaryProtocolConf(t, nil)
+	},
+	"compact": func(t thrift.TTransport) thrift.TProtocol {
+		return thrift.NewTCompactProtocolConf(t, nil)
+	},
+}
+
+func genMeasurement() *fastpathstest.Measurement {
+	m := fastpathstest.NewMeasurement()
+	m.ID = 42
+	m.Name = "pressure"
+	m.Valid = true
+	m.Flags = -3
+	m.Channel = 7
+	m.Value = 1013.25
+	m.Raw = []byte{0, 1, 2, 255}
+	m.Kind = fastpathstest.Kind_LARGE
+	m.Origin = &fastpathstest.Point{X: 1, Y: -1}
+	for i := int32(0); i < 10; i++ {
+		m.Path = append(m.Path, &fastpathstest.Point{X: i, Y: i * i})
+	}
+	m.Labels = []string{"a", "b"}
+	// single entries, as maps are written in random order
+	m.Counters = map[string]int64{"reads": 10}
+	m.Samples = fastpathstest.Samples{5, 6, 7}
+	m.Thresholds = map[float64]string{0.5: "low"}
+	m.Grid = [][]int32{{1}, {}, {2, 3}}
+	m.History = []int64{100, 200}
+	comment := "calibrated"
+	m.Comment = &comment
+	m.Shape = &fastpathstest.Shape{Outline: []*fastpathstest.Point{{X: 1}, {Y: 2}}}
+	return m
+}
+
+func memoryBufferOf(data []byte) *thrift.TMemoryBuffer {
+	buffer := thrift.NewTMemoryBuffer()
+	buffer.Write(data)
+	return buffer
+}
+
+func writeMeasurement(t *testing.T, prot thrift.TProtocol, m *fastpathstest.Measurement) {
+	ctx := context.Background()
+	if err := m.Write(ctx, prot); err != nil {
+		t.Fatal(err)
+	}
+	if err := prot.Flush(ctx); err != nil {
+		t.Fatal(err)
+	}
+}
+
+func TestFastPathsMatchGenericPath(t *testing.T) {
+	ctx := context.Background()
+	for name, newProtocol := range fastPathProtocols {
+		m := genMeasurement()
+
+		fast := thrift.NewTMemoryBuffer()
+		writeMeasurement(t, newProtocol(fast), m)
+		generic := thrift.NewTMemoryBuffer()
+		writeMeasurement(t, opaqueProtocol{newProtocol(generic)}, m)
+		if !bytes.Equal(fast.Bytes(), generic.Bytes()) {
+			t.Errorf("%s: fast path wrote %x, generic path wrote %x", name, fast.Bytes(), generic.Bytes())
+		}
+
+		fromFast := fastpathstest.NewMeasurement()
+		if err := fromFast.Read(ctx, newProtocol(fast)); err != nil {
+			t.Fatalf("%s: %v", name, err)
+		}
+		fromGeneric := fastpathstest.NewMeasurement()
+		if err := fromGeneric.Read(ctx, opaqueProtocol{newProtocol(generic)}); err != nil {
+			t.Fatalf("%s: %v", name, err)
+		}
+		if !fromFast.Equals(m) || !fromGeneric.Equals(m) {
+			t.Errorf("%s: round trip changed %v into %v and %v", name, m, fromFast, fromGeneric)
+		}
+	}
+}
+
+func TestFastPathsServiceArgs(t *testing.T) {
+	ctx := context.Background()
+	for name, newProtocol := range fastPathProtocols {
+		args := &fastpathstest.MeasurementServiceRecordArgs{Measurement: genMeasurement()}
+		buffer := thrift.NewTMemoryBuffer()
+		if err := args.Write(ctx, newProtocol(buffer)); err != nil {
+			t.Fatalf("%s: %v", name, err)
+		}
+		read := fastpathstest.NewMeasurementServiceRecordArgs()
+		if err := read.Read(ctx, newProtocol(buffer)); err != nil {
+			t.Fatalf("%s: %v", name, err)
+		}
+		if !read.Measurement.Equals(args.Measurement) {
+			t.Errorf("%s: round trip changed %v into %v", name, args.Measurement, read.Measurement)
+		}
+	}
+}
+
+func TestResetKeepsStorage(t *testing.T) {
+	ctx := context.Background()
+	m := genMeasurement()
+	m.Reset()
+	if !m.Equals(fastpathstest.NewMeasurement()) {
+		t.Errorf("Reset left %v", m)
+	}
+	if m.IsSetHistory() || m.IsSetComment() || m.Origin != nil || m.Shape != nil {
+		t.Errorf("Reset left optional fields set: %v", m)
+	}
+	if len(m.Defaults) != 3 {
+		t.Errorf("Reset did not restore defaults: %v", m.Defaults)
+	}
+
+	buffer := thrift.NewTMemoryBuffer()
+	writeMeasurement(t, thrift.NewTBinaryProtocolConf(buffer, nil), genMeasurement())
+	data := append([]byte(nil), buffer.Bytes()...)
+
+	if err := m.Read(ctx, thrift.NewTBinaryProtocolConf(memoryBufferOf(data), nil)); err != nil {
+		t.Fatal(err)
+	}
+	path, counters := &m.Path[0], m.Counters
+	m.Reset()
+	if len(m.Path) != 0 || cap(m.Path) < 10 || len(m.Counters) != 0 || m.Counters == nil {
+		t.Fatalf("Reset dropped storage: %v", m)
+	}
+	if err := m.Read(ctx, thrift.NewTBinaryProtocolConf(memoryBufferOf(data), nil)); err != nil {
+		t.Fatal(err)
+	}
+	if &m.Path[0] != path {
+		t.Error("Read did not reuse the list that Reset emptied")
+	}
+	counters["marker"] = 1
+	if m.Counters["marker"] != 1 {
+		t.Error("Read did not reuse the map that Reset emptied")
+	}
+	delete(counters, "marker")
+	if !m.Equals(genMeasurement()) {
+		t.Errorf("Read into reset struct produced %v", m)
+	}
+}
+
+func TestMeasurementPool(t *testing.T) {
+	m := fastpathstest.AcquireMeasurement()
+	if !m.Equals(fastpathstest.NewMeasurement()) {
+		t.Errorf("AcquireMeasurement returned %v", m)
+	}
+	m.Name = "used"
+	m.Path = append(m.Path, &fastpathstest.Point{})
+	fastpathstest.ReleaseMeasurement(m)
+
+	m = fastpathstest.AcquireMeasurement()
+	if !m.Equals(fastpathstest.NewMeasurement()) {
+		t.Errorf("AcquireMeasurement returned %v after release", m)
+	}
+	fastpathstest.ReleaseMeasurement(m)
+}
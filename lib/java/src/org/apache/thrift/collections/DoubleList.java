@@ -0,0 +1,182 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.thrift.collections;
+
+import java.util.AbstractList;
+import java.util.Arrays;
+import java.util.Collection;
+import java.util.RandomAccess;
+
+/**
+ * A growable list of doubles that does not box its elements. Generated code uses
+ * it for list&lt;double&gt; fields with the java:primitive_lists option.
+ *
+ * It is a {@code java.util.List<Double>} too, but only the methods that take
+ * or return double avoid boxing. It cannot hold nulls.
+ */
+public final class DoubleList extends AbstractList<Double> implements RandomAccess {
+  private static final double[] EMPTY = {};
+
+  private double[] elements;
+  private int size;
+
+  public DoubleList() {
+    elements = EMPTY;
+  }
+
+  public DoubleList(int capacity) {
+    if (capacity < 0) {
+      throw new IllegalArgumentException("Negative capacity: " + capacity);
+    }
+    elements = capacity == 0 ? EMPTY : new double[capacity];
+  }
+
+  public DoubleList(Collection<? extends Double> other) {
+    if (other instanceof DoubleList) {
+      DoubleList list = (DoubleList) other;
+      elements = Arrays.copyOf(list.elements, list.size);
+      size = list.size;
+    } else {
+      elements = new double[other.size()];
+      for (Double element : other) {
+        add((double) element);
+      }
+    }
+  }
+
+  public double getDouble(int index) {
+    checkIndex(index);
+    return elements[index];
+  }
+
+  public double setDouble(int index, double element) {
+    checkIndex(index);
+    double previous = elements[index];
+    elements[index] = element;
+    return previous;
+  }
+
+  public boolean add(double element) {
+    if (size == elements.length) {
+      grow(size + 1);
+    }
+    elements[size++] = element;
+    modCount++;
+    return true;
+  }
+
+  @Override
+  public Double get(int index) {
+    return getDouble(index);
+  }
+
+  @Override
+  public Double set(int index, Double element) {
+    return setDouble(index, element);
+  }
+
+  @Override
+  public void add(int index, Double element) {
+    if (index < 0 || index > size) {
+      throw new IndexOutOfBoundsException("Index: " + index + ", Size: " + size);
+    }
+    double value = element;
+    if (size == elements.length) {
+      grow(size + 1);
+    }
+    System.arraycopy(elements, index, elements, index + 1, size - index);
+    elements[index] = value;
+    size++;
+    modCount++;
+  }
+
+  @Override
+  public Double remove(int index) {
+    checkIndex(index);
+    double previous = elements[index];
+    System.arraycopy(elements, index + 1, elements, index, size - index - 1);
+    size--;
+    modCount++;
+    return previous;
+  }
+
+  @Override
+  public int size() {
+    return size;
+  }
+
+  /**
+   * Removes all elements but keeps the storage for the next ones.
+   */
+  @Override
+  public void clear() {
+    size = 0;
+    modCount++;
+  }
+
+  public void ensureCapacity(int capacity) {
+    if (capacity > elements.length) {
+      grow(capacity);
+    }
+  }
+
+  public double[] toDoubleArray() {
+    return Arrays.copyOf(elements, size);
+  }
+
+  @Override
+  public boolean equals(Object other) {
+    if (!(other instanceof DoubleList)) {
+      return super.equals(other);
+    }
+    DoubleList list = (DoubleList) other;
+    if (size != list.size) {
+      return false;
+    }
+    for (int i = 0; i < size; i++) {
+      if (Double.doubleToLongBits(elements[i]) != Double.doubleToLongBits(list.elements[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  @Override
+  public int hashCode() {
+    int hashCode = 1;
+    for (int i = 0; i < size; i++) {
+      hashCode = 31 * hashCode + Double.hashCode(elements[i]);
+    }
+    return hashCode;
+  }
+
+  private void grow(int minCapacity) {
+    int capacity = elements.length + (elements.length >> 1) + 1;
+    if (capacity < minCapacity || capacity < 0) {
+      capacity = minCapacity;
+    }
+    elements = Arrays.copyOf(elements, capacity);
+  }
+
+  private void checkIndex(int index) {
+    if (index < 0 || index >= size) {
+      throw new IndexOutOfBoundsException("Index: " + index + ", Size: " + size);
+    }
+  }
+}
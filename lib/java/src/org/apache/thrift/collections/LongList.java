@@ -0,0 +1,182 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.thrift.collections;
+
+import java.util.AbstractList;
+import java.util.Arrays;
+import java.util.Collection;
+import java.util.RandomAccess;
+
+/**
+ * A growable list of longs that does not box its elements. Generated code uses
+ * it for list&lt;i64&gt; fields with the java:primitive_lists option.
+ *
+ * It is a {@code java.util.List<Long>} too, but only the methods that take
+ * or return long avoid boxing. It cannot hold nulls.
+ */
+public final class LongList extends AbstractList<Long> implements RandomAccess {
+  private static final long[] EMPTY = {};
+
+  private long[] elements;
+  private int size;
+
+  public LongList() {
+    elements = EMPTY;
+  }
+
+  public LongList(int capacity) {
+    if (capacity < 0) {
+      throw new IllegalArgumentException("Negative capacity: " + capacity);
+    }
+    elements = capacity == 0 ? EMPTY : new long[capacity];
+  }
+
+  public LongList(Collection<? extends Long> other) {
+    if (other instanceof LongList) {
+      LongList list = (LongList) other;
+      elements = Arrays.copyOf(list.elements, list.size);
+      size = list.size;
+    } else {
+      elements = new long[other.size()];
+      for (Long element : other) {
+        add((long) element);
+      }
+    }
+  }
+
+  public long getLong(int index) {
+    checkIndex(index);
+    return elements[index];
+  }
+
+  public long setLong(int index, long element) {
+    checkIndex(index);
+    long previous = elements[index];
+    elements[index] = element;
+    return previous;
+  }
+
+  public boolean add(long element) {
+    if (size == elements.length) {
+      grow(size + 1);
+    }
+    elements[size++] = element;
+    modCount++;
+    return true;
+  }
+
+  @Override
+  public Long get(int index) {
+    return getLong(index);
+  }
+
+  @Override
+  public Long set(int index, Long element) {
+    return setLong(index, element);
+  }
+
+  @Override
+  public void add(int index, Long element) {
+    if (index < 0 || index > size) {
+      throw new IndexOutOfBoundsException("Index: " + index + ", Size: " + size);
+    }
+    long value = element;
+    if (size == elements.length) {
+      grow(size + 1);
+    }
+    System.arraycopy(elements, index, elements, index + 1, size - index);
+    elements[index] = value;
+    size++;
+    modCount++;
+  }
+
+  @Override
+  public Long remove(int index) {
+    checkIndex(index);
+    long previous = elements[index];
+    System.arraycopy(elements, index + 1, elements, index, size - index - 1);
+    size--;
+    modCount++;
+    return previous;
+  }
+
+  @Override
+  public int size() {
+    return size;
+  }
+
+  /**
+   * Removes all elements but keeps the storage for the next ones.
+   */
+  @Override
+  public void clear() {
+    size = 0;
+    modCount++;
+  }
+
+  public void ensureCapacity(int capacity) {
+    if (capacity > elements.length) {
+      grow(capacity);
+    }
+  }
+
+  public long[] toLongArray() {
+    return Arrays.copyOf(elements, size);
+  }
+
+  @Override
+  public boolean equals(Object other) {
+    if (!(other instanceof LongList)) {
+      return super.equals(other);
+    }
+    LongList list = (LongList) other;
+    if (size != list.size) {
+      return false;
+    }
+    for (int i = 0; i < size; i++) {
+      if (elements[i] != list.elements[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  @Override
+  public int hashCode() {
+    int hashCode = 1;
+    for (int i = 0; i < size; i++) {
+      hashCode = 31 * hashCode + Long.hashCode(elements[i]);
+    }
+    return hashCode;
+  }
+
+  private void grow(int minCapacity) {
+    int capacity = elements.length + (elements.length >> 1) + 1;
+    if (capacity < minCapacity || capacity < 0) {
+      capacity = minCapacity;
+    }
+    elements = Arrays.copyOf(elements, capacity);
+  }
+
+  private void checkIndex(int index) {
+    if (index < 0 || index >= size) {
+      throw new IndexOutOfBoundsException("Index: " + index + ", Size: " + size);
+    }
+  }
+}
@@ -0,0 +1,182 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.thrift.collections;
+
+import java.util.AbstractList;
+import java.util.Arrays;
+import java.util.Collection;
+import java.util.RandomAccess;
+
+/**
+ * A growable list of shorts that does not box its elements. Generated code uses
+ * it for list&lt;i16&gt; fields with the java:primitive_lists option.
+ *
+ * It is a {@code java.util.List<Short>} too, but only the methods that take
+ * or return short avoid boxing. It cannot hold nulls.
+ */
+public final class ShortList extends AbstractList<Short> implements RandomAccess {
+  private static final short[] EMPTY = {};
+
+  private short[] elements;
+  private int size;
+
+  public ShortList() {
+    elements = EMPTY;
+  }
+
+  public ShortList(int capacity) {
+    if (capacity < 0) {
+      throw new IllegalArgumentException("Negative capacity: " + capacity);
+    }
+    elements = capacity == 0 ? EMPTY : new short[capacity];
+  }
+
+  public ShortList(Collection<? extends Short> other) {
+    if (other instanceof ShortList) {
+      ShortList list = (ShortList) other;
+      elements = Arrays.copyOf(list.elements, list.size);
+      size = list.size;
+    } else {
+      elements = new short[other.size()];
+      for (Short element : other) {
+        add((short) element);
+      }
+    }
+  }
+
+  public short getShort(int index) {
+    checkIndex(index);
+    return elements[index];
+  }
+
+  public short setShort(int index, short element) {
+    checkIndex(index);
+    short previous = elements[index];
+    elements[index] = element;
+    return previous;
+  }
+
+  public boolean add(short element) {
+    if (size == elements.length) {
+      grow(size + 1);
+    }
+    elements[size++] = element;
+    modCount++;
+    return true;
+  }
+
+  @Override
+  public Short get(int index) {
+    return getShort(index);
+  }
+
+  @Override
+  public Short set(int index, Short element) {
+    return setShort(index, element);
+  }
+
+  @Override
+  public void add(int index, Short element) {
+    if (index < 0 || index > size) {
+      throw new IndexOutOfBoundsException("Index: " + index + ", Size: " + size);
+    }
+    short value = element;
+    if (size == elements.length) {
+      grow(size + 1);
+    }
+    System.arraycopy(elements, index, elements, index + 1, size - index);
+    elements[index] = value;
+    size++;
+    modCount++;
+  }
+
+  @Override
+  public Short remove(int index) {
+    checkIndex(index);
+    short previous = elements[index];
+    System.arraycopy(elements, index + 1, elements, index, size - index - 1);
+    size--;
+    modCount++;
+    return previous;
+  }
+
+  @Override
+  public int size() {
+    return size;
+  }
+
+  /**
+   * Removes all elements but keeps the storage for the next ones.
+   */
+  @Override
+  public void clear() {
+    size = 0;
+    modCount++;
+  }
+
+  public void ensureCapacity(int capacity) {
+    if (capacity > elements.length) {
+      grow(capacity);
+    }
+  }
+
+  public short[] toShortArray() {
+    return Arrays.copyOf(elements, size);
+  }
+
+  @Override
+  public boolean equals(Object other) {
+    if (!(other instanceof ShortList)) {
+      return super.equals(other);
+    }
+    ShortList list = (ShortList) other;
+    if (size != list.size) {
+      return false;
+    }
+    for (int i = 0; i < size; i++) {
+      if (elements[i] != list.elements[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  @Override
+  public int hashCode() {
+    int hashCode = 1;
+    for (int i = 0; i < size; i++) {
+      hashCode = 31 * hashCode + Short.hashCode(elements[i]);
+    }
+    return hashCode;
+  }
+
+  private void grow(int minCapacity) {
+    int capacity = elements.length + (elements.length >> 1) + 1;
+    if (capacity < minCapacity || capacity < 0) {
+      capacity = minCapacity;
+    }
+    elements = Arrays.copyOf(elements, capacity);
+  }
+
+  private void checkIndex(int index) {
+    if (index < 0 || index >= size) {
+      throw new IndexOutOfBoundsException("Index: " + index + ", Size: " + size);
+    }
+  }
+}
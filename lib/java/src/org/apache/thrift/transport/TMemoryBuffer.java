@@ -120,5 +120,33 @@ public class TMemoryBuffer extends TEndpointTransport {
   public byte[] getArray() {
     return arr_.get();
   }
+
+  /**
+   * Exposes the written bytes to the protocols, so that they decode from the
+   * buffer directly and read binaries as slices of it rather than copies.
+   */
+  @Override
+  public byte[] getBuffer() {
+    return arr_.get();
+  }
+
+  @Override
+  public int getBufferPosition() {
+    return pos_;
+  }
+
+  /**
+   * Capped at the remaining message size, so that reads the size check in
+   * read() would refuse still go through read() and fail there.
+   */
+  @Override
+  public int getBytesRemainingInBuffer() {
+    return (int) Math.min(arr_.len() - pos_, remainingMessageSize);
+  }
+
+  @Override
+  public void consumeBuffer(int len) {
+    pos_ += len;
+  }
 }
 
@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+package org.apache.thrift;
+
+import java.nio.ByteBuffer;
+import java.util.Arrays;
+
+import junit.framework.TestCase;
+
+import org.apache.thrift.collections.DoubleList;
+import org.apache.thrift.collections.IntList;
+import org.apache.thrift.collections.LongList;
+import org.apache.thrift.protocol.TBinaryProtocol;
+import org.apache.thrift.protocol.TCompactProtocol;
+import org.apache.thrift.protocol.TProtocol;
+import org.apache.thrift.transport.TMemoryBuffer;
+
+import thrift.test.reuse.Sample;
+import thrift.test.reuse.Series;
+
+// Tests the primitive_lists and clear_and_reuse options of the java generator.
+//
+public class TestClearAndReuse extends TestCase {
+
+  private static Series series(int base) {
+    Series series = new Series();
+    for (int i = 0; i < 10; i++) {
+      series.addToInts(base + i);
+      series.addToLongs((long) base << 32 | i);
+      series.addToDoubles(base + i / 4.0);
+    }
+    IntList bucket = new IntList();
+    bucket.add(base);
+    series.putToBuckets("b" + base, bucket);
+    series.addToNested(new LongList(Arrays.asList((long) base, -1L)));
+    series.setLast(new Sample(base, ByteBuffer.wrap(new byte[] {1, 2, (byte) base})));
+    series.addToLabels("l" + base);
+    return series;
+  }
+
+  private static TMemoryBuffer write(TBase<?, ?> struct, boolean compact) throws Exception {
+    TMemoryBuffer buffer = new TMemoryBuffer(64);
+    TProtocol oprot = compact ? new TCompactProtocol(buffer) : new TBinaryProtocol(buffer);
+    struct.write(oprot);
+    return buffer;
+  }
+
+  private static void read(TBase<?, ?> struct, TMemoryBuffer buffer, boolean compact) throws Exception {
+    TProtocol iprot = compact ? new TCompactProtocol(buffer) : new TBinaryProtocol(buffer);
+    struct.read(iprot);
+  }
+
+  public void testPrimitiveLists() throws Exception {
+    for (boolean compact : new boolean[] {false, true}) {
+      Series expected = series(7);
+      Series actual = new Series();
+      read(actual, write(expected, compact), compact);
+      assertEquals(expected, actual);
+      assertEquals(expected.hashCode(), actual.hashCode());
+      assertEquals(0, expected.compareTo(actual));
+      assertEquals(9.25, actual.getDoubles().getDouble(9), 0.0);
+      assertEquals(3, actual.getShorts().size());
+      assertEquals(16, actual.getInts().getInt(9));
+    }
+  }
+
+  public void testPrimitiveListEquality() {
+    IntList ints = new IntList(Arrays.asList(1, 2, 3));
+    assertEquals(Arrays.asList(1, 2, 3), ints);
+    assertEquals(ints, Arrays.asList(1, 2, 3));
+    assertEquals(Arrays.asList(1, 2, 3).hashCode(), ints.hashCode());
+
+    DoubleList doubles = new DoubleList();
+    doubles.add(Double.NaN);
+    assertEquals(Arrays.asList(Double.NaN), doubles);
+    assertEquals(Arrays.asList(Double.NaN).hashCode(), doubles.hashCode());
+
+    ints.add(1, 5);
+    assertEquals(Arrays.asList(1, 5, 2, 3), ints);
+    assertEquals(Integer.valueOf(5), ints.remove(1));
+    ints.clear();
+    assertTrue(ints.isEmpty());
+    try {
+      ints.getInt(0);
+      fail("expected an IndexOutOfBoundsException");
+    } catch (IndexOutOfBoundsException e) {
+      // expected
+    }
+  }
+
+  public void testClearAndReuse() throws Exception {
+    for (boolean compact : new boolean[] {false, true}) {
+      Series actual = new Series();
+      read(actual, write(series(1), compact), compact);
+      IntList ints = actual.getInts();
+      LongList longs = actual.getLongs();
+      Sample last = actual.getLast();
+
+      Series expected = series(2);
+      read(actual, write(expected, compact), compact);
+      assertEquals(expected, actual);
+      assertSame(ints, actual.getInts());
+      assertSame(longs, actual.getLongs());
+      assertSame(last, actual.getLast());
+      assertEquals(1, actual.getBucketsSize());
+      assertEquals(1, actual.getLabelsSize());
+    }
+  }
+
+  public void testBinarySliceOfMemoryBuffer() throws Exception {
+    Series series = series(3);
+    TMemoryBuffer buffer = write(series, false);
+    Series actual = new Series();
+    read(actual, buffer, false);
+
+    // the accessors copy, the field is what was read
+    ByteBuffer payload = actual.getLast().payload;
+    assertEquals(series.getLast().payload, payload);
+    assertSame(buffer.getArray(), payload.array());
+  }
+}
@@ -85,6 +85,27 @@ const int8_t T_EXCEPTION = 3;
 const int INVALID_DATA = 1;
 const int BAD_VERSION = 4;
 
+ZEND_DECLARE_MODULE_GLOBALS(thrift_protocol)
+
+static
+PHP_GINIT_FUNCTION(thrift_protocol) {
+#if defined(COMPILE_DL_THRIFT_PROTOCOL) && defined(ZTS)
+  ZEND_TSRMLS_CACHE_UPDATE();
+#endif
+  thrift_protocol_globals->class_cache = nullptr;
+}
+
+// User classes go away at the end of the request, and so must the cache.
+static
+PHP_RSHUTDOWN_FUNCTION(thrift_protocol) {
+  if (THRIFT_PROTOCOL_G(class_cache)) {
+    zend_hash_destroy(THRIFT_PROTOCOL_G(class_cache));
+    FREE_HASHTABLE(THRIFT_PROTOCOL_G(class_cache));
+    THRIFT_PROTOCOL_G(class_cache) = nullptr;
+  }
+  return SUCCESS;
+}
+
 zend_module_entry thrift_protocol_module_entry = {
   STANDARD_MODULE_HEADER,
   "thrift_protocol",
@@ -92,13 +113,20 @@ zend_module_entry thrift_protocol_module_entry = {
   nullptr,
   nullptr,
   nullptr,
-  nullptr,
+  PHP_RSHUTDOWN(thrift_protocol),
   nullptr,
   "1.0",
-  STANDARD_MODULE_PROPERTIES
+  PHP_MODULE_GLOBALS(thrift_protocol),
+  PHP_GINIT(thrift_protocol),
+  nullptr,
+  nullptr,
+  STANDARD_MODULE_PROPERTIES_EX
 };
 
 #ifdef COMPILE_DL_THRIFT_PROTOCOL
+#ifdef ZTS
+ZEND_TSRMLS_CACHE_DEFINE()
+#endif
 ZEND_GET_MODULE(thrift_protocol)
 #endif
 
@@ -161,6 +189,19 @@ protected:
     zval_dtor(&t);
   }
 
+  // Exact class match: subclasses may override read() or write().
+  bool transportIs(const char* name, size_t len) const {
+    zend_string* class_name = Z_OBJCE(t)->name;
+    return ZSTR_LEN(class_name) == len && zend_binary_strcasecmp(ZSTR_VAL(class_name), len, name, len) == 0;
+  }
+
+  // Reads a (possibly private) property of the transport object.
+  zval* transportProperty(const char* name, zval* rv) {
+    zval* prop = zend_read_property(Z_OBJCE(t), Z4_OBJ_P(&t), name, strlen(name), true, rv);
+    ZVAL_DEREF(prop);
+    return prop;
+  }
+
   char* buffer;
   char* buffer_ptr;
   size_t buffer_used;
@@ -172,12 +213,23 @@ protected:
 
 class PHPOutputTransport : public PHPTransport {
 public:
-  PHPOutputTransport(zval* _p, size_t _buffer_size = 8192) : PHPTransport(_p, _buffer_size) { }
+  PHPOutputTransport(zval* _p, size_t _buffer_size = 8192) : PHPTransport(_p, _buffer_size) {
+    // These only append to a PHP string until flushed, so there is nothing
+    // to gain from handing them the message in pieces: keep it all here and
+    // pass it on with a single write().
+    grow = transportIs(ZEND_STRL("Thrift\\Transport\\TMemoryBuffer"))
+        || transportIs(ZEND_STRL("Thrift\\Transport\\TBufferedTransport"))
+        || transportIs(ZEND_STRL("Thrift\\Transport\\TFramedTransport"));
+  }
   ~PHPOutputTransport() { }
 
   void write(const char* data, size_t len) {
     if ((len + buffer_used) > buffer_size) {
-      internalFlush();
+      if (grow) {
+        reserve(len + buffer_used);
+      } else {
+        internalFlush();
+      }
     }
     if (len > buffer_size) {
       directWrite(data, len);
@@ -223,6 +275,16 @@ public:
   }
 
 protected:
+  void reserve(size_t needed) {
+    size_t new_size = buffer_size * 2;
+    while (new_size < needed) {
+      new_size *= 2;
+    }
+    buffer = reinterpret_cast<char*>(erealloc(buffer, new_size));
+    buffer_ptr = buffer + buffer_used;
+    buffer_size = new_size;
+  }
+
   void internalFlush() {
      if (buffer_used) {
       directWrite(buffer, buffer_used);
@@ -263,11 +325,16 @@ protected:
       throw PHPExceptionWrapper(ex);
     }
   }
+
+  bool grow;
 };
 
 class PHPInputTransport : public PHPTransport {
 public:
   PHPInputTransport(zval* _p, size_t _buffer_size = 8192) : PHPTransport(_p, _buffer_size) {
+    borrowed = nullptr;
+    borrowed_prop = nullptr;
+    borrow();
   }
 
   ~PHPInputTransport() {
@@ -275,6 +342,12 @@ public:
   }
 
   void put_back() {
+    if (borrowed) {
+      zend_update_property_stringl(Z_OBJCE(t), Z4_OBJ_P(&t), borrowed_prop, strlen(borrowed_prop),
+                                   buffer_ptr, buffer_used);
+      release();
+      return;
+    }
     if (buffer_used) {
       zval args[1], ret, putbackfn;
       ZVAL_STRINGL(&args[0], buffer_ptr, buffer_used);
@@ -349,8 +422,105 @@ public:
   }
 
 protected:
+  // TMemoryBuffer, TBufferedTransport and a framed TFramedTransport keep
+  // the bytes still to be read in a PHP string.  Decode straight out of that
+  // string instead of copying it over through read(), and when a
+  // TFramedTransport has nothing buffered pull in the whole next frame here,
+  // so that a message that fits in one frame is read without calling back
+  // into PHP at all.  Whatever is left over goes back in put_back().
+  void borrow() {
+    zval rv;
+    bool framed = false;
+    if (transportIs(ZEND_STRL("Thrift\\Transport\\TMemoryBuffer"))) {
+      borrowed_prop = "buf_";
+    } else if (transportIs(ZEND_STRL("Thrift\\Transport\\TBufferedTransport"))) {
+      borrowed_prop = "rBuf_";
+    } else if (transportIs(ZEND_STRL("Thrift\\Transport\\TFramedTransport"))) {
+      if (!zend_is_true(transportProperty("read_", &rv))) {
+        return;
+      }
+      borrowed_prop = "rBuf_";
+      framed = true;
+    } else {
+      return;
+    }
+
+    zval* buf = transportProperty(borrowed_prop, &rv);
+    if (Z_TYPE_P(buf) == IS_STRING && Z_STRLEN_P(buf) > 0) {
+      borrowed = zend_string_copy(Z_STR_P(buf));
+    } else if (framed) {
+      borrowed = readFrame();
+    } else {
+      borrowed_prop = nullptr;
+      return;
+    }
+    buffer_ptr = ZSTR_VAL(borrowed);
+    buffer_used = ZSTR_LEN(borrowed);
+  }
+
+  // Stops reading from the borrowed string; the caller updates the property.
+  void release() {
+    zend_string_release(borrowed);
+    borrowed = nullptr;
+    borrowed_prop = nullptr;
+    buffer_ptr = buffer;
+    buffer_used = 0;
+  }
+
+  zend_string* readFrame() {
+    zval rv;
+    zval inner;
+    ZVAL_COPY(&inner, transportProperty("transport_", &rv));
+
+    zval header;
+    readAll(&inner, 4, &header);
+    uint32_t sz;
+    memcpy(&sz, Z_STRVAL(header), 4);
+    zval_dtor(&header);
+
+    zval frame;
+    readAll(&inner, ntohl(sz), &frame);
+    zval_dtor(&inner);
+    return Z_STR(frame);
+  }
+
+  void readAll(zval* from, size_t len, zval* retval) {
+    zval args[1];
+    zval funcname;
+
+    ZVAL_NULL(retval);
+    ZVAL_LONG(&args[0], len);
+    ZVAL_STRING(&funcname, "readAll");
+
+    call_user_function(EG(function_table), from, &funcname, retval, 1, args);
+    zval_dtor(&args[0]);
+    zval_dtor(&funcname);
+
+    if (EG(exception)) {
+      zval_dtor(retval);
+      zval_dtor(from);
+
+      zend_object *ex = EG(exception);
+      EG(exception) = nullptr;
+      throw PHPExceptionWrapper(ex);
+    }
+    if (Z_TYPE_P(retval) != IS_STRING) {
+      convert_to_string(retval);
+    }
+    if (Z_STRLEN_P(retval) < len) {
+      zval_dtor(retval);
+      zval_dtor(from);
+      throw std::runtime_error("TFramedTransport: short read");
+    }
+  }
+
   void refill() {
     assert(buffer_used == 0);
+    if (borrowed) {
+      // All of it was consumed; carry on through read() as usual.
+      zend_update_property_stringl(Z_OBJCE(t), Z4_OBJ_P(&t), borrowed_prop, strlen(borrowed_prop), "", 0);
+      release();
+    }
     zval retval;
     zval args[1];
     zval funcname;
@@ -380,6 +550,8 @@ protected:
     buffer_ptr = buffer;
   }
 
+  zend_string* borrowed;
+  const char* borrowed_prop;
 };
 
 static
@@ -393,11 +565,31 @@ bool ttype_is_scalar(int8_t t);
 
 // Create a PHP object given a typename and call the ctor, optionally passing up to 2 arguments
 static
-void createObject(const char* obj_typename, zval* return_value, int nargs = 0, zval* arg1 = nullptr, zval* arg2 = nullptr) {
-  /* is there a better way to do that on the stack ? */
-  zend_string *obj_name = zend_string_init(obj_typename, strlen(obj_typename), 0);
-  zend_class_entry* ce = zend_fetch_class(obj_name, ZEND_FETCH_CLASS_DEFAULT);
+zend_class_entry* lookup_class(const char* obj_typename, size_t len) {
+  HashTable* cache = THRIFT_PROTOCOL_G(class_cache);
+  if (!cache) {
+    ALLOC_HASHTABLE(cache);
+    zend_hash_init(cache, 16, nullptr, nullptr, 0);
+    THRIFT_PROTOCOL_G(class_cache) = cache;
+  }
+
+  zend_class_entry* ce = reinterpret_cast<zend_class_entry*>(zend_hash_str_find_ptr(cache, obj_typename, len));
+  if (ce) {
+    return ce;
+  }
+
+  zend_string *obj_name = zend_string_init(obj_typename, len, 0);
+  ce = zend_fetch_class(obj_name, ZEND_FETCH_CLASS_DEFAULT);
   zend_string_release(obj_name);
+  if (ce) {
+    zend_hash_str_add_ptr(cache, obj_typename, len, ce);
+  }
+  return ce;
+}
+
+static
+void createObject(const char* obj_typename, zval* return_value, int nargs = 0, zval* arg1 = nullptr, zval* arg2 = nullptr) {
+  zend_class_entry* ce = lookup_class(obj_typename, strlen(obj_typename));
 
   if (! ce) {
     php_error_docref(nullptr, E_ERROR, "Class %s does not exist", obj_typename);
@@ -74,3 +74,14 @@
 #endif
 
 #include "php_thrift_protocol_arginfo.h"
+
+ZEND_BEGIN_MODULE_GLOBALS(thrift_protocol)
+  /* class name => zend_class_entry*, for the current request */
+  HashTable* class_cache;
+ZEND_END_MODULE_GLOBALS(thrift_protocol)
+
+#define THRIFT_PROTOCOL_G(v) ZEND_MODULE_GLOBALS_ACCESSOR(thrift_protocol, v)
+
+#if defined(ZTS) && defined(COMPILE_DL_THRIFT_PROTOCOL)
+ZEND_TSRMLS_CACHE_EXTERN()
+#endif
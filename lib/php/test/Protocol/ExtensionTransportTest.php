@@ -0,0 +1,249 @@
+<?php
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ * @package thrift.test
+ */
+
+namespace Test\Thrift\Protocol;
+
+use PHPUnit\Framework\TestCase;
+use Thrift\Protocol\TBinaryProtocol;
+use Thrift\Protocol\TBinaryProtocolAccelerated;
+use Thrift\Transport\TBufferedTransport;
+use Thrift\Transport\TFramedTransport;
+use Thrift\Transport\TMemoryBuffer;
+use Thrift\Type\TMessageType;
+
+require __DIR__ . '/../../../../vendor/autoload.php';
+
+/***
+ * Covers the thrift_protocol extension reading straight out of the buffers
+ * of TMemoryBuffer, TBufferedTransport and TFramedTransport, and writing a
+ * whole message to them at once.
+ *
+ * This test suite depends on running the compiler against the
+ * standard ThriftTest.thrift file:
+ *
+ * lib/php/test$ ../../../compiler/cpp/thrift --gen php -r \
+ *   --out ./packages ../../../test/ThriftTest.thrift
+ *
+ * @runTestsInSeparateProcesses
+ */
+class ExtensionTransportTest extends TestCase
+{
+    public function setUp()
+    {
+        if (!extension_loaded('thrift_protocol')) {
+            $this->markTestSkipped('The thrift_protocol extension is not loaded.');
+        }
+
+        /** @var \Composer\Autoload\ClassLoader $loader */
+        $loader = require __DIR__ . '/../../../../vendor/autoload.php';
+        $loader->addPsr4('', __DIR__ . '/../packages/php');
+    }
+
+    public function testMemoryBufferKeepsWhatIsLeft()
+    {
+        $first = $this->xtruct('first', 1);
+        $second = $this->xtruct('second', 2);
+        $rest = $this->serialize($second);
+        $transport = new TMemoryBuffer($this->serialize($first) . $rest);
+
+        $this->assertEquals($first, $this->read($transport));
+        $this->assertEquals($rest, $transport->getBuffer());
+        $this->assertEquals($second, $this->read($transport));
+        $this->assertEquals(0, $transport->available());
+    }
+
+    public function testBufferedTransportKeepsWhatIsLeft()
+    {
+        $first = $this->xtruct('first', 1);
+        $second = $this->xtruct('second', 2);
+        $transport = new TBufferedTransport(new TMemoryBuffer());
+        $transport->putBack($this->serialize($first) . $this->serialize($second));
+
+        $this->assertEquals($first, $this->read($transport));
+
+        // the extension stored the rest back where the PHP code finds it
+        $protocol = new TBinaryProtocol($transport);
+        $protocol->readMessageBegin($name, $type, $seqid);
+        $read = new \ThriftTest\Xtruct();
+        $read->read($protocol);
+        $protocol->readMessageEnd();
+        $this->assertEquals($second, $read);
+    }
+
+    public function testMessageLargerThanBorrowedBuffer()
+    {
+        // the borrowed string runs out mid message, so the rest comes in
+        // through read()
+        $struct = $this->xtruct(str_repeat('x', 1000), 3);
+        $message = $this->serialize($struct);
+        $transport = new TBufferedTransport(new TMemoryBuffer(substr($message, 100)));
+        $transport->putBack(substr($message, 0, 100));
+
+        $this->assertEquals($struct, $this->read($transport));
+    }
+
+    public function testFramedTransportReadsWholeFrame()
+    {
+        $first = $this->xtruct('first', 1);
+        $second = $this->xtruct('second', 2);
+        $inner = new ChunkedTransport($this->frame($this->serialize($first) . $this->serialize($second)), 3);
+        $transport = new TFramedTransport($inner);
+
+        $this->assertEquals($first, $this->read($transport));
+        $this->assertEquals(0, $inner->available());
+        $this->assertEquals($second, $this->read($transport));
+    }
+
+    public function testMessageSplitAcrossFrames()
+    {
+        $struct = $this->xtruct(str_repeat('y', 100), 4);
+        $message = $this->serialize($struct);
+        $inner = new TMemoryBuffer($this->frame(substr($message, 0, 50)) . $this->frame(substr($message, 50)));
+        $transport = new TFramedTransport($inner);
+
+        $this->assertEquals($struct, $this->read($transport));
+        $this->assertEquals(0, $inner->available());
+    }
+
+    /**
+     * @expectedException \Exception
+     * @expectedExceptionMessage TFramedTransport: short read
+     */
+    public function testShortFrame()
+    {
+        $message = $this->serialize($this->xtruct('short', 5));
+        $frame = $this->frame($message);
+        $transport = new TFramedTransport(new TruncatedTransport(substr($frame, 0, strlen($frame) - 10)));
+
+        $this->read($transport);
+    }
+
+    public function testGrowOutput()
+    {
+        // several times the 8k the extension buffers by default
+        $struct = $this->xtruct(str_repeat('z', 40000), 6);
+        $expected = $this->serialize($struct);
+
+        $transport = new TMemoryBuffer();
+        $this->write($transport, $struct);
+        $this->assertEquals($expected, $transport->getBuffer());
+
+        // the message reaches the transport in a single write()
+        $inner = new CountingTransport();
+        $this->write(new TBufferedTransport($inner), $struct);
+        $this->assertEquals(1, $inner->writes);
+        $this->assertEquals($expected, $inner->getBuffer());
+
+        $inner = new CountingTransport();
+        $this->write(new TFramedTransport($inner), $struct);
+        $this->assertEquals(1, $inner->writes);
+        $this->assertEquals($this->frame($expected), $inner->getBuffer());
+
+        // other transports still get it in pieces
+        $transport = new CountingTransport();
+        $this->write($transport, $struct);
+        $this->assertGreaterThan(1, $transport->writes);
+        $this->assertEquals($expected, $transport->getBuffer());
+    }
+
+    private function xtruct($string, $i32)
+    {
+        return new \ThriftTest\Xtruct(array('string_thing' => $string, 'i32_thing' => $i32));
+    }
+
+    private function serialize($struct)
+    {
+        $transport = new TMemoryBuffer();
+        $protocol = new TBinaryProtocol($transport);
+        $protocol->writeMessageBegin('test', TMessageType::REPLY, 0);
+        $struct->write($protocol);
+        $protocol->writeMessageEnd();
+
+        return $transport->getBuffer();
+    }
+
+    private function frame($data)
+    {
+        return pack('N', strlen($data)) . $data;
+    }
+
+    private function read($transport)
+    {
+        $protocol = new TBinaryProtocolAccelerated($transport);
+
+        return thrift_protocol_read_binary($protocol, 'ThriftTest\\Xtruct', false);
+    }
+
+    private function write($transport, $struct)
+    {
+        $protocol = new TBinaryProtocolAccelerated($transport);
+        thrift_protocol_write_binary($protocol, 'test', TMessageType::REPLY, $struct, 0, true);
+    }
+}
+
+/**
+ * Hands out at most a few bytes per read(), like a socket
+ */
+class ChunkedTransport extends TMemoryBuffer
+{
+    private $chunkSize_;
+
+    public function __construct($buf, $chunkSize)
+    {
+        parent::__construct($buf);
+        $this->chunkSize_ = $chunkSize;
+    }
+
+    public function read($len)
+    {
+        return parent::read(min($len, $this->chunkSize_));
+    }
+}
+
+/**
+ * Returns what is left from readAll() rather than failing, like a stream
+ * that has reached its end
+ */
+class TruncatedTransport extends TMemoryBuffer
+{
+    public function readAll($len)
+    {
+        $data = (string) substr($this->buf_, 0, $len);
+        $this->buf_ = (string) substr($this->buf_, strlen($data));
+
+        return $data;
+    }
+}
+
+/**
+ * Counts the write() calls it receives
+ */
+class CountingTransport extends TMemoryBuffer
+{
+    public $writes = 0;
+
+    public function write($buf)
+    {
+        ++$this->writes;
+        parent::write($buf);
+    }
+}
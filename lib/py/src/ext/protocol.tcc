@@ -277,7 +277,8 @@ bool ProtocolBase<Impl>::readBytes(char** output, int len) {
   } else {
     // using building functions as this is a rare codepath
     ScopedPyObject newiobuf(PyObject_CallFunction(input_.refill_callable.get(), refill_signature,
-                                                  *output, rlen, len, nullptr));
+                                                  *output, static_cast<Py_ssize_t>(rlen), len,
+                                                  nullptr));
     if (!newiobuf) {
       return false;
     }
@@ -502,28 +503,33 @@ bool ProtocolBase<Impl>::encodeValue(PyObject* value, TType type, PyObject* type
       return false;
     }
 
-    Py_ssize_t nspec = PyTuple_Size(parsedargs.spec);
-    if (nspec == -1) {
-      PyErr_SetString(PyExc_TypeError, "spec is not a tuple");
+    const StructSpec* spec = get_struct_spec(parsedargs.klass, parsedargs.spec);
+    if (!spec) {
       return false;
     }
+    // Slot offsets are only valid for objects of exactly the compiled class.
+    bool direct = spec->slotted && Py_TYPE(value) == reinterpret_cast<PyTypeObject*>(spec->klass);
 
     detail::WriteStructScope<Impl> scope = detail::writeStructScope(this);
     if (!scope) {
       return false;
     }
-    for (Py_ssize_t i = 0; i < nspec; i++) {
-      PyObject* spec_tuple = PyTuple_GET_ITEM(parsedargs.spec, i);
-      if (spec_tuple == Py_None) {
+    for (size_t i = 0; i < spec->fields.size(); i++) {
+      const StructItemSpec& parsedspec = spec->fields[i];
+      if (!parsedspec.attrname) {
         continue;
       }
 
-      StructItemSpec parsedspec;
-      if (!parse_struct_item_spec(&parsedspec, spec_tuple)) {
-        return false;
+      ScopedPyObject instval;
+      if (direct) {
+        PyObject* slotval = get_slot(value, parsedspec);
+        Py_XINCREF(slotval);
+        instval.reset(slotval);
+      }
+      if (!instval) {
+        // also raises the AttributeError for an empty slot
+        instval.reset(PyObject_GetAttr(value, parsedspec.attrname));
       }
-
-      ScopedPyObject instval(PyObject_GetAttr(value, parsedspec.attrname));
 
       if (!instval) {
         return false;
@@ -829,19 +835,48 @@ PyObject* ProtocolBase<Impl>::decodeValue(TType type, PyObject* typeargs) {
 
 template <typename Impl>
 PyObject* ProtocolBase<Impl>::readStruct(PyObject* output, PyObject* klass, PyObject* spec_seq) {
-  int spec_seq_len = PyTuple_Size(spec_seq);
-  bool immutable = output == Py_None;
-  ScopedPyObject kwargs;
-  if (spec_seq_len == -1) {
+  const StructSpec* spec = get_struct_spec(klass, spec_seq);
+  if (!spec) {
     return nullptr;
   }
+  int spec_seq_len = static_cast<int>(spec->fields.size());
+  bool immutable = output == Py_None;
+  bool direct = false;
+  ScopedPyObject kwargs;
+  ScopedPyObject created;
 
-  if (immutable) {
+  if (immutable && spec->fast && klass == spec->klass) {
+    // Skip __init__ altogether; the defaults are filled in below.
+    PyTypeObject* type = reinterpret_cast<PyTypeObject*>(klass);
+    ScopedPyObject args(PyTuple_New(0));
+    if (!args) {
+      return nullptr;
+    }
+    created.reset(type->tp_new(type, args.get(), nullptr));
+    if (!created) {
+      return nullptr;
+    }
+    output = created.get();
+    immutable = false;
+    direct = true;
+  } else if (immutable && spec->slotted && klass == spec->klass) {
+    // Let the class fill in its defaults, then store what we decode straight
+    // into its slots instead of building keyword arguments.
+    created.reset(PyObject_CallObject(klass, nullptr));
+    if (!created) {
+      return nullptr;
+    }
+    output = created.get();
+    immutable = false;
+    direct = true;
+  } else if (immutable) {
     kwargs.reset(PyDict_New());
     if (!kwargs) {
       PyErr_SetString(PyExc_TypeError, "failed to prepare kwargument storage");
       return nullptr;
     }
+  } else {
+    direct = spec->slotted && Py_TYPE(output) == reinterpret_cast<PyTypeObject*>(spec->klass);
   }
 
   detail::ReadStructScope<Impl> scope = detail::readStructScope(this);
@@ -857,7 +892,7 @@ PyObject* ProtocolBase<Impl>::readStruct(PyObject* output, PyObject* klass, PyOb
     if (type == T_STOP) {
       break;
     }
-    if (tag < 0 || tag >= spec_seq_len) {
+    if (tag < 0 || tag >= spec_seq_len || !spec->fields[tag].attrname) {
       if (!skip(type)) {
         PyErr_SetString(PyExc_TypeError, "Error while skipping unknown field");
         return nullptr;
@@ -865,18 +900,7 @@ PyObject* ProtocolBase<Impl>::readStruct(PyObject* output, PyObject* klass, PyOb
       continue;
     }
 
-    PyObject* item_spec = PyTuple_GET_ITEM(spec_seq, tag);
-    if (item_spec == Py_None) {
-      if (!skip(type)) {
-        PyErr_SetString(PyExc_TypeError, "Error while skipping unknown field");
-        return nullptr;
-      }
-      continue;
-    }
-    StructItemSpec parsedspec;
-    if (!parse_struct_item_spec(&parsedspec, item_spec)) {
-      return nullptr;
-    }
+    const StructItemSpec& parsedspec = spec->fields[tag];
     if (parsedspec.type != type) {
       if (!skip(type)) {
         PyErr_Format(PyExc_TypeError, "struct field had wrong type: expected %d but got %d",
@@ -886,11 +910,16 @@ PyObject* ProtocolBase<Impl>::readStruct(PyObject* output, PyObject* klass, PyOb
       continue;
     }
 
-    ScopedPyObject fieldval(decodeValue(parsedspec.type, parsedspec.typeargs));
-    if (!fieldval) {
+    PyObject* decoded = decodeValue(parsedspec.type, parsedspec.typeargs);
+    if (!decoded) {
       return nullptr;
     }
+    if (direct) {
+      set_slot(output, parsedspec, decoded);
+      continue;
+    }
 
+    ScopedPyObject fieldval(decoded);
     if ((immutable && PyDict_SetItem(kwargs.get(), parsedspec.attrname, fieldval.get()) == -1)
         || (!immutable && PyObject_SetAttr(output, parsedspec.attrname, fieldval.get()) == -1)) {
       return nullptr;
@@ -904,6 +933,18 @@ PyObject* ProtocolBase<Impl>::readStruct(PyObject* output, PyObject* klass, PyOb
     }
     return PyObject_Call(klass, args.get(), kwargs.get());
   }
+  if (created && spec->fast) {
+    for (size_t i = 0; i < spec->fields.size(); i++) {
+      const StructItemSpec& item = spec->fields[i];
+      if (item.attrname && !get_slot(output, item)) {
+        Py_INCREF(item.defval);
+        set_slot(output, item, item.defval);
+      }
+    }
+  }
+  if (created) {
+    return created.release();
+  }
   Py_INCREF(output);
   return output;
 }
@@ -19,6 +19,8 @@
 
 #include "ext/types.h"
 #include "ext/protocol.h"
+#include <structmember.h>
+#include <map>
 
 namespace apache {
 namespace thrift {
@@ -53,9 +55,97 @@ bool parse_struct_item_spec(StructItemSpec* dest, PyObject* spec_tuple) {
   dest->attrname = PyTuple_GET_ITEM(spec_tuple, 2);
   dest->typeargs = PyTuple_GET_ITEM(spec_tuple, 3);
   dest->defval = PyTuple_GET_ITEM(spec_tuple, 4);
+  dest->offset = -1;
   return true;
 }
 
+// Offset of the writable __slots__ member klass.attrname, or -1.
+static Py_ssize_t find_slot_offset(PyObject* klass, PyObject* attrname) {
+  if (!PyType_Check(klass)) {
+    return -1;
+  }
+  ScopedPyObject descr(PyObject_GetAttr(klass, attrname));
+  if (!descr) {
+    PyErr_Clear();
+    return -1;
+  }
+  if (!PyObject_TypeCheck(descr.get(), &PyMemberDescr_Type)) {
+    return -1;
+  }
+  PyMemberDef* member = reinterpret_cast<PyMemberDescrObject*>(descr.get())->d_member;
+  if (member->type != T_OBJECT_EX || (member->flags & READONLY)) {
+    return -1;
+  }
+  return member->offset;
+}
+
+// Whether klass itself, not a base class, was generated with fast_structs.
+// A subclass may have an __init__ of its own.
+static bool has_fast_struct_marker(PyObject* klass) {
+  PyObject* marker = PyDict_GetItemString(reinterpret_cast<PyTypeObject*>(klass)->tp_dict,
+                                          "thrift_fast_struct");
+  return marker && PyObject_IsTrue(marker) == 1;
+}
+
+static std::map<PyObject*, StructSpec*> struct_specs;
+
+const StructSpec* get_struct_spec(PyObject* klass, PyObject* spec) {
+  std::map<PyObject*, StructSpec*>::const_iterator it = struct_specs.find(spec);
+  if (it != struct_specs.end()) {
+    return it->second;
+  }
+
+  Py_ssize_t nspec = PyTuple_Size(spec);
+  if (nspec == -1) {
+    PyErr_SetString(PyExc_TypeError, "spec is not a tuple");
+    return nullptr;
+  }
+
+  StructSpec* compiled = new StructSpec;
+  compiled->klass = klass;
+  compiled->spec = spec;
+  compiled->fields.resize(nspec);
+  compiled->slotted = PyType_Check(klass);
+  for (Py_ssize_t i = 0; i < nspec; i++) {
+    StructItemSpec& item = compiled->fields[i];
+    PyObject* spec_tuple = PyTuple_GET_ITEM(spec, i);
+    if (spec_tuple == Py_None) {
+      item.attrname = nullptr;
+      continue;
+    }
+    if (!parse_struct_item_spec(&item, spec_tuple)) {
+      for (Py_ssize_t j = 0; j < i; j++) {
+        Py_XDECREF(compiled->fields[j].attrname);
+      }
+      delete compiled;
+      return nullptr;
+    }
+    Py_INCREF(item.attrname);
+    PyString_InternInPlace(&item.attrname);
+    item.offset = find_slot_offset(klass, item.attrname);
+    if (item.offset < 0) {
+      compiled->slotted = false;
+    }
+  }
+  compiled->fast = compiled->slotted && has_fast_struct_marker(klass);
+  for (Py_ssize_t i = 0; compiled->fast && i < nspec; i++) {
+    const StructItemSpec& item = compiled->fields[i];
+    if (item.attrname && item.defval != Py_None
+        && (item.type == T_STRUCT || item.type == T_LIST || item.type == T_SET
+            || item.type == T_MAP)) {
+      // __init__ hands out a fresh copy of these
+      compiled->fast = false;
+    }
+  }
+
+  // Keep everything the entry points at alive; the class holds the spec
+  // anyway, and the interned names are never released.
+  Py_INCREF(klass);
+  Py_INCREF(spec);
+  struct_specs[spec] = compiled;
+  return compiled;
+}
+
 bool parse_set_list_args(SetListTypeArgs* dest, PyObject* typeargs) {
   if (PyTuple_Size(typeargs) != 3) {
     PyErr_SetString(PyExc_TypeError, "expecting tuple of size 3 for list/set type args");
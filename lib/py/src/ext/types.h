@@ -20,6 +20,7 @@
 #ifndef THRIFT_PY_TYPES_H
 #define THRIFT_PY_TYPES_H
 
+#define PY_SSIZE_T_CLEAN
 #include <Python.h>
 
 #ifdef _MSC_VER
@@ -27,16 +28,16 @@
 #define __STDC_LIMIT_MACROS
 #endif
 #include <stdint.h>
+#include <vector>
 
 #if PY_MAJOR_VERSION >= 3
 
-#include <vector>
-
 // TODO: better macros
 #define PyInt_AsLong(v) PyLong_AsLong(v)
 #define PyInt_FromLong(v) PyLong_FromLong(v)
 
 #define PyString_InternFromString(v) PyUnicode_InternFromString(v)
+#define PyString_InternInPlace(v) PyUnicode_InternInPlace(v)
 
 #endif
 
@@ -176,8 +177,55 @@ struct StructItemSpec {
   PyObject* attrname;
   PyObject* typeargs;
   PyObject* defval;
+  // Offset of the __slots__ member holding the field, or -1.
+  Py_ssize_t offset;
+};
+
+/**
+ * A struct specification parsed once and kept for the life of the process,
+ * so decoding and encoding don't have to re-parse thrift_spec for every
+ * object.  fields is indexed by field id like thrift_spec itself; ids with
+ * no field have a null attrname.  Attribute names are interned.
+ */
+struct StructSpec {
+  PyObject* klass;
+  PyObject* spec;
+  std::vector<StructItemSpec> fields;
+  // Every field lives in a __slots__ member of klass, so objects of exactly
+  // klass can be read and filled in without getattr/setattr.
+  bool slotted;
+  // klass was generated with fast_structs and no field has a mutable default,
+  // so its instances can be created without calling __init__: every slot
+  // gets either a decoded value or its default from the spec.
+  bool fast;
 };
 
+/**
+ * Look up the compiled spec for a thrift_spec tuple, compiling it on first
+ * use.  Entries are keyed on the spec object and hold references to both
+ * the spec and the class, which therefore live as long as the process.
+ * Returns null with an exception set on malformed specs.
+ */
+const StructSpec* get_struct_spec(PyObject* klass, PyObject* spec);
+
+/**
+ * The value of a slotted field, as a borrowed reference, or null if the
+ * slot is empty.
+ */
+inline PyObject* get_slot(PyObject* obj, const StructItemSpec& item) {
+  return *reinterpret_cast<PyObject**>(reinterpret_cast<char*>(obj) + item.offset);
+}
+
+/**
+ * Store value, stealing the reference, in a slotted field.
+ */
+inline void set_slot(PyObject* obj, const StructItemSpec& item, PyObject* value) {
+  PyObject** slot = reinterpret_cast<PyObject**>(reinterpret_cast<char*>(obj) + item.offset);
+  PyObject* old = *slot;
+  *slot = value;
+  Py_XDECREF(old);
+}
+
 bool parse_set_list_args(SetListTypeArgs* dest, PyObject* typeargs);
 
 bool parse_map_args(MapTypeArgs* dest, PyObject* typeargs);
@@ -0,0 +1,134 @@
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements. See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership. The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License. You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied. See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+"""
+Measures encoding and decoding through the fastbinary extension.
+
+Each struct comes in three flavours, matching the generator options:
+
+  fast   py:fast_structs, which the extension creates without calling
+         __init__ and fills in directly
+  slots  py:slots, which the extension creates with __init__ and fills in
+         directly
+  dict   plain py, whose fields are set with setattr
+
+Run it against two builds of lib/py to compare them.
+
+    python test/fastbinary_benchmark.py [--iterations N]
+"""
+
+import argparse
+import timeit
+
+import _import_local_thrift  # noqa
+from thrift.Thrift import TType
+from thrift.TSerialization import deserialize, serialize
+from thrift.protocol import fastbinary  # noqa: fail early without the extension
+from thrift.protocol.TBase import TBase
+from thrift.protocol.TBinaryProtocol import TBinaryProtocolAcceleratedFactory
+from thrift.protocol.TCompactProtocol import TCompactProtocolAcceleratedFactory
+
+
+def make_classes(flavour):
+    slotted = flavour != 'dict'
+    base = TBase if slotted else object
+
+    class Point(base):
+        if slotted:
+            __slots__ = ('x', 'y', 'label', 'weight')
+        thrift_fast_struct = flavour == 'fast'
+
+        def __init__(self, x=None, y=None, label=None, weight=None):
+            self.x = x
+            self.y = y
+            self.label = label
+            self.weight = weight
+
+    class Shape(base):
+        if slotted:
+            __slots__ = ('name', 'points', 'tags', 'origin')
+        thrift_fast_struct = flavour == 'fast'
+
+        def __init__(self, name=None, points=None, tags=None, origin=None):
+            self.name = name
+            self.points = points
+            self.tags = tags
+            self.origin = origin
+
+    Point.thrift_spec = (
+        None,
+        (1, TType.I32, 'x', None, None, ),
+        (2, TType.I32, 'y', None, None, ),
+        (3, TType.STRING, 'label', 'UTF8', None, ),
+        (4, TType.DOUBLE, 'weight', None, None, ),
+    )
+    Shape.thrift_spec = (
+        None,
+        (1, TType.STRING, 'name', 'UTF8', None, ),
+        (2, TType.LIST, 'points', (TType.STRUCT, [Point, None], False), None, ),
+        (3, TType.MAP, 'tags', (TType.STRING, 'UTF8', TType.I64, None, False), None, ),
+        (4, TType.STRUCT, 'origin', [Point, None], None, ),
+    )
+    Shape.thrift_spec[2][3][1][1] = Point.thrift_spec
+    Shape.thrift_spec[4][3][1] = Point.thrift_spec
+
+    if not slotted:
+        # what the generator emits for classes without slots
+        for cls in (Point, Shape):
+            cls.read = TBase.read
+            cls.write = TBase.write
+    return Point, Shape
+
+
+def make_shape(Point, Shape, npoints):
+    points = [Point(i, -i, 'p%d' % i, i / 3.0) for i in range(npoints)]
+    tags = dict(('tag%d' % i, i << 33) for i in range(10))
+    return Shape('shape', points, tags, Point(0, 0, 'origin', 0.0))
+
+
+def run(name, factory, flavour, iterations, npoints):
+    Point, Shape = make_classes(flavour)
+    shape = make_shape(Point, Shape, npoints)
+    data = serialize(shape, factory)
+
+    decoded = deserialize(Shape(), data, factory)
+    assert serialize(decoded, factory) == data, 'round trip mismatch'
+
+    encode = min(timeit.repeat(lambda: serialize(shape, factory), number=iterations, repeat=3))
+    decode = min(timeit.repeat(lambda: deserialize(Shape(), data, factory),
+                               number=iterations, repeat=3))
+    print('%-8s %-7s %8d bytes  encode %8.1f us  decode %8.1f us' % (
+        name, flavour, len(data),
+        encode * 1e6 / iterations, decode * 1e6 / iterations))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--iterations', type=int, default=2000)
+    parser.add_argument('--points', type=int, default=100)
+    args = parser.parse_args()
+
+    for name, factory in (('binary', TBinaryProtocolAcceleratedFactory()),
+                          ('compact', TCompactProtocolAcceleratedFactory())):
+        for flavour in ('fast', 'slots', 'dict'):
+            run(name, factory, flavour, args.iterations, args.points)
+
+
+if __name__ == '__main__':
+    main()
@@ -24,6 +24,7 @@
 #include <struct.h>
 #include <macros.h>
 #include <bytes.h>
+#include <protocol.h>
 
 VALUE rb_thrift_binary_proto_native_qmark(VALUE self) {
   return Qtrue;
@@ -400,6 +401,171 @@ VALUE rb_thrift_binary_proto_read_binary(VALUE self) {
   return READ(self, size);
 }
 
+//---------------------------------------
+// whole-struct encoding (see protocol.h)
+//---------------------------------------
+
+static void buffer_write_byte(native_writer* w, int8_t value) {
+  native_writer_append(w, (char*)&value, 1);
+}
+
+static void buffer_write_i16(native_writer* w, int16_t value) {
+  char data[2];
+  data[0] = value >> 8;
+  data[1] = value;
+  native_writer_append(w, data, 2);
+}
+
+static void buffer_write_i32(native_writer* w, int32_t value) {
+  char data[4];
+  data[0] = value >> 24;
+  data[1] = value >> 16;
+  data[2] = value >> 8;
+  data[3] = value;
+  native_writer_append(w, data, 4);
+}
+
+static void buffer_write_i64(native_writer* w, int64_t value) {
+  char data[8];
+  data[0] = value >> 56;
+  data[1] = value >> 48;
+  data[2] = value >> 40;
+  data[3] = value >> 32;
+  data[4] = value >> 24;
+  data[5] = value >> 16;
+  data[6] = value >> 8;
+  data[7] = value;
+  native_writer_append(w, data, 8);
+}
+
+static void buffer_write_double(native_writer* w, double value) {
+  union {
+    double f;
+    int64_t t;
+  } transfer;
+  transfer.f = value;
+  buffer_write_i64(w, transfer.t);
+}
+
+static void buffer_write_bool(native_writer* w, bool value) {
+  buffer_write_byte(w, value ? 1 : 0);
+}
+
+static void buffer_write_binary(native_writer* w, const char* data, long len) {
+  buffer_write_i32(w, len);
+  native_writer_append(w, data, len);
+}
+
+static void buffer_write_field_begin(native_writer* w, int ttype, int id, int* last_id) {
+  buffer_write_byte(w, ttype);
+  buffer_write_i16(w, id);
+}
+
+static void buffer_write_bool_field(native_writer* w, int id, bool value, int* last_id) {
+  buffer_write_field_begin(w, TTYPE_BOOL, id, last_id);
+  buffer_write_bool(w, value);
+}
+
+static void buffer_write_field_stop(native_writer* w) {
+  buffer_write_byte(w, TTYPE_STOP);
+}
+
+static void buffer_write_map_begin(native_writer* w, int ktype, int vtype, int size) {
+  buffer_write_byte(w, ktype);
+  buffer_write_byte(w, vtype);
+  buffer_write_i32(w, size);
+}
+
+static void buffer_write_list_begin(native_writer* w, int etype, int size) {
+  buffer_write_byte(w, etype);
+  buffer_write_i32(w, size);
+}
+
+static int8_t buffer_read_byte(native_reader* r) {
+  return *native_reader_read(r, 1);
+}
+
+static int16_t buffer_read_i16(native_reader* r) {
+  const uint8_t* data = (const uint8_t*)native_reader_read(r, 2);
+  return (int16_t)((data[0] << 8) | data[1]);
+}
+
+static int32_t buffer_read_i32(native_reader* r) {
+  const uint8_t* data = (const uint8_t*)native_reader_read(r, 4);
+  return (int32_t)(((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3]);
+}
+
+static int64_t buffer_read_i64(native_reader* r) {
+  const uint8_t* data = (const uint8_t*)native_reader_read(r, 8);
+  uint64_t value = 0;
+  int i;
+  for (i = 0; i < 8; i++) {
+    value = (value << 8) | data[i];
+  }
+  return (int64_t)value;
+}
+
+static double buffer_read_double(native_reader* r) {
+  union {
+    double f;
+    int64_t t;
+  } transfer;
+  transfer.t = buffer_read_i64(r);
+  return transfer.f;
+}
+
+static bool buffer_read_bool(native_reader* r) {
+  return buffer_read_byte(r) != 0;
+}
+
+static int32_t buffer_read_binary_begin(native_reader* r) {
+  return buffer_read_i32(r);
+}
+
+static int buffer_read_field_begin(native_reader* r, int* id, int* last_id, int* bool_value) {
+  int type = buffer_read_byte(r);
+  if (type != TTYPE_STOP) {
+    *id = buffer_read_i16(r);
+  }
+  return type;
+}
+
+static void buffer_read_map_begin(native_reader* r, int* ktype, int* vtype, int* size) {
+  *ktype = buffer_read_byte(r);
+  *vtype = buffer_read_byte(r);
+  *size = buffer_read_i32(r);
+}
+
+static void buffer_read_list_begin(native_reader* r, int* etype, int* size) {
+  *etype = buffer_read_byte(r);
+  *size = buffer_read_i32(r);
+}
+
+static const native_protocol binary_native_protocol = {
+  buffer_write_field_begin,
+  buffer_write_bool_field,
+  buffer_write_field_stop,
+  buffer_write_map_begin,
+  buffer_write_list_begin,
+  buffer_write_bool,
+  buffer_write_byte,
+  buffer_write_i16,
+  buffer_write_i32,
+  buffer_write_i64,
+  buffer_write_double,
+  buffer_write_binary,
+  buffer_read_field_begin,
+  buffer_read_map_begin,
+  buffer_read_list_begin,
+  buffer_read_bool,
+  buffer_read_byte,
+  buffer_read_i16,
+  buffer_read_i32,
+  buffer_read_i64,
+  buffer_read_double,
+  buffer_read_binary_begin
+};
+
 void Init_binary_protocol_accelerated() {
   VALUE thrift_binary_protocol_class = rb_const_get(thrift_module, rb_intern("BinaryProtocol"));
 
@@ -457,4 +623,6 @@ void Init_binary_protocol_accelerated() {
   rb_define_method(bpa_class, "read_set_end", rb_thrift_binary_proto_read_set_end, 0);
 
   rbuf_ivar_id = rb_intern("@rbuf");
+
+  native_protocol_register(bpa_class, &binary_native_protocol);
 }
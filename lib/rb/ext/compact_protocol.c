@@ -24,6 +24,7 @@
 #include <struct.h>
 #include <macros.h>
 #include <bytes.h>
+#include <protocol.h>
 
 #define LAST_ID(obj) FIX2INT(rb_ary_pop(rb_ivar_get(obj, last_field_id)))
 #define SET_LAST_ID(obj, val) rb_ary_push(rb_ivar_get(obj, last_field_id), val)
@@ -62,8 +63,7 @@ static int CTYPE_STRUCT         = 0x0C;
 VALUE rb_thrift_compact_proto_write_i16(VALUE self, VALUE i16);
 
 // TODO: implement this
-static int get_compact_type(VALUE type_value) {
-  int type = FIX2INT(type_value);
+static int to_compact_type(int type) {
   if (type == TTYPE_BOOL) {
     return CTYPE_BOOLEAN_TRUE;
   } else if (type == TTYPE_BYTE) {
@@ -94,6 +94,10 @@ static int get_compact_type(VALUE type_value) {
   }
 }
 
+static int get_compact_type(VALUE type_value) {
+  return to_compact_type(FIX2INT(type_value));
+}
+
 static void write_byte_direct(VALUE transport, int8_t b) {
   WRITE(transport, (char*)&b, 1);
 }
@@ -565,6 +569,235 @@ VALUE rb_thrift_compact_proto_read_binary(VALUE self) {
   return READ(self, size);
 }
 
+//---------------------------------------
+// whole-struct encoding (see protocol.h)
+//---------------------------------------
+
+static void buffer_write_byte(native_writer* w, int8_t value) {
+  native_writer_append(w, (char*)&value, 1);
+}
+
+static void buffer_write_varint32(native_writer* w, uint32_t n) {
+  char data[5];
+  int len = 0;
+  while ((n & ~0x7F) != 0) {
+    data[len++] = (n & 0x7F) | 0x80;
+    n >>= 7;
+  }
+  data[len++] = n;
+  native_writer_append(w, data, len);
+}
+
+static void buffer_write_varint64(native_writer* w, uint64_t n) {
+  char data[10];
+  int len = 0;
+  while ((n & ~0x7FULL) != 0) {
+    data[len++] = (n & 0x7F) | 0x80;
+    n >>= 7;
+  }
+  data[len++] = n;
+  native_writer_append(w, data, len);
+}
+
+static void buffer_write_i16(native_writer* w, int16_t value) {
+  buffer_write_varint32(w, int_to_zig_zag(value));
+}
+
+static void buffer_write_i32(native_writer* w, int32_t value) {
+  buffer_write_varint32(w, int_to_zig_zag(value));
+}
+
+static void buffer_write_i64(native_writer* w, int64_t value) {
+  buffer_write_varint64(w, ll_to_zig_zag(value));
+}
+
+static void buffer_write_double(native_writer* w, double value) {
+  union {
+    double f;
+    int64_t l;
+  } transfer;
+  char data[8];
+  int i;
+  transfer.f = value;
+  for (i = 0; i < 8; i++) {
+    data[i] = (transfer.l >> (8 * i)) & 0xff;
+  }
+  native_writer_append(w, data, 8);
+}
+
+static void buffer_write_bool(native_writer* w, bool value) {
+  buffer_write_byte(w, value ? CTYPE_BOOLEAN_TRUE : CTYPE_BOOLEAN_FALSE);
+}
+
+static void buffer_write_binary(native_writer* w, const char* data, long len) {
+  buffer_write_varint32(w, len);
+  native_writer_append(w, data, len);
+}
+
+static void buffer_write_field_header(native_writer* w, int ctype, int id, int* last_id) {
+  int diff = id - *last_id;
+  if (diff > 0 && diff <= 15) {
+    buffer_write_byte(w, diff << 4 | ctype);
+  } else {
+    buffer_write_byte(w, ctype);
+    buffer_write_i16(w, id);
+  }
+  *last_id = id;
+}
+
+static void buffer_write_field_begin(native_writer* w, int ttype, int id, int* last_id) {
+  buffer_write_field_header(w, to_compact_type(ttype), id, last_id);
+}
+
+static void buffer_write_bool_field(native_writer* w, int id, bool value, int* last_id) {
+  buffer_write_field_header(w, value ? CTYPE_BOOLEAN_TRUE : CTYPE_BOOLEAN_FALSE, id, last_id);
+}
+
+static void buffer_write_field_stop(native_writer* w) {
+  buffer_write_byte(w, TTYPE_STOP);
+}
+
+static void buffer_write_map_begin(native_writer* w, int ktype, int vtype, int size) {
+  if (size == 0) {
+    buffer_write_byte(w, 0);
+  } else {
+    buffer_write_varint32(w, size);
+    buffer_write_byte(w, to_compact_type(ktype) << 4 | to_compact_type(vtype));
+  }
+}
+
+static void buffer_write_list_begin(native_writer* w, int etype, int size) {
+  if (size <= 14) {
+    buffer_write_byte(w, size << 4 | to_compact_type(etype));
+  } else {
+    buffer_write_byte(w, 0xf0 | to_compact_type(etype));
+    buffer_write_varint32(w, size);
+  }
+}
+
+static int8_t buffer_read_byte(native_reader* r) {
+  return *native_reader_read(r, 1);
+}
+
+static uint64_t buffer_read_varint64(native_reader* r) {
+  int shift = 0;
+  uint64_t result = 0;
+  while (shift < 64) {
+    int8_t b = buffer_read_byte(r);
+    result |= (uint64_t)(b & 0x7f) << shift;
+    if ((b & 0x80) != 0x80) {
+      return result;
+    }
+    shift += 7;
+  }
+  raise_invalid_data("Variable-length int over 10 bytes.");
+  return 0;
+}
+
+static int16_t buffer_read_i16(native_reader* r) {
+  return zig_zag_to_int((int32_t)buffer_read_varint64(r));
+}
+
+static int32_t buffer_read_i32(native_reader* r) {
+  return zig_zag_to_int((int32_t)buffer_read_varint64(r));
+}
+
+static int64_t buffer_read_i64(native_reader* r) {
+  return zig_zag_to_ll(buffer_read_varint64(r));
+}
+
+static double buffer_read_double(native_reader* r) {
+  const uint8_t* data = (const uint8_t*)native_reader_read(r, 8);
+  union {
+    double f;
+    int64_t l;
+  } transfer;
+  uint64_t value = 0;
+  int i;
+  for (i = 7; i >= 0; i--) {
+    value = (value << 8) | data[i];
+  }
+  transfer.l = value;
+  return transfer.f;
+}
+
+static bool buffer_read_bool(native_reader* r) {
+  return buffer_read_byte(r) == CTYPE_BOOLEAN_TRUE;
+}
+
+static int32_t buffer_read_size(native_reader* r) {
+  int64_t size = (int64_t)buffer_read_varint64(r);
+  if (size < 0 || size > INT32_MAX) {
+    raise_negative_size();
+  }
+  return (int32_t)size;
+}
+
+static int32_t buffer_read_binary_begin(native_reader* r) {
+  return buffer_read_size(r);
+}
+
+static int buffer_read_field_begin(native_reader* r, int* id, int* last_id, int* bool_value) {
+  int8_t type = buffer_read_byte(r);
+  if ((type & 0x0f) == TTYPE_STOP) {
+    return TTYPE_STOP;
+  }
+
+  uint8_t modifier = (type & 0xf0) >> 4;
+  if (modifier == 0) {
+    *id = buffer_read_i16(r);
+  } else {
+    *id = *last_id + modifier;
+  }
+  *last_id = *id;
+
+  if (is_bool_type(type)) {
+    *bool_value = (type & 0x0f) == CTYPE_BOOLEAN_TRUE;
+  }
+  return get_ttype(type & 0x0f);
+}
+
+static void buffer_read_map_begin(native_reader* r, int* ktype, int* vtype, int* size) {
+  *size = buffer_read_size(r);
+  uint8_t key_and_value_type = *size == 0 ? 0 : buffer_read_byte(r);
+  *ktype = get_ttype(key_and_value_type >> 4);
+  *vtype = get_ttype(key_and_value_type & 0xf);
+}
+
+static void buffer_read_list_begin(native_reader* r, int* etype, int* size) {
+  uint8_t size_and_type = buffer_read_byte(r);
+  *size = (size_and_type >> 4) & 0x0f;
+  if (*size == 15) {
+    *size = buffer_read_size(r);
+  }
+  *etype = get_ttype(size_and_type & 0x0f);
+}
+
+static const native_protocol compact_native_protocol = {
+  buffer_write_field_begin,
+  buffer_write_bool_field,
+  buffer_write_field_stop,
+  buffer_write_map_begin,
+  buffer_write_list_begin,
+  buffer_write_bool,
+  buffer_write_byte,
+  buffer_write_i16,
+  buffer_write_i32,
+  buffer_write_i64,
+  buffer_write_double,
+  buffer_write_binary,
+  buffer_read_field_begin,
+  buffer_read_map_begin,
+  buffer_read_list_begin,
+  buffer_read_bool,
+  buffer_read_byte,
+  buffer_read_i16,
+  buffer_read_i32,
+  buffer_read_i64,
+  buffer_read_double,
+  buffer_read_binary_begin
+};
+
 static void Init_constants() {
   thrift_compact_protocol_class = rb_const_get(thrift_module, rb_intern("CompactProtocol"));
   rb_global_variable(&thrift_compact_protocol_class);
@@ -635,4 +868,5 @@ static void Init_rb_methods() {
 void Init_compact_protocol() {
   Init_constants();
   Init_rb_methods();
+  native_protocol_register(thrift_compact_protocol_class, &compact_native_protocol);
 }
@@ -0,0 +1,186 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <ruby.h>
+#include <constants.h>
+#include <macros.h>
+#include <protocol.h>
+
+#define MAX_NATIVE_PROTOCOLS 4
+
+static struct {
+  VALUE klass;
+  const native_protocol* protocol;
+} native_protocols[MAX_NATIVE_PROTOCOLS];
+static int num_native_protocols = 0;
+
+static VALUE memory_buffer_class;
+static VALUE framed_transport_class;
+static VALUE buffered_transport_class;
+
+static ID buf_ivar;
+static ID rbuf_ivar;
+static ID index_ivar;
+static ID read_ivar;
+
+static int INVALID_DATA;
+static int NEGATIVE_SIZE;
+static long GARBAGE_BUFFER_SIZE;
+
+void native_protocol_register(VALUE klass, const native_protocol* protocol) {
+  if (num_native_protocols == MAX_NATIVE_PROTOCOLS) {
+    rb_raise(rb_eRuntimeError, "too many native protocols");
+  }
+  native_protocols[num_native_protocols].klass = klass;
+  native_protocols[num_native_protocols].protocol = protocol;
+  num_native_protocols++;
+}
+
+// Subclasses may override the protocol methods, so only exact matches count.
+const native_protocol* native_protocol_for(VALUE protocol) {
+  VALUE klass = rb_obj_class(protocol);
+  int i;
+  for (i = 0; i < num_native_protocols; i++) {
+    if (native_protocols[i].klass == klass) {
+      return native_protocols[i].protocol;
+    }
+  }
+  return NULL;
+}
+
+static void raise_protocol_exception(int code, const char* message) {
+  VALUE args[2];
+  args[0] = INT2FIX(code);
+  args[1] = rb_str_new2(message);
+  rb_exc_raise(rb_class_new_instance(2, args, protocol_exception_class));
+}
+
+void raise_negative_size() {
+  raise_protocol_exception(NEGATIVE_SIZE, "Negative size");
+}
+
+void raise_invalid_data(const char* message) {
+  raise_protocol_exception(INVALID_DATA, message);
+}
+
+//--------------------------------
+// writing
+//--------------------------------
+
+void native_writer_init(native_writer* w) {
+  w->buf = rb_str_buf_new(128);
+}
+
+void native_writer_append(native_writer* w, const char* data, long len) {
+  rb_str_buf_cat(w->buf, data, len);
+}
+
+void native_writer_flush(native_writer* w, VALUE trans) {
+  rb_funcall(trans, write_method_id, 1, w->buf);
+}
+
+//--------------------------------
+// reading
+//--------------------------------
+
+// Picks up the read buffer and position of the transports that keep one in
+// a String, so that most reads need no call into Ruby at all.
+static void load_buffer(native_reader* r) {
+  if (r->buf_ivar) {
+    r->buf = rb_ivar_get(r->trans, r->buf_ivar);
+    r->index = FIX2LONG(rb_ivar_get(r->trans, r->index_ivar));
+  }
+}
+
+static void store_index(native_reader* r) {
+  if (r->buf_ivar) {
+    rb_ivar_set(r->trans, r->index_ivar, LONG2FIX(r->index));
+  }
+}
+
+void native_reader_init(native_reader* r, VALUE trans) {
+  VALUE klass = rb_obj_class(trans);
+
+  r->trans = trans;
+  r->buf = Qnil;
+  r->index = 0;
+  r->buf_ivar = 0;
+  r->index_ivar = index_ivar;
+  r->release_read = false;
+  r->chunk = Qnil;
+
+  if (klass == memory_buffer_class) {
+    r->buf_ivar = buf_ivar;
+    r->release_read = true;
+  } else if (klass == buffered_transport_class) {
+    r->buf_ivar = rbuf_ivar;
+  } else if (klass == framed_transport_class && RTEST(rb_ivar_get(trans, read_ivar))) {
+    r->buf_ivar = rbuf_ivar;
+  }
+  load_buffer(r);
+}
+
+// Returns a pointer to the next len bytes, valid until the next call.
+const char* native_reader_read(native_reader* r, long len) {
+  if (len < 0) {
+    raise_negative_size();
+  }
+  if (!NIL_P(r->buf) && r->index + len <= RSTRING_LEN(r->buf)) {
+    const char* data = RSTRING_PTR(r->buf) + r->index;
+    r->index += len;
+    return data;
+  }
+
+  // Not (or not all) buffered: let the transport refill, a frame or a
+  // buffer at a time, and pick up its new buffer afterwards.
+  store_index(r);
+  r->chunk = rb_funcall(r->trans, read_all_method_id, 1, LONG2FIX(len));
+  if (RSTRING_LEN(r->chunk) < len) {
+    rb_raise(rb_eEOFError, "Not enough bytes remain in buffer");
+  }
+  load_buffer(r);
+  return RSTRING_PTR(r->chunk);
+}
+
+void native_reader_finish(native_reader* r) {
+  if (r->release_read && r->index >= GARBAGE_BUFFER_SIZE) {
+    r->buf = rb_str_substr(r->buf, r->index, RSTRING_LEN(r->buf) - r->index);
+    rb_ivar_set(r->trans, r->buf_ivar, r->buf);
+    r->index = 0;
+  }
+  store_index(r);
+}
+
+void Init_protocol() {
+  memory_buffer_class = rb_const_get(thrift_module, rb_intern("MemoryBufferTransport"));
+  rb_global_variable(&memory_buffer_class);
+  framed_transport_class = rb_const_get(thrift_module, rb_intern("FramedTransport"));
+  rb_global_variable(&framed_transport_class);
+  buffered_transport_class = rb_const_get(thrift_module, rb_intern("BufferedTransport"));
+  rb_global_variable(&buffered_transport_class);
+
+  GARBAGE_BUFFER_SIZE = FIX2LONG(rb_const_get(memory_buffer_class, rb_intern("GARBAGE_BUFFER_SIZE")));
+  INVALID_DATA = FIX2INT(rb_const_get(protocol_exception_class, rb_intern("INVALID_DATA")));
+  NEGATIVE_SIZE = FIX2INT(rb_const_get(protocol_exception_class, rb_intern("NEGATIVE_SIZE")));
+
+  buf_ivar = rb_intern("@buf");
+  rbuf_ivar = rb_intern("@rbuf");
+  index_ivar = rb_intern("@index");
+  read_ivar = rb_intern("@read");
+}
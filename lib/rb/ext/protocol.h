@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <ruby.h>
+
+/*
+ * Whole-struct encoding for the native protocols.
+ *
+ * When Struct#write and Struct#read are handed one of the protocols that
+ * register themselves here, they encode the struct into a C-side buffer and
+ * pass it to the transport in a single write, and decode it from the
+ * transport's own read buffer, instead of calling a protocol method for
+ * every value.
+ */
+
+typedef struct {
+  VALUE buf;
+} native_writer;
+
+typedef struct {
+  VALUE trans;
+  VALUE buf;          // the transport's read buffer, or Qnil if it has none we know of
+  long index;         // read position in buf
+  ID buf_ivar;
+  ID index_ivar;
+  bool release_read;  // drop consumed bytes from buf when done, as MemoryBufferTransport does
+  VALUE chunk;        // holds the last block read through the transport
+} native_reader;
+
+typedef struct {
+  // last_id is the id of the previous field of the enclosing struct, which
+  // starts out as 0; protocols that delta-encode field ids keep it current.
+  void (*write_field_begin)(native_writer* w, int ttype, int id, int* last_id);
+  void (*write_bool_field)(native_writer* w, int id, bool value, int* last_id);
+  void (*write_field_stop)(native_writer* w);
+  void (*write_map_begin)(native_writer* w, int ktype, int vtype, int size);
+  void (*write_list_begin)(native_writer* w, int etype, int size);
+  void (*write_bool)(native_writer* w, bool value);
+  void (*write_byte)(native_writer* w, int8_t value);
+  void (*write_i16)(native_writer* w, int16_t value);
+  void (*write_i32)(native_writer* w, int32_t value);
+  void (*write_i64)(native_writer* w, int64_t value);
+  void (*write_double)(native_writer* w, double value);
+  void (*write_binary)(native_writer* w, const char* data, long len);
+
+  // Returns the field type, or TTYPE_STOP. A bool field whose value is part
+  // of the header sets *bool_value to 0 or 1; otherwise it is left alone.
+  int (*read_field_begin)(native_reader* r, int* id, int* last_id, int* bool_value);
+  void (*read_map_begin)(native_reader* r, int* ktype, int* vtype, int* size);
+  void (*read_list_begin)(native_reader* r, int* etype, int* size);
+  bool (*read_bool)(native_reader* r);
+  int8_t (*read_byte)(native_reader* r);
+  int16_t (*read_i16)(native_reader* r);
+  int32_t (*read_i32)(native_reader* r);
+  int64_t (*read_i64)(native_reader* r);
+  double (*read_double)(native_reader* r);
+  int32_t (*read_binary_begin)(native_reader* r);
+} native_protocol;
+
+void native_protocol_register(VALUE klass, const native_protocol* protocol);
+const native_protocol* native_protocol_for(VALUE protocol);
+
+void native_writer_init(native_writer* w);
+void native_writer_append(native_writer* w, const char* data, long len);
+void native_writer_flush(native_writer* w, VALUE trans);
+
+void native_reader_init(native_reader* r, VALUE trans);
+const char* native_reader_read(native_reader* r, long len);
+void native_reader_finish(native_reader* r);
+
+void raise_negative_size();
+void raise_invalid_data(const char* message);
+
+void Init_protocol();
@@ -20,7 +20,12 @@
 #include "struct.h"
 #include "constants.h"
 #include "macros.h"
-#include "strlcpy.h"
+#include "bytes.h"
+#include "protocol.h"
+#ifdef HAVE_RUBY_ENCODING_H
+#include <ruby/encoding.h>
+#endif
+#include <ruby/st.h>
 
 VALUE thrift_union_class;
 
@@ -28,11 +33,8 @@ ID setfield_id;
 ID setvalue_id;
 
 ID to_s_method_id;
-ID name_to_id_method_id;
-static ID sorted_field_ids_method_id;
 
 #define IS_CONTAINER(ttype) ((ttype) == TTYPE_MAP || (ttype) == TTYPE_LIST || (ttype) == TTYPE_SET)
-#define STRUCT_FIELDS(obj) rb_const_get(CLASS_OF(obj), fields_const_id)
 
 //-------------------------------------------
 // Writing section
@@ -209,24 +211,152 @@ VALUE default_read_struct_end(VALUE protocol) {
 
 // end default protocol methods
 
-static VALUE rb_thrift_union_write (VALUE self, VALUE protocol);
-static VALUE rb_thrift_struct_write(VALUE self, VALUE protocol);
-static void write_anything(int ttype, VALUE value, VALUE protocol, VALUE field_info);
+//-------------------------------------------
+// Field tables
+//-------------------------------------------
+
+// The FIELDS hash of each struct and union class is compiled into a table
+// the first time an instance is read or written, so that neither needs a
+// hash lookup per field.
+
+typedef struct struct_spec struct_spec;
+
+typedef struct field_spec {
+  int ttype;
+  int id;
+  bool binary;
+  VALUE name;           // field name, as given in FIELDS
+  VALUE name_sym;       // the same as a Symbol, which is what unions store
+  ID ivar;              // @name
+  VALUE klass;          // struct or union class of a TTYPE_STRUCT value
+  struct_spec* nested;  // its table, filled in on first use
+  struct field_spec* key;
+  struct field_spec* value;
+  struct field_spec* element;
+} field_spec;
+
+struct struct_spec {
+  bool is_union;
+  long num_fields;
+  field_spec* fields;   // ordered by id
+};
+
+static st_table* struct_specs;
+// The classes and FIELDS hashes the tables point into.
+static VALUE struct_spec_roots;
+
+static field_spec* compile_type_info(VALUE type_info);
+
+static void init_field_spec(field_spec* spec, VALUE type_info) {
+  MEMZERO(spec, field_spec, 1);
+  spec->ttype = FIX2INT(rb_hash_aref(type_info, type_sym));
+  spec->binary = rb_hash_aref(type_info, binary_sym) == Qtrue;
+  spec->name = rb_hash_aref(type_info, name_sym);
+  spec->klass = rb_hash_aref(type_info, class_sym);
+
+  if (spec->ttype == TTYPE_MAP) {
+    spec->key = compile_type_info(rb_hash_aref(type_info, key_sym));
+    spec->value = compile_type_info(rb_hash_aref(type_info, value_sym));
+  } else if (spec->ttype == TTYPE_LIST || spec->ttype == TTYPE_SET) {
+    spec->element = compile_type_info(rb_hash_aref(type_info, element_sym));
+  }
+}
+
+static field_spec* compile_type_info(VALUE type_info) {
+  field_spec* spec;
+  if (NIL_P(type_info)) {
+    return NULL;
+  }
+  spec = ALLOC(field_spec);
+  init_field_spec(spec, type_info);
+  return spec;
+}
+
+static struct_spec* get_struct_spec(VALUE klass) {
+  st_data_t data;
+  if (st_lookup(struct_specs, (st_data_t)klass, &data)) {
+    return (struct_spec*)data;
+  }
+
+  VALUE struct_fields = rb_const_get(klass, fields_const_id);
+  Check_Type(struct_fields, T_HASH);
+  VALUE field_ids = rb_ary_sort_bang(rb_funcall(struct_fields, keys_method_id, 0));
+
+  struct_spec* spec = ALLOC(struct_spec);
+  spec->is_union = RTEST(rb_class_inherited_p(klass, thrift_union_class));
+  spec->num_fields = RARRAY_LEN(field_ids);
+  spec->fields = ALLOC_N(field_spec, spec->num_fields);
+
+  long i;
+  for (i = 0; i < spec->num_fields; i++) {
+    VALUE field_id = rb_ary_entry(field_ids, i);
+    field_spec* field = &spec->fields[i];
+    init_field_spec(field, rb_hash_aref(struct_fields, field_id));
+    field->id = FIX2INT(field_id);
+    field->name_sym = rb_str_intern(field->name);
+    field->ivar = rb_intern_str(rb_str_plus(rb_str_new2("@"), field->name));
+  }
 
-VALUE get_field_value(VALUE obj, VALUE field_name) {
-  char name_buf[RSTRING_LEN(field_name) + 2];
+  rb_ary_push(struct_spec_roots, klass);
+  rb_ary_push(struct_spec_roots, struct_fields);
+  st_insert(struct_specs, (st_data_t)klass, (st_data_t)spec);
+  return spec;
+}
 
-  name_buf[0] = '@';
-  strlcpy(&name_buf[1], RSTRING_PTR(field_name), RSTRING_LEN(field_name) + 1);
+static field_spec* find_field(struct_spec* spec, int id) {
+  long lo = 0;
+  long hi = spec->num_fields - 1;
+  while (lo <= hi) {
+    long mid = (lo + hi) / 2;
+    int mid_id = spec->fields[mid].id;
+    if (mid_id == id) {
+      return &spec->fields[mid];
+    } else if (mid_id < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return NULL;
+}
 
-  VALUE value = rb_ivar_get(obj, rb_intern(name_buf));
+static field_spec* find_union_field(struct_spec* spec, VALUE setfield) {
+  VALUE sym = SYMBOL_P(setfield) ? setfield : rb_str_intern(rb_funcall(setfield, to_s_method_id, 0));
+  long i;
+  for (i = 0; i < spec->num_fields; i++) {
+    if (spec->fields[i].name_sym == sym) {
+      return &spec->fields[i];
+    }
+  }
+  rb_raise(rb_eRuntimeError, "set_field is not valid for this union!");
+  return NULL;
+}
+
+static struct_spec* nested_struct_spec(field_spec* spec, VALUE klass) {
+  if (klass != spec->klass) {
+    return get_struct_spec(klass);
+  }
+  if (spec->nested == NULL) {
+    spec->nested = get_struct_spec(klass);
+  }
+  return spec->nested;
+}
 
-  return value;
+static void check_container_spec(field_spec* spec) {
+  if (spec->ttype == TTYPE_MAP ? (spec->key == NULL || spec->value == NULL) : spec->element == NULL) {
+    rb_raise(rb_eStandardError, "missing type info for container of type: %d", spec->ttype);
+  }
 }
 
-static void write_container(int ttype, VALUE field_info, VALUE value, VALUE protocol) {
+static VALUE rb_thrift_union_write (VALUE self, VALUE protocol);
+static VALUE rb_thrift_struct_write(VALUE self, VALUE protocol);
+static void write_anything(int ttype, VALUE value, VALUE protocol, field_spec* spec);
+
+static void write_container(int ttype, field_spec* spec, VALUE value, VALUE protocol) {
   int sz, i;
 
+  check_container_spec(spec);
+
   if (ttype == TTYPE_MAP) {
     VALUE keys;
     VALUE key;
@@ -234,35 +364,21 @@ static void write_container(int ttype, VALUE field_info, VALUE value, VALUE prot
 
     Check_Type(value, T_HASH);
 
-    VALUE key_info = rb_hash_aref(field_info, key_sym);
-    VALUE keytype_value = rb_hash_aref(key_info, type_sym);
-    int keytype = FIX2INT(keytype_value);
-
-    VALUE value_info = rb_hash_aref(field_info, value_sym);
-    VALUE valuetype_value = rb_hash_aref(value_info, type_sym);
-    int valuetype = FIX2INT(valuetype_value);
+    int keytype = spec->key->ttype;
+    int valuetype = spec->value->ttype;
 
     keys = rb_funcall(value, keys_method_id, 0);
 
     sz = RARRAY_LEN(keys);
 
-    default_write_map_begin(protocol, keytype_value, valuetype_value, INT2FIX(sz));
+    default_write_map_begin(protocol, INT2FIX(keytype), INT2FIX(valuetype), INT2FIX(sz));
 
     for (i = 0; i < sz; i++) {
       key = rb_ary_entry(keys, i);
       val = rb_hash_aref(value, key);
 
-      if (IS_CONTAINER(keytype)) {
-        write_container(keytype, key_info, key, protocol);
-      } else {
-        write_anything(keytype, key, protocol, key_info);
-      }
-
-      if (IS_CONTAINER(valuetype)) {
-        write_container(valuetype, value_info, val, protocol);
-      } else {
-        write_anything(valuetype, val, protocol, value_info);
-      }
+      write_anything(keytype, key, protocol, spec->key);
+      write_anything(valuetype, val, protocol, spec->value);
     }
 
     default_write_map_end(protocol);
@@ -271,18 +387,12 @@ static void write_container(int ttype, VALUE field_info, VALUE value, VALUE prot
 
     sz = RARRAY_LEN(value);
 
-    VALUE element_type_info = rb_hash_aref(field_info, element_sym);
-    VALUE element_type_value = rb_hash_aref(element_type_info, type_sym);
-    int element_type = FIX2INT(element_type_value);
+    int element_type = spec->element->ttype;
 
-    default_write_list_begin(protocol, element_type_value, INT2FIX(sz));
+    default_write_list_begin(protocol, INT2FIX(element_type), INT2FIX(sz));
     for (i = 0; i < sz; ++i) {
       VALUE val = rb_ary_entry(value, i);
-      if (IS_CONTAINER(element_type)) {
-        write_container(element_type, element_type_info, val, protocol);
-      } else {
-        write_anything(element_type, val, protocol, element_type_info);
-      }
+      write_anything(element_type, val, protocol, spec->element);
     }
     default_write_list_end(protocol);
   } else if (ttype == TTYPE_SET) {
@@ -301,19 +411,13 @@ static void write_container(int ttype, VALUE field_info, VALUE value, VALUE prot
 
     sz = RARRAY_LEN(items);
 
-    VALUE element_type_info = rb_hash_aref(field_info, element_sym);
-    VALUE element_type_value = rb_hash_aref(element_type_info, type_sym);
-    int element_type = FIX2INT(element_type_value);
+    int element_type = spec->element->ttype;
 
-    default_write_set_begin(protocol, element_type_value, INT2FIX(sz));
+    default_write_set_begin(protocol, INT2FIX(element_type), INT2FIX(sz));
 
     for (i = 0; i < sz; i++) {
       VALUE val = rb_ary_entry(items, i);
-      if (IS_CONTAINER(element_type)) {
-        write_container(element_type, element_type_info, val, protocol);
-      } else {
-        write_anything(element_type, val, protocol, element_type_info);
-      }
+      write_anything(element_type, val, protocol, spec->element);
     }
 
     default_write_set_end(protocol);
@@ -322,7 +426,7 @@ static void write_container(int ttype, VALUE field_info, VALUE value, VALUE prot
   }
 }
 
-static void write_anything(int ttype, VALUE value, VALUE protocol, VALUE field_info) {
+static void write_anything(int ttype, VALUE value, VALUE protocol, field_spec* spec) {
   if (ttype == TTYPE_BOOL) {
     default_write_bool(protocol, value);
   } else if (ttype == TTYPE_BYTE) {
@@ -336,14 +440,13 @@ static void write_anything(int ttype, VALUE value, VALUE protocol, VALUE field_i
   } else if (ttype == TTYPE_DOUBLE) {
     default_write_double(protocol, value);
   } else if (ttype == TTYPE_STRING) {
-    VALUE is_binary = rb_hash_aref(field_info, binary_sym);
-    if (is_binary != Qtrue) {
+    if (!spec->binary) {
       default_write_string(protocol, value);
     } else {
       default_write_binary(protocol, value);
     }
   } else if (IS_CONTAINER(ttype)) {
-    write_container(ttype, field_info, value, protocol);
+    write_container(ttype, spec, value, protocol);
   } else if (ttype == TTYPE_STRUCT) {
     if (rb_obj_is_kind_of(value, thrift_union_class)) {
       rb_thrift_union_write(value, protocol);
@@ -355,7 +458,158 @@ static void write_anything(int ttype, VALUE value, VALUE protocol, VALUE field_i
   }
 }
 
+// Whole-struct encoding for the native protocols.
+
+typedef struct {
+  native_writer* writer;
+  const native_protocol* protocol;
+  field_spec* spec;
+} native_write_context;
+
+static void native_write_struct(native_writer* w, const native_protocol* p, VALUE self, struct_spec* spec);
+static void native_write_value(native_writer* w, const native_protocol* p, field_spec* spec, VALUE value);
+
+static int native_write_map_entry(VALUE key, VALUE value, VALUE arg) {
+  native_write_context* context = (native_write_context*)arg;
+  native_write_value(context->writer, context->protocol, context->spec->key, key);
+  native_write_value(context->writer, context->protocol, context->spec->value, value);
+  return ST_CONTINUE;
+}
+
+static void native_write_string(native_writer* w, const native_protocol* p, field_spec* spec, VALUE value) {
+  if (TYPE(value) != T_STRING) {
+    rb_raise(rb_eStandardError, "Value should be a string");
+  }
+#ifdef HAVE_RUBY_ENCODING_H
+  if (!spec->binary && ENCODING_GET(value) != rb_utf8_encindex()) {
+    value = convert_to_utf8_byte_buffer(value);
+  }
+#endif
+  p->write_binary(w, RSTRING_PTR(value), RSTRING_LEN(value));
+}
+
+static void native_write_container(native_writer* w, const native_protocol* p, field_spec* spec, VALUE value) {
+  long sz, i;
+
+  check_container_spec(spec);
+
+  if (spec->ttype == TTYPE_MAP) {
+    native_write_context context;
+
+    Check_Type(value, T_HASH);
+
+    p->write_map_begin(w, spec->key->ttype, spec->value->ttype, RHASH_SIZE(value));
+    context.writer = w;
+    context.protocol = p;
+    context.spec = spec;
+    rb_hash_foreach(value, native_write_map_entry, (VALUE)&context);
+  } else {
+    VALUE items = value;
+
+    if (spec->ttype == TTYPE_LIST) {
+      Check_Type(value, T_ARRAY);
+    } else if (TYPE(value) != T_ARRAY) {
+      if (rb_cSet == CLASS_OF(value)) {
+        items = rb_funcall(value, entries_method_id, 0);
+      } else {
+        Check_Type(value, T_HASH);
+        items = rb_funcall(value, keys_method_id, 0);
+      }
+    }
+
+    sz = RARRAY_LEN(items);
+    p->write_list_begin(w, spec->element->ttype, sz);
+    for (i = 0; i < sz; i++) {
+      native_write_value(w, p, spec->element, rb_ary_entry(items, i));
+    }
+  }
+}
+
+static void native_write_value(native_writer* w, const native_protocol* p, field_spec* spec, VALUE value) {
+  int ttype = spec->ttype;
+
+  if (ttype == TTYPE_BOOL) {
+    p->write_bool(w, RTEST(value));
+  } else if (ttype == TTYPE_BYTE) {
+    CHECK_NIL(value);
+    p->write_byte(w, NUM2INT(value));
+  } else if (ttype == TTYPE_I16) {
+    CHECK_NIL(value);
+    p->write_i16(w, NUM2INT(value));
+  } else if (ttype == TTYPE_I32) {
+    CHECK_NIL(value);
+    p->write_i32(w, NUM2INT(value));
+  } else if (ttype == TTYPE_I64) {
+    CHECK_NIL(value);
+    p->write_i64(w, NUM2LL(value));
+  } else if (ttype == TTYPE_DOUBLE) {
+    CHECK_NIL(value);
+    p->write_double(w, RFLOAT_VALUE(rb_Float(value)));
+  } else if (ttype == TTYPE_STRING) {
+    native_write_string(w, p, spec, value);
+  } else if (IS_CONTAINER(ttype)) {
+    native_write_container(w, p, spec, value);
+  } else if (ttype == TTYPE_STRUCT) {
+    native_write_struct(w, p, value, nested_struct_spec(spec, rb_obj_class(value)));
+  } else {
+    rb_raise(rb_eNotImpError, "Unknown type for binary_encoding: %d", ttype);
+  }
+}
+
+static void native_write_struct(native_writer* w, const native_protocol* p, VALUE self, struct_spec* spec) {
+  int last_id = 0;
+  long i;
+
+  rb_funcall(self, validate_method_id, 0);
+
+  if (spec->is_union) {
+    field_spec* field = find_union_field(spec, rb_ivar_get(self, setfield_id));
+    VALUE value = rb_ivar_get(self, setvalue_id);
+
+    if (field->ttype == TTYPE_BOOL) {
+      p->write_bool_field(w, field->id, RTEST(value), &last_id);
+    } else {
+      p->write_field_begin(w, field->ttype, field->id, &last_id);
+      native_write_value(w, p, field, value);
+    }
+  } else {
+    for (i = 0; i < spec->num_fields; i++) {
+      field_spec* field = &spec->fields[i];
+      VALUE value = rb_ivar_get(self, field->ivar);
+
+      if (NIL_P(value)) {
+        continue;
+      }
+      if (field->ttype == TTYPE_BOOL) {
+        p->write_bool_field(w, field->id, RTEST(value), &last_id);
+      } else {
+        p->write_field_begin(w, field->ttype, field->id, &last_id);
+        native_write_value(w, p, field, value);
+      }
+    }
+  }
+
+  p->write_field_stop(w);
+}
+
+static bool native_write(VALUE self, VALUE protocol) {
+  const native_protocol* p = native_protocol_for(protocol);
+  native_writer w;
+
+  if (p == NULL) {
+    return false;
+  }
+  native_writer_init(&w);
+  native_write_struct(&w, p, self, get_struct_spec(rb_obj_class(self)));
+  native_writer_flush(&w, GET_TRANSPORT(protocol));
+  return true;
+}
+
 static VALUE rb_thrift_struct_write(VALUE self, VALUE protocol) {
+  if (native_write(self, protocol)) {
+    return Qnil;
+  }
+
   // call validate
   rb_funcall(self, validate_method_id, 0);
 
@@ -363,25 +617,18 @@ static VALUE rb_thrift_struct_write(VALUE self, VALUE protocol) {
   default_write_struct_begin(protocol, rb_class_name(CLASS_OF(self)));
 
   // iterate through all the fields here
-  VALUE struct_fields = STRUCT_FIELDS(self);
-  VALUE sorted_field_ids = rb_funcall(self, sorted_field_ids_method_id, 0);
+  struct_spec* spec = get_struct_spec(rb_obj_class(self));
 
-  int i = 0;
-  for (i=0; i < RARRAY_LEN(sorted_field_ids); i++) {
-    VALUE field_id = rb_ary_entry(sorted_field_ids, i);
+  long i;
+  for (i = 0; i < spec->num_fields; i++) {
+    field_spec* field = &spec->fields[i];
 
-    VALUE field_info = rb_hash_aref(struct_fields, field_id);
-
-    VALUE ttype_value = rb_hash_aref(field_info, type_sym);
-    int ttype = FIX2INT(ttype_value);
-    VALUE field_name = rb_hash_aref(field_info, name_sym);
-
-    VALUE field_value = get_field_value(self, field_name);
+    VALUE field_value = rb_ivar_get(self, field->ivar);
 
     if (!NIL_P(field_value)) {
-      default_write_field_begin(protocol, field_name, ttype_value, field_id);
+      default_write_field_begin(protocol, field->name, INT2FIX(field->ttype), INT2FIX(field->id));
 
-      write_anything(ttype, field_value, protocol, field_info);
+      write_anything(field->ttype, field_value, protocol, field);
 
       default_write_field_end(protocol);
     }
@@ -404,15 +651,6 @@ static VALUE rb_thrift_struct_read(VALUE self, VALUE protocol);
 static void skip_map_contents(VALUE protocol, VALUE key_type_value, VALUE value_type_value, int size);
 static void skip_list_or_set_contents(VALUE protocol, VALUE element_type_value, int size);
 
-static void set_field_value(VALUE obj, VALUE field_name, VALUE value) {
-  char name_buf[RSTRING_LEN(field_name) + 2];
-
-  name_buf[0] = '@';
-  strlcpy(&name_buf[1], RSTRING_PTR(field_name), RSTRING_LEN(field_name)+1);
-
-  rb_ivar_set(obj, rb_intern(name_buf), value);
-}
-
 // Helper method to skip the contents of a map (assumes the map header has been read).
 static void skip_map_contents(VALUE protocol, VALUE key_type_value, VALUE value_type_value, int size) {
   int i;
@@ -430,7 +668,7 @@ static void skip_list_or_set_contents(VALUE protocol, VALUE element_type_value,
   }
 }
 
-static VALUE read_anything(VALUE protocol, int ttype, VALUE field_info) {
+static VALUE read_anything(VALUE protocol, int ttype, field_spec* spec) {
   VALUE result = Qnil;
 
   if (ttype == TTYPE_BOOL) {
@@ -444,8 +682,7 @@ static VALUE read_anything(VALUE protocol, int ttype, VALUE field_info) {
   } else if (ttype == TTYPE_I64) {
     result = default_read_i64(protocol);
   } else if (ttype == TTYPE_STRING) {
-    VALUE is_binary = rb_hash_aref(field_info, binary_sym);
-    if (is_binary != Qtrue) {
+    if (!spec->binary) {
       result = default_read_string(protocol);
     } else {
       result = default_read_binary(protocol);
@@ -453,8 +690,7 @@ static VALUE read_anything(VALUE protocol, int ttype, VALUE field_info) {
   } else if (ttype == TTYPE_DOUBLE) {
     result = default_read_double(protocol);
   } else if (ttype == TTYPE_STRUCT) {
-    VALUE klass = rb_hash_aref(field_info, class_sym);
-    result = rb_class_new_instance(0, NULL, klass);
+    result = rb_class_new_instance(0, NULL, spec->klass);
 
     if (rb_obj_is_kind_of(result, thrift_union_class)) {
       rb_thrift_union_read(result, protocol);
@@ -471,20 +707,18 @@ static VALUE read_anything(VALUE protocol, int ttype, VALUE field_info) {
 
     // Check the declared key and value types against the expected ones and skip the map contents
     // if the types don't match.
-    VALUE key_info = rb_hash_aref(field_info, key_sym);
-    VALUE value_info = rb_hash_aref(field_info, value_sym);
+    field_spec* key_spec = spec->key;
+    field_spec* value_spec = spec->value;
 
-    if (!NIL_P(key_info) && !NIL_P(value_info)) {
-      int specified_key_type = FIX2INT(rb_hash_aref(key_info, type_sym));
-      int specified_value_type = FIX2INT(rb_hash_aref(value_info, type_sym));
-      if (num_entries == 0 || (specified_key_type == key_ttype && specified_value_type == value_ttype)) {
+    if (key_spec != NULL && value_spec != NULL) {
+      if (num_entries == 0 || (key_spec->ttype == key_ttype && value_spec->ttype == value_ttype)) {
         result = rb_hash_new();
 
         for (i = 0; i < num_entries; ++i) {
           VALUE key, val;
 
-          key = read_anything(protocol, key_ttype, key_info);
-          val = read_anything(protocol, value_ttype, value_info);
+          key = read_anything(protocol, key_ttype, key_spec);
+          val = read_anything(protocol, value_ttype, value_spec);
 
           rb_hash_aset(result, key, val);
         }
@@ -505,14 +739,13 @@ static VALUE read_anything(VALUE protocol, int ttype, VALUE field_info) {
 
     // Check the declared element type against the expected one and skip the list contents
     // if the types don't match.
-    VALUE element_info = rb_hash_aref(field_info, element_sym);
-    if (!NIL_P(element_info)) {
-      int specified_element_type = FIX2INT(rb_hash_aref(element_info, type_sym));
-      if (specified_element_type == element_ttype) {
+    field_spec* element_spec = spec->element;
+    if (element_spec != NULL) {
+      if (element_spec->ttype == element_ttype) {
         result = rb_ary_new2(num_elements);
 
         for (i = 0; i < num_elements; ++i) {
-          rb_ary_push(result, read_anything(protocol, element_ttype, rb_hash_aref(field_info, element_sym)));
+          rb_ary_push(result, read_anything(protocol, element_ttype, element_spec));
         }
       } else {
         skip_list_or_set_contents(protocol, INT2FIX(element_ttype), num_elements);
@@ -532,14 +765,13 @@ static VALUE read_anything(VALUE protocol, int ttype, VALUE field_info) {
 
     // Check the declared element type against the expected one and skip the set contents
     // if the types don't match.
-    VALUE element_info = rb_hash_aref(field_info, element_sym);
-    if (!NIL_P(element_info)) {
-      int specified_element_type = FIX2INT(rb_hash_aref(element_info, type_sym));
-      if (specified_element_type == element_ttype) {
+    field_spec* element_spec = spec->element;
+    if (element_spec != NULL) {
+      if (element_spec->ttype == element_ttype) {
         items = rb_ary_new2(num_elements);
 
         for (i = 0; i < num_elements; ++i) {
-          rb_ary_push(items, read_anything(protocol, element_ttype, rb_hash_aref(field_info, element_sym)));
+          rb_ary_push(items, read_anything(protocol, element_ttype, element_spec));
         }
 
         result = rb_class_new_instance(1, &items, rb_cSet);
@@ -558,11 +790,215 @@ static VALUE read_anything(VALUE protocol, int ttype, VALUE field_info) {
   return result;
 }
 
+// Whole-struct decoding for the native protocols.
+
+static void native_read_struct(native_reader* r, const native_protocol* p, VALUE self, struct_spec* spec);
+
+static void native_skip(native_reader* r, const native_protocol* p, int ttype) {
+  int i, size, ktype, vtype, etype;
+
+  if (ttype == TTYPE_BOOL) {
+    p->read_bool(r);
+  } else if (ttype == TTYPE_BYTE) {
+    p->read_byte(r);
+  } else if (ttype == TTYPE_I16) {
+    p->read_i16(r);
+  } else if (ttype == TTYPE_I32) {
+    p->read_i32(r);
+  } else if (ttype == TTYPE_I64) {
+    p->read_i64(r);
+  } else if (ttype == TTYPE_DOUBLE) {
+    p->read_double(r);
+  } else if (ttype == TTYPE_STRING) {
+    native_reader_read(r, p->read_binary_begin(r));
+  } else if (ttype == TTYPE_STRUCT) {
+    int last_id = 0;
+    while (true) {
+      int id = 0;
+      int bool_value = -1;
+      int field_type = p->read_field_begin(r, &id, &last_id, &bool_value);
+      if (field_type == TTYPE_STOP) {
+        break;
+      }
+      if (bool_value < 0) {
+        native_skip(r, p, field_type);
+      }
+    }
+  } else if (ttype == TTYPE_MAP) {
+    p->read_map_begin(r, &ktype, &vtype, &size);
+    for (i = 0; i < size; i++) {
+      native_skip(r, p, ktype);
+      native_skip(r, p, vtype);
+    }
+  } else if (ttype == TTYPE_LIST || ttype == TTYPE_SET) {
+    p->read_list_begin(r, &etype, &size);
+    for (i = 0; i < size; i++) {
+      native_skip(r, p, etype);
+    }
+  } else {
+    raise_invalid_data("Invalid data");
+  }
+}
+
+// Reads a value whose type on the wire matches spec.
+static VALUE native_read_value(native_reader* r, const native_protocol* p, field_spec* spec) {
+  int ttype = spec->ttype;
+  int i, size;
+
+  if (ttype == TTYPE_BOOL) {
+    return p->read_bool(r) ? Qtrue : Qfalse;
+  } else if (ttype == TTYPE_BYTE) {
+    return INT2FIX(p->read_byte(r));
+  } else if (ttype == TTYPE_I16) {
+    return INT2FIX(p->read_i16(r));
+  } else if (ttype == TTYPE_I32) {
+    return INT2NUM(p->read_i32(r));
+  } else if (ttype == TTYPE_I64) {
+    return LL2NUM(p->read_i64(r));
+  } else if (ttype == TTYPE_DOUBLE) {
+    return rb_float_new(p->read_double(r));
+  } else if (ttype == TTYPE_STRING) {
+    size = p->read_binary_begin(r);
+    const char* data = native_reader_read(r, size);
+#ifdef HAVE_RUBY_ENCODING_H
+    if (!spec->binary) {
+      return rb_enc_str_new(data, size, rb_utf8_encoding());
+    }
+#endif
+    return rb_str_new(data, size);
+  } else if (ttype == TTYPE_STRUCT) {
+    VALUE result = rb_class_new_instance(0, NULL, spec->klass);
+    native_read_struct(r, p, result, nested_struct_spec(spec, spec->klass));
+    return result;
+  } else if (ttype == TTYPE_MAP) {
+    int ktype, vtype;
+
+    p->read_map_begin(r, &ktype, &vtype, &size);
+    if (size < 0) {
+      raise_negative_size();
+    }
+    if (spec->key != NULL && spec->value != NULL &&
+        (size == 0 || (spec->key->ttype == ktype && spec->value->ttype == vtype))) {
+      VALUE result = rb_hash_new();
+      for (i = 0; i < size; i++) {
+        VALUE key = native_read_value(r, p, spec->key);
+        VALUE val = native_read_value(r, p, spec->value);
+        rb_hash_aset(result, key, val);
+      }
+      return result;
+    }
+    for (i = 0; i < size; i++) {
+      native_skip(r, p, ktype);
+      native_skip(r, p, vtype);
+    }
+    return Qnil;
+  } else if (ttype == TTYPE_LIST || ttype == TTYPE_SET) {
+    int etype;
+
+    p->read_list_begin(r, &etype, &size);
+    if (size < 0) {
+      raise_negative_size();
+    }
+    if (spec->element != NULL && spec->element->ttype == etype) {
+      VALUE items = rb_ary_new2(size);
+      for (i = 0; i < size; i++) {
+        rb_ary_push(items, native_read_value(r, p, spec->element));
+      }
+      return ttype == TTYPE_SET ? rb_class_new_instance(1, &items, rb_cSet) : items;
+    }
+    for (i = 0; i < size; i++) {
+      native_skip(r, p, etype);
+    }
+    return Qnil;
+  }
+
+  rb_raise(rb_eNotImpError, "read_anything not implemented for type %d!", ttype);
+  return Qnil;
+}
+
+// Reads one field into self if it is one spec knows, or skips it. Returns
+// false at the end of the struct.
+static bool native_read_field(native_reader* r, const native_protocol* p, VALUE self, struct_spec* spec,
+                              int* last_id) {
+  int id = 0;
+  int bool_value = -1;
+  int ttype = p->read_field_begin(r, &id, last_id, &bool_value);
+
+  if (ttype == TTYPE_STOP) {
+    return false;
+  }
+
+  field_spec* field = find_field(spec, id);
+  if (field != NULL && field->ttype == ttype) {
+    VALUE value = bool_value >= 0 ? (bool_value ? Qtrue : Qfalse) : native_read_value(r, p, field);
+    if (spec->is_union) {
+      rb_ivar_set(self, setfield_id, field->name_sym);
+      rb_ivar_set(self, setvalue_id, value);
+    } else {
+      rb_ivar_set(self, field->ivar, value);
+    }
+  } else if (bool_value < 0) {
+    native_skip(r, p, ttype);
+  }
+  return true;
+}
+
+static void native_read_struct(native_reader* r, const native_protocol* p, VALUE self, struct_spec* spec) {
+  int last_id = 0;
+
+  if (spec->is_union) {
+    if (native_read_field(r, p, self, spec, &last_id) && native_read_field(r, p, self, spec, &last_id)) {
+      rb_raise(rb_eRuntimeError, "too many fields in union!");
+    }
+  } else {
+    while (native_read_field(r, p, self, spec, &last_id)) {
+    }
+  }
+
+  rb_funcall(self, validate_method_id, 0);
+}
+
+typedef struct {
+  native_reader reader;
+  const native_protocol* protocol;
+  VALUE self;
+  struct_spec* spec;
+} native_read_args;
+
+static VALUE native_read_body(VALUE arg) {
+  native_read_args* args = (native_read_args*)arg;
+  native_read_struct(&args->reader, args->protocol, args->self, args->spec);
+  return Qnil;
+}
+
+static VALUE native_read_ensure(VALUE arg) {
+  native_reader_finish(&((native_read_args*)arg)->reader);
+  return Qnil;
+}
+
+static bool native_read(VALUE self, VALUE protocol) {
+  native_read_args args;
+
+  args.protocol = native_protocol_for(protocol);
+  if (args.protocol == NULL) {
+    return false;
+  }
+  args.self = self;
+  args.spec = get_struct_spec(rb_obj_class(self));
+  native_reader_init(&args.reader, GET_TRANSPORT(protocol));
+  rb_ensure(native_read_body, (VALUE)&args, native_read_ensure, (VALUE)&args);
+  return true;
+}
+
 static VALUE rb_thrift_struct_read(VALUE self, VALUE protocol) {
+  if (native_read(self, protocol)) {
+    return Qnil;
+  }
+
   // read struct begin
   default_read_struct_begin(protocol);
 
-  VALUE struct_fields = STRUCT_FIELDS(self);
+  struct_spec* spec = get_struct_spec(rb_obj_class(self));
 
   // read each field
   while (true) {
@@ -575,17 +1011,11 @@ static VALUE rb_thrift_struct_read(VALUE self, VALUE protocol) {
     }
 
     // make sure we got a type we expected
-    VALUE field_info = rb_hash_aref(struct_fields, rb_ary_entry(field_header, 2));
-
-    if (!NIL_P(field_info)) {
-      int specified_type = FIX2INT(rb_hash_aref(field_info, type_sym));
-      if (field_type == specified_type) {
-        // read the value
-        VALUE name = rb_hash_aref(field_info, name_sym);
-        set_field_value(self, name, read_anything(protocol, field_type, field_info));
-      } else {
-        rb_funcall(protocol, skip_method_id, 1, field_type_value);
-      }
+    field_spec* field = find_field(spec, FIX2INT(rb_ary_entry(field_header, 2)));
+
+    if (field != NULL && field->ttype == field_type) {
+      // read the value
+      rb_ivar_set(self, field->ivar, read_anything(protocol, field_type, field));
     } else {
       rb_funcall(protocol, skip_method_id, 1, field_type_value);
     }
@@ -609,28 +1039,26 @@ static VALUE rb_thrift_struct_read(VALUE self, VALUE protocol) {
 // --------------------------------
 
 static VALUE rb_thrift_union_read(VALUE self, VALUE protocol) {
+  if (native_read(self, protocol)) {
+    return Qnil;
+  }
+
   // read struct begin
   default_read_struct_begin(protocol);
 
-  VALUE struct_fields = STRUCT_FIELDS(self);
+  struct_spec* spec = get_struct_spec(rb_obj_class(self));
 
   VALUE field_header = default_read_field_begin(protocol);
   VALUE field_type_value = rb_ary_entry(field_header, 1);
   int field_type = FIX2INT(field_type_value);
 
   // make sure we got a type we expected
-  VALUE field_info = rb_hash_aref(struct_fields, rb_ary_entry(field_header, 2));
+  field_spec* field = find_field(spec, FIX2INT(rb_ary_entry(field_header, 2)));
 
-  if (!NIL_P(field_info)) {
-    int specified_type = FIX2INT(rb_hash_aref(field_info, type_sym));
-    if (field_type == specified_type) {
-      // read the value
-      VALUE name = rb_hash_aref(field_info, name_sym);
-      rb_iv_set(self, "@setfield", rb_str_intern(name));
-      rb_iv_set(self, "@value", read_anything(protocol, field_type, field_info));
-    } else {
-      rb_funcall(protocol, skip_method_id, 1, field_type_value);
-    }
+  if (field != NULL && field->ttype == field_type) {
+    // read the value
+    rb_ivar_set(self, setfield_id, field->name_sym);
+    rb_ivar_set(self, setvalue_id, read_anything(protocol, field_type, field));
   } else {
     rb_funcall(protocol, skip_method_id, 1, field_type_value);
   }
@@ -656,30 +1084,26 @@ static VALUE rb_thrift_union_read(VALUE self, VALUE protocol) {
 }
 
 static VALUE rb_thrift_union_write(VALUE self, VALUE protocol) {
+  if (native_write(self, protocol)) {
+    return Qnil;
+  }
+
   // call validate
   rb_funcall(self, validate_method_id, 0);
 
   // write struct begin
   default_write_struct_begin(protocol, rb_class_name(CLASS_OF(self)));
 
-  VALUE struct_fields = STRUCT_FIELDS(self);
+  struct_spec* spec = get_struct_spec(rb_obj_class(self));
 
   VALUE setfield = rb_ivar_get(self, setfield_id);
   VALUE setvalue = rb_ivar_get(self, setvalue_id);
-  VALUE field_id = rb_funcall(self, name_to_id_method_id, 1, rb_funcall(setfield, to_s_method_id, 0));
-
-  VALUE field_info = rb_hash_aref(struct_fields, field_id);
 
-  if(NIL_P(field_info)) {
-    rb_raise(rb_eRuntimeError, "set_field is not valid for this union!");
-  }
-
-  VALUE ttype_value = rb_hash_aref(field_info, type_sym);
-  int ttype = FIX2INT(ttype_value);
+  field_spec* field = find_union_field(spec, setfield);
 
-  default_write_field_begin(protocol, setfield, ttype_value, field_id);
+  default_write_field_begin(protocol, setfield, INT2FIX(field->ttype), INT2FIX(field->id));
 
-  write_anything(ttype, setvalue, protocol, field_info);
+  write_anything(field->ttype, setvalue, protocol, field);
 
   default_write_field_end(protocol);
 
@@ -712,9 +1136,7 @@ void Init_struct() {
   to_s_method_id = rb_intern("to_s");
   rb_global_variable(&to_s_method_id);
 
-  name_to_id_method_id = rb_intern("name_to_id");
-  rb_global_variable(&name_to_id_method_id);
-
-  sorted_field_ids_method_id = rb_intern("sorted_field_ids");
-  rb_global_variable(&sorted_field_ids_method_id);
+  struct_specs = st_init_numtable();
+  struct_spec_roots = rb_ary_new();
+  rb_global_variable(&struct_spec_roots);
 }
@@ -23,6 +23,7 @@
 #include <binary_protocol_accelerated.h>
 #include <compact_protocol.h>
 #include <memory_buffer.h>
+#include <protocol.h>
 
 // cached classes/modules
 VALUE rb_cSet;
@@ -211,6 +212,7 @@ void Init_thrift_native() {
   rb_global_variable(&class_sym);
   rb_global_variable(&binary_sym);
 
+  Init_protocol();
   Init_struct();
   Init_binary_protocol_accelerated();
   Init_compact_protocol();
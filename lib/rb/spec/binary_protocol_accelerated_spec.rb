@@ -31,6 +31,22 @@ if defined? Thrift::BinaryProtocolAccelerated
       Thrift::BinaryProtocolAccelerated
     end
 
+    it "should encode whole structs the same way as BinaryProtocol" do
+      struct = SpecNamespace::SimpleList.new(
+        :bools => [true, false], :i32s => [1, -2**31], :i64s => [2**40], :doubles => [-1.5],
+        :strings => ["", "\u20AC"], :maps => [{1 => 2}], :sets => [Set.new([3])],
+        :hellos => [SpecNamespace::Hello.new(:greeting => "hi")])
+
+      expected = Thrift::Serializer.new(Thrift::BinaryProtocolFactory.new).serialize(struct)
+      data = Thrift::Serializer.new(Thrift::BinaryProtocolAcceleratedFactory.new).serialize(struct)
+      expect(data).to eq(expected)
+
+      trans = Thrift::FramedTransport.new(Thrift::MemoryBufferTransport.new([data.length].pack('N') + data))
+      struct2 = SpecNamespace::SimpleList.new
+      struct2.read(Thrift::BinaryProtocolAccelerated.new(trans))
+      expect(struct2).to eq(struct)
+    end
+
     describe Thrift::BinaryProtocolAcceleratedFactory do
       it "should create a BinaryProtocolAccelerated" do
         expect(Thrift::BinaryProtocolAcceleratedFactory.new.get_protocol(double("MockTransport"))).to be_instance_of(Thrift::BinaryProtocolAccelerated)
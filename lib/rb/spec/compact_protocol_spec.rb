@@ -84,6 +84,25 @@ describe Thrift::CompactProtocol do
     expect(struct2).to eq(struct)
   end
 
+  it "should encode whole structs the same way as its field-by-field methods" do
+    # struct encoding is only done in C for CompactProtocol itself
+    subclass = Class.new(Thrift::CompactProtocol)
+    struct = Thrift::Test::BreaksRubyCompactProtocol.new(
+      :field1 => "blah",
+      :field2 => Thrift::Test::BigFieldIdStruct.new(:field1 => "string1", :field2 => "string2"),
+      :field3 => 3)
+
+    expected = Thrift::MemoryBufferTransport.new
+    struct.write(subclass.new(expected))
+    trans = Thrift::MemoryBufferTransport.new
+    struct.write(Thrift::CompactProtocol.new(trans))
+    expect(trans.inspect_buffer).to eq(expected.inspect_buffer)
+
+    struct2 = Thrift::Test::BreaksRubyCompactProtocol.new
+    struct2.read(Thrift::CompactProtocol.new(trans))
+    expect(struct2).to eq(struct)
+  end
+
   it "should make method calls correctly" do
     client_out_trans = Thrift::MemoryBufferTransport.new
     client_out_proto = Thrift::CompactProtocol.new(client_out_trans)
@@ -18,7 +18,7 @@
 use std::convert::TryFrom;
 use std::convert::{From, Into};
 use std::fmt::{Debug, Display, Formatter};
-use std::{error, fmt, io, string};
+use std::{error, fmt, io, str, string};
 
 use crate::protocol::{
     TFieldIdentifier, TInputProtocol, TOutputProtocol, TStructIdentifier, TType,
@@ -450,6 +450,15 @@ impl From<string::FromUtf8Error> for Error {
     }
 }
 
+impl From<str::Utf8Error> for Error {
+    fn from(err: str::Utf8Error) -> Self {
+        Error::Protocol(ProtocolError {
+            kind: ProtocolErrorKind::InvalidData,
+            message: err.to_string(),
+        })
+    }
+}
+
 /// Create a new `Error` instance of type `Protocol` that wraps a
 /// `ProtocolError`.
 pub fn new_protocol_error<S: Into<String>>(kind: ProtocolErrorKind, message: S) -> Error {
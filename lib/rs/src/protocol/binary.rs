@@ -18,13 +18,14 @@
 use byteorder::{BigEndian, ByteOrder, ReadBytesExt, WriteBytesExt};
 use std::convert::{From, TryFrom};
 
+use super::{borrow_bytes, read_fixed_width_list};
 use super::{
-    TFieldIdentifier, TInputProtocol, TInputProtocolFactory, TListIdentifier, TMapIdentifier,
-    TMessageIdentifier, TMessageType,
+    TBorrowedInputProtocol, TFieldIdentifier, TInputProtocol, TInputProtocolFactory,
+    TListIdentifier, TMapIdentifier, TMessageIdentifier, TMessageType,
 };
 use super::{TOutputProtocol, TOutputProtocolFactory, TSetIdentifier, TStructIdentifier, TType};
 use crate::transport::{TReadTransport, TWriteTransport};
-use crate::{ProtocolError, ProtocolErrorKind};
+use crate::{OrderedFloat, ProtocolError, ProtocolErrorKind};
 
 const BINARY_PROTOCOL_VERSION_1: u32 = 0x8001_0000;
 
@@ -226,6 +227,28 @@ where
         Ok(())
     }
 
+    fn read_i8_list(&mut self, size: i32) -> crate::Result<Vec<i8>> {
+        read_fixed_width_list(&mut self.transport, size, 1, |b| b[0] as i8)
+    }
+
+    fn read_i16_list(&mut self, size: i32) -> crate::Result<Vec<i16>> {
+        read_fixed_width_list(&mut self.transport, size, 2, BigEndian::read_i16)
+    }
+
+    fn read_i32_list(&mut self, size: i32) -> crate::Result<Vec<i32>> {
+        read_fixed_width_list(&mut self.transport, size, 4, BigEndian::read_i32)
+    }
+
+    fn read_i64_list(&mut self, size: i32) -> crate::Result<Vec<i64>> {
+        read_fixed_width_list(&mut self.transport, size, 8, BigEndian::read_i64)
+    }
+
+    fn read_double_list(&mut self, size: i32) -> crate::Result<Vec<OrderedFloat<f64>>> {
+        read_fixed_width_list(&mut self.transport, size, 8, |b| {
+            OrderedFloat::from(BigEndian::read_f64(b))
+        })
+    }
+
     // utility
     //
 
@@ -234,6 +257,13 @@ where
     }
 }
 
+impl<'a> TBorrowedInputProtocol<'a> for TBinaryInputProtocol<&'a [u8]> {
+    fn read_borrowed_bytes(&mut self) -> crate::Result<&'a [u8]> {
+        let num_bytes = self.transport.read_i32::<BigEndian>()? as usize;
+        borrow_bytes(&mut self.transport, num_bytes)
+    }
+}
+
 /// Factory for creating instances of `TBinaryInputProtocol`.
 #[derive(Default)]
 pub struct TBinaryInputProtocolFactory;
@@ -926,6 +956,63 @@ mod tests {
         assert_eq!(&received_bytes, &bytes);
     }
 
+    #[test]
+    fn must_read_lists_in_bulk() {
+        let mut buf: Vec<u8> = Vec::new();
+        {
+            let mut o_prot = TBinaryOutputProtocol::new(&mut buf, true);
+            // more than one buffer's worth of i32s
+            for i in 0..300 {
+                o_prot.write_i32(i * 7 - 1000).unwrap();
+            }
+            o_prot.write_i64(-1).unwrap();
+            o_prot.write_i64(1 << 40).unwrap();
+            o_prot.write_double(-0.5).unwrap();
+            o_prot.write_i16(-300).unwrap();
+            o_prot.write_i8(-3).unwrap();
+        }
+
+        let mut i_prot = TBinaryInputProtocol::new(&buf[..], true);
+        let expected: Vec<i32> = (0..300).map(|i| i * 7 - 1000).collect();
+        assert_eq!(i_prot.read_i32_list(300).unwrap(), expected);
+        assert_eq!(i_prot.read_i64_list(2).unwrap(), vec![-1, 1 << 40]);
+        assert_eq!(
+            i_prot.read_double_list(1).unwrap(),
+            vec![OrderedFloat::from(-0.5)]
+        );
+        assert_eq!(i_prot.read_i16_list(1).unwrap(), vec![-300]);
+        assert_eq!(i_prot.read_i8_list(1).unwrap(), vec![-3]);
+        assert_eq!(i_prot.read_i32_list(0).unwrap(), Vec::<i32>::new());
+        assert!(i_prot.read_i32_list(1).is_err());
+    }
+
+    #[test]
+    fn must_borrow_strings_and_bytes() {
+        let mut buf: Vec<u8> = Vec::new();
+        {
+            let mut o_prot = TBinaryOutputProtocol::new(&mut buf, true);
+            o_prot.write_string("borrowed").unwrap();
+            o_prot.write_bytes(&[0x00, 0xFF]).unwrap();
+            o_prot.write_bytes(&[0xC3, 0x28]).unwrap();
+        }
+
+        let mut i_prot = TBinaryInputProtocol::new(&buf[..], true);
+        let string = i_prot.read_borrowed_string().unwrap();
+        assert_eq!(string, "borrowed");
+        assert_eq!(string.as_ptr(), buf[4..].as_ptr());
+        assert_eq!(i_prot.read_borrowed_bytes().unwrap(), &[0x00, 0xFF]);
+        // not UTF-8
+        assert!(i_prot.read_borrowed_string().is_err());
+        assert!(i_prot.read_borrowed_bytes().is_err());
+    }
+
+    #[test]
+    fn must_not_borrow_past_end_of_buffer() {
+        let buf: [u8; 6] = [0x00, 0x00, 0x00, 0x03, 0x61, 0x62];
+        let mut i_prot = TBinaryInputProtocol::new(&buf[..], true);
+        assert!(i_prot.read_borrowed_bytes().is_err());
+    }
+
     fn test_objects(
         strict: bool,
     ) -> (
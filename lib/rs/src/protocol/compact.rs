@@ -15,17 +15,19 @@
 // specific language governing permissions and limitations
 // under the License.
 
-use byteorder::{LittleEndian, ReadBytesExt, WriteBytesExt};
+use byteorder::{ByteOrder, LittleEndian, ReadBytesExt, WriteBytesExt};
 use integer_encoding::{VarIntReader, VarIntWriter};
 use std::convert::{From, TryFrom};
 use std::io;
 
+use super::{borrow_bytes, read_fixed_width_list};
 use super::{
-    TFieldIdentifier, TInputProtocol, TInputProtocolFactory, TListIdentifier, TMapIdentifier,
-    TMessageIdentifier, TMessageType,
+    TBorrowedInputProtocol, TFieldIdentifier, TInputProtocol, TInputProtocolFactory,
+    TListIdentifier, TMapIdentifier, TMessageIdentifier, TMessageType,
 };
 use super::{TOutputProtocol, TOutputProtocolFactory, TSetIdentifier, TStructIdentifier, TType};
 use crate::transport::{TReadTransport, TWriteTransport};
+use crate::OrderedFloat;
 
 const COMPACT_PROTOCOL_ID: u8 = 0x82;
 const COMPACT_VERSION: u8 = 0x01;
@@ -292,6 +294,18 @@ where
         Ok(())
     }
 
+    // integers are varints, so only bytes and doubles have a fixed width
+
+    fn read_i8_list(&mut self, size: i32) -> crate::Result<Vec<i8>> {
+        read_fixed_width_list(&mut self.transport, size, 1, |b| b[0] as i8)
+    }
+
+    fn read_double_list(&mut self, size: i32) -> crate::Result<Vec<OrderedFloat<f64>>> {
+        read_fixed_width_list(&mut self.transport, size, 8, |b| {
+            OrderedFloat::from(LittleEndian::read_f64(b))
+        })
+    }
+
     // utility
     //
 
@@ -304,6 +318,13 @@ where
     }
 }
 
+impl<'a> TBorrowedInputProtocol<'a> for TCompactInputProtocol<&'a [u8]> {
+    fn read_borrowed_bytes(&mut self) -> crate::Result<&'a [u8]> {
+        let len = self.transport.read_varint::<u32>()?;
+        borrow_bytes(&mut self.transport, len as usize)
+    }
+}
+
 impl<T> io::Seek for TCompactInputProtocol<T>
 where
     T: io::Seek + TReadTransport,
@@ -2827,6 +2848,47 @@ mod tests {
         assert_eq_written_bytes!(o_prot, expected);
     }
 
+    #[test]
+    fn must_read_lists_in_bulk() {
+        let mut buf: Vec<u8> = Vec::new();
+        {
+            let mut o_prot = TCompactOutputProtocol::new(&mut buf);
+            // more than one buffer's worth of doubles
+            for i in 0..200 {
+                o_prot.write_double(f64::from(i) / 4.0).unwrap();
+            }
+            o_prot.write_i32(-1).unwrap();
+            o_prot.write_i32(i32::MAX).unwrap();
+            o_prot.write_i8(-3).unwrap();
+        }
+
+        let mut i_prot = TCompactInputProtocol::new(&buf[..]);
+        let expected: Vec<OrderedFloat<f64>> = (0..200)
+            .map(|i| OrderedFloat::from(f64::from(i) / 4.0))
+            .collect();
+        assert_eq!(i_prot.read_double_list(200).unwrap(), expected);
+        assert_eq!(i_prot.read_i32_list(2).unwrap(), vec![-1, i32::MAX]);
+        assert_eq!(i_prot.read_i8_list(1).unwrap(), vec![-3]);
+        assert!(i_prot.read_i8_list(1).is_err());
+    }
+
+    #[test]
+    fn must_borrow_strings_and_bytes() {
+        let mut buf: Vec<u8> = Vec::new();
+        {
+            let mut o_prot = TCompactOutputProtocol::new(&mut buf);
+            o_prot.write_string("borrowed").unwrap();
+            o_prot.write_bytes(&[0x00, 0xFF]).unwrap();
+        }
+
+        let mut i_prot = TCompactInputProtocol::new(&buf[..]);
+        let string = i_prot.read_borrowed_string().unwrap();
+        assert_eq!(string, "borrowed");
+        assert_eq!(string.as_ptr(), buf[1..].as_ptr());
+        assert_eq!(i_prot.read_borrowed_bytes().unwrap(), &[0x00, 0xFF]);
+        assert!(i_prot.read_borrowed_bytes().is_err());
+    }
+
     fn assert_no_write<F>(mut write_fn: F)
     where
         F: FnMut(&mut TCompactOutputProtocol<WriteHalf<TBufferChannel>>) -> crate::Result<()>,
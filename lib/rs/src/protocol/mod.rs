@@ -60,9 +60,10 @@
 use std::convert::{From, TryFrom};
 use std::fmt;
 use std::fmt::{Display, Formatter};
+use std::str;
 
 use crate::transport::{TReadTransport, TWriteTransport};
-use crate::{ProtocolError, ProtocolErrorKind};
+use crate::{OrderedFloat, ProtocolError, ProtocolErrorKind, TransportErrorKind};
 
 #[cfg(test)]
 macro_rules! assert_eq_written_bytes {
@@ -177,6 +178,31 @@ pub trait TInputProtocol {
     fn read_map_begin(&mut self) -> crate::Result<TMapIdentifier>;
     /// Read the end of a map.
     fn read_map_end(&mut self) -> crate::Result<()>;
+    /// Read the `size` elements of a list of `i8`, after its beginning.
+    ///
+    /// Generated code reads lists of numbers with these methods, so reading
+    /// a list takes one call instead of one per element. Protocols override
+    /// them to decode fixed-width elements in bulk.
+    fn read_i8_list(&mut self, size: i32) -> crate::Result<Vec<i8>> {
+        read_list_elements(size, || self.read_i8())
+    }
+    /// Read the `size` elements of a list of `i16`, after its beginning.
+    fn read_i16_list(&mut self, size: i32) -> crate::Result<Vec<i16>> {
+        read_list_elements(size, || self.read_i16())
+    }
+    /// Read the `size` elements of a list of `i32`, after its beginning.
+    fn read_i32_list(&mut self, size: i32) -> crate::Result<Vec<i32>> {
+        read_list_elements(size, || self.read_i32())
+    }
+    /// Read the `size` elements of a list of `i64`, after its beginning.
+    fn read_i64_list(&mut self, size: i32) -> crate::Result<Vec<i64>> {
+        read_list_elements(size, || self.read_i64())
+    }
+    /// Read the `size` elements of a list of 64-bit floats, after its
+    /// beginning.
+    fn read_double_list(&mut self, size: i32) -> crate::Result<Vec<OrderedFloat<f64>>> {
+        read_list_elements(size, || self.read_double().map(OrderedFloat::from))
+    }
     /// Skip a field with type `field_type` recursively until the default
     /// maximum skip depth is reached.
     fn skip(&mut self, field_type: TType) -> crate::Result<()> {
@@ -425,11 +451,113 @@ where
         (**self).read_map_end()
     }
 
+    fn read_i8_list(&mut self, size: i32) -> crate::Result<Vec<i8>> {
+        (**self).read_i8_list(size)
+    }
+
+    fn read_i16_list(&mut self, size: i32) -> crate::Result<Vec<i16>> {
+        (**self).read_i16_list(size)
+    }
+
+    fn read_i32_list(&mut self, size: i32) -> crate::Result<Vec<i32>> {
+        (**self).read_i32_list(size)
+    }
+
+    fn read_i64_list(&mut self, size: i32) -> crate::Result<Vec<i64>> {
+        (**self).read_i64_list(size)
+    }
+
+    fn read_double_list(&mut self, size: i32) -> crate::Result<Vec<OrderedFloat<f64>>> {
+        (**self).read_double_list(size)
+    }
+
     fn read_byte(&mut self) -> crate::Result<u8> {
         (**self).read_byte()
     }
 }
 
+/// Converts part of an in-memory buffer into Thrift strings and binaries
+/// without copying them.
+///
+/// It is implemented by the input protocols that read from a `&'a [u8]`, and
+/// types generated with the `borrowed` option of the Rust generator read
+/// themselves through it. Their strings and binaries point into the buffer,
+/// which has to outlive them.
+///
+/// # Examples
+///
+/// Borrow a string from a buffer.
+///
+/// ```
+/// use thrift::protocol::{TBinaryInputProtocol, TBorrowedInputProtocol};
+///
+/// let buf: &[u8] = &[0x00, 0x00, 0x00, 0x03, b'f', b'o', b'o'];
+/// let mut protocol = TBinaryInputProtocol::new(buf, true);
+///
+/// let recvd_string: &str = protocol.read_borrowed_string().unwrap();
+/// assert_eq!(recvd_string, "foo");
+/// ```
+pub trait TBorrowedInputProtocol<'a>: TInputProtocol {
+    /// Read a fixed-length byte array that borrows from the buffer.
+    fn read_borrowed_bytes(&mut self) -> crate::Result<&'a [u8]>;
+    /// Read a fixed-length string (not null terminated) that borrows from the
+    /// buffer.
+    fn read_borrowed_string(&mut self) -> crate::Result<&'a str> {
+        let bytes = self.read_borrowed_bytes()?;
+        str::from_utf8(bytes).map_err(From::from)
+    }
+}
+
+// Reads `size` list elements one at a time.
+fn read_list_elements<T, F>(size: i32, mut read: F) -> crate::Result<Vec<T>>
+where
+    F: FnMut() -> crate::Result<T>,
+{
+    let mut list = Vec::with_capacity(size.max(0) as usize);
+    for _ in 0..size {
+        list.push(read()?);
+    }
+    Ok(list)
+}
+
+// Reads `size` list elements of `width` bytes each, a buffer at a time, and
+// converts them with `decode`.
+fn read_fixed_width_list<R, T, F>(
+    transport: &mut R,
+    size: i32,
+    width: usize,
+    decode: F,
+) -> crate::Result<Vec<T>>
+where
+    R: TReadTransport,
+    F: Fn(&[u8]) -> T,
+{
+    let mut buf = [0u8; 1024];
+    let mut remaining = size.max(0) as usize;
+    let mut list = Vec::with_capacity(remaining);
+    while remaining > 0 {
+        let count = remaining.min(buf.len() / width);
+        let chunk = &mut buf[..count * width];
+        transport.read_exact(chunk)?;
+        list.extend(chunk.chunks_exact(width).map(&decode));
+        remaining -= count;
+    }
+    Ok(list)
+}
+
+// Splits the first `len` bytes off `buf`.
+fn borrow_bytes<'a>(buf: &mut &'a [u8], len: usize) -> crate::Result<&'a [u8]> {
+    if len > buf.len() {
+        return Err(crate::new_transport_error(
+            TransportErrorKind::EndOfFile,
+            format!("cannot borrow {} bytes, {} remaining", len, buf.len()),
+        ));
+    }
+    let (bytes, rest) = buf.split_at(len);
+    *buf = rest;
+    Ok(bytes)
+}
+
 impl<P> TOutputProtocol for Box<P>
 where
     P: TOutputProtocol + ?Sized,
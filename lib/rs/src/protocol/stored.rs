@@ -21,7 +21,7 @@ use super::{
     TFieldIdentifier, TInputProtocol, TListIdentifier, TMapIdentifier, TMessageIdentifier,
     TSetIdentifier, TStructIdentifier,
 };
-use crate::ProtocolErrorKind;
+use crate::{OrderedFloat, ProtocolErrorKind};
 
 /// `TInputProtocol` required to use a `TMultiplexedProcessor`.
 ///
@@ -186,6 +186,26 @@ impl<'a> TInputProtocol for TStoredInputProtocol<'a> {
         self.inner.read_map_end()
     }
 
+    fn read_i8_list(&mut self, size: i32) -> crate::Result<Vec<i8>> {
+        self.inner.read_i8_list(size)
+    }
+
+    fn read_i16_list(&mut self, size: i32) -> crate::Result<Vec<i16>> {
+        self.inner.read_i16_list(size)
+    }
+
+    fn read_i32_list(&mut self, size: i32) -> crate::Result<Vec<i32>> {
+        self.inner.read_i32_list(size)
+    }
+
+    fn read_i64_list(&mut self, size: i32) -> crate::Result<Vec<i64>> {
+        self.inner.read_i64_list(size)
+    }
+
+    fn read_double_list(&mut self, size: i32) -> crate::Result<Vec<OrderedFloat<f64>>> {
+        self.inner.read_double_list(size)
+    }
+
     // utility
     //
 
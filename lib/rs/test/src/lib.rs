@@ -17,6 +17,7 @@
 
 pub mod base_one;
 pub mod base_two;
+pub mod decoding;
 pub mod midlayer;
 pub mod ultimate;
 pub mod recursive;
@@ -24,8 +25,15 @@ pub mod recursive;
 #[cfg(test)]
 mod tests {
 
+    use std::collections::HashMap;
     use std::default::Default;
 
+    use thrift::protocol::{
+        TBinaryInputProtocol, TBinaryOutputProtocol, TCompactInputProtocol, TCompactOutputProtocol,
+        TOutputProtocol,
+    };
+    use thrift::OrderedFloat;
+
     use super::*;
 
     #[test]
@@ -50,4 +58,133 @@ mod tests {
             ..Default::default()
         };
     }
+
+    fn decoding_event() -> decoding::Event {
+        let mut series = HashMap::new();
+        series.insert("cpu".to_owned(), vec![1, 2, 3]);
+        series.insert("disk".to_owned(), vec![]);
+        let mut points = HashMap::new();
+        points.insert(-1, decoding::Point::new(3, 4));
+        decoding::Event {
+            id: 42,
+            name: Some("deploy".to_owned()),
+            label: Some("prod".to_owned()),
+            payload: Some(vec![0x00, 0xFF, 0x10]),
+            channel: Some(decoding::Channel::MOBILE),
+            origin: Some(decoding::Point::new(-1, 1)),
+            tags: Some(vec![
+                decoding::Tag::new("a".to_owned(), None),
+                decoding::Tag::new("b".to_owned(), vec![0x01]),
+            ]),
+            counts: Some((0..300).collect()),
+            weights: Some(vec![OrderedFloat::from(0.25), OrderedFloat::from(-8.0)]),
+            times: Some(vec![i64::MIN, 0, i64::MAX]),
+            ranks: Some(vec![-300, 300]),
+            keywords: Some(vec!["x".to_owned(), "y".to_owned()].into_iter().collect()),
+            series: Some(series),
+            target: Some(decoding::Target::Url("https://example.com".to_owned())),
+            points: Some(points),
+        }
+    }
+
+    fn write_event(event: &decoding::Event, o_prot: &mut dyn TOutputProtocol) {
+        event.write_to_out_protocol(o_prot).unwrap();
+        o_prot.flush().unwrap();
+    }
+
+    fn check_borrowed_event(event: &decoding::Event, view: &decoding::EventRef<'_>) {
+        assert_eq!(view.id, event.id);
+        assert_eq!(view.name, event.name.as_deref());
+        assert_eq!(view.label, event.label.as_deref());
+        assert_eq!(view.payload, event.payload.as_deref());
+        assert_eq!(view.channel, event.channel);
+        assert_eq!(view.origin, event.origin);
+        let tags = view.tags.as_ref().unwrap();
+        assert_eq!(tags.len(), 2);
+        assert_eq!(tags[0].name, Some("a"));
+        assert_eq!(tags[0].payload, None);
+        assert_eq!(tags[1].payload, Some(&[0x01][..]));
+        assert_eq!(view.counts, event.counts);
+        assert_eq!(view.weights, event.weights);
+        assert_eq!(view.times, event.times);
+        assert_eq!(view.ranks, event.ranks);
+        let keywords = view.keywords.as_ref().unwrap();
+        assert!(keywords.contains("x") && keywords.contains("y"));
+        assert_eq!(view.series.as_ref().unwrap()["cpu"], vec![1, 2, 3]);
+        assert_eq!(
+            view.target,
+            Some(decoding::TargetRef::Url("https://example.com"))
+        );
+        assert_eq!(view.points, event.points);
+    }
+
+    #[test]
+    fn must_round_trip_hash_collections() {
+        let event = decoding_event();
+
+        let mut buf: Vec<u8> = Vec::new();
+        write_event(&event, &mut TBinaryOutputProtocol::new(&mut buf, true));
+        let mut i_prot = TBinaryInputProtocol::new(&buf[..], true);
+        let read_event = decoding::Event::read_from_in_protocol(&mut i_prot).unwrap();
+        assert_eq!(read_event, event);
+
+        let mut buf: Vec<u8> = Vec::new();
+        write_event(&event, &mut TCompactOutputProtocol::new(&mut buf));
+        let mut i_prot = TCompactInputProtocol::new(&buf[..]);
+        let read_event = decoding::Event::read_from_in_protocol(&mut i_prot).unwrap();
+        assert_eq!(read_event, event);
+    }
+
+    #[test]
+    fn must_borrow_from_binary_buffer() {
+        let event = decoding_event();
+        let mut buf: Vec<u8> = Vec::new();
+        write_event(&event, &mut TBinaryOutputProtocol::new(&mut buf, true));
+
+        let mut i_prot = TBinaryInputProtocol::new(&buf[..], true);
+        let view = decoding::EventRef::read_from_in_protocol(&mut i_prot).unwrap();
+        check_borrowed_event(&event, &view);
+
+        let buf_range = buf.as_ptr() as usize..buf.as_ptr() as usize + buf.len();
+        assert!(buf_range.contains(&(view.name.unwrap().as_ptr() as usize)));
+    }
+
+    #[test]
+    fn must_borrow_from_compact_buffer() {
+        let event = decoding_event();
+        let mut buf: Vec<u8> = Vec::new();
+        write_event(&event, &mut TCompactOutputProtocol::new(&mut buf));
+
+        let mut i_prot = TCompactInputProtocol::new(&buf[..]);
+        let view = decoding::EventRef::read_from_in_protocol(&mut i_prot).unwrap();
+        check_borrowed_event(&event, &view);
+
+        // a truncated buffer is an error, not a short read
+        let mut i_prot = TCompactInputProtocol::new(&buf[..buf.len() - 8]);
+        assert!(decoding::EventRef::read_from_in_protocol(&mut i_prot).is_err());
+    }
+
+    #[test]
+    fn must_borrow_recursive_types() {
+        let tree = decoding::Node::new(
+            "root".to_owned(),
+            vec![
+                Box::new(decoding::Node::new("left".to_owned(), None)),
+                Box::new(decoding::Node::new("right".to_owned(), vec![])),
+            ],
+        );
+        let mut buf: Vec<u8> = Vec::new();
+        {
+            let mut o_prot = TBinaryOutputProtocol::new(&mut buf, true);
+            tree.write_to_out_protocol(&mut o_prot).unwrap();
+        }
+
+        let mut i_prot = TBinaryInputProtocol::new(&buf[..], true);
+        let view = decoding::NodeRef::read_from_in_protocol(&mut i_prot).unwrap();
+        assert_eq!(view.name, Some("root"));
+        let children = view.children.unwrap();
+        assert_eq!(children[0].name, Some("left"));
+        assert_eq!(children[0].children, None);
+        assert_eq!(children[1].children, Some(vec![]));
+    }
 }
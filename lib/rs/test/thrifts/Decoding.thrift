@@ -0,0 +1,70 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+# Generated with rs:hash_collections,borrowed
+
+enum Channel {
+  WEB = 1,
+  MOBILE = 2,
+}
+
+struct Point {
+  1: i32 x
+  2: i32 y
+}
+
+struct Tag {
+  1: string name
+  2: optional binary payload
+}
+
+union Target {
+  1: string url
+  2: Point position
+}
+
+typedef string Label
+typedef i64 Timestamp
+
+struct Event {
+  1: required i64 id
+  2: string name
+  3: Label label
+  4: binary payload
+  5: Channel channel
+  6: Point origin
+  7: list<Tag> tags
+  8: list<i32> counts
+  9: list<double> weights
+  10: list<Timestamp> times
+  11: list<i16> ranks
+  12: set<string> keywords
+  13: map<string, list<i64>> series
+  14: optional Target target
+  15: optional map<i16, Point> points
+}
+
+struct Node {
+  1: string name
+  2: optional list<Node> children
+}
+
+exception DecodeFailed {
+  1: string reason
+}
@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements. See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership. The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License. You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied. See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+namespace java thrift.test.reuse
+
+typedef list<i32> Ids
+
+const list<i16> DEFAULT_SHORTS = [1, 2, 3]
+
+struct Sample {
+  1: i32 id;
+  2: binary payload;
+}
+
+struct Series {
+  1: list<i16> shorts = [1, 2, 3];
+  2: list<i32> ints;
+  3: list<i64> longs;
+  4: list<double> doubles;
+  5: Ids ids;
+  6: map<string, list<i32>> buckets;
+  7: list<list<i64>> nested;
+  8: list<Sample> samples;
+  9: Sample last;
+  10: set<string> labels;
+  11: list<bool> flags;
+  12: optional list<double> weights;
+}
+
+service SeriesService {
+  Series echo(1: Series series, 2: Ids ids);
+}